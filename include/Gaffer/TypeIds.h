@@ -117,6 +117,8 @@ enum TypeId
 	SwitchComputeNodeTypeId = 110070,
 	SwitchDependencyNodeTypeId = 110071,
 	ParameterisedHolderExecutableNodeTypeId = 110072,
+	V2fVectorDataPlugTypeId = 110073,
+	Color4fVectorDataPlugTypeId = 110074,
 	LastTypeId = 110200,
 	
 };
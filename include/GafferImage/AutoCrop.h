@@ -0,0 +1,114 @@
+//////////////////////////////////////////////////////////////////////////
+//  
+//  Copyright (c) 2014, Image Engine Design Inc. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//  
+//      * Redistributions of source code must retain the above
+//        copyright notice, this list of conditions and the following
+//        disclaimer.
+//  
+//      * Redistributions in binary form must reproduce the above
+//        copyright notice, this list of conditions and the following
+//        disclaimer in the documentation and/or other materials provided with
+//        the distribution.
+//  
+//      * Neither the name of John Haddon nor the names of
+//        any other contributors to this software may be used to endorse or
+//        promote products derived from this software without specific prior
+//        written permission.
+//  
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef GAFFERIMAGE_AUTOCROP_H
+#define GAFFERIMAGE_AUTOCROP_H
+
+#include "Gaffer/TypedPlug.h"
+
+#include "GafferImage/ImageProcessor.h"
+#include "GafferImage/ChannelMaskPlug.h"
+
+namespace GafferImage
+{
+
+/// Shrinks the data window of the input image to the tightest bound of the pixels
+/// which are non-zero in any of the chosen channels. The tiles of the input data window
+/// are scanned in parallel, and constant tiles are accounted for without visiting their
+/// pixels. The bound may optionally be expanded to the enclosing tile boundaries, so that
+/// the tiles of the output are passed through from the input without modification.
+///
+/// Because the pixels outside the bound are zero in the scanned channels by definition,
+/// those channels are passed through from the input without depending on the data window.
+/// This matters, because the data window depends on every input tile, and would otherwise
+/// have to be hashed once for every output tile. Only the unscanned channels need masking.
+class AutoCrop : public ImageProcessor
+{
+
+	public :
+
+		AutoCrop( const std::string &name=defaultName<AutoCrop>() );
+		virtual ~AutoCrop();
+
+		IE_CORE_DECLARERUNTIMETYPEDEXTENSION( GafferImage::AutoCrop, AutoCropTypeId, ImageProcessor );
+
+		virtual void affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const;
+
+		//! @name Plug Accessors
+		/// Returns a pointer to the node's plugs.
+		//////////////////////////////////////////////////////////////
+		//@{
+		/// The channels which are scanned for non-zero pixels.
+		GafferImage::ChannelMaskPlug *channelsPlug();
+		const GafferImage::ChannelMaskPlug *channelsPlug() const;
+		/// When on, the data window is expanded to the boundaries of the
+		/// tiles it intersects, clipped to the input data window.
+		Gaffer::BoolPlug *snapToTilesPlug();
+		const Gaffer::BoolPlug *snapToTilesPlug() const;
+		//@}
+
+	protected :
+
+		virtual void hashFormat( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
+		virtual void hashDataWindow( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
+		virtual void hashChannelNames( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
+		/// Passes through the input hash for the scanned channels, and for tiles which lie
+		/// entirely within the output data window.
+		virtual void hashChannelData( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
+
+		virtual GafferImage::Format computeFormat( const Gaffer::Context *context, const ImagePlug *parent ) const;
+		virtual Imath::Box2i computeDataWindow( const Gaffer::Context *context, const ImagePlug *parent ) const;
+		virtual IECore::ConstStringVectorDataPtr computeChannelNames( const Gaffer::Context *context, const ImagePlug *parent ) const;
+		/// Returns the input tile unchanged if the channel is scanned or the tile lies entirely within
+		/// the output data window, and otherwise a copy with the pixels outside the data window set to zero.
+		virtual IECore::ConstFloatVectorDataPtr computeChannelData( const std::string &channelName, const Imath::V2i &tileOrigin, const Gaffer::Context *context, const ImagePlug *parent ) const;
+
+	private :
+
+		/// Returns the intersection of the input channel names with channelsPlug().
+		std::vector<std::string> scannedChannels() const;
+		/// Returns true if the channel is in channelsPlug(), without evaluating the input.
+		bool channelScanned( const std::string &channel ) const;
+
+		static size_t g_firstPlugIndex;
+
+};
+
+IE_CORE_DECLAREPTR( AutoCrop );
+
+} // namespace GafferImage
+
+#endif // GAFFERIMAGE_AUTOCROP_H
@@ -0,0 +1,138 @@
+//////////////////////////////////////////////////////////////////////////
+//  
+//  Copyright (c) 2014, Image Engine Design Inc. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//  
+//      * Redistributions of source code must retain the above
+//        copyright notice, this list of conditions and the following
+//        disclaimer.
+//  
+//      * Redistributions in binary form must reproduce the above
+//        copyright notice, this list of conditions and the following
+//        disclaimer in the documentation and/or other materials provided with
+//        the distribution.
+//  
+//      * Neither the name of John Haddon nor the names of
+//        any other contributors to this software may be used to endorse or
+//        promote products derived from this software without specific prior
+//        written permission.
+//  
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef GAFFERIMAGE_BLUR_H
+#define GAFFERIMAGE_BLUR_H
+
+#include "Gaffer/NumericPlug.h"
+#include "Gaffer/CompoundNumericPlug.h"
+#include "Gaffer/TypedObjectPlug.h"
+
+#include "GafferImage/ImageProcessor.h"
+#include "GafferImage/FilterPlug.h"
+
+namespace GafferImage
+{
+
+/// Blurs the input image with a separable kernel, expanding the data window by
+/// the extent of the kernel. The kernel is applied as a sequence of horizontal
+/// and then vertical passes. The input to each pass is computed a tile at a time
+/// into an internal plug, as prefix sums along the axis of the pass, so that it is
+/// cached and shared by all the tiles which need it, and the passes operate on
+/// whole rows or columns of a tile at once, using SIMD instructions.
+///
+/// In the Box and Gaussian modes, each output pixel of a pass is the difference
+/// of two lookups into the chained sums, so the cost per pixel does not grow with
+/// the radius. The number of tiles whose sums must be chained, and whose hashes
+/// must be combined, does grow with it, but only by one per tileSize pixels. The
+/// Gaussian mode approximates a gaussian with three successive box passes, and the
+/// radius is three standard deviations. The FilterKernel mode convolves directly
+/// with one of the GafferImage::Filter kernels, scaled to the radius, and so is
+/// more costly for large radii.
+class Blur : public ImageProcessor
+{
+
+	public :
+
+		enum Mode
+		{
+			Box = 0,
+			Gaussian = 1,
+			FilterKernel = 2
+		};
+
+		Blur( const std::string &name=defaultName<Blur>() );
+		virtual ~Blur();
+
+		IE_CORE_DECLARERUNTIMETYPEDEXTENSION( GafferImage::Blur, BlurTypeId, ImageProcessor );
+
+		virtual void affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const;
+
+		//! @name Plug Accessors
+		/// Returns a pointer to the node's plugs.
+		//////////////////////////////////////////////////////////////
+		//@{
+		Gaffer::IntPlug *modePlug();
+		const Gaffer::IntPlug *modePlug() const;
+		/// The radius of the blur in pixels, in x and y.
+		Gaffer::V2fPlug *radiusPlug();
+		const Gaffer::V2fPlug *radiusPlug() const;
+		/// The filter used in FilterKernel mode.
+		GafferImage::FilterPlug *filterPlug();
+		const GafferImage::FilterPlug *filterPlug() const;
+		//@}
+
+	protected :
+
+		/// Reimplemented to return false when the radius is zero.
+		virtual bool enabled() const;
+
+		/// Reimplemented to hash and compute the sums.
+		virtual void hash( const Gaffer::ValuePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
+		virtual void compute( Gaffer::ValuePlug *output, const Gaffer::Context *context ) const;
+
+		virtual void hashFormat( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
+		virtual void hashDataWindow( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
+		virtual void hashChannelNames( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
+		virtual void hashChannelData( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
+
+		virtual GafferImage::Format computeFormat( const Gaffer::Context *context, const ImagePlug *parent ) const;
+		virtual Imath::Box2i computeDataWindow( const Gaffer::Context *context, const ImagePlug *parent ) const;
+		virtual IECore::ConstStringVectorDataPtr computeChannelNames( const Gaffer::Context *context, const ImagePlug *parent ) const;
+		virtual IECore::ConstFloatVectorDataPtr computeChannelData( const std::string &channelName, const Imath::V2i &tileOrigin, const Gaffer::Context *context, const ImagePlug *parent ) const;
+
+	private :
+
+		/// Holds the prefix sums of the input to a pass, along the axis of the
+		/// pass, for the tile and channel specified by the context. The pass is
+		/// specified by an int context variable, "__blur:pass".
+		Gaffer::FloatVectorDataPlug *sumsPlug();
+		const Gaffer::FloatVectorDataPlug *sumsPlug() const;
+
+		/// Hashes and computes a tile of the input to the specified pass. The
+		/// input to the pass one beyond the last is the output image.
+		void hashPassInput( size_t pass, const Imath::V2i &tileOrigin, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
+		IECore::ConstFloatVectorDataPtr computePassInput( size_t pass, const Imath::V2i &tileOrigin, const Gaffer::Context *context ) const;
+
+		static size_t g_firstPlugIndex;
+
+};
+
+IE_CORE_DECLAREPTR( Blur );
+
+} // namespace GafferImage
+
+#endif // GAFFERIMAGE_BLUR_H
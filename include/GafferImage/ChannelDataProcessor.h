@@ -46,6 +46,11 @@ namespace GafferImage
 
 /// The ChannelDataProcessor provides a useful base class for nodes that manipulate individual channels
 /// of an image and leave their image dimensions and channel names unchanged.
+///
+/// Because processChannelData() is a pure point operation, consecutive ChannelDataProcessors
+/// are fused at compute time. When the input to a node is fed directly by another ChannelDataProcessor,
+/// the input tile is fetched from the head of the chain and each node in turn processes it in place,
+/// so the intermediate tiles are neither computed nor cached unless something else requests them.
 class ChannelDataProcessor : public ImageProcessor
 {
 
@@ -70,6 +75,8 @@ class ChannelDataProcessor : public ImageProcessor
 	
 		/// This implementation queries whether or not the requested channel is masked by the channelMaskPlug().
 		virtual bool channelEnabled( const std::string &channel ) const;
+		/// Returns true, as the data window is always that of the input.
+		virtual bool passesThroughDataWindow() const;
 	
 		/// Reimplemented to pass through the hashes from the input plug as they don't change.
 		virtual void hashFormat( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
@@ -81,7 +88,8 @@ class ChannelDataProcessor : public ImageProcessor
 		virtual Imath::Box2i computeDataWindow( const Gaffer::Context *context, const ImagePlug *parent ) const;
 		virtual IECore::ConstStringVectorDataPtr computeChannelNames( const Gaffer::Context *context, const ImagePlug *parent ) const;
 
-		/// Implemented to initialize the output tile and then call processChannelData() 
+		/// Implemented to initialize the output tile and then call processChannelData(), applying
+		/// the processing of any directly connected upstream ChannelDataProcessors first.
 		virtual IECore::ConstFloatVectorDataPtr computeChannelData( const std::string &channelName, const Imath::V2i &tileOrigin, const Gaffer::Context *context, const ImagePlug *parent ) const;
 
 		/// Should be implemented by derived classes to processes each channel's data.
@@ -90,10 +98,24 @@ class ChannelDataProcessor : public ImageProcessor
 		/// @param channelIndex An index in the range of 0-3 which indicates whether the channel to be processed is R, G, B or A. 
 		///                     It is useful for querying Color4f plugs for the value that coresponds to the channel being processed. 
 		/// @param outData The tile where the result of the operation should be written. It is initialized with the coresponding tile data from inPlug() which should be used as the input data.
+		///                When the input tile is constant (see ImagePlug::isConstantTile()), outData contains just a single
+		///                value, so implementations must process outData->readable().size() values rather than assuming a
+		///                full tile.
 		virtual void processChannelData( const Gaffer::Context *context, const ImagePlug *parent, const std::string &channel, IECore::FloatVectorDataPtr outData ) const = 0;
 
 	private :
 		
+		// ColorProcessor uses fusedChannelData() to fetch its input channels.
+		friend class ColorProcessor;
+		
+		// Returns a writable copy of the channel data from image, which must be an input plug.
+		// If image is fed by a chain of ChannelDataProcessors, their processing is applied to a
+		// single copy of the data from the head of the chain, without computing the intermediate
+		// tiles. If the data at the head of the chain is a constant tile, the result contains only
+		// a single value. Must be called with the channel name and tile origin set in the current
+		// context.
+		static IECore::FloatVectorDataPtr fusedChannelData( const ImagePlug *image, const std::string &channelName, const Imath::V2i &tileOrigin );
+		
 		static size_t g_firstPlugIndex;
 
 };
@@ -65,6 +65,8 @@ class ColorProcessor : public ImageProcessor
 	
 		virtual void hash( const Gaffer::ValuePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
 		virtual void compute( Gaffer::ValuePlug *output, const Gaffer::Context *context ) const;
+		/// Returns true, as the data window is always that of the input.
+		virtual bool passesThroughDataWindow() const;
 
 		/// Implemented to pass through the hashes from the input plug.
 		virtual void hashFormat( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
@@ -85,7 +87,9 @@ class ColorProcessor : public ImageProcessor
 		/// Must be implemented by derived classes to compute the hash for the color processing - all implementations
 		/// must call their base class implementation first.
 		virtual void hashColorData( const Gaffer::Context *context, IECore::MurmurHash &h ) const = 0;
-		/// Must be implemented by derived classes to modify R, G and B in place.
+		/// Must be implemented by derived classes to modify R, G and B in place. When the input tiles are
+		/// constant (see ImagePlug::isConstantTile()), each contains just a single value, so implementations
+		/// must process r->readable().size() values rather than assuming a full tile.
 		virtual void processColorData( const Gaffer::Context *context, IECore::FloatVectorData *r, IECore::FloatVectorData *g, IECore::FloatVectorData *b ) const = 0;
 
 	private :
@@ -40,6 +40,7 @@
 #include "IECore/DisplayDriverServer.h"
 
 #include "Gaffer/NumericPlug.h"
+#include "Gaffer/TypedPlug.h"
 
 #include "GafferImage/ImageNode.h"
 
@@ -60,6 +61,13 @@ class Display : public ImageNode
 		
 		Gaffer::IntPlug *portPlug();
 		const Gaffer::IntPlug *portPlug() const;
+		
+		/// When on, renderers on the same machine using the
+		/// "GafferImage::SharedMemoryClientDisplayDriver" driver type
+		/// send pixels via shared memory rather than the socket.
+		/// Takes effect for subsequently opened images.
+		Gaffer::BoolPlug *sharedMemoryPlug();
+		const Gaffer::BoolPlug *sharedMemoryPlug() const;
 				
 		virtual void affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const;
 		
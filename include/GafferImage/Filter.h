@@ -90,6 +90,8 @@ public :
 	void setScale( float scale );
 	/// Returns the current scale of the kernel.
 	inline float getScale() const { return m_scale; }
+	/// Returns the radius of the kernel in pixels, at the current scale.
+	inline float getRadius() const { return m_scaledRadius; }
 	//@}
 	//! @name Filter Convolution
 	/// A set of methods that create a simple interface to allow the
@@ -121,6 +123,30 @@ public :
 	}
 	//@}
 
+	//! @name Weight Tables
+	/// Methods to precompute the taps and weights for a set of kernel
+	/// positions along one axis, so that a separable convolution can
+	/// reuse them for every row or column rather than evaluating the
+	/// filter again for each pixel.
+	//////////////////////////////////////////////////////////////
+	//@{
+	struct Weights
+	{
+		/// The number of weights stored for each position.
+		int width;
+		/// The first pixel covered by the kernel at each position.
+		std::vector<int> taps;
+		/// The normalised weights for each position, stored
+		/// consecutively with width weights per position.
+		std::vector<float> weights;
+	};
+	/// Fills weights with the taps and normalised weights for the kernel
+	/// centered at each of the positions in centers. As in Sampler::sample(),
+	/// the box filter is treated as a point sample of the pixel containing
+	/// each center.
+	void computeWeights( const std::vector<float> &centers, Weights &weights ) const;
+	//@}
+
 	//! @name Filter Registry
 	/// A set of methods to query the available Filters and create them.
 	//////////////////////////////////////////////////////////////
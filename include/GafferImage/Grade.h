@@ -89,6 +89,8 @@ class Grade : public ChannelDataProcessor
 	protected :
 
 		virtual bool channelEnabled( const std::string &channel ) const;
+		/// Returns false, so that grades are stored at full precision.
+		virtual bool halfStorageEnabled( const std::string &channel ) const;
 		
 		virtual void hashChannelData( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
 		virtual void processChannelData( const Gaffer::Context *context, const ImagePlug *parent, const std::string &channelIndex, IECore::FloatVectorDataPtr outData ) const;
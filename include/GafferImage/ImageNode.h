@@ -88,8 +88,28 @@ class ImageNode : public Gaffer::ComputeNode
 		virtual bool channelEnabled( const std::string &channel ) const { return true; };
 		/// The default implementation of enabled returns the value of the enabled plug.
 		virtual bool enabled() const;
+		
+		/// Called to determine whether or not the results of computeChannelData() may be stored
+		/// at half precision when ImagePlug::getTileStorage() is HalfTileStorage. The default
+		/// implementation returns true. Derived classes may reimplement it to return false for
+		/// channels which would be unduly degraded by quantisation to half, or where they wish
+		/// to keep full precision for the benefit of the nodes downstream. Note that this has no
+		/// bearing on the precision of the computation itself, which is always performed in float.
+		virtual bool halfStorageEnabled( const std::string &channel ) const;
+		
+		/// The results of computeChannelData() are stored in the cache via this plug rather
+		/// than via outPlug()->channelDataPlug(). With FloatTileStorage the stored tile is
+		/// returned from outPlug()->channelDataPlug() as is, so this costs no more than caching
+		/// the output directly. With HalfTileStorage it is converted back to float on every
+		/// access, because the float tile isn't cached - see ImagePlug::setTileStorage().
+		/// Derived classes which manage the caching of their channel data themselves may turn
+		/// off the Cacheable flag on this plug, in which case computeChannelData() will be called
+		/// directly whenever the channel data is requested, and half storage has no effect.
+		Gaffer::ObjectPlug *channelDataStoragePlug();
+		const Gaffer::ObjectPlug *channelDataStoragePlug() const;
 			
 		/// Implemented to call the hash*() methods below whenever output is part of an ImagePlug and the node is enabled.
+		/// Derived classes which reimplement hash() or compute() must pass channelDataStoragePlug() through to the base class.
 		virtual void hash( const Gaffer::ValuePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
 		/// Hash methods for the individual children of an image output - these must be implemented by derived classes.
 		/// An implementation must do one or the other of the following :
@@ -116,6 +136,8 @@ class ImageNode : public Gaffer::ComputeNode
 		
 	private :
 		
+		bool useHalfStorage( const std::string &channel ) const;
+		
 		static size_t g_firstPlugIndex;
 };
 
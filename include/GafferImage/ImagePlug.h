@@ -123,10 +123,60 @@ class ImagePlug : public Gaffer::CompoundPlug
 		IECore::MurmurHash imageHash() const;
 		//@}
 		
-		static int tileSize() { return 64; };
+		/// Returns the width and height of the tiles. This defaults to 64, but
+		/// may be overridden for the whole process by setting the
+		/// GAFFERIMAGE_TILE_SIZE environment variable - larger tiles reduce the
+		/// per-tile overhead of contexts, hashes and cache entries, while smaller
+		/// ones give finer grained parallelism for interactive work. The tile size
+		/// can't be changed once the process is running, because it isn't included
+		/// in any hashes.
+		static int tileSize() { return g_tileSize; };
 		static Imath::Box2i tileBound( const Imath::V2i &tileOrigin ) { return Imath::Box2i( tileOrigin * tileSize(), ( tileOrigin + Imath::V2i( 1 ) ) * tileSize() - Imath::V2i( 1 ) ); }
 		static const IECore::FloatVectorData *blackTile();
 		static const IECore::FloatVectorData *whiteTile();
+		/// Returns a tile with every pixel set to the specified value. Where
+		/// possible, the tile is shared between all callers requesting the same
+		/// value, and can subsequently be identified by isConstantTile(). Nodes
+		/// which output tiles of a single value should use this so that nodes
+		/// downstream may process them in constant time.
+		static IECore::ConstFloatVectorDataPtr constantTile( float value );
+		/// Returns true if the tile was returned by blackTile(), whiteTile() or
+		/// constantTile(), filling value with the value of its pixels. This is
+		/// a constant time operation, and may return false for tiles which just
+		/// happen to have a single value but were created by other means.
+		static bool isConstantTile( const IECore::FloatVectorData *tile, float &value );
+		/// Returns a new tile of tileSize() * tileSize() pixels, for nodes to fill
+		/// in computeChannelData(). Note that the pixel values are uninitialised.
+		/// Rather than using the global allocator, the storage is taken from a
+		/// per-thread pool, and is returned to the pool when the tile is destroyed,
+		/// typically on eviction from the cache. Nodes should always use this in
+		/// preference to allocating their own tiles.
+		static IECore::FloatVectorDataPtr allocateTile();
+		
+		/// @name Tile storage
+		/// Tiles are always passed between nodes as FloatVectorData, but
+		/// ImageNodes may store the results of their computations in the
+		/// cache at half precision, converting back to float on demand.
+		/// This roughly doubles the number of tiles which fit in the cache,
+		/// at the expense of precision and of a conversion to float (into a
+		/// newly allocated tile) every time a tile is read. It is therefore
+		/// only a win when the working set of tiles doesn't otherwise fit in
+		/// the cache, and recomputing them costs more than the conversions.
+		/// Nodes which don't cache their channel data themselves (ImageReader,
+		/// ColorProcessor, OSLImage and ImagePrimitiveSource) are unaffected,
+		/// and individual nodes may opt out - see ImageNode::halfStorageEnabled().
+		/// The default is FloatTileStorage, and changes nothing compared to
+		/// caching the channel data plugs directly.
+		////////////////////////////////////////////////////////////////////
+		//@{
+		enum TileStorage
+		{
+			FloatTileStorage,
+			HalfTileStorage
+		};
+		static void setTileStorage( TileStorage tileStorage );
+		static TileStorage getTileStorage();
+		//@}
 		
 		/// Returns the origin of the tile that contains the point.
 		inline static Imath::V2i tileOrigin( const Imath::V2i &point )
@@ -140,6 +190,7 @@ class ImagePlug : public Gaffer::CompoundPlug
 	private :
 		
 		static size_t g_firstPlugIndex;
+		static const int g_tileSize;
 };
 
 IE_CORE_DECLAREPTR( ImagePlug );
@@ -38,6 +38,8 @@
 #ifndef GAFFERIMAGE_IMAGEPRIMITIVESOURCE_H
 #define GAFFERIMAGE_IMAGEPRIMITIVESOURCE_H
 
+#include "IECore/CompoundObject.h"
+
 #include "Gaffer/TypedObjectPlug.h"
 
 #include "GafferImage/ImageNode.h"
@@ -45,6 +47,9 @@
 namespace GafferImage
 {
 
+/// Base class for nodes which generate their output from an ImagePrimitive.
+/// The ImagePrimitive is converted into tiles once, when it is first needed,
+/// and the tiles themselves are then output as channel data without copying.
 template<typename BaseType>
 class ImagePrimitiveSource : public BaseType
 {
@@ -62,9 +67,6 @@ class ImagePrimitiveSource : public BaseType
 
 		ImagePrimitiveSource( const std::string &name );
 
-		Gaffer::ObjectPlug *imagePrimitivePlug();
-		const Gaffer::ObjectPlug *imagePrimitivePlug() const;
-
 		virtual void hashImagePrimitive( const Gaffer::Context *context, IECore::MurmurHash &h ) const = 0;
 		/// It is ok to return 0 if no ImagePrimitive is available.
 		virtual IECore::ConstImagePrimitivePtr computeImagePrimitive( const Gaffer::Context *context ) const = 0;		
@@ -83,8 +85,18 @@ class ImagePrimitiveSource : public BaseType
 
 	private :
 	
-		Gaffer::ObjectPlug *inputImagePrimitivePlug();
-		const Gaffer::ObjectPlug *inputImagePrimitivePlug() const;
+		// Holds a CompoundObject containing the tiles converted from the
+		// ImagePrimitive, along with the windows and channel names.
+		Gaffer::ObjectPlug *tilesPlug();
+		const Gaffer::ObjectPlug *tilesPlug() const;
+		
+		// Connected to tilesPlug(), so that we can use getValue() to access
+		// the tiles during other computes.
+		Gaffer::ObjectPlug *inputTilesPlug();
+		const Gaffer::ObjectPlug *inputTilesPlug() const;
+		
+		IECore::ConstCompoundObjectPtr inputTiles() const;
+		static IECore::CompoundObjectPtr tiles( const IECore::ImagePrimitive *image );
 		
 };
 
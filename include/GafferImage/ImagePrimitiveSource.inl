@@ -38,6 +38,9 @@
 #include "IECore/BoxOps.h"
 #include "IECore/BoxAlgo.h"
 #include "IECore/NullObject.h"
+#include "IECore/ObjectVector.h"
+#include "IECore/SimpleTypedData.h"
+#include "IECore/VectorTypedData.h"
 
 #include "Gaffer/Context.h"
 
@@ -53,16 +56,17 @@ template<typename BaseType>
 ImagePrimitiveSource<BaseType>::ImagePrimitiveSource( const std::string &name )
 	:	BaseType( name )
 {
-	BaseType::addChild( new Gaffer::ObjectPlug( "__imagePrimitive", Gaffer::Plug::Out, IECore::NullObject::defaultNullObject() ) );
-	BaseType::addChild( new Gaffer::ObjectPlug( "__inputImagePrimitive", Gaffer::Plug::In, IECore::NullObject::defaultNullObject(), Gaffer::Plug::Default & ~Gaffer::Plug::Serialisable ) );
-	inputImagePrimitivePlug()->setInput( imagePrimitivePlug() );
+	BaseType::addChild( new Gaffer::ObjectPlug( "__tiles", Gaffer::Plug::Out, IECore::NullObject::defaultNullObject() ) );
+	BaseType::addChild( new Gaffer::ObjectPlug( "__inputTiles", Gaffer::Plug::In, IECore::NullObject::defaultNullObject(), Gaffer::Plug::Default & ~Gaffer::Plug::Serialisable ) );
+	inputTilesPlug()->setInput( tilesPlug() );
 
 	// disable caching on our outputs, as we're basically caching the entire
-	// image ourselves in __inputImagePrimitive.
+	// image ourselves in __inputTiles.
 	for( Gaffer::OutputPlugIterator it( BaseType::outPlug() ); it!=it.end(); it++ )
 	{
 		(*it)->setFlags( Gaffer::Plug::Cacheable, false );
 	}
+	BaseType::channelDataStoragePlug()->setFlags( Gaffer::Plug::Cacheable, false );
 }
 
 template<typename BaseType>
@@ -75,7 +79,7 @@ void ImagePrimitiveSource<BaseType>::affects( const Gaffer::Plug *input, Gaffer:
 {
 	BaseType::affects( input, outputs );
 	
-	if( input == inputImagePrimitivePlug() )
+	if( input == inputTilesPlug() )
 	{
 		for( Gaffer::ValuePlugIterator it( BaseType::outPlug() ); it != it.end(); it++ )
 		{
@@ -89,9 +93,10 @@ void ImagePrimitiveSource<BaseType>::hash( const Gaffer::ValuePlug *output, cons
 {
 	BaseType::hash( output, context, h );
 	
-	if( output == imagePrimitivePlug() )
+	if( output == tilesPlug() )
 	{
 		hashImagePrimitive( context, h );
+		h.append( ImagePlug::tileSize() );
 	}
 }
 
@@ -99,21 +104,21 @@ template<typename BaseType>
 void ImagePrimitiveSource<BaseType>::hashFormat( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {
 	BaseType::hashFormat( output, context, h );
-	inputImagePrimitivePlug()->hash( h );
+	inputTilesPlug()->hash( h );
 }
 
 template<typename BaseType>
 void ImagePrimitiveSource<BaseType>::hashChannelNames( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {
 	BaseType::hashChannelNames( output, context, h );
-	inputImagePrimitivePlug()->hash( h );
+	inputTilesPlug()->hash( h );
 }
 
 template<typename BaseType>
 void ImagePrimitiveSource<BaseType>::hashDataWindow( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {
 	BaseType::hashDataWindow( output, context, h );
-	inputImagePrimitivePlug()->hash( h );
+	inputTilesPlug()->hash( h );
 }
 
 template<typename BaseType>
@@ -122,43 +127,125 @@ void ImagePrimitiveSource<BaseType>::hashChannelData( const GafferImage::ImagePl
 	BaseType::hashChannelData( output, context, h );
 	h.append( context->get<Imath::V2i>( ImagePlug::tileOriginContextName ) );
 	h.append( context->get<std::string>( ImagePlug::channelNameContextName ) );
-	inputImagePrimitivePlug()->hash( h );
+	inputTilesPlug()->hash( h );
 }
 		
 template<typename BaseType>
-Gaffer::ObjectPlug *ImagePrimitiveSource<BaseType>::imagePrimitivePlug()
+Gaffer::ObjectPlug *ImagePrimitiveSource<BaseType>::tilesPlug()
 {
-	return BaseType::template getChild<Gaffer::ObjectPlug>( "__imagePrimitive" );
+	return BaseType::template getChild<Gaffer::ObjectPlug>( "__tiles" );
 }
 
 template<typename BaseType>
-const Gaffer::ObjectPlug *ImagePrimitiveSource<BaseType>::imagePrimitivePlug() const
+const Gaffer::ObjectPlug *ImagePrimitiveSource<BaseType>::tilesPlug() const
 {
-	return BaseType::template getChild<Gaffer::ObjectPlug>( "__imagePrimitive" );
+	return BaseType::template getChild<Gaffer::ObjectPlug>( "__tiles" );
 }
 
 template<typename BaseType>
-Gaffer::ObjectPlug *ImagePrimitiveSource<BaseType>::inputImagePrimitivePlug()
+Gaffer::ObjectPlug *ImagePrimitiveSource<BaseType>::inputTilesPlug()
 {
-	return BaseType::template getChild<Gaffer::ObjectPlug>( "__inputImagePrimitive" );
+	return BaseType::template getChild<Gaffer::ObjectPlug>( "__inputTiles" );
 }
 
 template<typename BaseType>
-const Gaffer::ObjectPlug *ImagePrimitiveSource<BaseType>::inputImagePrimitivePlug() const
+const Gaffer::ObjectPlug *ImagePrimitiveSource<BaseType>::inputTilesPlug() const
 {
-	return BaseType::template getChild<Gaffer::ObjectPlug>( "__inputImagePrimitive" );
+	return BaseType::template getChild<Gaffer::ObjectPlug>( "__inputTiles" );
 }
+
+template<typename BaseType>
+IECore::ConstCompoundObjectPtr ImagePrimitiveSource<BaseType>::inputTiles() const
+{
+	return IECore::runTimeCast<const IECore::CompoundObject>( inputTilesPlug()->getValue() );
+}
+
+template<typename BaseType>
+IECore::CompoundObjectPtr ImagePrimitiveSource<BaseType>::tiles( const IECore::ImagePrimitive *image )
+{
+	IECore::CompoundObjectPtr result = new IECore::CompoundObject;
+	
+	Imath::Box2i displayWindow = image->getDisplayWindow();
+	Imath::Box2i dataWindow = image->getDataWindow();
+	const int yOffset = displayWindow.min.y + ( displayWindow.size().y + 1 ) - dataWindow.min.y;
+	dataWindow.min.y = yOffset - ( dataWindow.size().y + 1 );
+	dataWindow.max.y = yOffset - 1;
+	
+	IECore::StringVectorDataPtr channelNamesData = new IECore::StringVectorData;
+	image->channelNames( channelNamesData->writable() );
+	
+	IECore::CompoundObjectPtr channels = new IECore::CompoundObject;
+	
+	result->members()["displayWindow"] = new IECore::Box2iData( displayWindow );
+	result->members()["dataWindow"] = new IECore::Box2iData( dataWindow );
+	result->members()["channelNames"] = channelNamesData;
+	result->members()["channels"] = channels;
+	
+	if( dataWindow.isEmpty() )
+	{
+		return result;
+	}
+	
+	// we store only the tiles which intersect the data window, in
+	// row-major order, ready to be output as channel data as-is.
+	const int tileSize = ImagePlug::tileSize();
+	const Imath::V2i minTileOrigin = ImagePlug::tileOrigin( dataWindow.min );
+	const Imath::V2i numTiles = ( ImagePlug::tileOrigin( dataWindow.max ) - minTileOrigin ) / tileSize + Imath::V2i( 1 );
+	
+	const std::vector<std::string> &channelNames = channelNamesData->readable();
+	for( std::vector<std::string>::const_iterator it = channelNames.begin(), eIt = channelNames.end(); it != eIt; ++it )
+	{
+		IECore::ConstFloatVectorDataPtr channelData = image->getChannel<float>( *it );
+		if( !channelData )
+		{
+			continue;
+		}
+		const std::vector<float> &channel = channelData->readable();
 		
+		IECore::ObjectVectorPtr channelTiles = new IECore::ObjectVector;
+		channelTiles->members().resize( numTiles.x * numTiles.y );
+		for( int tileY = 0; tileY < numTiles.y; ++tileY )
+		{
+			for( int tileX = 0; tileX < numTiles.x; ++tileX )
+			{
+				const Imath::V2i tileOrigin = minTileOrigin + Imath::V2i( tileX, tileY ) * tileSize;
+				const Imath::Box2i tileBound( tileOrigin, tileOrigin + Imath::V2i( tileSize - 1 ) );
+				const Imath::Box2i bound = IECore::boxIntersection( tileBound, dataWindow );
+				
+				IECore::FloatVectorDataPtr tileData = new IECore::FloatVectorData;
+				std::vector<float> &tile = tileData->writable();
+				tile.resize( tileSize * tileSize, 0.0f );
+				
+				for( int y = bound.min.y; y<=bound.max.y; y++ )
+				{
+					const size_t srcIndex = ( dataWindow.size().y - ( y - dataWindow.min.y ) ) * ( dataWindow.size().x + 1 ) + bound.min.x - dataWindow.min.x;
+					const size_t dstIndex = ( y - tileBound.min.y ) * tileSize + bound.min.x - tileBound.min.x;
+					std::copy( channel.begin() + srcIndex, channel.begin() + srcIndex + bound.size().x + 1, tile.begin() + dstIndex );
+				}
+				
+				channelTiles->members()[tileY * numTiles.x + tileX] = tileData;
+			}
+		}
+		
+		channels->members()[*it] = channelTiles;
+	}
+	
+	return result;
+}
+
 template<typename BaseType>
 void ImagePrimitiveSource<BaseType>::compute( Gaffer::ValuePlug *output, const Gaffer::Context *context ) const
 {
-	if( output == imagePrimitivePlug() )
+	if( output == tilesPlug() )
 	{
+		// we convert to tiles up front, and don't keep hold of the
+		// image itself, so the image needn't exist twice in memory
+		// once we're done.
 		IECore::ConstImagePrimitivePtr image = computeImagePrimitive( context );
 		Gaffer::ObjectPlug *plug = static_cast<Gaffer::ObjectPlug *>( output );
 		if( image )
 		{
-			plug->setValue( image );
+			plug->setValue( tiles( image.get() ) );
 		}
 		else
 		{
@@ -173,15 +260,14 @@ void ImagePrimitiveSource<BaseType>::compute( Gaffer::ValuePlug *output, const G
 template<typename BaseType>
 GafferImage::Format ImagePrimitiveSource<BaseType>::computeFormat( const Gaffer::Context *context, const ImagePlug *parent ) const
 {
-	Imath::Box2i result;
-	IECore::ConstImagePrimitivePtr image = IECore::runTimeCast<const IECore::ImagePrimitive>( inputImagePrimitivePlug()->getValue() );
-	if( image )
+	IECore::ConstCompoundObjectPtr tiles = inputTiles();
+	if( tiles )
 	{
 		/// \todo Stop ignoring the origin - just return the display window as-is,
 		/// then use the space conversion methods in Format to implement computeDataWindow()
 		/// and computeChannelData() appropriately.
-		result = image->getDisplayWindow();
-		return GafferImage::Format( result.size().x+1, result.size().y+1 );
+		const Imath::Box2i &displayWindow = tiles->member<IECore::Box2iData>( "displayWindow" )->readable();
+		return GafferImage::Format( displayWindow.size().x+1, displayWindow.size().y+1 );
 	}
 	return GafferImage::Format();
 }
@@ -189,79 +275,61 @@ GafferImage::Format ImagePrimitiveSource<BaseType>::computeFormat( const Gaffer:
 template<typename BaseType>
 Imath::Box2i ImagePrimitiveSource<BaseType>::computeDataWindow( const Gaffer::Context *context, const ImagePlug *parent ) const
 {
-	Imath::Box2i result;
-	IECore::ConstImagePrimitivePtr image = IECore::runTimeCast<const IECore::ImagePrimitive>( inputImagePrimitivePlug()->getValue() );
-	if( image )
+	IECore::ConstCompoundObjectPtr tiles = inputTiles();
+	if( tiles )
 	{
-		Imath::Box2i displayWindow = image->getDisplayWindow();
-		result = image->getDataWindow();
-		const int yOffset = displayWindow.min.y + ( displayWindow.size().y + 1 ) - result.min.y;
-		result.min.y = yOffset - ( result.size().y + 1 );
-		result.max.y = yOffset - 1;
+		return tiles->member<IECore::Box2iData>( "dataWindow" )->readable();
 	}
-	return result;
+	return Imath::Box2i();
 }
 
 template<typename BaseType>
 IECore::ConstStringVectorDataPtr ImagePrimitiveSource<BaseType>::computeChannelNames( const Gaffer::Context *context, const ImagePlug *parent ) const
 {
-	IECore::StringVectorDataPtr result = new IECore::StringVectorData();
-	IECore::ConstImagePrimitivePtr image = IECore::runTimeCast<const IECore::ImagePrimitive>( inputImagePrimitivePlug()->getValue() );
-	if( image )
-	{
-		image->channelNames( result->writable() );
-	}
-	else
+	IECore::ConstCompoundObjectPtr tiles = inputTiles();
+	if( tiles )
 	{
-		std::vector<std::string> &channelStrVector( result->writable() );
-		channelStrVector.push_back("R");
-		channelStrVector.push_back("G");
-		channelStrVector.push_back("B");
+		return tiles->member<IECore::StringVectorData>( "channelNames" );
 	}
 	
+	IECore::StringVectorDataPtr result = new IECore::StringVectorData();
+	std::vector<std::string> &channelStrVector( result->writable() );
+	channelStrVector.push_back("R");
+	channelStrVector.push_back("G");
+	channelStrVector.push_back("B");
+	
 	return result;
 }
 
 template<typename BaseType>
 IECore::ConstFloatVectorDataPtr ImagePrimitiveSource<BaseType>::computeChannelData( const std::string &channelName, const Imath::V2i &tileOrigin, const Gaffer::Context *context, const ImagePlug *parent ) const
 {
-	IECore::ConstImagePrimitivePtr image = IECore::runTimeCast<const IECore::ImagePrimitive>( inputImagePrimitivePlug()->getValue() );
-	if( !image )
+	IECore::ConstCompoundObjectPtr tiles = inputTiles();
+	if( !tiles )
 	{
 		return ImagePlug::blackTile();
 	}
 	
-	IECore::ConstFloatVectorDataPtr channelData = image->getChannel<float>( channelName );
-	if( !channelData )
+	const IECore::ObjectVector *channelTiles = tiles->member<IECore::CompoundObject>( "channels" )->member<IECore::ObjectVector>( channelName );
+	if( !channelTiles )
 	{
 		return ImagePlug::blackTile();
 	}
-	const std::vector<float> &channel = channelData->readable();
-	
-	IECore::FloatVectorDataPtr resultData = new IECore::FloatVectorData;
-	std::vector<float> &result = resultData->writable();
-	result.resize( ImagePlug::tileSize() * ImagePlug::tileSize(), 0.0f );
-	
-	Imath::Box2i displayWindow = image->getDisplayWindow();
-	Imath::Box2i dataWindow = image->getDataWindow();
-	const int yOffset = displayWindow.min.y + ( displayWindow.size().y + 1 ) - dataWindow.min.y;
-	dataWindow.min.y = yOffset - ( dataWindow.size().y + 1 );
-	dataWindow.max.y = yOffset - 1;
-	Imath::Box2i tileBound( tileOrigin, tileOrigin + Imath::V2i( GafferImage::ImagePlug::tileSize() - 1 ) );
-	Imath::Box2i bound = IECore::boxIntersection( tileBound, dataWindow );
 	
-	for( int y = bound.min.y; y<=bound.max.y; y++ )
+	const Imath::Box2i &dataWindow = tiles->member<IECore::Box2iData>( "dataWindow" )->readable();
+	const Imath::V2i minTileOrigin = ImagePlug::tileOrigin( dataWindow.min );
+	const Imath::V2i numTiles = ( ImagePlug::tileOrigin( dataWindow.max ) - minTileOrigin ) / ImagePlug::tileSize() + Imath::V2i( 1 );
+	const Imath::V2i tileIndex = ( tileOrigin - minTileOrigin ) / ImagePlug::tileSize();
+	if(
+		tileOrigin.x < minTileOrigin.x || tileOrigin.y < minTileOrigin.y ||
+		tileIndex.x >= numTiles.x || tileIndex.y >= numTiles.y
+	)
 	{
-		size_t srcIndex = ( dataWindow.size().y - ( y - dataWindow.min.y ) ) * ( dataWindow.size().x + 1 ) + bound.min.x - dataWindow.min.x;
-		size_t dstIndex = ( y - tileBound.min.y ) * GafferImage::ImagePlug::tileSize() + bound.min.x - tileBound.min.x;
-		const size_t srcEndIndex = srcIndex + bound.size().x;
-		while( srcIndex <= srcEndIndex )
-		{
-			result[dstIndex++] = channel[srcIndex++];
-		}
+		return ImagePlug::blackTile();
 	}
 	
-	return resultData;
+	// the tile is output as-is, shared with our store rather than copied.
+	return IECore::staticPointerCast<const IECore::FloatVectorData>( channelTiles->members()[tileIndex.y * numTiles.x + tileIndex.x] );
 }
 
 } // namespace GafferImage
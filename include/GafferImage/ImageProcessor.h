@@ -61,14 +61,24 @@ class ImageProcessor : public ImageNode
 		
 		virtual Gaffer::Plug *correspondingInput( const Gaffer::Plug *output );
 		virtual const Gaffer::Plug *correspondingInput( const Gaffer::Plug *output ) const;
+		
+		virtual void affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const;
 
 	protected :
 	
-		/// Reimplemented to pass through the hashes of the inPlug() when the node is disabled.
+		/// Reimplemented to pass through the hashes of the inPlug() when the node is disabled,
+		/// and to skip the tiles outside the data window when passesThroughDataWindow() is true.
 		virtual void hash( const Gaffer::ValuePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;	
 		/// Reimplemented from ImageNode to pass through the inPlug() computations when the node is disabled.
 		virtual void compute( Gaffer::ValuePlug *output, const Gaffer::Context *context ) const;
 		
+		/// May be reimplemented to return true by derived classes whose output data window is always
+		/// that of the inPlug(). Tiles which lie entirely outside the input data window are then output
+		/// as ImagePlug::blackTile() without calling hashChannelData() or computeChannelData(). The
+		/// default implementation returns false, so that other nodes needn't evaluate a data window
+		/// every time a tile is hashed.
+		virtual bool passesThroughDataWindow() const;
+		
 	private :
 	
 		static size_t g_firstPlugIndex;
@@ -38,6 +38,8 @@
 #ifndef GAFFERSCENE_IMAGEREADER_H
 #define GAFFERSCENE_IMAGEREADER_H
 
+#include "IECore/CompoundData.h"
+
 #include "GafferImage/ImageNode.h"
 
 namespace GafferImage
@@ -66,6 +68,36 @@ class ImageReader : public ImageNode
 		
 		static size_t supportedExtensions( std::vector<std::string> &extensions );
 		
+		/// Loads the image into the cache for each of the frames from startFrame
+		/// to endFrame inclusive, so that subsequent computes needn't wait for file
+		/// I/O. The fileName is evaluated in a copy of the current Context for each
+		/// frame. The region is specified in the pixel space of the ImagePlug, and
+		/// an empty region prefetches the entire data window.
+		void prefetch( int startFrame, int endFrame, const Imath::Box2i &region = Imath::Box2i() ) const;
+		
+		/// @name Cache management
+		/// All ImageReaders share a single OpenImageIO ImageCache,
+		/// which may be configured using these methods. Changes to
+		/// the tiling options only apply to files opened subsequently.
+		////////////////////////////////////////////////////////////
+		//@{
+		static size_t getCacheMemoryLimit();
+		static void setCacheMemoryLimit( size_t bytes );
+		static int getCacheFileHandleLimit();
+		static void setCacheFileHandleLimit( int fileHandles );
+		/// The tile size used for files which aren't tiled
+		/// natively, or 0 to load such files in their entirety.
+		static int getCacheAutoTile();
+		static void setCacheAutoTile( int tileSize );
+		/// Whether or not mipmaps are generated on demand for
+		/// files which don't contain them.
+		static bool getCacheAutoMip();
+		static void setCacheAutoMip( bool autoMip );
+		/// Returns statistics for the cache, including "hitRate",
+		/// "bytesRead", "memoryUsage" and "openFiles".
+		static IECore::CompoundDataPtr cacheStatistics();
+		//@}
+		
 	protected :
 		
 		virtual void hashFormat( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
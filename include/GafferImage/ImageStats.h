@@ -39,7 +39,9 @@
 
 #include "Gaffer/ComputeNode.h"
 #include "Gaffer/CompoundNumericPlug.h"
+#include "Gaffer/CompoundPlug.h"
 #include "Gaffer/BoxPlug.h"
+#include "Gaffer/TypedObjectPlug.h"
 
 #include "GafferImage/ImagePlug.h"
 #include "GafferImage/ChannelMaskPlug.h"
@@ -49,6 +51,10 @@ namespace GafferImage
 
 /// Provides statistics on an image's colour profile. 
 /// The ImageStats node outputs the minimum, maximum and average values of the pixel values within a region of interest in the image.
+/// It also outputs the positions of the minimum and maximum pixels, a histogram of the pixel values and the value at a
+/// given percentile. The statistics for each channel are gathered by a single parallel pass over the tiles of the region
+/// of interest, and are shared by all the outputs for that channel. The percentile is only computed on demand, as it
+/// requires all the pixel values to be gathered and partially sorted.
 class ImageStats : public Gaffer::ComputeNode
 {
 
@@ -73,6 +79,30 @@ class ImageStats : public Gaffer::ComputeNode
 		const Gaffer::Color4fPlug *minPlug() const;
 		Gaffer::Color4fPlug *maxPlug();
 		const Gaffer::Color4fPlug *maxPlug() const;
+		/// The number of bins in the histogram.
+		Gaffer::IntPlug *histogramBinsPlug();
+		const Gaffer::IntPlug *histogramBinsPlug() const;
+		/// The range of values covered by the histogram. Values outside
+		/// the range are counted in the first or last bin.
+		Gaffer::V2fPlug *histogramRangePlug();
+		const Gaffer::V2fPlug *histogramRangePlug() const;
+		/// The percentile, in the range 0-1, for which percentileValuePlug()
+		/// is computed.
+		Gaffer::FloatPlug *percentilePlug();
+		const Gaffer::FloatPlug *percentilePlug() const;
+		/// Has a V2iPlug child for each of "r", "g", "b" and "a", holding the
+		/// position of the first pixel with the minimum value, ordered by y and then x.
+		Gaffer::CompoundPlug *minPositionPlug();
+		const Gaffer::CompoundPlug *minPositionPlug() const;
+		/// As above, but for the maximum value.
+		Gaffer::CompoundPlug *maxPositionPlug();
+		const Gaffer::CompoundPlug *maxPositionPlug() const;
+		/// Has an IntVectorDataPlug child for each of "r", "g", "b" and "a",
+		/// holding the pixel count for each bin of the histogram.
+		Gaffer::CompoundPlug *histogramPlug();
+		const Gaffer::CompoundPlug *histogramPlug() const;
+		Gaffer::Color4fPlug *percentileValuePlug();
+		const Gaffer::Color4fPlug *percentileValuePlug() const;
 
 	protected :
 	
@@ -84,16 +114,30 @@ class ImageStats : public Gaffer::ComputeNode
 
 	private :
 		
+		/// Used to store the statistics gathered for the channel specified
+		/// by the context, so they can be shared by all the outputs.
+		Gaffer::ObjectPlug *channelStatisticsPlug();
+		const Gaffer::ObjectPlug *channelStatisticsPlug() const;
+		
 		void inputChanged( Gaffer::Plug *plug );
 
+		/// Returns the index of the channel which corresponds to the output plug,
+		/// or -1 if output is not one of the statistics outputs.
+		int outputChannelIndex( const Gaffer::ValuePlug *output ) const;
+		
 		/// Sets channelName to the channel which corresponds to the output plug. The channel name is
 		/// computed from the intersection of the "in" plug's channels and the "channels" plug's channels.
 		/// If multiple channels are found to have the same channel index, the first is used.
 		/// For more information on this, please see ChannelMaskPlug::removeDuplicateIndices().
 		void channelNameFromOutput( const Gaffer::ValuePlug *output, std::string &channelName ) const;
 
-		/// A convenience function to just set the plug to 0 or 1 depending on what it's index is.
-		void setOutputToDefault( Gaffer::FloatPlug *output ) const;
+		/// A convenience function to set the plug to its default value, which is 1 for alpha
+		/// and 0 for the other channels in the case of the colour outputs.
+		void setOutputToDefault( Gaffer::ValuePlug *output ) const;
+		
+		void hashChannelStatistics( const Gaffer::Context *context, IECore::MurmurHash &h ) const;
+		IECore::ConstObjectPtr computeChannelStatistics( const Imath::Box2i &regionOfInterest ) const;
+		float computePercentile( const Imath::Box2i &regionOfInterest ) const;
 		
 		/// Implemented to initialize the default format settings if they don't exist already.
 		void parentChanging( Gaffer::GraphComponent *newParent );
@@ -38,6 +38,7 @@
 #define GAFFERIMAGE_MERGE_H
 
 #include "GafferImage/FilterProcessor.h"
+#include "GafferImage/SIMDFloat.h"
 
 namespace GafferImage
 {
@@ -101,12 +102,20 @@ class Merge : public FilterProcessor
 	
 		/// This implementation checks that each of the inputs is connected and if not, returns false.
 		virtual bool enabled() const;
+		/// Returns false, so that merges are stored at full precision.
+		virtual bool halfStorageEnabled( const std::string &channel ) const;
 	
 	private :
 		
-		/// Performs the merge operation using the functor 'F'.
+		/// Performs the merge operation using the functor 'F', which must provide an
+		/// operator() templated on the value type, so that it may be applied to both
+		/// float and Detail::SIMDFloat.
 		template< typename F >
-		IECore::ConstFloatVectorDataPtr doMergeOperation( F f, std::vector< IECore::ConstFloatVectorDataPtr > &inData, std::vector< IECore::ConstFloatVectorDataPtr > &inAlpha, const Imath::V2i &tileOrigin ) const;
+		IECore::ConstFloatVectorDataPtr doMergeOperation( F f, std::vector< IECore::ConstFloatVectorDataPtr > &inData, std::vector< IECore::ConstFloatVectorDataPtr > &inAlpha ) const;
+		/// Used by doMergeOperation() to compute the result in constant time when all the
+		/// inputs are constant tiles. Returns NULL if any input is not constant.
+		template< typename F >
+		IECore::ConstFloatVectorDataPtr doConstantMergeOperation( F f, std::vector< IECore::ConstFloatVectorDataPtr > &inData, std::vector< IECore::ConstFloatVectorDataPtr > &inAlpha ) const;
 
 		/// A useful method which returns true if the StringVector contains the channel "A".
 		inline bool hasAlpha( IECore::ConstStringVectorDataPtr channelNamesData ) const;
@@ -34,43 +34,123 @@
 //  
 //////////////////////////////////////////////////////////////////////////
 
-template< typename F >
-IECore::ConstFloatVectorDataPtr Merge::doMergeOperation( F f, std::vector< IECore::ConstFloatVectorDataPtr > &inData, std::vector< IECore::ConstFloatVectorDataPtr > &inAlpha, const Imath::V2i &tileOrigin ) const
+namespace Detail
 {
-	// Allocate the new tile
-	Imath::Box2i tile( tileOrigin, Imath::V2i( tileOrigin.x + ImagePlug::tileSize() - 1, tileOrigin.y + ImagePlug::tileSize() - 1 ) );
-	IECore::FloatVectorDataPtr outDataPtr = inData.back()->copy();
-	std::vector<float> &outData = outDataPtr->writable();
 
-	// Allocate a temporary tile that will hold the intermediate values of the alpha channel.
-	IECore::FloatVectorDataPtr aOut = inAlpha.back()->copy();
-	std::vector<float> &outAlpha = aOut->writable();
+/// Merges the values at index i of each of the inputs, writing the
+/// result to out + i. T is either float or SIMDFloat, so that the same
+/// code provides both the vectorised kernel and the scalar loop for any
+/// remainder.
+template< typename T, typename F >
+inline void mergePixels( F f, const float * const *data, const float * const *alpha, int numInputs, int i, float *out )
+{
+	T A = load<T>( data[numInputs-1] + i );
+	T a = load<T>( alpha[numInputs-1] + i );
+	for( int j = numInputs - 2; j >= 0; --j )
+	{
+		const T B = load<T>( data[j] + i );
+		const T b = load<T>( alpha[j] + i );
+		A = f( A, B, a, b );
+		a = f( a, b, a, b );
+	}
+	store( A, out + i );
+}
+
+/// As above, but for when we are merging the alpha channel itself, in
+/// which case the data and the alpha are one and the same.
+template< typename T, typename F >
+inline void mergeAlphaPixels( F f, const float * const *alpha, int numInputs, int i, float *out )
+{
+	T a = load<T>( alpha[numInputs-1] + i );
+	for( int j = numInputs - 2; j >= 0; --j )
+	{
+		const T b = load<T>( alpha[j] + i );
+		a = f( a, b, a, b );
+	}
+	store( a, out + i );
+}
+
+} // namespace Detail
+
+template< typename F >
+IECore::ConstFloatVectorDataPtr Merge::doConstantMergeOperation( F f, std::vector< IECore::ConstFloatVectorDataPtr > &inData, std::vector< IECore::ConstFloatVectorDataPtr > &inAlpha ) const
+{
+	float outValue, outAlpha;
+	if( !ImagePlug::isConstantTile( inData.back().get(), outValue ) || !ImagePlug::isConstantTile( inAlpha.back().get(), outAlpha ) )
+	{
+		return NULL;
+	}
 	
-	// Perform the operation.
-	unsigned int nIterations( inData.size() -1 );
-	for( unsigned int i = nIterations; i > 0; --i )
+	for( unsigned int i = inData.size() - 1; i > 0; --i )
 	{
-		for( int y = tile.min.y; y<=tile.max.y; y++ )
+		float value, alpha;
+		if( !ImagePlug::isConstantTile( inData[i-1].get(), value ) || !ImagePlug::isConstantTile( inAlpha[i-1].get(), alpha ) )
 		{
-			// Compute the data values and afterwards, the intermediate alpha values.
-			const float *dIn1 = &(outData[0]) + ( y - tileOrigin.y ) * ImagePlug::tileSize() + (tile.min.x - tileOrigin.x);
-			const float *dIn2 = &(inData[i-1]->readable()[0]) + (y - tileOrigin.y) * ImagePlug::tileSize() + (tile.min.x - tileOrigin.x);	
-			const float *aIn1 = &(outAlpha[0]) + ( y - tileOrigin.y ) * ImagePlug::tileSize() + (tile.min.x - tileOrigin.x);
-			const float *aIn2 = &(inAlpha[i-1]->readable()[0]) + (y - tileOrigin.y) * ImagePlug::tileSize() + (tile.min.x - tileOrigin.x);
+			return NULL;
+		}
+		outValue = f( outValue, value, outAlpha, alpha );
+		outAlpha = f( outAlpha, alpha, outAlpha, alpha );
+	}
+	
+	return ImagePlug::constantTile( outValue );
+}
 
-			float *dOut = &(outData[0]) + ( y - tileOrigin.y ) * ImagePlug::tileSize() + (tile.min.x - tileOrigin.x);
-			float *aOut = &(outAlpha[0]) + ( y - tileOrigin.y ) * ImagePlug::tileSize() + (tile.min.x - tileOrigin.x);
+template< typename F >
+IECore::ConstFloatVectorDataPtr Merge::doMergeOperation( F f, std::vector< IECore::ConstFloatVectorDataPtr > &inData, std::vector< IECore::ConstFloatVectorDataPtr > &inAlpha ) const
+{
+	// If all the inputs are constant then so is the output, and we need
+	// only compute a single pixel.
+	IECore::ConstFloatVectorDataPtr constantResult = doConstantMergeOperation( f, inData, inAlpha );
+	if( constantResult )
+	{
+		return constantResult;
+	}
 
-			const float *END = dOut+(tile.max.x-tile.min.x)+1;
-			while( dOut != END )
-			{
-				*dOut++ = f( *dIn1++, *dIn2++, *aIn1, *aIn2 );
-				*aOut++ = f( *aIn1, *aIn2, *aIn1, *aIn2 );
-				++aIn1;
-				++aIn2;
-			}	
+	// Get pointers to all the input data, so we can merge all the inputs
+	// in a single pass without needing any intermediate tiles.
+	const int numInputs = inData.size();
+	std::vector<const float *> data( numInputs );
+	std::vector<const float *> alpha( numInputs );
+	bool mergingAlpha = true;
+	for( int i = 0; i < numInputs; ++i )
+	{
+		data[i] = &(inData[i]->readable()[0]);
+		alpha[i] = &(inAlpha[i]->readable()[0]);
+		mergingAlpha = mergingAlpha && data[i] == alpha[i];
+	}
+	
+	// Allocate the new tile.
+	const int numPixels = ImagePlug::tileSize() * ImagePlug::tileSize();
+	IECore::FloatVectorDataPtr outDataPtr = ImagePlug::allocateTile();
+	std::vector<float> &outData = outDataPtr->writable();
+	float *out = &(outData[0]);
+	
+	// Perform the operation, SIMDFloat::width pixels at a time, and
+	// then one at a time for any remainder.
+	typedef Detail::SIMDFloat V;
+	int i = 0;
+	if( mergingAlpha )
+	{
+		for( ; i <= numPixels - V::width; i += V::width )
+		{
+			Detail::mergeAlphaPixels<V>( f, &(alpha[0]), numInputs, i, out );
+		}
+		for( ; i < numPixels; ++i )
+		{
+			Detail::mergeAlphaPixels<float>( f, &(alpha[0]), numInputs, i, out );
+		}
+	}
+	else
+	{
+		for( ; i <= numPixels - V::width; i += V::width )
+		{
+			Detail::mergePixels<V>( f, &(data[0]), &(alpha[0]), numInputs, i, out );
+		}
+		for( ; i < numPixels; ++i )
+		{
+			Detail::mergePixels<float>( f, &(data[0]), &(alpha[0]), numInputs, i, out );
 		}
 	}
+	
 	return outDataPtr;
 }
-
@@ -59,6 +59,13 @@ class OpenColorIO : public ColorProcessor
 		Gaffer::StringPlug *outputSpacePlug();
 		const Gaffer::StringPlug *outputSpacePlug() const;
 
+		/// When on, the transform is approximated by a 3D LUT, indexed via a shaper
+		/// built from the allocation of the input space in the OpenColorIO config. This
+		/// is much quicker for complex transforms, at the expense of some accuracy,
+		/// particularly for values outside the allocation range of the input space.
+		Gaffer::BoolPlug *bakeLUTPlug();
+		const Gaffer::BoolPlug *bakeLUTPlug() const;
+
 	protected :
 
 		/// Overrides the default implementation to disable the node when the input color space is
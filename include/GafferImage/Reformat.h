@@ -68,6 +68,9 @@ class Reformat : public ImageProcessor
 				
 	protected :
 		
+		virtual void hash( const Gaffer::ValuePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
+		virtual void compute( Gaffer::ValuePlug *output, const Gaffer::Context *context ) const;
+
 		virtual void hashFormat( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
 		virtual void hashChannelNames( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
 		virtual void hashDataWindow( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
@@ -78,10 +81,13 @@ class Reformat : public ImageProcessor
 		virtual IECore::ConstStringVectorDataPtr computeChannelNames( const Gaffer::Context *context, const ImagePlug *parent ) const;
 
 		/// Reformats the input plug with a filter by doing a 2-pass squash/stretch.
-		/// We reformat the image by doing two passes over the input in first the horizontal and then vertical directions.
-		/// On each pass we use the chosen filter to create a (row or column) buffer of pixels their weighted contributeion to each pixel on the row or column.
-		/// Using this column/row buffer we iterate over the input and sum the contributing pixels. The result is normalized by the sum of weights.
-		/// This process is repeated once for the vertical and horizontal passes and the final result is written into the output buffer.
+		/// We precompute a table of the taps and normalised weights of the chosen filter for each column and each row
+		/// of the output tile, and then use Sampler::sampleGrid() to convolve the input first horizontally and then
+		/// vertically, writing the final result into the output buffer. The weights for a column of tiles are the
+		/// same for every tile in it, and likewise for a row, so the tables are computed once per column and row
+		/// and cached. When the scale is an integer factor the weights are periodic, so only a single period is
+		/// computed, and box filtered downsampling by integer factors is done by simply averaging blocks of input
+		/// pixels.
 		virtual IECore::ConstFloatVectorDataPtr computeChannelData( const std::string &channelName, const Imath::V2i &tileOrigin, const Gaffer::Context *context, const ImagePlug *parent ) const;
 		
 		// Computes the output scale factor from the input and output formats.
@@ -89,6 +95,15 @@ class Reformat : public ImageProcessor
 
 	private :
 
+		// The tables of filter weights for the columns and rows of an output tile,
+		// evaluated with the tile origin in the context. The x weights depend only
+		// on the x coordinate of the tile origin, and the y weights only on the y
+		// coordinate, so they are shared between all the tiles in a column or row.
+		Gaffer::ObjectPlug *xWeightsPlug();
+		const Gaffer::ObjectPlug *xWeightsPlug() const;
+		Gaffer::ObjectPlug *yWeightsPlug();
+		const Gaffer::ObjectPlug *yWeightsPlug() const;
+
 		static size_t g_firstPlugIndex;
 		
 };
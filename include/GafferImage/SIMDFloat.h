@@ -0,0 +1,317 @@
+//////////////////////////////////////////////////////////////////////////
+//  
+//  Copyright (c) 2014, Image Engine Design Inc. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//  
+//      * Redistributions of source code must retain the above
+//        copyright notice, this list of conditions and the following
+//        disclaimer.
+//  
+//      * Redistributions in binary form must reproduce the above
+//        copyright notice, this list of conditions and the following
+//        disclaimer in the documentation and/or other materials provided with
+//        the distribution.
+//  
+//      * Neither the name of John Haddon nor the names of
+//        any other contributors to this software may be used to endorse or
+//        promote products derived from this software without specific prior
+//        written permission.
+//  
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef GAFFERIMAGE_SIMDFLOAT_H
+#define GAFFERIMAGE_SIMDFLOAT_H
+
+#include <cmath>
+
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#elif defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+namespace GafferImage
+{
+
+namespace Detail
+{
+
+/// A minimal wrapper around the widest floating point SIMD register type
+/// available at compile time - AVX2 if the build enables it, SSE2 otherwise,
+/// and a plain float on other architectures. This allows image kernels to
+/// be written once, as loops over ImagePlug tiles in steps of
+/// SIMDFloat::width, with the arithmetic expressed using ordinary operators.
+/// Kernels must process any remainder of width with plain floats.
+class SIMDFloat
+{
+
+	public :
+
+#if defined( __AVX2__ )
+		typedef __m256 Native;
+		enum { width = 8 };
+#elif defined( __SSE2__ )
+		typedef __m128 Native;
+		enum { width = 4 };
+#else
+		typedef float Native;
+		enum { width = 1 };
+#endif
+
+		SIMDFloat()
+		{
+		}
+
+		/// Sets all elements to f.
+		SIMDFloat( float f )
+		{
+#if defined( __AVX2__ )
+			m_v = _mm256_set1_ps( f );
+#elif defined( __SSE2__ )
+			m_v = _mm_set1_ps( f );
+#else
+			m_v = f;
+#endif
+		}
+
+		static SIMDFloat fromNative( Native v )
+		{
+			SIMDFloat result;
+			result.m_v = v;
+			return result;
+		}
+
+		const Native &native() const
+		{
+			return m_v;
+		}
+
+		/// Loads width consecutive values from p, which
+		/// needn't be aligned.
+		static SIMDFloat load( const float *p )
+		{
+#if defined( __AVX2__ )
+			return fromNative( _mm256_loadu_ps( p ) );
+#elif defined( __SSE2__ )
+			return fromNative( _mm_loadu_ps( p ) );
+#else
+			return fromNative( *p );
+#endif
+		}
+
+		/// Stores width consecutive values to p, which
+		/// needn't be aligned.
+		void store( float *p ) const
+		{
+#if defined( __AVX2__ )
+			_mm256_storeu_ps( p, m_v );
+#elif defined( __SSE2__ )
+			_mm_storeu_ps( p, m_v );
+#else
+			*p = m_v;
+#endif
+		}
+
+	private :
+
+		Native m_v;
+
+};
+
+#if defined( __AVX2__ )
+
+inline SIMDFloat operator + ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm256_add_ps( a.native(), b.native() ) ); }
+inline SIMDFloat operator - ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm256_sub_ps( a.native(), b.native() ) ); }
+inline SIMDFloat operator * ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm256_mul_ps( a.native(), b.native() ) ); }
+inline SIMDFloat operator / ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm256_div_ps( a.native(), b.native() ) ); }
+inline SIMDFloat min( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm256_min_ps( a.native(), b.native() ) ); }
+inline SIMDFloat max( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm256_max_ps( a.native(), b.native() ) ); }
+inline SIMDFloat operator < ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm256_cmp_ps( a.native(), b.native(), _CMP_LT_OQ ) ); }
+inline SIMDFloat operator > ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm256_cmp_ps( a.native(), b.native(), _CMP_GT_OQ ) ); }
+inline SIMDFloat select( const SIMDFloat &mask, const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm256_blendv_ps( b.native(), a.native(), mask.native() ) ); }
+inline SIMDFloat floor( const SIMDFloat &x ) { return SIMDFloat::fromNative( _mm256_floor_ps( x.native() ) ); }
+
+inline SIMDFloat frexp( const SIMDFloat &x, SIMDFloat &exponent )
+{
+	const __m256i bits = _mm256_castps_si256( x.native() );
+	const __m256i e = _mm256_sub_epi32( _mm256_srli_epi32( bits, 23 ), _mm256_set1_epi32( 126 ) );
+	exponent = SIMDFloat::fromNative( _mm256_cvtepi32_ps( e ) );
+	const __m256i m = _mm256_or_si256( _mm256_and_si256( bits, _mm256_set1_epi32( 0x807fffff ) ), _mm256_set1_epi32( 0x3f000000 ) );
+	return SIMDFloat::fromNative( _mm256_castsi256_ps( m ) );
+}
+
+inline SIMDFloat ldexp( const SIMDFloat &x, const SIMDFloat &exponent )
+{
+	const __m256i e = _mm256_add_epi32( _mm256_cvtps_epi32( exponent.native() ), _mm256_set1_epi32( 127 ) );
+	return x * SIMDFloat::fromNative( _mm256_castsi256_ps( _mm256_slli_epi32( e, 23 ) ) );
+}
+
+#elif defined( __SSE2__ )
+
+inline SIMDFloat operator + ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm_add_ps( a.native(), b.native() ) ); }
+inline SIMDFloat operator - ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm_sub_ps( a.native(), b.native() ) ); }
+inline SIMDFloat operator * ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm_mul_ps( a.native(), b.native() ) ); }
+inline SIMDFloat operator / ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm_div_ps( a.native(), b.native() ) ); }
+inline SIMDFloat min( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm_min_ps( a.native(), b.native() ) ); }
+inline SIMDFloat max( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm_max_ps( a.native(), b.native() ) ); }
+inline SIMDFloat operator < ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm_cmplt_ps( a.native(), b.native() ) ); }
+inline SIMDFloat operator > ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm_cmpgt_ps( a.native(), b.native() ) ); }
+inline SIMDFloat select( const SIMDFloat &mask, const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( _mm_or_ps( _mm_and_ps( mask.native(), a.native() ), _mm_andnot_ps( mask.native(), b.native() ) ) ); }
+
+inline SIMDFloat floor( const SIMDFloat &x )
+{
+	// SSE2 has no floor instruction, so we truncate and then
+	// subtract one where that rounded upwards.
+	const __m128 t = _mm_cvtepi32_ps( _mm_cvttps_epi32( x.native() ) );
+	return SIMDFloat::fromNative( _mm_sub_ps( t, _mm_and_ps( _mm_cmpgt_ps( t, x.native() ), _mm_set1_ps( 1.0f ) ) ) );
+}
+
+inline SIMDFloat frexp( const SIMDFloat &x, SIMDFloat &exponent )
+{
+	const __m128i bits = _mm_castps_si128( x.native() );
+	const __m128i e = _mm_sub_epi32( _mm_srli_epi32( bits, 23 ), _mm_set1_epi32( 126 ) );
+	exponent = SIMDFloat::fromNative( _mm_cvtepi32_ps( e ) );
+	const __m128i m = _mm_or_si128( _mm_and_si128( bits, _mm_set1_epi32( 0x807fffff ) ), _mm_set1_epi32( 0x3f000000 ) );
+	return SIMDFloat::fromNative( _mm_castsi128_ps( m ) );
+}
+
+inline SIMDFloat ldexp( const SIMDFloat &x, const SIMDFloat &exponent )
+{
+	const __m128i e = _mm_add_epi32( _mm_cvtps_epi32( exponent.native() ), _mm_set1_epi32( 127 ) );
+	return x * SIMDFloat::fromNative( _mm_castsi128_ps( _mm_slli_epi32( e, 23 ) ) );
+}
+
+#else
+
+inline SIMDFloat operator + ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( a.native() + b.native() ); }
+inline SIMDFloat operator - ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( a.native() - b.native() ); }
+inline SIMDFloat operator * ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( a.native() * b.native() ); }
+inline SIMDFloat operator / ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( a.native() / b.native() ); }
+inline SIMDFloat min( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( a.native() < b.native() ? a.native() : b.native() ); }
+inline SIMDFloat max( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat::fromNative( a.native() > b.native() ? a.native() : b.native() ); }
+inline SIMDFloat operator < ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat( a.native() < b.native() ? 1.0f : 0.0f ); }
+inline SIMDFloat operator > ( const SIMDFloat &a, const SIMDFloat &b ) { return SIMDFloat( a.native() > b.native() ? 1.0f : 0.0f ); }
+inline SIMDFloat select( const SIMDFloat &mask, const SIMDFloat &a, const SIMDFloat &b ) { return mask.native() != 0.0f ? a : b; }
+inline SIMDFloat floor( const SIMDFloat &x ) { return SIMDFloat( std::floor( x.native() ) ); }
+
+inline SIMDFloat frexp( const SIMDFloat &x, SIMDFloat &exponent )
+{
+	int e;
+	const float m = std::frexp( x.native(), &e );
+	exponent = SIMDFloat( (float)e );
+	return SIMDFloat( m );
+}
+
+inline SIMDFloat ldexp( const SIMDFloat &x, const SIMDFloat &exponent )
+{
+	return SIMDFloat( std::ldexp( x.native(), (int)exponent.native() ) );
+}
+
+#endif
+
+/// Scalar equivalents of the functions above, and loads and stores,
+/// so that kernels templated on the value type may be used with plain
+/// floats too. Note that min( a, b ) and max( a, b ) return b if either
+/// argument is NaN, matching the behaviour of the SIMD instructions.
+inline float min( float a, float b ) { return a < b ? a : b; }
+inline float max( float a, float b ) { return a > b ? a : b; }
+inline float select( bool mask, float a, float b ) { return mask ? a : b; }
+inline float floor( float x ) { return std::floor( x ); }
+inline float frexp( float x, float &exponent ) { int e; const float m = std::frexp( x, &e ); exponent = (float)e; return m; }
+inline float ldexp( float x, float exponent ) { return std::ldexp( x, (int)exponent ); }
+
+template<typename T>
+T load( const float *p );
+
+template<>
+inline float load<float>( const float *p ) { return *p; }
+
+template<>
+inline SIMDFloat load<SIMDFloat>( const float *p ) { return SIMDFloat::load( p ); }
+
+inline void store( float v, float *p ) { *p = v; }
+inline void store( const SIMDFloat &v, float *p ) { v.store( p ); }
+
+/// Approximations to the natural logarithm and exponential, and to pow(),
+/// suitable for use with either float or SIMDFloat. These are based on the
+/// polynomial approximations from the Cephes library. fastPow() has a
+/// relative error of less than 1e-5 for results within the range of
+/// normalised floats. fastLog() and fastPow() require x to be positive and
+/// normalised - callers are responsible for dealing with zero, negative and
+/// denormalised values.
+template<typename T>
+inline T fastLog( const T &xIn )
+{
+	T e;
+	T x = frexp( xIn, e );
+	
+	// Shift the mantissa into the range [ sqrt( 0.5 ), sqrt( 2 ) ), and
+	// subtract one, giving us the argument to our polynomial.
+	e = select( x < T( 0.707106781186547524f ), e - T( 1.0f ), e );
+	x = select( x < T( 0.707106781186547524f ), x + x, x ) - T( 1.0f );
+	
+	const T z = x * x;
+	T y = T( 7.0376836292e-2f );
+	y = y * x - T( 1.1514610310e-1f );
+	y = y * x + T( 1.1676998740e-1f );
+	y = y * x - T( 1.2420140846e-1f );
+	y = y * x + T( 1.4249322787e-1f );
+	y = y * x - T( 1.6668057665e-1f );
+	y = y * x + T( 2.0000714765e-1f );
+	y = y * x - T( 2.4999993993e-1f );
+	y = y * x + T( 3.3333331174e-1f );
+	y = y * x * z;
+	
+	y = y - T( 2.12194440e-4f ) * e;
+	y = y - T( 0.5f ) * z;
+	return x + y + T( 0.693359375f ) * e;
+}
+
+template<typename T>
+inline T fastExp( const T &xIn )
+{
+	T x = min( T( 88.3762626647949f ), max( T( -88.3762626647949f ), xIn ) );
+	
+	// Express exp( x ) as exp( g ) * 2^n, with n integer.
+	const T n = floor( x * T( 1.44269504088896341f ) + T( 0.5f ) );
+	x = x - n * T( 0.693359375f );
+	x = x + n * T( 2.12194440e-4f );
+	
+	const T z = x * x;
+	T y = T( 1.9875691500e-4f );
+	y = y * x + T( 1.3981999507e-3f );
+	y = y * x + T( 8.3334519073e-3f );
+	y = y * x + T( 4.1665795894e-2f );
+	y = y * x + T( 1.6666665459e-1f );
+	y = y * x + T( 5.0000001201e-1f );
+	y = y * z + x + T( 1.0f );
+	
+	return ldexp( y, n );
+}
+
+template<typename T>
+inline T fastPow( const T &x, const T &y )
+{
+	return fastExp( y * fastLog( x ) );
+}
+
+} // namespace Detail
+
+} // namespace GafferImage
+
+#endif // GAFFERIMAGE_SIMDFLOAT_H
@@ -82,6 +82,19 @@ class Sampler
 		/// Sub-samples the image using a filter.
 		inline float sample( float x, float y );
 
+		/// Copies the pixels within region into buffer, row by row. The buffer
+		/// must have room for every pixel in the region. Pixels outside the sample
+		/// window are treated according to the bounding mode. Each tile is fetched
+		/// once and copied a span at a time, so this is much quicker than calling
+		/// sample( int, int ) for every pixel.
+		void sampleRegion( const Imath::Box2i &region, float *buffer );
+
+		/// Filters the image at the grid of positions described by xWeights and
+		/// yWeights, which would typically be computed using Filter::computeWeights().
+		/// The region covered by the kernels is fetched using sampleRegion() and then
+		/// convolved separably, writing xWeights.taps.size() results per row into buffer.
+		void sampleGrid( const Filter::Weights &xWeights, const Filter::Weights &yWeights, float *buffer );
+
 		/// Accumulates the hashes of the tiles that it accesses.
 		void hash( IECore::MurmurHash &h ) const;
 
@@ -94,6 +107,10 @@ class Sampler
 		/// @param tileIndex XY indices that can be used to access the colour value of point 'p' from tileData.
 		inline void cachedData( Imath::V2i p, const float *& tileData, Imath::V2i &tileOrigin, Imath::V2i &tileIndex );
 
+		/// Copies count pixels from row y, starting at x, into buffer. All the pixels
+		/// must lie within the sample window.
+		void copySpan( int x, int y, int count, float *buffer );
+
 		const ImagePlug *m_plug;
 		const std::string m_channelName;
 		Imath::Box2i m_sampleWindow;
@@ -105,6 +122,12 @@ class Sampler
 
 		BoundingMode m_boundingMode;
 		ConstFilterPtr m_filter;
+		bool m_boxFilter;
+
+		// Scratch space, reused between calls to avoid reallocation.
+		std::vector<float> m_filterWeights;
+		std::vector<float> m_regionBuffer;
+		std::vector<float> m_rowBuffer;
 
 };
 
@@ -48,47 +48,76 @@ Imath::Box2i Sampler::getSampleWindow() const
 float Sampler::sample( float x, float y )
 {
 	// Perform an early-out for the box filter.
-	if ( static_cast<GafferImage::TypeId>( m_filter->typeId() ) == GafferImage::BoxFilterTypeId )
+	if ( m_boxFilter )
 	{
 		return sample( IECore::fastFloatFloor( x ), IECore::fastFloatFloor( y ) );
 	}
 
-	// Otherwise do a filtered lookup.	
-	int tapX = m_filter->tap( x - m_cacheWindow.min.x );
+	// Otherwise do a filtered lookup.
 	const int width = m_filter->width();
-	float weightsX[width];
-	
+	if ( m_filterWeights.size() < size_t( width * 2 ) )
+	{
+		m_filterWeights.resize( width * 2 );
+	}
+	float *weightsX = &m_filterWeights[0];
+	float *weightsY = weightsX + width;
+
+	const int tapX = m_filter->tap( x - m_cacheWindow.min.x ) + m_cacheWindow.min.x;
+	const int tapY = m_filter->tap( y - m_cacheWindow.min.y ) + m_cacheWindow.min.y;
+
+	float weightedSumX = 0.;
+	float weightedSumY = 0.;
 	for ( int i = 0; i < width; ++i )
 	{
-		weightsX[i] = m_filter->weight( x, tapX+i+m_cacheWindow.min.x );
+		weightedSumX += weightsX[i] = m_filter->weight( x, tapX + i );
+		weightedSumY += weightsY[i] = m_filter->weight( y, tapY + i );
 	}
 
-	int tapY = m_filter->tap( y - m_cacheWindow.min.y );
-	const int height = m_filter->width();
-	float weightsY[height];
-	
-	for ( int i = 0; i < height; ++i )
+	const float weightedSum = weightedSumX * weightedSumY;
+	if ( weightedSum == 0. )
 	{
-		weightsY[i] = m_filter->weight( y, tapY+i+m_cacheWindow.min.y );
+		return 0.;
 	}
 
-	float weightedSum = 0.;
 	float colour = 0.f;
-	int absY = tapY + m_cacheWindow.min.y;
-	for ( int y = 0; y < height; ++y, ++absY )
+	const Imath::V2i tapMax( tapX + width - 1, tapY + width - 1 );
+	if (
+		tapX >= m_sampleWindow.min.x && tapMax.x <= m_sampleWindow.max.x &&
+		tapY >= m_sampleWindow.min.y && tapMax.y <= m_sampleWindow.max.y &&
+		ImagePlug::tileOrigin( Imath::V2i( tapX, tapY ) ) == ImagePlug::tileOrigin( tapMax )
+	)
+	{
+		// The whole kernel lies within a single tile of the sample window, so
+		// we can convolve directly from the tile data without any bounds checks.
+		const float *tileData;
+		Imath::V2i tileOrigin;
+		Imath::V2i tileIndex;
+		cachedData( Imath::V2i( tapX, tapY ), tileData, tileOrigin, tileIndex );
+		const float *row = tileData + tileIndex.y * ImagePlug::tileSize() + tileIndex.x;
+		for ( int y = 0; y < width; ++y, row += ImagePlug::tileSize() )
+		{
+			float rowColour = 0.f;
+			for ( int x = 0; x < width; ++x )
+			{
+				rowColour += row[x] * weightsX[x];
+			}
+			colour += rowColour * weightsY[y];
+		}
+	}
+	else
 	{
-		int absX = tapX + m_cacheWindow.min.x;
-		for ( int x = 0; x < width; ++x, ++absX )
+		for ( int y = 0; y < width; ++y )
 		{
-			float c = 0.;
-			float w = weightsX[x] * weightsY[y];		
-			c = sample( absX, absY );
-			weightedSum += w;
-			colour += c * w;
+			float rowColour = 0.f;
+			for ( int x = 0; x < width; ++x )
+			{
+				rowColour += sample( tapX + x, tapY + y ) * weightsX[x];
+			}
+			colour += rowColour * weightsY[y];
 		}
 	}
 
-	return weightedSum == 0 ? 0 : colour / weightedSum;
+	return colour / weightedSum;
 }
 
 float Sampler::sample( int x, int y )
@@ -87,6 +87,9 @@ enum TypeId
 	ImageContextVariablesTypeId = 110791,
 	ImageSwitchTypeId = 110792,
 	ImageSamplerTypeId = 110793,
+	SharedMemoryClientDisplayDriverTypeId = 110794,
+	AutoCropTypeId = 110795,
+	BlurTypeId = 110796,
 
 	LastTypeId = 110849
 };
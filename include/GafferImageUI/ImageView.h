@@ -60,6 +60,28 @@ IE_CORE_FORWARDDECLARE( ImageSampler )
 namespace GafferImageUI
 {
 
+namespace Detail
+{
+
+IE_CORE_FORWARDDECLARE( ImageViewGadget )
+
+} // namespace Detail
+
+/// Displays images, computing only the tiles which are visible in the
+/// viewport. Tiles are computed in parallel and displayed progressively
+/// as they complete, and are held in a tile-level display buffer so that
+/// only tiles whose hashes change are recomputed following an upstream
+/// edit. When the frame is changed, the frames ahead in the direction of
+/// playback are prefetched into the cache while the UI is otherwise idle,
+/// allowing subsequent playback in realtime.
+///
+/// Prefetching only warms the compute cache - it doesn't fill the display
+/// buffer, which holds the current frame alone. The display transform
+/// caches its processed colour data rather than its output tiles (see
+/// ColorProcessor), so prefetched frames are displayed by copying from the
+/// cache, without further processing. Prefetching happens on the UI thread,
+/// but in batches of a single tile per core between events, so that the UI
+/// remains responsive while it takes place.
 class ImageView : public GafferUI::View
 {
 
@@ -82,6 +104,15 @@ class ImageView : public GafferUI::View
 		/// Values should be names that exist in registeredDisplayTransforms().
 		Gaffer::StringPlug *displayTransformPlug();
 		const Gaffer::StringPlug *displayTransformPlug() const;
+		
+		/// The maximum number of frames to prefetch.
+		Gaffer::IntPlug *prefetchFramesPlug();
+		const Gaffer::IntPlug *prefetchFramesPlug() const;
+		
+		/// The maximum memory (in megabytes) to be occupied
+		/// by prefetched frames.
+		Gaffer::IntPlug *prefetchMemoryPlug();
+		const Gaffer::IntPlug *prefetchMemoryPlug() const;
 	
 		typedef boost::function<GafferImage::ImageProcessorPtr ()> DisplayTransformCreator;
 
@@ -102,6 +133,9 @@ class ImageView : public GafferUI::View
 		
 		virtual void update();
 		
+		virtual void contextChanged( const IECore::InternedString &name );
+		virtual void plugDirtied( const Gaffer::Plug *plug );
+		
 	private:
 
 		GafferImage::ImageStats *imageStatsNode();
@@ -121,9 +155,24 @@ class ImageView : public GafferUI::View
 		
 		void plugSet( Gaffer::Plug *plug );
 		void insertDisplayTransform();
+		void viewportChanged();
+		/// Computes a batch of tiles for the frames ahead of
+		/// the current one, returning true if there are more
+		/// to compute. Each batch is kept small, as it blocks
+		/// the UI thread while it is computed.
+		bool prefetch();
+		void resetPrefetch();
 
 		typedef std::map<std::string, GafferImage::ImageProcessorPtr> DisplayTransformMap;
 		DisplayTransformMap m_displayTransforms;
+		
+		Detail::ImageViewGadgetPtr m_imageViewGadget;
+		bool m_imageDirty;
+		
+		float m_frame;
+		int m_prefetchDirection;
+		int m_prefetchOffset;
+		size_t m_prefetchTileIndex;
 
 		int m_channelToView;
 		Imath::V2f m_mousePos;
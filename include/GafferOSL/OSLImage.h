@@ -40,6 +40,7 @@
 #include "GafferImage/ImageProcessor.h"
 
 #include "GafferOSL/TypeIds.h"
+#include "GafferOSL/OSLRenderer.h"
 
 namespace GafferOSL
 {
@@ -89,7 +90,37 @@ class OSLImage : public GafferImage::ImageProcessor
 		const Gaffer::ObjectPlug *shadingPlug() const;
 		
 		void hashShading( const Gaffer::Context *context, IECore::MurmurHash &h ) const;
+		// As above, but using a state hash and engine the caller has already obtained
+		// from the shader, so that hashChannelData() can reuse them.
+		void hashShading( const Gaffer::Context *context, const IECore::MurmurHash &stateHash, const OSLRenderer::ShadingEngine *engine, IECore::MurmurHash &h ) const;
 		IECore::ConstCompoundDataPtr computeShading( const Gaffer::Context *context ) const;
+		
+		// Returns the shading for the first tile of the data window, from which
+		// computeChannelNames() determines the channels the shader outputs.
+		IECore::ConstCompoundDataPtr firstTileShading( const Gaffer::Context *context ) const;
+		// Returns true if the channel must be shaded, and false if the input
+		// can be passed through. This is consistent with computeChannelNames(),
+		// so that every channel it adds is shaded.
+		bool shadesChannel( const std::string &channelName, const OSLRenderer::ShadingEngine *engine, const Gaffer::Context *context ) const;
+
+		// Running the shader for a single tile at a time means paying the setup costs of
+		// the ShadingEngine for every tile, and gives it too few points to shade efficiently.
+		// We therefore shade a whole batch of tiles at once using this plug, which is evaluated
+		// with the tile origin in the context set to the origin of the batch. The shadingPlug()
+		// then extracts the results for each individual tile, and it is those that are cached
+		// for use by computeChannelData(). Only one thread computes a given batch at a time -
+		// others requesting tiles from it meanwhile shade just their own tile instead.
+		Gaffer::ObjectPlug *batchShadingPlug();
+		const Gaffer::ObjectPlug *batchShadingPlug() const;
+		
+		void hashBatchShading( const Gaffer::Context *context, IECore::MurmurHash &h ) const;
+		IECore::ConstCompoundDataPtr computeBatchShading( const Gaffer::Context *context ) const;
+		
+		// Hashes the shader and the outputs it will compute, for use by both
+		// hashShading() and hashBatchShading().
+		void hashShadingState( const Gaffer::Context *context, const IECore::MurmurHash &stateHash, const OSLRenderer::ShadingEngine *engine, IECore::MurmurHash &h ) const;
+		// Shades all the points in the specified range of tile origins (inclusive).
+		IECore::ConstCompoundDataPtr shade( const Imath::Box2i &tiles, const Gaffer::Context *context ) const;
 
 		static size_t g_firstPlugIndex;
 					
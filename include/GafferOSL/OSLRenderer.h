@@ -36,6 +36,7 @@
 #define GAFFEROSL_OSLRENDERER_H
 
 #include <stack>
+#include <set>
 
 #include "OSL/oslexec.h"
 
@@ -132,16 +133,47 @@ class OSLRenderer : public IECore::Renderer
 
 				IE_CORE_DECLAREMEMBERPTR( ShadingEngine )
 		
+				typedef std::set<std::string> Outputs;
+		
 				IECore::CompoundDataPtr shade( const IECore::CompoundData *points ) const;
+				/// As above, but only executes the parts of the shading network needed
+				/// to compute the specified outputs. The result is guaranteed to contain
+				/// the requested outputs, but may also contain others.
+				IECore::CompoundDataPtr shade( const IECore::CompoundData *points, const Outputs &outputs ) const;
+				
+				/// Returns the names of all the outputs produced by the shading network.
+				/// These are determined by shading a single point when the ShadingEngine is
+				/// created, so networks which compute output names from varying data are
+				/// not supported.
+				const Outputs &outputs() const;
+				/// Returns the outputs that will be computed by a call to
+				/// shade( points, outputs ). This may be used to share the result
+				/// of a single call between several outputs.
+				const Outputs &computedOutputs( const Outputs &outputs ) const;
 				
 			private :
 			
 				friend class OSLRenderer;
 			
-				ShadingEngine( ConstOSLRendererPtr renderer, OSL::ShadingAttribStateRef shadingState );
+				ShadingEngine( ConstOSLRendererPtr renderer, OSL::ShadingAttribStateRef shadingState, const std::vector<OSL::ShadingAttribStateRef> &partitionShadingStates );
+			
+				IECore::CompoundDataPtr shade( const IECore::CompoundData *points, OSL::ShadingAttribState &shadingState ) const;
+				Outputs shadedOutputs( OSL::ShadingAttribState &shadingState ) const;
+				
+				// A part of the shading network which can be executed
+				// independently of the rest.
+				struct Partition
+				{
+					OSL::ShadingAttribStateRef shadingState;
+					Outputs outputs;
+				};
+				
+				const Partition *partition( const Outputs &outputs ) const;
 			
 				ConstOSLRendererPtr m_renderer;
 				OSL::ShadingAttribStateRef m_shadingState;
+				Outputs m_outputs;
+				std::vector<Partition> m_partitions;
 		
 		};
 		
@@ -155,6 +187,7 @@ class OSLRenderer : public IECore::Renderer
 		class RenderState;
 		class RendererServices;
 		class ShadingResults;
+		class ShadeTask;
 		
 		enum ClosureId
 		{
@@ -60,6 +60,9 @@ class OSLShader : public GafferScene::Shader
 		void loadShader( const std::string &shaderName, bool keepExistingValues=false );
 
 		OSLRenderer::ConstShadingEnginePtr shadingEngine() const;
+		/// As above, but using a stateHash() the caller has already computed,
+		/// to avoid the cost of computing it again.
+		OSLRenderer::ConstShadingEnginePtr shadingEngine( const IECore::MurmurHash &stateHash ) const;
 
 		/// Returns an OSL metadata item from the shader.
 		const IECore::Data *shaderMetadata( const IECore::InternedString &name ) const;
@@ -0,0 +1,230 @@
+##########################################################################
+#
+#  Copyright (c) 2014, Image Engine Design Inc. All rights reserved.
+#
+#  Redistribution and use in source and binary forms, with or without
+#  modification, are permitted provided that the following conditions are
+#  met:
+#
+#      * Redistributions of source code must retain the above
+#        copyright notice, this list of conditions and the following
+#        disclaimer.
+#
+#      * Redistributions in binary form must reproduce the above
+#        copyright notice, this list of conditions and the following
+#        disclaimer in the documentation and/or other materials provided with
+#        the distribution.
+#
+#      * Neither the name of John Haddon nor the names of
+#        any other contributors to this software may be used to endorse or
+#        promote products derived from this software without specific prior
+#        written permission.
+#
+#  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+#  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+#  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+#  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+#  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+#  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+#  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+#  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+#  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+#  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+#  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+##########################################################################
+
+
+import os
+import unittest
+
+import IECore
+
+import Gaffer
+import GafferTest
+import GafferImage
+
+class AutoCropTest( GafferTest.TestCase ) :
+
+	__rgbFilePath = os.path.expandvars( "$GAFFER_ROOT/python/GafferTest/images/rgb.100x100.exr" )
+	__checkerFilePath = os.path.expandvars( "$GAFFER_ROOT/python/GafferTest/images/checkerWithNegativeDataWindow.200x150.exr" )
+
+	# Returns an image with a red square in the region min-max, specified in
+	# Gaffer's y-up coordinates, and a green channel which is non-zero everywhere.
+	def __squareImage( self, min, max ) :
+
+		window = IECore.Box2i( IECore.V2i( 0 ), IECore.V2i( 199, 149 ) )
+		image = IECore.ImagePrimitive( window, window )
+		red = IECore.FloatVectorData()
+		green = IECore.FloatVectorData()
+		blue = IECore.FloatVectorData()
+		image["R"] = IECore.PrimitiveVariable( IECore.PrimitiveVariable.Interpolation.Vertex, red )
+		image["G"] = IECore.PrimitiveVariable( IECore.PrimitiveVariable.Interpolation.Vertex, green )
+		image["B"] = IECore.PrimitiveVariable( IECore.PrimitiveVariable.Interpolation.Vertex, blue )
+		for y in range( 0, 150 ) :
+			for x in range( 0, 200 ) :
+				# cortex image coordinates run top->bottom.
+				inside = x >= min.x and x <= max.x and 149 - y >= min.y and 149 - y <= max.y
+				red.append( 1 if inside else 0 )
+				green.append( 0.5 )
+				blue.append( 0 )
+
+		result = GafferImage.ObjectToImage()
+		result["object"].setValue( image )
+
+		return result
+
+	# Returns the origins of all the tiles intersecting the data window of image.
+	def __tileOrigins( self, image ) :
+
+		tileSize = GafferImage.ImagePlug.tileSize()
+		dataWindow = image["dataWindow"].getValue()
+		minTile = GafferImage.ImagePlug.tileOrigin( dataWindow.min )
+		maxTile = GafferImage.ImagePlug.tileOrigin( dataWindow.max )
+
+		result = []
+		for y in range( minTile.y, maxTile.y + 1, tileSize ) :
+			for x in range( minTile.x, maxTile.x + 1, tileSize ) :
+				result.append( IECore.V2i( x, y ) )
+
+		return result
+
+	# Computes the bound of the non-zero pixels in the specified channels
+	# the slow way, for comparison with the AutoCrop node.
+	def __nonZeroBound( self, image, channels ) :
+
+		tileSize = GafferImage.ImagePlug.tileSize()
+		dataWindow = image["dataWindow"].getValue()
+
+		result = IECore.Box2i()
+		for tileOrigin in self.__tileOrigins( image ) :
+			for channel in channels :
+				tile = image.channelData( channel, tileOrigin )
+				for y in range( max( tileOrigin.y, dataWindow.min.y ), min( tileOrigin.y + tileSize - 1, dataWindow.max.y ) + 1 ) :
+					for x in range( max( tileOrigin.x, dataWindow.min.x ), min( tileOrigin.x + tileSize - 1, dataWindow.max.x ) + 1 ) :
+						if tile[(y-tileOrigin.y)*tileSize + x - tileOrigin.x] != 0 :
+							result.extendBy( IECore.V2i( x, y ) )
+
+		return result
+
+	def testDataWindow( self ) :
+
+		for fileName in ( self.__rgbFilePath, self.__checkerFilePath ) :
+
+			r = GafferImage.ImageReader()
+			r["fileName"].setValue( fileName )
+
+			a = GafferImage.AutoCrop()
+			a["in"].setInput( r["out"] )
+
+			for channels in ( [ "R" ], [ "G" ], [ "B" ], [ "R", "G", "B" ] ) :
+				a["channels"].setValue( IECore.StringVectorData( channels ) )
+				self.assertEqual( a["out"]["dataWindow"].getValue(), self.__nonZeroBound( r["out"], channels ) )
+
+	def testPassThrough( self ) :
+
+		c = GafferImage.Constant()
+		c["format"].setValue( GafferImage.Format( 200, 150, 1. ) )
+		c["color"].setValue( IECore.Color4f( 1, 0.5, 0.25, 1 ) )
+
+		a = GafferImage.AutoCrop()
+		a["in"].setInput( c["out"] )
+
+		self.assertEqual( a["out"]["dataWindow"].getValue(), c["out"]["dataWindow"].getValue() )
+		self.assertEqual( a["out"]["format"].hash(), c["out"]["format"].hash() )
+		self.assertEqual( a["out"]["channelNames"].hash(), c["out"]["channelNames"].hash() )
+		for tileOrigin in self.__tileOrigins( c["out"] ) :
+			for channel in [ "R", "G", "B", "A" ] :
+				self.assertEqual( a["out"].channelDataHash( channel, tileOrigin ), c["out"].channelDataHash( channel, tileOrigin ) )
+
+	def testEmpty( self ) :
+
+		c = GafferImage.Constant()
+		c["color"].setValue( IECore.Color4f( 0 ) )
+
+		a = GafferImage.AutoCrop()
+		a["in"].setInput( c["out"] )
+		self.assertTrue( a["out"]["dataWindow"].getValue().isEmpty() )
+
+		c["color"].setValue( IECore.Color4f( 0, 0, 0, 1 ) )
+		self.assertFalse( a["out"]["dataWindow"].getValue().isEmpty() )
+
+		a["channels"].setValue( IECore.StringVectorData( [ "R", "G", "B" ] ) )
+		self.assertTrue( a["out"]["dataWindow"].getValue().isEmpty() )
+
+	def testChannelData( self ) :
+
+		squareBound = IECore.Box2i( IECore.V2i( 37, 52 ), IECore.V2i( 121, 104 ) )
+		r = self.__squareImage( squareBound.min, squareBound.max )
+
+		a = GafferImage.AutoCrop()
+		a["in"].setInput( r["out"] )
+		a["channels"].setValue( IECore.StringVectorData( [ "R" ] ) )
+
+		tileSize = GafferImage.ImagePlug.tileSize()
+		dataWindow = a["out"]["dataWindow"].getValue()
+		self.assertEqual( dataWindow, squareBound )
+
+		# Pixels outside the cropped data window must be zero in every
+		# channel, and pixels inside it must be unchanged.
+		for tileOrigin in self.__tileOrigins( r["out"] ) :
+			for channel in [ "R", "G", "B" ] :
+				inTile = r["out"].channelData( channel, tileOrigin )
+				outTile = a["out"].channelData( channel, tileOrigin )
+				for y in range( 0, tileSize ) :
+					for x in range( 0, tileSize ) :
+						i = y * tileSize + x
+						if dataWindow.intersects( tileOrigin + IECore.V2i( x, y ) ) :
+							self.assertEqual( outTile[i], inTile[i] )
+						else :
+							self.assertEqual( outTile[i], 0 )
+
+		# The scanned channel is zero outside the data window already,
+		# so it is passed straight through, without the data window
+		# needing to be hashed for every tile.
+		for tileOrigin in self.__tileOrigins( r["out"] ) :
+			self.assertEqual( a["out"].channelDataHash( "R", tileOrigin ), r["out"].channelDataHash( "R", tileOrigin ) )
+
+	def testSnapToTiles( self ) :
+
+		r = self.__squareImage( IECore.V2i( 37, 52 ), IECore.V2i( 121, 104 ) )
+
+		a = GafferImage.AutoCrop()
+		a["in"].setInput( r["out"] )
+		a["channels"].setValue( IECore.StringVectorData( [ "R" ] ) )
+		a["snapToTiles"].setValue( True )
+
+		tileSize = GafferImage.ImagePlug.tileSize()
+		bound = self.__nonZeroBound( r["out"], [ "R" ] )
+		inDataWindow = r["out"]["dataWindow"].getValue()
+		expectedDataWindow = IECore.Box2i(
+			GafferImage.ImagePlug.tileOrigin( bound.min ),
+			GafferImage.ImagePlug.tileOrigin( bound.max ) + IECore.V2i( tileSize - 1 ),
+		)
+		expectedDataWindow = IECore.Box2i(
+			IECore.V2i( max( expectedDataWindow.min.x, inDataWindow.min.x ), max( expectedDataWindow.min.y, inDataWindow.min.y ) ),
+			IECore.V2i( min( expectedDataWindow.max.x, inDataWindow.max.x ), min( expectedDataWindow.max.y, inDataWindow.max.y ) ),
+		)
+
+		self.assertEqual( a["out"]["dataWindow"].getValue(), expectedDataWindow )
+
+		# All the tiles within the data window are passed through unmodified.
+		for tileOrigin in self.__tileOrigins( a["out"] ) :
+			for channel in [ "R", "G", "B" ] :
+				self.assertEqual( a["out"].channelDataHash( channel, tileOrigin ), r["out"].channelDataHash( channel, tileOrigin ) )
+
+	def testAffects( self ) :
+
+		a = GafferImage.AutoCrop()
+
+		for name in ( "channels", "snapToTiles" ) :
+			cs = GafferTest.CapturingSlot( a.plugDirtiedSignal() )
+			a[name].setValue( IECore.StringVectorData( [ "A" ] ) if name == "channels" else True )
+			dirtied = set( [ x[0].relativeName( a ) for x in cs ] )
+			self.assertTrue( "out.dataWindow" in dirtied )
+			self.assertTrue( "out.channelData" in dirtied )
+			self.assertFalse( "out.format" in dirtied )
+			self.assertFalse( "out.channelNames" in dirtied )
+
+if __name__ == "__main__":
+	unittest.main()
@@ -0,0 +1,259 @@
+##########################################################################
+#
+#  Copyright (c) 2014, Image Engine Design Inc. All rights reserved.
+#
+#  Redistribution and use in source and binary forms, with or without
+#  modification, are permitted provided that the following conditions are
+#  met:
+#
+#      * Redistributions of source code must retain the above
+#        copyright notice, this list of conditions and the following
+#        disclaimer.
+#
+#      * Redistributions in binary form must reproduce the above
+#        copyright notice, this list of conditions and the following
+#        disclaimer in the documentation and/or other materials provided with
+#        the distribution.
+#
+#      * Neither the name of John Haddon nor the names of
+#        any other contributors to this software may be used to endorse or
+#        promote products derived from this software without specific prior
+#        written permission.
+#
+#  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+#  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+#  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+#  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+#  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+#  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+#  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+#  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+#  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+#  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+#  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+##########################################################################
+
+
+import unittest
+
+import IECore
+
+import Gaffer
+import GafferTest
+import GafferImage
+
+class BlurTest( GafferTest.TestCase ) :
+
+	# Returns an ObjectToImage node outputting a single channel image with
+	# the pixel values given by f( x, y ), in cortex's y-down coordinates.
+	def __image( self, width, height, f ) :
+
+		window = IECore.Box2i( IECore.V2i( 0 ), IECore.V2i( width - 1, height - 1 ) )
+		image = IECore.ImagePrimitive( window, window )
+		red = IECore.FloatVectorData()
+		image["R"] = IECore.PrimitiveVariable( IECore.PrimitiveVariable.Interpolation.Vertex, red )
+		for y in range( 0, height ) :
+			for x in range( 0, width ) :
+				red.append( f( x, y ) )
+
+		result = GafferImage.ObjectToImage()
+		result["object"].setValue( image )
+
+		return result
+
+	# Returns a dictionary mapping ( x, y ) to the value of each pixel
+	# within the data window of image.
+	def __pixels( self, image, channel = "R" ) :
+
+		tileSize = GafferImage.ImagePlug.tileSize()
+		dataWindow = image["dataWindow"].getValue()
+		minTile = GafferImage.ImagePlug.tileOrigin( dataWindow.min )
+		maxTile = GafferImage.ImagePlug.tileOrigin( dataWindow.max )
+
+		result = {}
+		for tileY in range( minTile.y, maxTile.y + 1, tileSize ) :
+			for tileX in range( minTile.x, maxTile.x + 1, tileSize ) :
+				tile = image.channelData( channel, IECore.V2i( tileX, tileY ) )
+				for y in range( max( tileY, dataWindow.min.y ), min( tileY + tileSize - 1, dataWindow.max.y ) + 1 ) :
+					for x in range( max( tileX, dataWindow.min.x ), min( tileX + tileSize - 1, dataWindow.max.x ) + 1 ) :
+						result[(x,y)] = tile[(y-tileY)*tileSize + x - tileX]
+
+		return result
+
+	# Box filters the pixels in the slowest way possible, for
+	# comparison with the Blur node.
+	def __boxFilter( self, pixels, radius ) :
+
+		def weight( offset, r ) :
+
+			offset = abs( offset )
+			if offset <= int( r ) :
+				return 1.0
+			elif offset == int( r ) + 1 :
+				return r - int( r )
+			return 0.0
+
+		support = ( int( radius.x ) + 1, int( radius.y ) + 1 )
+		result = {}
+		for ( x, y ) in pixels.keys() :
+			for dy in range( -support[1], support[1] + 1 ) :
+				for dx in range( -support[0], support[0] + 1 ) :
+					w = weight( dx, radius.x ) * weight( dy, radius.y )
+					result[(x+dx,y+dy)] = result.get( (x+dx,y+dy), 0.0 ) + w * pixels[(x,y)]
+
+		normalisation = ( 2 * int( radius.x ) + 1 + 2 * ( radius.x - int( radius.x ) ) ) * ( 2 * int( radius.y ) + 1 + 2 * ( radius.y - int( radius.y ) ) )
+		return dict( [ ( k, v / normalisation ) for k, v in result.items() ] )
+
+	def testPassThrough( self ) :
+
+		i = self.__image( 30, 20, lambda x, y : x + y )
+
+		b = GafferImage.Blur()
+		b["in"].setInput( i["out"] )
+		self.assertEqual( b["radius"].getValue(), IECore.V2f( 0 ) )
+
+		self.assertEqual( b["out"]["dataWindow"].hash(), i["out"]["dataWindow"].hash() )
+		self.assertEqual( b["out"].channelDataHash( "R", IECore.V2i( 0 ) ), i["out"].channelDataHash( "R", IECore.V2i( 0 ) ) )
+
+		b["radius"].setValue( IECore.V2f( 1 ) )
+		self.assertNotEqual( b["out"].channelDataHash( "R", IECore.V2i( 0 ) ), i["out"].channelDataHash( "R", IECore.V2i( 0 ) ) )
+		self.assertEqual( b["out"]["format"].hash(), i["out"]["format"].hash() )
+		self.assertEqual( b["out"]["channelNames"].hash(), i["out"]["channelNames"].hash() )
+
+	def testDataWindow( self ) :
+
+		i = self.__image( 30, 20, lambda x, y : 1 )
+		inDataWindow = i["out"]["dataWindow"].getValue()
+
+		b = GafferImage.Blur()
+		b["in"].setInput( i["out"] )
+
+		for mode, radius, filter, expectedSupport in [
+			( GafferImage.Blur.Mode.Box, IECore.V2f( 3.5, 0 ), "Bilinear", IECore.V2i( 4, 0 ) ),
+			( GafferImage.Blur.Mode.Box, IECore.V2f( 2, 70 ), "Bilinear", IECore.V2i( 2, 70 ) ),
+			( GafferImage.Blur.Mode.FilterKernel, IECore.V2f( 4, 8 ), "Bilinear", IECore.V2i( 4, 8 ) ),
+			( GafferImage.Blur.Mode.FilterKernel, IECore.V2f( 5, 1 ), "Box", IECore.V2i( 5, 1 ) ),
+		] :
+			b["mode"].setValue( mode )
+			b["radius"].setValue( radius )
+			b["filter"].setValue( filter )
+			self.assertEqual(
+				b["out"]["dataWindow"].getValue(),
+				IECore.Box2i( inDataWindow.min - expectedSupport, inDataWindow.max + expectedSupport )
+			)
+
+	def testBox( self ) :
+
+		i = self.__image( 30, 20, lambda x, y : ( x * 0.1 + y * y * 0.01 ) if ( x + y ) % 7 else 2 )
+		inPixels = self.__pixels( i["out"] )
+
+		b = GafferImage.Blur()
+		b["in"].setInput( i["out"] )
+		b["mode"].setValue( GafferImage.Blur.Mode.Box )
+
+		for radius in ( IECore.V2f( 2, 1 ), IECore.V2f( 1.5, 3.25 ), IECore.V2f( 0, 2 ), IECore.V2f( 4, 0 ) ) :
+
+			b["radius"].setValue( radius )
+			outPixels = self.__pixels( b["out"] )
+
+			expectedPixels = self.__boxFilter( inPixels, radius )
+			for k, v in outPixels.items() :
+				self.assertAlmostEqual( v, expectedPixels.get( k, 0.0 ), 4 )
+
+	def testBoxAcrossTiles( self ) :
+
+		# Radii spanning several tiles, so that the sums for
+		# each pass are chained across the tile boundaries.
+		for width, height, radius in (
+			( 150, 6, IECore.V2f( 90, 0.5 ) ),
+			( 150, 6, IECore.V2f( 70.25, 2 ) ),
+			( 6, 150, IECore.V2f( 1.5, 80 ) ),
+		) :
+
+			i = self.__image( width, height, lambda x, y : ( ( x + 2 * y ) % 11 ) * 0.1 )
+			inPixels = self.__pixels( i["out"] )
+
+			b = GafferImage.Blur()
+			b["in"].setInput( i["out"] )
+			b["mode"].setValue( GafferImage.Blur.Mode.Box )
+			b["radius"].setValue( radius )
+
+			outPixels = self.__pixels( b["out"] )
+			expectedPixels = self.__boxFilter( inPixels, radius )
+			for k, v in outPixels.items() :
+				self.assertAlmostEqual( v, expectedPixels.get( k, 0.0 ), 4 )
+
+	def testFilterKernelWithBoxFilter( self ) :
+
+		i = self.__image( 30, 20, lambda x, y : x * y )
+
+		b1 = GafferImage.Blur()
+		b1["in"].setInput( i["out"] )
+		b1["mode"].setValue( GafferImage.Blur.Mode.Box )
+		b1["radius"].setValue( IECore.V2f( 3, 2 ) )
+
+		b2 = GafferImage.Blur()
+		b2["in"].setInput( i["out"] )
+		b2["mode"].setValue( GafferImage.Blur.Mode.FilterKernel )
+		b2["filter"].setValue( "Box" )
+		b2["radius"].setValue( IECore.V2f( 3, 2 ) )
+
+		self.assertEqual( self.__pixels( b1["out"] ), self.__pixels( b2["out"] ) )
+
+	def testPreservesSum( self ) :
+
+		i = self.__image( 75, 50, lambda x, y : ( x % 5 ) * 0.25 + ( y % 3 ) )
+		inSum = sum( self.__pixels( i["out"] ).values() )
+
+		b = GafferImage.Blur()
+		b["in"].setInput( i["out"] )
+
+		for mode in ( GafferImage.Blur.Mode.Box, GafferImage.Blur.Mode.Gaussian, GafferImage.Blur.Mode.FilterKernel ) :
+			for radius in ( IECore.V2f( 1.5, 0.5 ), IECore.V2f( 10, 70 ) ) :
+				b["mode"].setValue( mode )
+				b["radius"].setValue( radius )
+				outSum = sum( self.__pixels( b["out"] ).values() )
+				self.assertAlmostEqual( outSum / inSum, 1, 4 )
+
+	def testGaussianVariance( self ) :
+
+		# A single pixel image, which should be blurred
+		# into a gaussian with a standard deviation of a
+		# third of the radius.
+		i = self.__image( 1, 1, lambda x, y : 1 )
+
+		b = GafferImage.Blur()
+		b["in"].setInput( i["out"] )
+		b["mode"].setValue( GafferImage.Blur.Mode.Gaussian )
+
+		for radius in ( IECore.V2f( 9, 6 ), IECore.V2f( 1, 40 ), IECore.V2f( 100, 3.5 ) ) :
+
+			b["radius"].setValue( radius )
+			pixels = self.__pixels( b["out"] )
+
+			total = sum( pixels.values() )
+			self.assertAlmostEqual( total, 1, 4 )
+
+			varianceX = sum( [ v * x * x for ( x, y ), v in pixels.items() ] ) / total
+			varianceY = sum( [ v * y * y for ( x, y ), v in pixels.items() ] ) / total
+			self.assertAlmostEqual( varianceX / ( radius.x / 3 ) ** 2, 1, 3 )
+			self.assertAlmostEqual( varianceY / ( radius.y / 3 ) ** 2, 1, 3 )
+
+	def testAffects( self ) :
+
+		b = GafferImage.Blur()
+
+		for plug in ( b["radius"]["x"], b["radius"]["y"], b["mode"], b["filter"] ) :
+			cs = GafferTest.CapturingSlot( b.plugDirtiedSignal() )
+			if isinstance( plug, Gaffer.StringPlug ) :
+				plug.setValue( "Sinc" )
+			else :
+				plug.setValue( 2 )
+			dirtied = set( [ x[0].relativeName( b ) for x in cs ] )
+			self.assertTrue( "out.dataWindow" in dirtied )
+			self.assertTrue( "out.channelData" in dirtied )
+			self.assertFalse( "out.format" in dirtied )
+
+if __name__ == "__main__":
+	unittest.main()
@@ -35,6 +35,9 @@
 ##########################################################################
 
 import os
+import sys
+import glob
+import stat
 import unittest
 import random
 import threading
@@ -124,6 +127,48 @@ class DisplayTest( unittest.TestCase ) :
 		
 		driver.imageClose()
 
+	def testDataReceivedForEveryBucket( self ) :
+	
+		node = GafferImage.Display()
+		node["port"].setValue( 2500 )
+		
+		displayWindow = IECore.Box2i( IECore.V2i( 0 ), IECore.V2i( 99 ) )
+		channelNames = [ "R", "G", "B", "A", "Z" ]
+		driver = IECore.ClientDisplayDriver(
+			displayWindow,
+			displayWindow,
+			channelNames,
+			{
+				"displayHost" : "localHost",
+				"displayPort" : "2500",
+				"remoteDisplayType" : "GafferImage::GafferDisplayDriver",
+			}
+		)
+		
+		for y in range( 0, 100, 10 ) :
+			for x in range( 0, 100, 10 ) :
+				bucketWindow = IECore.Box2i( IECore.V2i( x, y ), IECore.V2i( x + 9, y + 9 ) )
+				bucketData = IECore.FloatVectorData()
+				for i in range( 0, 100 ) :
+					for c in range( 0, len( channelNames ) ) :
+						bucketData.append( c + 1 )
+				driver.imageData( bucketWindow, bucketData )
+		
+		driver.imageClose()
+		self.__imageReceivedSemaphore.acquire()
+		
+		# every bucket should have been signalled, whether or not
+		# anyone acted on the previous signals.
+		for i in range( 0, 100 ) :
+			self.assertTrue( self.__dataReceivedSemaphore.acquire( False ) )
+		self.assertFalse( self.__dataReceivedSemaphore.acquire( False ) )
+		
+		# but all the data should have arrived regardless, with
+		# the channels correctly de-interleaved.
+		for i, channelName in enumerate( channelNames ) :
+			channelData = node["out"].channelData( channelName, IECore.V2i( 0 ) )
+			self.assertEqual( set( channelData ), set( [ i + 1 ] ) )
+
 	def testTransferChecker( self ) :
 
 		self.__testTransferImage( "$GAFFER_ROOT/python/GafferTest/images/checker.exr" )
@@ -148,25 +193,57 @@ class DisplayTest( unittest.TestCase ) :
 			blackTile
 		)
 
-	def __testTransferImage( self, fileName ) :
+	def testSharedMemoryTransfer( self ) :
+	
+		self.__testTransferImage(
+			"$GAFFER_ROOT/python/GafferTest/images/checkerWithNegativeDataWindow.200x150.exr",
+			driverType = "GafferImage::SharedMemoryClientDisplayDriver",
+			sharedMemory = True,
+		)
+
+	def testSharedMemoryFallback( self ) :
+	
+		# the Display doesn't allow shared memory, so the
+		# client should fall back to the socket.
+		self.__testTransferImage(
+			"$GAFFER_ROOT/python/GafferTest/images/checker.exr",
+			driverType = "GafferImage::SharedMemoryClientDisplayDriver",
+			sharedMemory = False,
+		)
+
+	def __testTransferImage( self, fileName, driverType = "ClientDisplayDriver", sharedMemory = False ) :
 	
 		imageReader = GafferImage.ImageReader()
 		imageReader["fileName"].setValue( os.path.expandvars( fileName ) )
 		
 		node = GafferImage.Display()
 		node["port"].setValue( 2500 )
-				
-		driver = IECore.ClientDisplayDriver(
+		node["sharedMemory"].setValue( sharedMemory )
+		
+		segmentsBefore = self.__sharedMemorySegments()
+		
+		driver = IECore.DisplayDriver.create(
+			driverType,
 			imageReader["out"]["format"].getValue().getDisplayWindow(),
 			imageReader["out"]["format"].getValue().formatToYDownSpace( imageReader["out"]["dataWindow"].getValue() ),
 			list( imageReader["out"]["channelNames"].getValue() ),
-			{
+			IECore.CompoundData( {
 				"displayHost" : "localHost",
 				"displayPort" : "2500",
 				"remoteDisplayType" : "GafferImage::GafferDisplayDriver",
-			}
+			} )
 		)
 		
+		# check that the shared memory segment was created if and only
+		# if it should have been, and that only we may access it.
+		if sys.platform.startswith( "linux" ) :
+			newSegments = self.__sharedMemorySegments() - segmentsBefore
+			if sharedMemory and driverType == "GafferImage::SharedMemoryClientDisplayDriver" :
+				self.assertEqual( len( newSegments ), 1 )
+				self.assertEqual( stat.S_IMODE( os.stat( newSegments.pop() ).st_mode ), 0600 )
+			else :
+				self.assertEqual( len( newSegments ), 0 )
+		
 		dataWindow = imageReader["out"]["dataWindow"].getValue()
 		tileSize = GafferImage.ImagePlug.tileSize()
 		minTileOrigin = GafferImage.ImagePlug.tileOrigin( dataWindow.min )
@@ -196,6 +273,10 @@ class DisplayTest( unittest.TestCase ) :
 		
 		return node
 
+	def __sharedMemorySegments( self ) :
+	
+		return set( glob.glob( "/dev/shm/gafferDisplay.%d.*" % os.getpid() ) )
+
 	def __tiles( self, node, channelName ) :
 	
 		dataWindow = node["out"]["dataWindow"].getValue()
@@ -46,6 +46,97 @@ class GradeTest( unittest.TestCase ) :
 
 	checkerFile = os.path.expandvars( "$GAFFER_ROOT/python/GafferTest/images/checker.exr" )
 	
+	def testConstantInput( self ) :
+	
+		c = GafferImage.Constant()
+		c["color"].setValue( IECore.Color4f( 0.25, 0.5, 0.75, 1 ) )
+		
+		grade = GafferImage.Grade()
+		grade["in"].setInput( c["out"] )
+		grade["multiply"].setValue( IECore.Color3f( 2, 3, 4 ) )
+		grade["whiteClamp"].setValue( True )
+		
+		expected = { "R" : 0.5, "G" : 1, "B" : 1 }
+		for channel, value in expected.items() :
+			tile = grade["out"].channelData( channel, IECore.V2i( 0 ) )
+			self.assertEqual( len( tile ), GafferImage.ImagePlug.tileSize() ** 2 )
+			for v in tile :
+				self.assertAlmostEqual( v, value, 6 )
+	
+	def testGammaTolerance( self ) :
+	
+		# Gamma is applied using an approximation to pow(), so here we check
+		# that the results remain within a tight tolerance of the exact result.
+	
+		i = GafferImage.ImageReader()
+		i["fileName"].setValue( self.checkerFile )
+		
+		grade = GafferImage.Grade()
+		grade["in"].setInput( i["out"] )
+		grade["multiply"].setValue( IECore.Color3f( 1.5, 1, 0.5 ) )
+		grade["offset"].setValue( IECore.Color3f( 0.1, -0.1, 0 ) )
+		grade["gamma"].setValue( IECore.Color3f( 0.5, 2.2, 4 ) )
+		
+		multiply = grade["multiply"].getValue()
+		offset = grade["offset"].getValue()
+		gamma = grade["gamma"].getValue()
+		
+		for channelIndex, channel in enumerate( [ "R", "G", "B" ] ) :
+			inTile = i["out"].channelData( channel, IECore.V2i( 0 ) )
+			outTile = grade["out"].channelData( channel, IECore.V2i( 0 ) )
+			for x, y in zip( inTile, outTile ) :
+				c = x * multiply[channelIndex] + offset[channelIndex]
+				expected = pow( c, 1.0 / gamma[channelIndex] ) if c > 0 else c
+				self.assertAlmostEqual( y, expected, delta = max( abs( expected ) * 1e-5, 1e-6 ) )
+	
+	def testFusedChain( self ) :
+	
+		# Consecutive ChannelDataProcessors are fused into a single pass
+		# at compute time. Check that the results match those of evaluating
+		# each node in turn, including when nodes in the chain are disabled
+		# or have channels masked.
+	
+		i = GafferImage.ImageReader()
+		i["fileName"].setValue( self.checkerFile )
+		
+		grade1 = GafferImage.Grade()
+		grade1["in"].setInput( i["out"] )
+		grade1["multiply"].setValue( IECore.Color3f( 2, 3, 4 ) )
+		
+		clamp = GafferImage.Clamp()
+		clamp["in"].setInput( grade1["out"] )
+		clamp["channels"].setValue( IECore.StringVectorData( [ "R", "G" ] ) )
+		
+		grade2 = GafferImage.Grade()
+		grade2["in"].setInput( clamp["out"] )
+		grade2["offset"].setValue( IECore.Color3f( 0.1, 0.2, 0.3 ) )
+		
+		def assertChainCorrect() :
+		
+			for channelIndex, channel in enumerate( [ "R", "G", "B" ] ) :
+				inTile = i["out"].channelData( channel, IECore.V2i( 0 ) )
+				outTile = grade2["out"].channelData( channel, IECore.V2i( 0 ) )
+				for x, y in zip( inTile, outTile ) :
+					if grade1["enabled"].getValue() :
+						x *= grade1["multiply"].getValue()[channelIndex]
+					if clamp["enabled"].getValue() and channel in clamp["channels"].getValue() :
+						x = min( max( x, 0 ), 1 )
+					x += grade2["offset"].getValue()[channelIndex]
+					self.assertAlmostEqual( y, x, 5 )
+		
+		assertChainCorrect()
+		
+		clamp["enabled"].setValue( False )
+		assertChainCorrect()
+		
+		clamp["enabled"].setValue( True )
+		grade1["enabled"].setValue( False )
+		assertChainCorrect()
+		
+		grade1["enabled"].setValue( True )
+		grade2["channels"].setValue( IECore.StringVectorData( [ "G" ] ) )
+		assertChainCorrect()
+	
 	# Test that when gamma == 0 that the coresponding channel isn't modified.
 	def testChannelEnable( self ) :
 		i = GafferImage.ImageReader()
@@ -34,6 +34,7 @@
 #
 ##########################################################################
 
+import os
 import unittest
 import threading
 
@@ -82,13 +83,102 @@ class ImageNodeTest( GafferTest.TestCase ) :
 		for e in exceptions :
 			raise e
 	
+	def testHalfTileStorage( self ) :
+	
+		r = GafferImage.ImageReader()
+		r["fileName"].setValue( os.path.expandvars( "$GAFFER_ROOT/python/GafferTest/images/checkerboard.100x100.exr" ) )
+		t = GafferImage.ImageTransform()
+		t["in"].setInput( r["out"] )
+		t["transform"]["translate"].setValue( IECore.V2f( 0.3, 0.6 ) )
+		
+		self.assertEqual( GafferImage.ImagePlug.getTileStorage(), GafferImage.ImagePlug.TileStorage.Float )
+		floatTile = t["out"].channelData( "G", IECore.V2i( 0 ) )
+		floatHash = t["out"].channelDataHash( "G", IECore.V2i( 0 ) )
+		
+		GafferImage.ImagePlug.setTileStorage( GafferImage.ImagePlug.TileStorage.Half )
+		self.assertEqual( GafferImage.ImagePlug.getTileStorage(), GafferImage.ImagePlug.TileStorage.Half )
+		
+		# The hash of the channel data itself is unaffected by the storage mode,
+		# and the data is still presented as float.
+		self.assertEqual( t["out"].channelDataHash( "G", IECore.V2i( 0 ) ), floatHash )
+		halfTile = t["out"].channelData( "G", IECore.V2i( 0 ) )
+		self.assertTrue( isinstance( halfTile, IECore.FloatVectorData ) )
+		self.assertEqual( len( halfTile ), len( floatTile ) )
+		for f, h in zip( floatTile, halfTile ) :
+			self.assertAlmostEqual( f, h, 3 )
+	
+	def testHalfStorageOptOut( self ) :
+	
+		# Grade opts out of half storage, so its results are kept at full
+		# precision even though its input is stored at half.
+		
+		GafferImage.ImagePlug.setTileStorage( GafferImage.ImagePlug.TileStorage.Half )
+		
+		c = GafferImage.Constant()
+		c["format"].setValue( GafferImage.Format( 200, 200, 1.0 ) )
+		c["color"].setValue( IECore.Color4f( 1 ) )
+		g = GafferImage.Grade()
+		g["in"].setInput( c["out"] )
+		g["multiply"].setValue( IECore.Color3f( 0.1234567 ) )
+		
+		expected = IECore.FloatVectorData( [ 0.1234567 ] )[0]
+		for v in g["out"].channelData( "G", IECore.V2i( 0 ) ) :
+			self.assertEqual( v, expected )
+	
+	def testTileReuseUnderCacheThrashing( self ) :
+	
+		# Tiles are recycled as soon as they are evicted from the cache, so
+		# we thrash the cache from several threads to check that recycled
+		# tiles are never still in use elsewhere.
+	
+		r = GafferImage.ImageReader()
+		r["fileName"].setValue( os.path.expandvars( "$GAFFER_ROOT/python/GafferTest/images/checkerboard.100x100.exr" ) )
+		
+		t = GafferImage.ImageTransform()
+		t["in"].setInput( r["out"] )
+		t["transform"]["rotate"].setValue( 10 )
+		
+		m = GafferImage.Merge()
+		m["in"].setInput( r["out"] )
+		m["in1"].setInput( t["out"] )
+		
+		expectedImage = m["out"].image()
+		
+		Gaffer.ValuePlug.setCacheMemoryLimit( 2 * r["out"].channelData( "R", IECore.V2i( 0 ) ).memoryUsage() )
+		
+		images = []
+		exceptions = []
+		def merger() :
+		
+			try :
+				images.append( m["out"].image() )
+			except Exception, e :
+				exceptions.append( e )
+				
+		threads = []
+		for i in range( 0, 10 ) :
+			thread = threading.Thread( target = merger )
+			threads.append( thread )
+			thread.start()
+		
+		for thread in threads :
+			thread.join()
+		
+		for e in exceptions :
+			raise e
+		
+		for image in images :
+			self.assertEqual( image, expectedImage )
+	
 	def setUp( self ) :
 	
 		self.__previousCacheMemoryLimit = Gaffer.ValuePlug.getCacheMemoryLimit()
+		self.__previousTileStorage = GafferImage.ImagePlug.getTileStorage()
 	
 	def tearDown( self ) :
 	
 		Gaffer.ValuePlug.setCacheMemoryLimit( self.__previousCacheMemoryLimit )
+		GafferImage.ImagePlug.setTileStorage( self.__previousTileStorage )
 		
 if __name__ == "__main__":
 	unittest.main()
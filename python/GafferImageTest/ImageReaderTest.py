@@ -238,6 +238,61 @@ class ImageReaderTest( unittest.TestCase ) :
 		self.assertTrue( "png" in e )
 		self.assertTrue( "cin" in e )
 		self.assertTrue( "dpx" in e )
+	
+	def testCacheSettings( self ) :
+	
+		memoryLimit = GafferImage.ImageReader.getCacheMemoryLimit()
+		fileHandleLimit = GafferImage.ImageReader.getCacheFileHandleLimit()
+		autoTile = GafferImage.ImageReader.getCacheAutoTile()
+		autoMip = GafferImage.ImageReader.getCacheAutoMip()
+		
+		try :
+		
+			GafferImage.ImageReader.setCacheMemoryLimit( 100 * 1024 * 1024 )
+			self.assertEqual( GafferImage.ImageReader.getCacheMemoryLimit(), 100 * 1024 * 1024 )
+		
+			GafferImage.ImageReader.setCacheFileHandleLimit( 20 )
+			self.assertEqual( GafferImage.ImageReader.getCacheFileHandleLimit(), 20 )
+			
+			GafferImage.ImageReader.setCacheAutoTile( 128 )
+			self.assertEqual( GafferImage.ImageReader.getCacheAutoTile(), 128 )
+			
+			GafferImage.ImageReader.setCacheAutoMip( not autoMip )
+			self.assertEqual( GafferImage.ImageReader.getCacheAutoMip(), not autoMip )
+		
+		finally :
+		
+			GafferImage.ImageReader.setCacheMemoryLimit( memoryLimit )
+			GafferImage.ImageReader.setCacheFileHandleLimit( fileHandleLimit )
+			GafferImage.ImageReader.setCacheAutoTile( autoTile )
+			GafferImage.ImageReader.setCacheAutoMip( autoMip )
+	
+	def testPrefetch( self ) :
+	
+		r = GafferImage.ImageReader()
+		r["fileName"].setValue( self.circlesExrFileName )
+		
+		s1 = GafferImage.ImageReader.cacheStatistics()
+		for key in [ "hitRate", "bytesRead", "memoryUsage", "openFiles", "tileRequests", "tileMisses", "uniqueFiles" ] :
+			self.assertTrue( key in s1 )
+		
+		r.prefetch( 1, 10 )
+		
+		s2 = GafferImage.ImageReader.cacheStatistics()
+		self.assertGreater( s2["tileRequests"].value, s1["tileRequests"].value )
+		
+		# prefetching a region only requests the tiles within it
+		r.prefetch( 1, 1, IECore.Box2i( IECore.V2i( 0 ), IECore.V2i( 10 ) ) )
+		s3 = GafferImage.ImageReader.cacheStatistics()
+		self.assertGreater( s3["tileRequests"].value, s2["tileRequests"].value )
+		self.assertLessEqual( s3["tileRequests"].value - s2["tileRequests"].value, s2["tileRequests"].value - s1["tileRequests"].value )
+		
+		# and the image is unaffected
+		image = r["out"].image()
+		image2 = IECore.Reader.create( self.circlesExrFileName ).read()
+		image.blindData().clear()
+		image2.blindData().clear()
+		self.assertEqual( image, image2 )
 		
 if __name__ == "__main__":
 	unittest.main()
@@ -34,6 +34,10 @@
 #  
 ##########################################################################
 
+import os
+import random
+import unittest
+
 import IECore
 
 import Gaffer
@@ -86,5 +90,40 @@ class ImageSamplerTest( GafferTest.TestCase ) :
 		sampler["filter"].setValue( "Box" )
 		self.assertNotEqual( sampler["color"].hash(), h )
 			
+	def testBatch( self ) :
+	
+		reader = GafferImage.ImageReader()
+		reader["fileName"].setValue( os.path.expandvars( "$GAFFER_ROOT/python/GafferTest/images/checker.exr" ) )
+		
+		sampler = GafferImage.ImageSampler()
+		sampler["image"].setInput( reader["out"] )
+		
+		random.seed( 0 )
+		dataWindow = reader["out"]["dataWindow"].getValue()
+		pixels = IECore.V2fVectorData()
+		for i in range( 0, 500 ) :
+			pixels.append(
+				IECore.V2f(
+					random.uniform( dataWindow.min.x - 10, dataWindow.max.x + 10 ),
+					random.uniform( dataWindow.min.y - 10, dataWindow.max.y + 10 ),
+				)
+			)
+		
+		for filter in ( "Box", "Bilinear", "Lanczos" ) :
+		
+			sampler["filter"].setValue( filter )
+			sampler["pixels"].setValue( pixels )
+			colors = sampler["colors"].getValue()
+			self.assertEqual( len( colors ), len( pixels ) )
+			
+			for pixel, color in zip( pixels, colors ) :
+				sampler["pixel"].setValue( pixel )
+				self.assertEqual( color, sampler["color"].getValue() )
+		
+		h = sampler["colors"].hash()
+		pixels[0] = pixels[0] + IECore.V2f( 1 )
+		sampler["pixels"].setValue( pixels )
+		self.assertNotEqual( sampler["colors"].hash(), h )
+
 if __name__ == "__main__":
 	unittest.main()
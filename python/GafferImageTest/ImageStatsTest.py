@@ -198,6 +198,93 @@ class ImageStatsTest( unittest.TestCase ) :
 		self.__assertColour( s["min"].getValue(), IECore.Color4f( 0.25, 0, 0, 0.5 ) )
 		self.__assertColour( s["max"].getValue(), IECore.Color4f( 0.5, 0.5, 0, 0.75 ) )
 
+	def testNegativeMax( self ) :
+	
+		c = GafferImage.Constant()
+		c["format"].setValue( GafferImage.Format( 100, 100, 1. ) )
+		c["color"].setValue( IECore.Color4f( -0.5, -0.25, -1, -2 ) )
+		
+		s = GafferImage.ImageStats()
+		s["in"].setInput( c["out"] )
+		s["channels"].setValue( IECore.StringVectorData( [ "R", "G", "B", "A" ] ) )
+		s["regionOfInterest"].setValue( IECore.Box2i( IECore.V2i( 0 ), IECore.V2i( 99 ) ) )
+		
+		self.__assertColour( s["max"].getValue(), IECore.Color4f( -0.5, -0.25, -1, -2 ) )
+		self.__assertColour( s["min"].getValue(), IECore.Color4f( -0.5, -0.25, -1, -2 ) )
+		
+	def testPositionsHistogramAndPercentile( self ) :
+	
+		r = GafferImage.ImageReader()
+		r["fileName"].setValue( self.__rgbFilePath )
+		
+		s = GafferImage.ImageStats()
+		s["in"].setInput( r["out"] )
+		s["channels"].setValue( IECore.StringVectorData( [ "R", "G", "B", "A" ] ) )
+		s["histogramBins"].setValue( 8 )
+		s["percentile"].setValue( 0.9 )
+		
+		roi = IECore.Box2i( IECore.V2i( 10, 15 ), IECore.V2i( 80, 90 ) )
+		s["regionOfInterest"].setValue( roi )
+		width = roi.size().x + 1
+		
+		for channelIndex, channel in enumerate( [ "r", "g", "b", "a" ] ) :
+		
+			values = self.__regionValues( r["out"], channel.upper(), roi )
+			
+			minIndex = values.index( min( values ) )
+			maxIndex = values.index( max( values ) )
+			self.assertEqual( s["minPosition"][channel].getValue(), IECore.V2i( roi.min.x + minIndex % width, roi.min.y + minIndex / width ) )
+			self.assertEqual( s["maxPosition"][channel].getValue(), IECore.V2i( roi.min.x + maxIndex % width, roi.min.y + maxIndex / width ) )
+			
+			histogram = [ 0 ] * 8
+			for v in values :
+				histogram[ min( max( int( v * 8 ), 0 ), 7 ) ] += 1
+			self.assertEqual( list( s["histogram"][channel].getValue() ), histogram )
+			
+			sortedValues = sorted( values )
+			self.assertEqual( s["percentileValue"][channelIndex].getValue(), sortedValues[ int( 0.9 * ( len( values ) - 1 ) + 0.5 ) ] )
+			
+		# Changing the histogram settings should update the histogram,
+		# but leave the other statistics unchanged.
+		
+		histogram = s["histogram"]["r"].getValue()
+		maxValue = s["max"].getValue()
+		s["histogramRange"].setValue( IECore.V2f( 0, 2 ) )
+		self.assertNotEqual( s["histogram"]["r"].getValue(), histogram )
+		self.assertEqual( s["max"].getValue(), maxValue )
+		
+	def testManyTiles( self ) :
+	
+		# a region covering many tiles, with partial tiles at the edges,
+		# checks that the parallel reduction combines tiles correctly.
+		
+		c = GafferImage.Constant()
+		c["format"].setValue( GafferImage.Format( 300, 200, 1. ) )
+		c["color"].setValue( IECore.Color4f( 0.25, 0.5, 0.75, 1 ) )
+		
+		g = GafferImage.Grade()
+		g["in"].setInput( c["out"] )
+		g["multiply"].setValue( IECore.Color3f( 0.5 ) )
+		
+		s = GafferImage.ImageStats()
+		s["in"].setInput( g["out"] )
+		s["channels"].setValue( IECore.StringVectorData( [ "R", "G", "B", "A" ] ) )
+		s["regionOfInterest"].setValue( IECore.Box2i( IECore.V2i( 10, 20 ), IECore.V2i( 289, 179 ) ) )
+		
+		expected = IECore.Color4f( 0.125, 0.25, 0.375, 1 )
+		self.__assertColour( s["average"].getValue(), expected )
+		self.__assertColour( s["min"].getValue(), expected )
+		self.__assertColour( s["max"].getValue(), expected )
+	
+	def __regionValues( self, image, channel, roi ) :
+	
+		c = Gaffer.Context()
+		c["image:channelName"] = channel
+		c["image:tileOrigin"] = IECore.V2i( 0 )
+		with c :
+			sampler = GafferImage.Sampler( image, channel, roi, GafferImage.BoundingMode.Black )
+			return list( sampler.sampleRegion( roi ) )
+
 	def __assertColour( self, colour1, colour2 ) :
 		for i in range( 0, 4 ):
 			self.assertEqual( "%.4f" % colour2[i], "%.4f" % colour1[i] )
@@ -35,6 +35,7 @@
 ##########################################################################
 
 import unittest
+import math
 
 import IECore
 import os
@@ -102,9 +103,9 @@ class ImageTransformTest( unittest.TestCase ) :
 		t = GafferImage.ImageTransform()
 		t["in"].setInput( r["out"] )
 
-		h1 = t["__scaledFormat"].hash()
+		h1 = t["out"]["dataWindow"].hash()
 		t["transform"]["scale"].setValue( IECore.V2f( 2., 2. ) )
-		h2 = t["__scaledFormat"].hash()
+		h2 = t["out"]["dataWindow"].hash()
 		self.assertNotEqual( h1, h2 )	
 		
 	def testDirtyPropagation( self ) :
@@ -119,7 +120,7 @@ class ImageTransformTest( unittest.TestCase ) :
 		t["transform"]["scale"].setValue( IECore.V2f( 2., 2. ) )	
 		
 		dirtiedPlugs = set( [ x[0].relativeName( x[0].node() ) for x in cs ] )
-		self.assertEqual( len( dirtiedPlugs ), 8 )
+		self.assertEqual( len( dirtiedPlugs ), 7 )
 		self.assertTrue( "transform.scale.x" in dirtiedPlugs )
 		self.assertTrue( "transform.scale.y" in dirtiedPlugs )
 		self.assertTrue( "transform.scale" in dirtiedPlugs )
@@ -127,7 +128,6 @@ class ImageTransformTest( unittest.TestCase ) :
 		self.assertTrue( "out" in dirtiedPlugs )
 		self.assertTrue( "out.channelData" in dirtiedPlugs )
 		self.assertTrue( "out.dataWindow" in dirtiedPlugs )
-		self.assertTrue( "__scaledFormat" in dirtiedPlugs )
 
 	def testOutputFormat( self ) :
 	
@@ -239,6 +239,95 @@ class ImageTransformTest( unittest.TestCase ) :
 		
 		self.assertFalse( res.value )
 
+	def testPivotWithNonUniformScale( self ) :
+
+		# Scaling about a pivot should be the same as scaling about the
+		# origin and then translating by pivot - pivot * scale, as it was
+		# when the scale was applied by a separate Reformat pass. The values
+		# are chosen so that both matrices are exact.
+
+		reader = GafferImage.ImageReader()
+		reader["fileName"].setValue( os.path.join( self.path, "checkerWithNegativeDataWindow.200x150.exr" ) )
+		inWindow = reader["out"]["dataWindow"].getValue()
+
+		pivot = IECore.V2f( 50, 30 )
+		scale = IECore.V2f( 0.75, 1.25 )
+
+		t1 = GafferImage.ImageTransform()
+		t1["in"].setInput( reader["out"] )
+		t1["transform"]["pivot"].setValue( pivot )
+		t1["transform"]["scale"].setValue( scale )
+
+		t2 = GafferImage.ImageTransform()
+		t2["in"].setInput( reader["out"] )
+		t2["transform"]["scale"].setValue( scale )
+		t2["transform"]["translate"].setValue( IECore.V2f( pivot.x - pivot.x * scale.x, pivot.y - pivot.y * scale.y ) )
+
+		# The data window should bound the transformed corners of the input,
+		# with the maximum inclusive as usual.
+		def transformed( x, y ) :
+			return ( ( x - pivot.x ) * scale.x + pivot.x, ( y - pivot.y ) * scale.y + pivot.y )
+
+		corners = [ transformed( x, y ) for x in ( inWindow.min.x, inWindow.max.x + 1 ) for y in ( inWindow.min.y, inWindow.max.y + 1 ) ]
+		expectedWindow = IECore.Box2i(
+			IECore.V2i( int( math.floor( min( c[0] for c in corners ) ) ), int( math.floor( min( c[1] for c in corners ) ) ) ),
+			IECore.V2i( int( math.ceil( max( c[0] for c in corners ) ) ) - 1, int( math.ceil( max( c[1] for c in corners ) ) ) - 1 ),
+		)
+
+		self.assertEqual( t1["out"]["dataWindow"].getValue(), expectedWindow )
+		self.assertEqual( t2["out"]["dataWindow"].getValue(), expectedWindow )
+
+		image1 = t1["out"].image()
+		image1.blindData().clear()
+		image2 = t2["out"].image()
+		image2.blindData().clear()
+
+		op = IECore.ImageDiffOp()
+		res = op(
+			imageA = image1,
+			imageB = image2
+		)
+
+		self.assertFalse( res.value )
+
+	def testIntegerTranslation( self ) :
+
+		r = GafferImage.ImageReader()
+		r["fileName"].setValue( self.fileName )
+
+		t = GafferImage.ImageTransform()
+		t["in"].setInput( r["out"] )
+		t["transform"]["pivot"].setValue( IECore.V2f( 10.3, 20.7 ) )
+
+		tileSize = GafferImage.ImagePlug.tileSize()
+		inWindow = r["out"]["dataWindow"].getValue()
+
+		for offset in ( IECore.V2i( tileSize, -2 * tileSize ), IECore.V2i( 3, -7 ) ) :
+
+			t["transform"]["translate"].setValue( IECore.V2f( offset.x, offset.y ) )
+
+			outWindow = t["out"]["dataWindow"].getValue()
+			self.assertEqual( outWindow, IECore.Box2i( inWindow.min + offset, inWindow.max + offset ) )
+
+			c = Gaffer.Context()
+			c["image:channelName"] = "R"
+			c["image:tileOrigin"] = IECore.V2i( 0 )
+			with c :
+				inSampler = GafferImage.Sampler( r["out"], "R", inWindow )
+				outSampler = GafferImage.Sampler( t["out"], "R", outWindow )
+				self.assertEqual( inSampler.sampleRegion( inWindow ), outSampler.sampleRegion( outWindow ) )
+
+		# Tile aligned translations should pass through the input tiles unchanged.
+		t["transform"]["translate"].setValue( IECore.V2f( tileSize, -2 * tileSize ) )
+		self.assertEqual(
+			t["out"].channelDataHash( "R", IECore.V2i( tileSize, -2 * tileSize ) ),
+			r["out"].channelDataHash( "R", IECore.V2i( 0 ) )
+		)
+		self.assertEqual(
+			t["out"].channelData( "R", IECore.V2i( tileSize, -2 * tileSize ) ),
+			r["out"].channelData( "R", IECore.V2i( 0 ) )
+		)
+
 	def testChannelNamesPassThrough( self ) :
 	
 		c = GafferImage.Constant()
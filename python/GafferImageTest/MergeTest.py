@@ -172,7 +172,95 @@ class MergeTest( unittest.TestCase ) :
 		expected = IECore.Reader.create( self.checkerRGBPath ).read()
 		
 		self.assertTrue( not IECore.ImageDiffOp()( imageA = expected, imageB = mergeResult, skipMissingChannels = False, maxError = 0.001 ).value )
+	
+	def testConstantInputs( self ) :
+	
+		c1 = GafferImage.Constant()
+		c1["color"].setValue( IECore.Color4f( 0.25, 0.5, 0.75, 1 ) )
+		
+		c2 = GafferImage.Constant()
+		c2["color"].setValue( IECore.Color4f( 0.5, 0.25, 0, 0.5 ) )
+		
+		merge = GafferImage.Merge()
+		merge["operation"].setValue(8) # 8 is the Enum value of the over operation.
+		merge["in"].setInput( c1["out"] )
+		merge["in1"].setInput( c2["out"] )
+		
+		# B * ( 1 - alphaA ) + A
+		expected = { "R" : 0.625, "G" : 0.5, "B" : 0.375, "A" : 1 }
+		for channel, value in expected.items() :
+			tile = merge["out"].channelData( channel, IECore.V2i( 0 ) )
+			self.assertEqual( len( tile ), GafferImage.ImagePlug.tileSize() ** 2 )
+			for v in tile :
+				self.assertAlmostEqual( v, value, 6 )
+	
+	def testManyInputs( self ) :
+	
+		r = GafferImage.ImageReader()
+		r["fileName"].setValue( self.checkerPath )
+		
+		g = GafferImage.Grade()
+		g["in"].setInput( r["out"] )
+		g["multiply"].setValue( IECore.Color3f( 0.5, 0.25, 0.125 ) )
+		
+		for numInputs in ( 2, 8, 32 ) :
 		
+			merge = GafferImage.Merge()
+			merge["operation"].setValue(0) # 0 is the Enum value of the add operation.
+			for i in range( 0, numInputs ) :
+				merge["in%s" % ( str( i ) if i else "" )].setInput( g["out"] )
+			
+			graded = g["out"].channelData( "R", IECore.V2i( 0 ) )
+			merged = merge["out"].channelData( "R", IECore.V2i( 0 ) )
+			for a, b in zip( graded, merged ) :
+				self.assertAlmostEqual( a * numInputs, b, 4 )
 
+	def testTilesOutsideDataWindow( self ) :
+	
+		c1 = GafferImage.Constant()
+		c1["format"].setValue( GafferImage.Format( 100, 100, 1. ) )
+		c1["color"].setValue( IECore.Color4f( 0.25, 0.5, 0.75, 1 ) )
+		
+		c2 = GafferImage.Constant()
+		c2["format"].setValue( GafferImage.Format( 300, 300, 1. ) )
+		c2["color"].setValue( IECore.Color4f( 0.5, 0.25, 0, 0.5 ) )
+		
+		merge = GafferImage.Merge()
+		merge["operation"].setValue(8) # 8 is the Enum value of the over operation.
+		merge["in"].setInput( c2["out"] )
+		merge["in1"].setInput( c1["out"] )
+		
+		# A tile outside the data window of c1 should see only c2,
+		# and shouldn't depend on c1 at all.
+		tileOrigin = IECore.V2i( 2 * GafferImage.ImagePlug.tileSize() )
+		for channel, value in { "R" : 0.5, "G" : 0.25, "B" : 0, "A" : 0.5 }.items() :
+			for v in merge["out"].channelData( channel, tileOrigin ) :
+				self.assertAlmostEqual( v, value, 6 )
+		
+		h = merge["out"].channelDataHash( "R", tileOrigin )
+		c1["color"].setValue( IECore.Color4f( 1, 0, 0, 1 ) )
+		self.assertEqual( merge["out"].channelDataHash( "R", tileOrigin ), h )
+		
+		# A tile inside it must still depend on c1.
+		h = merge["out"].channelDataHash( "R", IECore.V2i( 0 ) )
+		c1["color"].setValue( IECore.Color4f( 0, 1, 0, 1 ) )
+		self.assertNotEqual( merge["out"].channelDataHash( "R", IECore.V2i( 0 ) ), h )
+		
+		# As should the R channel when only the alpha of c1 changes.
+		h = merge["out"].channelDataHash( "R", IECore.V2i( 0 ) )
+		c1["color"].setValue( IECore.Color4f( 0, 1, 0, 0.5 ) )
+		self.assertNotEqual( merge["out"].channelDataHash( "R", IECore.V2i( 0 ) ), h )
+		
+		# And tiles outside the data window of the merge are black.
+		tileOrigin = IECore.V2i( 8 * GafferImage.ImagePlug.tileSize() )
+		self.assertEqual( set( merge["out"].channelData( "R", tileOrigin ) ), set( [ 0 ] ) )
+		
+		grade = GafferImage.Grade()
+		grade["in"].setInput( c1["out"] )
+		grade["offset"].setValue( IECore.Color3f( 1 ) )
+		tileOrigin = IECore.V2i( GafferImage.ImagePlug.tileSize() * 2 )
+		self.assertEqual( set( grade["out"].channelData( "R", tileOrigin ) ), set( [ 0 ] ) )
+		self.assertEqual( grade["out"].channelDataHash( "R", tileOrigin ), grade["out"].channelDataHash( "G", tileOrigin * 2 ) )
+		
 if __name__ == "__main__":
 	unittest.main()
@@ -82,5 +82,24 @@ class ObjectToImageTest( unittest.TestCase ) :
 			n["out"].channelDataHash( "R", IECore.V2i( GafferImage.ImagePlug.tileSize() ) )
 		)
 
+	def testChangingObject( self ) :
+	
+		i1 = IECore.Reader.create( self.fileName ).read()
+		i1.blindData().clear()
+		i2 = IECore.Reader.create( self.negFileName ).read()
+		i2.blindData().clear()
+		
+		n = GafferImage.ObjectToImage()
+		n["object"].setValue( i1 )
+		self.assertEqual( n["out"].image(), i1 )
+		
+		n["object"].setValue( i2 )
+		self.assertEqual( n["out"].image(), i2 )
+		
+		# tiles outside the data window should be black
+		dataWindow = n["out"]["dataWindow"].getValue()
+		tileOrigin = GafferImage.ImagePlug.tileOrigin( dataWindow.max ) + IECore.V2i( GafferImage.ImagePlug.tileSize() )
+		self.assertEqual( set( n["out"].channelData( "R", tileOrigin ) ), set( [ 0 ] ) )
+
 if __name__ == "__main__":
 	unittest.main()
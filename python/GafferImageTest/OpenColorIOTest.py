@@ -130,5 +130,27 @@ class OpenColorIOTest( unittest.TestCase ) :
 			o["out"].channelData( "G", IECore.V2i( 0 ) )
 		)
 		
+	def testBakeLUT( self ) :
+
+		i = GafferImage.ImageReader()
+		i["fileName"].setValue( os.path.expandvars( "$GAFFER_ROOT/python/GafferTest/images/circles.exr" ) )
+
+		o = GafferImage.OpenColorIO()
+		o["in"].setInput( i["out"] )
+		o["inputSpace"].setValue( "linear" )
+		o["outputSpace"].setValue( "sRGB" )
+
+		exact = o["out"].channelData( "R", IECore.V2i( 0 ) )
+		exactHash = o["out"].channelDataHash( "R", IECore.V2i( 0 ) )
+
+		o["bakeLUT"].setValue( True )
+
+		approximate = o["out"].channelData( "R", IECore.V2i( 0 ) )
+		self.assertNotEqual( o["out"].channelDataHash( "R", IECore.V2i( 0 ) ), exactHash )
+
+		self.assertEqual( len( exact ), len( approximate ) )
+		for e, a in zip( exact, approximate ) :
+			self.assertAlmostEqual( e, a, delta = 0.01 )
+
 if __name__ == "__main__":
 	unittest.main()
@@ -73,8 +73,10 @@ class ReformatTest( unittest.TestCase ) :
 		reformat["format"].setValue( GafferImage.Format( 150, 125, 1. ) )
 		
 		dirtiedPlugs = set( [ x[0].relativeName( x[0].node() ) for x in cs ] )
-		self.assertEqual( len( dirtiedPlugs ), 5 )
+		self.assertEqual( len( dirtiedPlugs ), 7 )
 		self.assertTrue( "format" in dirtiedPlugs )
+		self.assertTrue( "__xWeights" in dirtiedPlugs )
+		self.assertTrue( "__yWeights" in dirtiedPlugs )
 		self.assertTrue( "out" in dirtiedPlugs )
 		self.assertTrue( "out.dataWindow" in dirtiedPlugs )
 		self.assertTrue( "out.channelData" in dirtiedPlugs )
@@ -179,6 +181,60 @@ class ReformatTest( unittest.TestCase ) :
 			
 			self.assertFalse( res.value )	
 		
+	def testBoxDownsampleByIntegerRatio( self ) :
+
+		reader = GafferImage.ImageReader()
+		reader["fileName"].setValue( os.path.join( self.path, "checkerboard.100x100.exr" ) )
+
+		reformat = GafferImage.Reformat()
+		reformat["in"].setInput( reader["out"] )
+		reformat["filter"].setValue( "Box" )
+		reformat["format"].setValue( GafferImage.Format( 50, 25, 1. ) )
+
+		c = Gaffer.Context()
+		c["image:channelName"] = "R"
+		c["image:tileOrigin"] = IECore.V2i( 0 )
+
+		with c :
+
+			inWindow = reader["out"]["dataWindow"].getValue()
+			inSampler = GafferImage.Sampler( reader["out"], "R", inWindow, GafferImage.BoundingMode.Clamp )
+			inPixels = inSampler.sampleRegion( IECore.Box2i( IECore.V2i( 0 ), IECore.V2i( 99 ) ) )
+
+			outSampler = GafferImage.Sampler( reformat["out"], "R", reformat["out"]["dataWindow"].getValue(), GafferImage.BoundingMode.Clamp )
+			outPixels = outSampler.sampleRegion( IECore.Box2i( IECore.V2i( 0 ), IECore.V2i( 49, 24 ) ) )
+
+		# Each output pixel should be the average of a 2x4 block of input pixels.
+		for y in range( 0, 25 ) :
+			for x in range( 0, 50 ) :
+				expected = 0
+				for j in range( y * 4, y * 4 + 4 ) :
+					for i in range( x * 2, x * 2 + 2 ) :
+						expected += inPixels[j*100+i]
+				self.assertAlmostEqual( outPixels[y*50+x], expected / 8., 5 )
+
+	def testIntegerRatioOfConstant( self ) :
+
+		# Scaling a constant image by an integer ratio, in either direction
+		# and with any filter, must leave it unchanged.
+
+		c = GafferImage.Constant()
+		c["format"].setValue( GafferImage.Format( 128, 96, 1. ) )
+		c["color"].setValue( IECore.Color4f( 0.25, 0.5, 0.75, 1 ) )
+
+		r = GafferImage.Reformat()
+		r["in"].setInput( c["out"] )
+
+		for filter in ( "Box", "Bilinear" ) :
+			r["filter"].setValue( filter )
+			for format in ( GafferImage.Format( 64, 48, 1. ), GafferImage.Format( 256, 192, 1. ) ) :
+				r["format"].setValue( format )
+				image = r["out"].image()
+				self.assertEqual( image.dataWindow, format.getDisplayWindow() )
+				for channelName, value in zip( ( "R", "G", "B" ), ( 0.25, 0.5, 0.75 ) ) :
+					for v in image[channelName].data :
+						self.assertAlmostEqual( v, value, 5 )
+
 	def testChannelNamesPassThrough( self ) :
 	
 		c = GafferImage.Constant()
@@ -188,3 +244,29 @@ class ReformatTest( unittest.TestCase ) :
 		
 		self.assertEqual( r["out"]["channelNames"].hash(), c["out"]["channelNames"].hash() )
 		self.assertEqual( r["out"]["channelNames"].getValue(), c["out"]["channelNames"].getValue() )
+
+	def testWeightsSharedAcrossTiles( self ) :
+	
+		c = GafferImage.Constant()
+		c["format"].setValue( GafferImage.Format( 300, 300, 1.0 ) )
+		r = GafferImage.Reformat()
+		r["in"].setInput( c["out"] )
+		r["format"].setValue( GafferImage.Format( 250, 220, 1.0 ) )
+		
+		tileSize = GafferImage.ImagePlug.tileSize()
+		def weightsHashes( tileOrigin ) :
+			context = Gaffer.Context()
+			context["image:tileOrigin"] = tileOrigin
+			with context :
+				return r["__xWeights"].hash(), r["__yWeights"].hash()
+		
+		x1, y1 = weightsHashes( IECore.V2i( 0 ) )
+		x2, y2 = weightsHashes( IECore.V2i( 0, tileSize ) )
+		x3, y3 = weightsHashes( IECore.V2i( tileSize, 0 ) )
+		
+		# tiles in the same column share their x weights, and
+		# tiles in the same row share their y weights.
+		self.assertEqual( x1, x2 )
+		self.assertNotEqual( y1, y2 )
+		self.assertEqual( y1, y3 )
+		self.assertNotEqual( x1, x3 )
@@ -175,6 +175,41 @@ class SamplerTest( unittest.TestCase ) :
 			self.assertEqual( s.sample( bounds.max.x+1, bounds.min.y ), br )
 			self.assertEqual( s.sample( bounds.max.x, bounds.min.y-1 ), br )
 	
+	def testSampleRegion( self ) :
+
+		s = Gaffer.ScriptNode()
+		r = GafferImage.ImageReader()
+		r["fileName"].setValue( self.fileName )
+		s.addChild( r )
+
+		c = Gaffer.Context()
+		c["image:channelName"] = 'R'
+		c["image:tileOrigin"] = IECore.V2i( 0 )
+
+		bounds = r["out"]["dataWindow"].getValue()
+
+		# A region that straddles the edges of the data window, so that
+		# both the bounding modes and the tile boundaries are exercised.
+		region = IECore.Box2i( bounds.min - IECore.V2i( 5 ), IECore.V2i( bounds.min.x + 70, bounds.max.y + 3 ) )
+
+		# We use a box filter for the reference samples, so that they
+		# are just lookups of the pixel containing the sample position.
+		f = GafferImage.Filter.create( "Box" )
+
+		with c :
+
+			for boundingMode in ( GafferImage.BoundingMode.Black, GafferImage.BoundingMode.Clamp ) :
+
+				sampler = GafferImage.Sampler( r["out"], "R", bounds, f, boundingMode )
+				samples = sampler.sampleRegion( region )
+				self.assertEqual( len( samples ), ( region.size().x + 1 ) * ( region.size().y + 1 ) )
+
+				i = 0
+				for y in range( region.min.y, region.max.y + 1 ) :
+					for x in range( region.min.x, region.max.x + 1 ) :
+						self.assertEqual( samples[i], sampler.sample( x + .5, y + .5 ) )
+						i += 1
+
 	# Test that the hash() method accumulates all of the hashes of the tiles within the sample area
 	# for a large number of different sample areas.
 	def testSampleHash( self ) :
@@ -0,0 +1,106 @@
+##########################################################################
+#
+#  Copyright (c) 2014, Image Engine Design Inc. All rights reserved.
+#
+#  Redistribution and use in source and binary forms, with or without
+#  modification, are permitted provided that the following conditions are
+#  met:
+#
+#      * Redistributions of source code must retain the above
+#        copyright notice, this list of conditions and the following
+#        disclaimer.
+#
+#      * Redistributions in binary form must reproduce the above
+#        copyright notice, this list of conditions and the following
+#        disclaimer in the documentation and/or other materials provided with
+#        the distribution.
+#
+#      * Neither the name of John Haddon nor the names of
+#        any other contributors to this software may be used to endorse or
+#        promote products derived from this software without specific prior
+#        written permission.
+#
+#  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+#  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+#  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+#  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+#  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+#  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+#  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+#  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+#  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+#  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+#  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+##########################################################################
+
+import os
+import shutil
+import tempfile
+import subprocess
+import unittest
+
+import IECore
+
+import GafferTest
+import GafferImage
+
+class TileSizeTest( GafferTest.TestCase ) :
+
+	__benchmarkScript = os.path.dirname( __file__ ) + "/pythonScripts/tileSizeBenchmark.py"
+	__tileSizes = ( 32, 64, 128, 256 )
+	
+	def setUp( self ) :
+	
+		GafferTest.TestCase.setUp( self )
+		
+		self.__temporaryDirectory = tempfile.mkdtemp( prefix = "gafferImageTileSizeTest" )
+	
+	def __outputFile( self, tileSize ) :
+	
+		return os.path.join( self.__temporaryDirectory, "tileSizeTest.%d.exr" % tileSize )
+	
+	def __runBenchmark( self, tileSize ) :
+	
+		env = os.environ.copy()
+		env["GAFFERIMAGE_TILE_SIZE"] = str( tileSize )
+		
+		p = subprocess.Popen(
+			"gaffer python " + self.__benchmarkScript + " -arguments " + self.__outputFile( tileSize ) + " 300 200",
+			shell = True,
+			env = env,
+			stdout = subprocess.PIPE,
+			stderr = subprocess.PIPE,
+		)
+		stdout, stderr = p.communicate()
+		self.assertEqual( p.returncode, 0, stderr )
+		
+		return stdout
+	
+	def testDefault( self ) :
+	
+		if "GAFFERIMAGE_TILE_SIZE" not in os.environ :
+			self.assertEqual( GafferImage.ImagePlug.tileSize(), 64 )
+	
+	def testTileSizes( self ) :
+	
+		# Runs the benchmark graphs on small images at each tile size, checking
+		# that the results are independent of the tile size. Run the benchmark
+		# script directly to get timings at production resolution.
+	
+		for tileSize in self.__tileSizes :
+			self.__runBenchmark( tileSize )
+		
+		expected = IECore.Reader.create( self.__outputFile( 64 ) ).read()
+		for tileSize in self.__tileSizes :
+			image = IECore.Reader.create( self.__outputFile( tileSize ) ).read()
+			self.assertFalse( IECore.ImageDiffOp()( imageA = expected, imageB = image, maxError = 0.0001 ).value )
+	
+	def tearDown( self ) :
+	
+		GafferTest.TestCase.tearDown( self )
+		
+		shutil.rmtree( self.__temporaryDirectory )
+		
+if __name__ == "__main__":
+	unittest.main()
@@ -62,6 +62,9 @@ from ImageTimeWarpTest import ImageTimeWarpTest
 from ImageSamplerTest import ImageSamplerTest
 from ImageNodeTest import ImageNodeTest
 from FormatDataTest import FormatDataTest
+from TileSizeTest import TileSizeTest
+from AutoCropTest import AutoCropTest
+from BlurTest import BlurTest
 
 if __name__ == "__main__":
 	import unittest
@@ -0,0 +1,83 @@
+##########################################################################
+#
+#  Copyright (c) 2014, Image Engine Design Inc. All rights reserved.
+#
+#  Redistribution and use in source and binary forms, with or without
+#  modification, are permitted provided that the following conditions are
+#  met:
+#
+#      * Redistributions of source code must retain the above
+#        copyright notice, this list of conditions and the following
+#        disclaimer.
+#
+#      * Redistributions in binary form must reproduce the above
+#        copyright notice, this list of conditions and the following
+#        disclaimer in the documentation and/or other materials provided with
+#        the distribution.
+#
+#      * Neither the name of John Haddon nor the names of
+#        any other contributors to this software may be used to endorse or
+#        promote products derived from this software without specific prior
+#        written permission.
+#
+#  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+#  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+#  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+#  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+#  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+#  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+#  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+#  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+#  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+#  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+#  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+##########################################################################
+
+
+# This script times Merge nodes with 2, 8 and 32 inputs, so that the cost of
+# merging many layers in a single pass can be measured :
+#
+#	gaffer python mergeBenchmark.py
+#
+# It may be passed a width and height to use in place of the default 2048x1556 :
+#
+#	gaffer python mergeBenchmark.py -arguments 300 200
+
+import os
+
+import IECore
+
+import GafferImage
+
+width, height = 2048, 1556
+if len( argv ) > 1 :
+	width, height = int( argv[0] ), int( argv[1] )
+
+reader = GafferImage.ImageReader()
+reader["fileName"].setValue( os.path.expandvars( "$GAFFER_ROOT/python/GafferTest/images/checkerboard.100x100.exr" ) )
+
+reformat = GafferImage.Reformat()
+reformat["in"].setInput( reader["out"] )
+reformat["format"].setValue( GafferImage.Format( width, height, 1. ) )
+
+# Each layer is graded differently so that the merge operates on distinct
+# tiles, and the layers are computed up front so that only the merge
+# itself is timed.
+layers = []
+for i in range( 0, 32 ) :
+	grade = GafferImage.Grade()
+	grade["in"].setInput( reformat["out"] )
+	grade["multiply"].setValue( IECore.Color3f( 1.0 / ( i + 1 ) ) )
+	grade["out"].image()
+	layers.append( grade )
+
+for operation, operationName in ( ( 0, "add" ), ( 8, "over" ) ) :
+	for numInputs in ( 2, 8, 32 ) :
+		merge = GafferImage.Merge()
+		merge["operation"].setValue( operation )
+		for i in range( 0, numInputs ) :
+			merge["in%s" % ( str( i ) if i else "" )].setInput( layers[i]["out"] )
+		t = IECore.Timer()
+		merge["out"].image()
+		print "%-6s %3d inputs %8.3f" % ( operationName, numInputs, t.stop() )
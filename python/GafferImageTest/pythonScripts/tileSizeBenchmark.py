@@ -0,0 +1,107 @@
+##########################################################################
+#
+#  Copyright (c) 2014, Image Engine Design Inc. All rights reserved.
+#
+#  Redistribution and use in source and binary forms, with or without
+#  modification, are permitted provided that the following conditions are
+#  met:
+#
+#      * Redistributions of source code must retain the above
+#        copyright notice, this list of conditions and the following
+#        disclaimer.
+#
+#      * Redistributions in binary form must reproduce the above
+#        copyright notice, this list of conditions and the following
+#        disclaimer in the documentation and/or other materials provided with
+#        the distribution.
+#
+#      * Neither the name of John Haddon nor the names of
+#        any other contributors to this software may be used to endorse or
+#        promote products derived from this software without specific prior
+#        written permission.
+#
+#  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+#  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+#  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+#  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+#  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+#  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+#  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+#  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+#  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+#  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+#  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+##########################################################################
+
+# This script is used by TileSizeTest.py. It times the processing of some
+# representative graphs at the tile size specified by the GAFFERIMAGE_TILE_SIZE
+# environment variable, so it must be run in a fresh process for each tile size :
+#
+#	GAFFERIMAGE_TILE_SIZE=128 gaffer python tileSizeBenchmark.py
+#
+# If a file name is passed as an argument, the final image is written to it
+# so that the results at different tile sizes may be compared. It may be
+# followed by a width and height to use in place of the default 2048x1556 :
+#
+#	gaffer python tileSizeBenchmark.py -arguments /tmp/out.exr 300 200
+
+import os
+import sys
+
+import IECore
+
+import GafferImage
+
+tileSize = GafferImage.ImagePlug.tileSize()
+if "GAFFERIMAGE_TILE_SIZE" in os.environ and int( os.environ["GAFFERIMAGE_TILE_SIZE"] ) != tileSize :
+	sys.stderr.write( "Tile size %d does not match GAFFERIMAGE_TILE_SIZE\n" % tileSize )
+	sys.exit( 1 )
+
+def timeImage( name, plug ) :
+
+	t = IECore.Timer()
+	image = plug.image()
+	print "%-12s %5d %8.3f" % ( name, tileSize, t.stop() )
+	return image
+
+width, height = 2048, 1556
+if len( argv ) > 2 :
+	width, height = int( argv[1] ), int( argv[2] )
+
+reader = GafferImage.ImageReader()
+reader["fileName"].setValue( os.path.expandvars( "$GAFFER_ROOT/python/GafferTest/images/checkerboard.100x100.exr" ) )
+
+reformat = GafferImage.Reformat()
+reformat["in"].setInput( reader["out"] )
+reformat["format"].setValue( GafferImage.Format( width, height, 1. ) )
+timeImage( "reformat", reformat["out"] )
+
+grade = GafferImage.Grade()
+grade["in"].setInput( reformat["out"] )
+grade["multiply"].setValue( IECore.Color3f( 0.5, 0.25, 0.125 ) )
+grade["gamma"].setValue( IECore.Color3f( 1.2 ) )
+timeImage( "grade", grade["out"] )
+
+transform = GafferImage.ImageTransform()
+transform["in"].setInput( reformat["out"] )
+transform["transform"]["rotate"].setValue( 10 )
+transform["transform"]["scale"].setValue( IECore.V2f( 0.9 ) )
+timeImage( "transform", transform["out"] )
+
+merge = GafferImage.Merge()
+merge["operation"].setValue( 8 ) # Over
+merge["in"].setInput( grade["out"] )
+merge["in1"].setInput( transform["out"] )
+image = timeImage( "merge", merge["out"] )
+
+stats = GafferImage.ImageStats()
+stats["in"].setInput( merge["out"] )
+stats["channels"].setValue( IECore.StringVectorData( [ "R", "G", "B", "A" ] ) )
+stats["regionOfInterest"].setValue( merge["out"]["format"].getValue().getDisplayWindow() )
+t = IECore.Timer()
+stats["average"].getValue()
+print "%-12s %5d %8.3f" % ( "stats", tileSize, t.stop() )
+
+if argv :
+	IECore.Writer.create( image, argv[0] ).write()
@@ -34,6 +34,7 @@
 #  
 ##########################################################################
 
+import time
 import threading
 
 import IECore
@@ -42,15 +43,24 @@ import GafferUI
 
 import GafferImage
 
+QtCore = GafferUI._qtImport( "QtCore" )
+
 __all__ = []
 
 ## Here we're taking signals the Display node emits when it has new data, and using them
 # to trigger a plugDirtiedSignal on the main ui thread. This is necessary because the Display
-# receives data on a background thread, where we can't do ui stuff.
+# receives data on a background thread, where we can't do ui stuff. Signals arriving while
+# an update is pending are coalesced into that update, and we limit the rate at which each
+# Display is updated, so that fast renders don't swamp the ui with redraws.
 
 __plugsPendingUpdate = []
 __plugsPendingUpdateLock = threading.Lock()
 
+__minimumUpdateInterval = 0.1 # seconds
+## Pairs of ( plug, time ) for the updates made within the last
+# __minimumUpdateInterval. Only accessed on the ui thread.
+__recentUpdates = []
+
 def __scheduleUpdate( plug, force = False ) :
 
 	if not force :
@@ -67,13 +77,27 @@ def __scheduleUpdate( plug, force = False ) :
 		
 def __update( plug ) :
 
-	updateCountPlug = plug.node()["__updateCount"]
-	updateCountPlug.setValue( updateCountPlug.getValue() + 1 )
+	global __recentUpdates
+	now = time.time()
+	__recentUpdates = [ u for u in __recentUpdates if now - u[1] < __minimumUpdateInterval ]
+	for p, t in __recentUpdates :
+		if p.isSame( plug ) :
+			QtCore.QTimer.singleShot( int( ( t + __minimumUpdateInterval - now ) * 1000 ), lambda : __update( plug ) )
+			return
+	
+	__recentUpdates.append( ( plug, now ) )
 
+	# we must remove the plug from the pending list before
+	# incrementing the update count, so that a signal arriving
+	# after the plug has been dirtied schedules another update
+	# rather than being lost.
 	global __plugsPendingUpdate
 	global __plugsPendingUpdateLock
 	with __plugsPendingUpdateLock :
 		__plugsPendingUpdate = [ p for p in __plugsPendingUpdate if not p.isSame( plug ) ]
+
+	updateCountPlug = plug.node()["__updateCount"]
+	updateCountPlug.setValue( updateCountPlug.getValue() + 1 )
 	
 __displayDataReceivedConnection = GafferImage.Display.dataReceivedSignal().connect( __scheduleUpdate )
 __displayImageReceivedConnection = GafferImage.Display.imageReceivedSignal().connect( IECore.curry( __scheduleUpdate, force = True ) )
\ No newline at end of file
@@ -164,3 +164,18 @@ GafferUI.PlugValueWidget.registerCreator(
 Gaffer.Metadata.registerPlugDescription( GafferImageUI.ImageView, "displayTransform",
 	"Applies colour space transformations for viewing the image correctly."
 )
+
+## Prefetching. These are not shown in the toolbar, to keep it uncluttered,
+# but may be set from a startup file to suit the memory of the machine.
+
+GafferUI.PlugValueWidget.registerCreator( GafferImageUI.ImageView, "prefetchFrames", None )
+GafferUI.PlugValueWidget.registerCreator( GafferImageUI.ImageView, "prefetchMemory", None )
+
+Gaffer.Metadata.registerPlugDescription( GafferImageUI.ImageView, "prefetchFrames",
+	"The number of frames to compute in advance, in the direction of playback, "
+	"while the viewer is otherwise idle."
+)
+
+Gaffer.Metadata.registerPlugDescription( GafferImageUI.ImageView, "prefetchMemory",
+	"The maximum memory (in megabytes) to use for prefetched frames."
+)
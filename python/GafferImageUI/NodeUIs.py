@@ -160,4 +160,13 @@ GafferUI.PlugValueWidget.registerCreator(
 	labelsAndValues = removeChannelsLabelsAndValues
 )
 
+# Blur
+blurModeLabelsAndValues = [ ( "Box", 0 ), ( "Gaussian", 1 ), ( "Filter", 2 ) ]
+GafferUI.PlugValueWidget.registerCreator(
+	GafferImage.Blur,
+	"mode",
+	GafferUI.EnumPlugValueWidget,
+	labelsAndValues = blurModeLabelsAndValues
+)
+
 
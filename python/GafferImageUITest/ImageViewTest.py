@@ -87,6 +87,73 @@ class ImageViewTest( GafferUITest.TestCase ) :
 		
 		view._update()	
 		
+	def testProgressiveUpdate( self ) :
+	
+		constant = GafferImage.Constant()
+		constant["format"].setValue( GafferImage.Format( 2048, 2048, 1. ) )
+		
+		view = GafferUI.View.create( constant["out"] )
+		view.viewportGadget().setViewport( IECore.V2i( 2048 ) )
+		
+		self.assertGreater( self.__updateUntilComplete( view ), 1 )
+		
+		# Once everything is up to date, there's nothing more to do.
+		self.assertEqual( self.__updateUntilComplete( view ), 1 )
+		
+		# Editing the image dirties the view, and the tiles must
+		# be recomputed.
+		requests = GafferTest.CapturingSlot( view.updateRequestSignal() )
+		constant["color"].setValue( IECore.Color4f( 0.5 ) )
+		self.assertTrue( len( requests ) )
+		self.assertGreater( self.__updateUntilComplete( view ), 1 )
+	
+	def testPrefetch( self ) :
+	
+		constant = GafferImage.Constant()
+		constant["format"].setValue( GafferImage.Format( 2048, 2048, 1. ) )
+		
+		view = GafferUI.View.create( constant["out"] )
+		view.viewportGadget().setViewport( IECore.V2i( 2048 ) )
+		view["prefetchFrames"].setValue( 4 )
+		
+		# We don't know which way to prefetch until the frame has changed.
+		self.__updateUntilComplete( view )
+		self.assertEqual( self.__updateUntilComplete( view ), 1 )
+		
+		# The image is the same on every frame, so once the frame changes
+		# there's nothing to recompute for display, and all the updates
+		# are spent prefetching the following frames.
+		view.getContext().setFrame( 2 )
+		self.assertGreater( self.__updateUntilComplete( view ), 1 )
+		self.assertEqual( self.__updateUntilComplete( view ), 1 )
+		
+		# Stepping forward only needs to prefetch one more frame, which is
+		# less work than reversing direction, which starts again.
+		view.getContext().setFrame( 3 )
+		numForwardUpdates = self.__updateUntilComplete( view )
+		view.getContext().setFrame( 2 )
+		numReverseUpdates = self.__updateUntilComplete( view )
+		self.assertGreater( numReverseUpdates, numForwardUpdates )
+		
+		# And with prefetching off, there's nothing to do.
+		view["prefetchFrames"].setValue( 0 )
+		view.getContext().setFrame( 1 )
+		self.assertEqual( self.__updateUntilComplete( view ), 1 )
+	
+	def __updateUntilComplete( self, view ) :
+	
+		# Tiles are computed a batch at a time, with the view requesting
+		# another update until all the visible tiles are complete.
+		numUpdates = 0
+		requests = GafferTest.CapturingSlot( view.updateRequestSignal() )
+		while True :
+			del requests[:]
+			view._update()
+			numUpdates += 1
+			if not len( requests ) :
+				return numUpdates
+			self.assertLess( numUpdates, 10000 )
+		
 if __name__ == "__main__":
 	unittest.main()
 	
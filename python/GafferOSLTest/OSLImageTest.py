@@ -91,12 +91,13 @@ class OSLImageTest( GafferOSLTest.OSLTestCase ) :
 		cs = GafferTest.CapturingSlot( image.plugDirtiedSignal() )
 		image["shader"].setInput( imageShader["out"] )
 				
-		self.assertEqual( len( cs ), 5 )
+		self.assertEqual( len( cs ), 6 )
 		self.assertTrue( cs[0][0].isSame( image["shader"] ) )
-		self.assertTrue( cs[1][0].isSame( image["__shading"] ) )
-		self.assertTrue( cs[2][0].isSame( image["out"]["channelNames"] ) )
-		self.assertTrue( cs[3][0].isSame( image["out"]["channelData"] ) )
-		self.assertTrue( cs[4][0].isSame( image["out"] ) )
+		self.assertTrue( cs[1][0].isSame( image["__batchShading"] ) )
+		self.assertTrue( cs[2][0].isSame( image["__shading"] ) )
+		self.assertTrue( cs[3][0].isSame( image["out"]["channelNames"] ) )
+		self.assertTrue( cs[4][0].isSame( image["out"]["channelData"] ) )
+		self.assertTrue( cs[5][0].isSame( image["out"] ) )
 		
 		inputImage = reader["out"].image()
 		outputImage = image["out"].image()
@@ -112,23 +113,25 @@ class OSLImageTest( GafferOSLTest.OSLTestCase ) :
 		
 		getGreen["parameters"]["channelName"].setValue( "R" )
 		
-		self.assertEqual( len( cs ), 5 )
+		self.assertEqual( len( cs ), 6 )
 		self.assertTrue( cs[0][0].isSame( image["shader"] ) )
-		self.assertTrue( cs[1][0].isSame( image["__shading"] ) )
-		self.assertTrue( cs[2][0].isSame( image["out"]["channelNames"] ) )
-		self.assertTrue( cs[3][0].isSame( image["out"]["channelData"] ) )
-		self.assertTrue( cs[4][0].isSame( image["out"] ) )
+		self.assertTrue( cs[1][0].isSame( image["__batchShading"] ) )
+		self.assertTrue( cs[2][0].isSame( image["__shading"] ) )
+		self.assertTrue( cs[3][0].isSame( image["out"]["channelNames"] ) )
+		self.assertTrue( cs[4][0].isSame( image["out"]["channelData"] ) )
+		self.assertTrue( cs[5][0].isSame( image["out"] ) )
 		
 		del cs[:]
 	
 		buildColor["parameters"]["r"].setInput( getRed["out"]["channelValue"] )
 		
-		self.assertEqual( len( cs ), 5 )
+		self.assertEqual( len( cs ), 6 )
 		self.assertTrue( cs[0][0].isSame( image["shader"] ) )
-		self.assertTrue( cs[1][0].isSame( image["__shading"] ) )
-		self.assertTrue( cs[2][0].isSame( image["out"]["channelNames"] ) )
-		self.assertTrue( cs[3][0].isSame( image["out"]["channelData"] ) )
-		self.assertTrue( cs[4][0].isSame( image["out"] ) )
+		self.assertTrue( cs[1][0].isSame( image["__batchShading"] ) )
+		self.assertTrue( cs[2][0].isSame( image["__shading"] ) )
+		self.assertTrue( cs[3][0].isSame( image["out"]["channelNames"] ) )
+		self.assertTrue( cs[4][0].isSame( image["out"]["channelData"] ) )
+		self.assertTrue( cs[5][0].isSame( image["out"] ) )
 
 		inputImage = reader["out"].image()
 		outputImage = image["out"].image()
@@ -185,5 +188,87 @@ class OSLImageTest( GafferOSLTest.OSLTestCase ) :
 		self.assertEqual( outputImage["G"].data, inputImage["G"].data )
 		self.assertEqual( outputImage["B"].data, inputImage["B"].data )
 		
+	def testMultipleBatches( self ) :
+	
+		# the data window of this image straddles the origin, so the tiles
+		# are shaded in several batches, some with negative origins.
+	
+		reader = GafferImage.ImageReader()
+		reader["fileName"].setValue( os.path.expandvars( "$GAFFER_ROOT/python/GafferTest/images/checkerWithNegativeDataWindow.200x150.exr" ) )
+		
+		getRed = GafferOSL.OSLShader()
+		getRed.loadShader( "ImageProcessing/InChannel" )
+		getRed["parameters"]["channelName"].setValue( "R" )
+		
+		outBlue = GafferOSL.OSLShader()
+		outBlue.loadShader( "ImageProcessing/OutChannel" )
+		outBlue["parameters"]["channelName"].setValue( "B" )
+		outBlue["parameters"]["channelValue"].setInput( getRed["out"]["channelValue"] )
+		
+		imageShader = GafferOSL.OSLShader()
+		imageShader.loadShader( "ImageProcessing/OutImage" )
+		imageShader["parameters"]["in0"].setInput( outBlue["out"]["channel"] )
+		
+		image = GafferOSL.OSLImage()
+		image["in"].setInput( reader["out"] )
+		image["shader"].setInput( imageShader["out"] )
+		
+		inputImage = reader["out"].image()
+		outputImage = image["out"].image()
+		
+		self.assertEqual( outputImage.dataWindow, inputImage.dataWindow )
+		self.assertEqual( outputImage["R"].data, inputImage["R"].data )
+		self.assertEqual( outputImage["G"].data, inputImage["G"].data )
+		self.assertEqual( outputImage["B"].data, inputImage["R"].data )
+		
+	def testUnshadedChannelsPassThrough( self ) :
+	
+		getGreen = GafferOSL.OSLShader()
+		getGreen.loadShader( "ImageProcessing/InChannel" )
+		getGreen["parameters"]["channelName"].setValue( "G" )
+		
+		outRed = GafferOSL.OSLShader()
+		outRed.loadShader( "ImageProcessing/OutChannel" )
+		outRed["parameters"]["channelName"].setValue( "R" )
+		outRed["parameters"]["channelValue"].setInput( getGreen["out"]["channelValue"] )
+		
+		outAlpha = GafferOSL.OSLShader()
+		outAlpha.loadShader( "ImageProcessing/OutChannel" )
+		outAlpha["parameters"]["channelName"].setValue( "A" )
+		outAlpha["parameters"]["channelValue"].setValue( 0.5 )
+		
+		imageShader = GafferOSL.OSLShader()
+		imageShader.loadShader( "ImageProcessing/OutImage" )
+		imageShader["parameters"]["in0"].setInput( outRed["out"]["channel"] )
+		imageShader["parameters"]["in1"].setInput( outAlpha["out"]["channel"] )
+		
+		reader = GafferImage.ImageReader()
+		reader["fileName"].setValue( os.path.expandvars( "$GAFFER_ROOT/python/GafferTest/images/rgb.100x100.exr" ) )
+		
+		image = GafferOSL.OSLImage()
+		image["in"].setInput( reader["out"] )
+		image["shader"].setInput( imageShader["out"] )
+		
+		self.assertEqual( image["out"]["channelNames"].getValue(), IECore.StringVectorData( [ "A", "B", "G", "R" ] ) )
+		
+		# channels the shader doesn't write are passed through without shading
+		
+		for channelName in ( "G", "B" ) :
+			self.assertEqual(
+				image["out"].channelDataHash( channelName, IECore.V2i( 0 ) ),
+				reader["out"].channelDataHash( channelName, IECore.V2i( 0 ) )
+			)
+		
+		# and the others are computed from only the part of the
+		# network which feeds them.
+		
+		inputImage = reader["out"].image()
+		outputImage = image["out"].image()
+		
+		self.assertEqual( outputImage["R"].data, inputImage["G"].data )
+		self.assertEqual( outputImage["G"].data, inputImage["G"].data )
+		self.assertEqual( outputImage["B"].data, inputImage["B"].data )
+		self.assertEqual( outputImage["A"].data, IECore.FloatVectorData( [ 0.5 ] * inputImage["R"].data.size() ) )
+		
 if __name__ == "__main__":
 	unittest.main()
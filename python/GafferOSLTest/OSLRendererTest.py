@@ -301,6 +301,82 @@ class OSLRendererTest( GafferOSLTest.OSLTestCase ) :
 				self.assertEqual( shading["v"][i], IECore.V3f( 0 ) )
 				self.assertEqual( shading["n"][i], IECore.V3f( 0 ) )
 				self.assertEqual( shading["c"][i], IECore.Color3f( 0 ) )
+
+	def testManyPoints( self ) :
+	
+		# enough points to be split across several threads, so we
+		# exercise the merging of user data and debug results.
+	
+		shader = self.compileShader( os.path.dirname( __file__ ) + "/shaders/multipleDebugClosures.osl" )
+		attribute = self.compileShader( os.path.dirname( __file__ ) + "/shaders/attribute.osl" )
+		
+		points = self.rectanglePoints( divisions = IECore.V2i( 200 ) )
+		
+		r = GafferOSL.OSLRenderer()
+		with IECore.WorldBlock( r ) :
+		
+			r.shader( "surface", shader, {} )
+			shading = r.shadingEngine().shade( points )
+			
+			for n in ( "u", "v", "P" ) :
+				self.assertEqual( len( shading[n] ), len( points["P"] ) )
+				for i in range( 0, len( shading[n] ) ) :
+					self.assertEqual( shading[n][i], IECore.Color3f( points[n][i] ) )
+		
+			r.shader( "surface", attribute, { "name" : "colorUserData" } )
+			shading = r.shadingEngine().shade( points )
+			
+			self.assertEqual( shading["Ci"], points["colorUserData"] )
 						
+	def testPrunedShading( self ) :
+	
+		outputDebugClosure = self.compileShader( os.path.dirname( __file__ ) + "/shaders/outputDebugClosure.osl" )
+		inputClosures = self.compileShader( os.path.dirname( __file__ ) + "/shaders/inputClosures.osl" )
+		
+		points = self.rectanglePoints()
+		
+		r = GafferOSL.OSLRenderer()
+		with IECore.WorldBlock( r ) :
+		
+			r.shader( "shader", outputDebugClosure, { "name" : "a", "value" : 1.0, "__handle" : "h1" } )
+			r.shader( "shader", outputDebugClosure, { "name" : "b", "value" : 2.0, "__handle" : "h2" } )
+			r.shader( "surface", inputClosures, { "i0" : "link:h1.c", "i1" : "link:h2.c" } )
+			e = r.shadingEngine()
+			
+			self.assertEqual( e.outputs(), [ "Ci", "a", "b" ] )
+			self.assertEqual( e.computedOutputs( [ "a" ] ), [ "Ci", "a" ] )
+			self.assertEqual( e.computedOutputs( [ "b" ] ), [ "Ci", "b" ] )
+			self.assertEqual( e.computedOutputs( [ "a", "b" ] ), [ "Ci", "a", "b" ] )
+			
+			shading = e.shade( points )
+			self.assertEqual( shading["a"], IECore.FloatVectorData( [ 1 ] * len( points["P"] ) ) )
+			self.assertEqual( shading["b"], IECore.FloatVectorData( [ 2 ] * len( points["P"] ) ) )
+			
+			shading = e.shade( points, [ "a" ] )
+			self.assertEqual( shading["a"], IECore.FloatVectorData( [ 1 ] * len( points["P"] ) ) )
+			self.assertFalse( "b" in shading )
+			
+			shading = e.shade( points, [ "b" ] )
+			self.assertEqual( shading["b"], IECore.FloatVectorData( [ 2 ] * len( points["P"] ) ) )
+			self.assertFalse( "a" in shading )
+			
+	def testSharedOutputsAreNotPruned( self ) :
+	
+		outputDebugClosure = self.compileShader( os.path.dirname( __file__ ) + "/shaders/outputDebugClosure.osl" )
+		inputClosures = self.compileShader( os.path.dirname( __file__ ) + "/shaders/inputClosures.osl" )
+		
+		r = GafferOSL.OSLRenderer()
+		with IECore.WorldBlock( r ) :
+		
+			# both branches write to "a", so it depends on the whole network
+			r.shader( "shader", outputDebugClosure, { "name" : "a", "value" : 1.0, "__handle" : "h1" } )
+			r.shader( "shader", outputDebugClosure, { "name" : "a", "value" : 2.0, "__handle" : "h2" } )
+			r.shader( "surface", inputClosures, { "i0" : "link:h1.c", "i1" : "link:h2.c" } )
+			e = r.shadingEngine()
+			
+			points = self.rectanglePoints()
+			self.assertEqual( e.computedOutputs( [ "a" ] ), e.outputs() )
+			self.assertEqual( e.shade( points, [ "a" ] ), e.shade( points ) )
+		
 if __name__ == "__main__":
 	unittest.main()
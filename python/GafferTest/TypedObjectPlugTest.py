@@ -197,7 +197,9 @@ class TypedObjectPlugTest( GafferTest.TestCase ) :
 		self.failUnless( Gaffer.IntVectorDataPlug.ValueType is IECore.IntVectorData )
 		self.failUnless( Gaffer.FloatVectorDataPlug.ValueType is IECore.FloatVectorData )
 		self.failUnless( Gaffer.StringVectorDataPlug.ValueType is IECore.StringVectorData )
+		self.failUnless( Gaffer.V2fVectorDataPlug.ValueType is IECore.V2fVectorData )
 		self.failUnless( Gaffer.V3fVectorDataPlug.ValueType is IECore.V3fVectorData )
+		self.failUnless( Gaffer.Color4fVectorDataPlug.ValueType is IECore.Color4fVectorData )
 		self.failUnless( Gaffer.ObjectVectorPlug.ValueType is IECore.ObjectVector )
 	
 	def testReadOnlySetValueRaises( self ) :
@@ -158,8 +158,10 @@ void GafferBindings::bindTypedObjectPlug()
 	bind<FloatVectorDataPlug>();
 	bind<StringVectorDataPlug>();
 	bind<InternedStringVectorDataPlug>();
+	bind<V2fVectorDataPlug>();
 	bind<V3fVectorDataPlug>();
 	bind<Color3fVectorDataPlug>();
+	bind<Color4fVectorDataPlug>();
 	bind<ObjectVectorPlug>();
 	bind<CompoundObjectPlug>();
 }
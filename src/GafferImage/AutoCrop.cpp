@@ -0,0 +1,466 @@
+//////////////////////////////////////////////////////////////////////////
+//  
+//  Copyright (c) 2014, Image Engine Design Inc. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//  
+//      * Redistributions of source code must retain the above
+//        copyright notice, this list of conditions and the following
+//        disclaimer.
+//  
+//      * Redistributions in binary form must reproduce the above
+//        copyright notice, this list of conditions and the following
+//        disclaimer in the documentation and/or other materials provided with
+//        the distribution.
+//  
+//      * Neither the name of John Haddon nor the names of
+//        any other contributors to this software may be used to endorse or
+//        promote products derived from this software without specific prior
+//        written permission.
+//  
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//////////////////////////////////////////////////////////////////////////
+
+#include "tbb/parallel_for.h"
+#include "tbb/parallel_reduce.h"
+#include "tbb/blocked_range2d.h"
+
+#include "IECore/BoxOps.h"
+
+#include "Gaffer/Context.h"
+
+#include "GafferImage/AutoCrop.h"
+
+using namespace std;
+using namespace Imath;
+using namespace IECore;
+using namespace Gaffer;
+using namespace GafferImage;
+
+//////////////////////////////////////////////////////////////////////////
+// Utilities for scanning the tiles of the input image in parallel.
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+tbb::blocked_range2d<int> tileRange( const Box2i &dataWindow )
+{
+	const V2i minTile = ImagePlug::tileOrigin( dataWindow.min ) / ImagePlug::tileSize();
+	const V2i maxTile = ImagePlug::tileOrigin( dataWindow.max ) / ImagePlug::tileSize();
+	return tbb::blocked_range2d<int>( minTile.y, maxTile.y + 1, 1, minTile.x, maxTile.x + 1, 1 );
+}
+
+inline Box2i tileBound( const V2i &tileOrigin )
+{
+	return Box2i( tileOrigin, tileOrigin + V2i( ImagePlug::tileSize() - 1 ) );
+}
+
+// Body for tbb::parallel_reduce(), accumulating the bound of
+// the non-zero pixels in a set of channels.
+class BoundReducer
+{
+
+	public :
+
+		BoundReducer( const ImagePlug *image, const vector<string> &channels, const Box2i &dataWindow, const Context *context )
+			:	m_image( image ), m_channels( channels ), m_dataWindow( dataWindow ), m_context( context )
+		{
+		}
+
+		BoundReducer( BoundReducer &other, tbb::split )
+			:	m_image( other.m_image ), m_channels( other.m_channels ), m_dataWindow( other.m_dataWindow ), m_context( other.m_context )
+		{
+		}
+
+		void operator()( const tbb::blocked_range2d<int> &range )
+		{
+			ContextPtr context = new Context( *m_context, Context::Borrowed );
+			Context::Scope scopedContext( context.get() );
+
+			const int tileSize = ImagePlug::tileSize();
+			for( int tileY = range.rows().begin(); tileY != range.rows().end(); ++tileY )
+			{
+				for( int tileX = range.cols().begin(); tileX != range.cols().end(); ++tileX )
+				{
+					const V2i tileOrigin( tileX * tileSize, tileY * tileSize );
+					const Box2i region = boxIntersection( tileBound( tileOrigin ), m_dataWindow );
+					context->set( ImagePlug::tileOriginContextName, tileOrigin );
+					for( vector<string>::const_iterator it = m_channels.begin(), eIt = m_channels.end(); it != eIt; ++it )
+					{
+						if( contains( m_bound, region ) )
+						{
+							// Nothing in this tile can grow the bound, so
+							// we needn't even compute it.
+							break;
+						}
+						context->set( ImagePlug::channelNameContextName, *it );
+						visitTile( tileOrigin, region );
+					}
+				}
+			}
+		}
+
+		void join( const BoundReducer &other )
+		{
+			m_bound.extendBy( other.m_bound );
+		}
+
+		const Box2i &bound() const
+		{
+			return m_bound;
+		}
+
+	private :
+
+		static inline bool contains( const Box2i &container, const Box2i &box )
+		{
+			return !container.isEmpty() && container.intersects( box.min ) && container.intersects( box.max );
+		}
+
+		// Expects the channel name and tile origin to have been set in the current context.
+		void visitTile( const V2i &tileOrigin, const Box2i &region )
+		{
+			ConstFloatVectorDataPtr tileData = m_image->channelDataPlug()->getValue();
+
+			float constantValue;
+			if( ImagePlug::isConstantTile( tileData.get(), constantValue ) )
+			{
+				if( constantValue != 0.0f )
+				{
+					m_bound.extendBy( region );
+				}
+				return;
+			}
+
+			// For rows already spanned by the bound, we need only search the
+			// pixels to either side of it.
+			const int tileSize = ImagePlug::tileSize();
+			const float *tile = &(tileData->readable()[0]);
+			for( int y = region.min.y; y <= region.max.y; ++y )
+			{
+				const float *row = tile + ( y - tileOrigin.y ) * tileSize;
+				const bool rowInBound = !m_bound.isEmpty() && y >= m_bound.min.y && y <= m_bound.max.y;
+
+				const int leftEnd = rowInBound ? std::min( region.max.x, m_bound.min.x - 1 ) : region.max.x;
+				int first = region.min.x;
+				while( first <= leftEnd && row[first - tileOrigin.x] == 0.0f )
+				{
+					++first;
+				}
+				if( first <= leftEnd )
+				{
+					m_bound.extendBy( V2i( first, y ) );
+				}
+				else if( !rowInBound )
+				{
+					// The whole row is zero.
+					continue;
+				}
+
+				const int rightEnd = rowInBound ? std::max( region.min.x, m_bound.max.x + 1 ) : first;
+				int last = region.max.x;
+				while( last >= rightEnd && row[last - tileOrigin.x] == 0.0f )
+				{
+					--last;
+				}
+				if( last >= rightEnd )
+				{
+					m_bound.extendBy( V2i( last, y ) );
+				}
+			}
+		}
+
+		const ImagePlug *m_image;
+		const vector<string> &m_channels;
+		const Box2i m_dataWindow;
+		const Context *m_context;
+
+		Box2i m_bound;
+
+};
+
+// Body for tbb::parallel_for(), gathering the channel data hashes
+// for all the tiles, in the order of the tile range.
+class HashGatherer
+{
+
+	public :
+
+		HashGatherer( const ImagePlug *image, const vector<string> &channels, const tbb::blocked_range2d<int> &tiles, const Context *context, MurmurHash *hashes )
+			:	m_image( image ), m_channels( channels ), m_tiles( tiles ), m_context( context ), m_hashes( hashes )
+		{
+		}
+
+		void operator()( const tbb::blocked_range2d<int> &range ) const
+		{
+			ContextPtr context = new Context( *m_context, Context::Borrowed );
+			Context::Scope scopedContext( context.get() );
+
+			const int tileSize = ImagePlug::tileSize();
+			const size_t numColumns = m_tiles.cols().size();
+			for( int tileY = range.rows().begin(); tileY != range.rows().end(); ++tileY )
+			{
+				for( int tileX = range.cols().begin(); tileX != range.cols().end(); ++tileX )
+				{
+					context->set( ImagePlug::tileOriginContextName, V2i( tileX * tileSize, tileY * tileSize ) );
+					MurmurHash *hashes = m_hashes + ( ( tileY - m_tiles.rows().begin() ) * numColumns + ( tileX - m_tiles.cols().begin() ) ) * m_channels.size();
+					for( vector<string>::const_iterator it = m_channels.begin(), eIt = m_channels.end(); it != eIt; ++it )
+					{
+						context->set( ImagePlug::channelNameContextName, *it );
+						*hashes++ = m_image->channelDataPlug()->hash();
+					}
+				}
+			}
+		}
+
+	private :
+
+		const ImagePlug *m_image;
+		const vector<string> &m_channels;
+		const tbb::blocked_range2d<int> m_tiles;
+		const Context *m_context;
+		MurmurHash *m_hashes;
+
+};
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+// AutoCrop
+//////////////////////////////////////////////////////////////////////////
+
+IE_CORE_DEFINERUNTIMETYPED( AutoCrop );
+
+size_t AutoCrop::g_firstPlugIndex = 0;
+
+AutoCrop::AutoCrop( const std::string &name )
+	:	ImageProcessor( name )
+{
+	storeIndexOfNextChild( g_firstPlugIndex );
+
+	addChild(
+		new ChannelMaskPlug(
+			"channels",
+			Gaffer::Plug::In,
+			inPlug()->channelNamesPlug()->defaultValue(),
+			Gaffer::Plug::Default
+		)
+	);
+
+	addChild( new BoolPlug( "snapToTiles" ) );
+}
+
+AutoCrop::~AutoCrop()
+{
+}
+
+GafferImage::ChannelMaskPlug *AutoCrop::channelsPlug()
+{
+	return getChild<ChannelMaskPlug>( g_firstPlugIndex );
+}
+
+const GafferImage::ChannelMaskPlug *AutoCrop::channelsPlug() const
+{
+	return getChild<ChannelMaskPlug>( g_firstPlugIndex );
+}
+
+Gaffer::BoolPlug *AutoCrop::snapToTilesPlug()
+{
+	return getChild<BoolPlug>( g_firstPlugIndex + 1 );
+}
+
+const Gaffer::BoolPlug *AutoCrop::snapToTilesPlug() const
+{
+	return getChild<BoolPlug>( g_firstPlugIndex + 1 );
+}
+
+void AutoCrop::affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const
+{
+	ImageProcessor::affects( input, outputs );
+
+	if( input == inPlug()->formatPlug() )
+	{
+		outputs.push_back( outPlug()->formatPlug() );
+	}
+	else if( input == inPlug()->channelNamesPlug() )
+	{
+		outputs.push_back( outPlug()->channelNamesPlug() );
+		outputs.push_back( outPlug()->dataWindowPlug() );
+	}
+	else if(
+		input == inPlug()->dataWindowPlug() ||
+		input == inPlug()->channelDataPlug()
+	)
+	{
+		outputs.push_back( outPlug()->dataWindowPlug() );
+		outputs.push_back( outPlug()->channelDataPlug() );
+	}
+	else if( input == channelsPlug() )
+	{
+		outputs.push_back( outPlug()->dataWindowPlug() );
+		outputs.push_back( outPlug()->channelDataPlug() );
+	}
+	else if( input == snapToTilesPlug() )
+	{
+		outputs.push_back( outPlug()->dataWindowPlug() );
+	}
+	else if( input == outPlug()->dataWindowPlug() )
+	{
+		// The unscanned channels are masked by the data window.
+		outputs.push_back( outPlug()->channelDataPlug() );
+	}
+}
+
+std::vector<std::string> AutoCrop::scannedChannels() const
+{
+	ConstStringVectorDataPtr channelNamesData = inPlug()->channelNamesPlug()->getValue();
+	vector<string> channels = channelNamesData->readable();
+	channelsPlug()->maskChannels( channels );
+	return channels;
+}
+
+bool AutoCrop::channelScanned( const std::string &channel ) const
+{
+	vector<string> channels( 1, channel );
+	channelsPlug()->maskChannels( channels );
+	return !channels.empty();
+}
+
+void AutoCrop::hashFormat( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
+{
+	h = inPlug()->formatPlug()->hash();
+}
+
+void AutoCrop::hashDataWindow( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
+{
+	ImageProcessor::hashDataWindow( output, context, h );
+
+	const Box2i dataWindow = inPlug()->dataWindowPlug()->getValue();
+	const vector<string> channels = scannedChannels();
+
+	h.append( dataWindow );
+	snapToTilesPlug()->hash( h );
+	if( dataWindow.isEmpty() || channels.empty() )
+	{
+		return;
+	}
+
+	h.append( &channels[0], channels.size() );
+
+	const tbb::blocked_range2d<int> tiles = tileRange( dataWindow );
+	vector<MurmurHash> hashes( tiles.rows().size() * tiles.cols().size() * channels.size() );
+	tbb::parallel_for( tiles, HashGatherer( inPlug(), channels, tiles, context, &hashes[0] ) );
+
+	for( vector<MurmurHash>::const_iterator it = hashes.begin(), eIt = hashes.end(); it != eIt; ++it )
+	{
+		h.append( *it );
+	}
+}
+
+void AutoCrop::hashChannelNames( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
+{
+	h = inPlug()->channelNamesPlug()->hash();
+}
+
+void AutoCrop::hashChannelData( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
+{
+	const std::string &channelName = context->get<std::string>( ImagePlug::channelNameContextName );
+	if( channelScanned( channelName ) )
+	{
+		h = inPlug()->channelDataPlug()->hash();
+		return;
+	}
+
+	const V2i tileOrigin = context->get<V2i>( ImagePlug::tileOriginContextName );
+	const Box2i region = boxIntersection( tileBound( tileOrigin ), inPlug()->dataWindowPlug()->getValue() );
+	const Box2i dataWindow = output->dataWindowPlug()->getValue();
+	if( boxIntersection( region, dataWindow ) == region )
+	{
+		h = inPlug()->channelDataPlug()->hash();
+		return;
+	}
+
+	ImageProcessor::hashChannelData( output, context, h );
+	inPlug()->channelDataPlug()->hash( h );
+	h.append( dataWindow );
+}
+
+GafferImage::Format AutoCrop::computeFormat( const Gaffer::Context *context, const ImagePlug *parent ) const
+{
+	return inPlug()->formatPlug()->getValue();
+}
+
+Imath::Box2i AutoCrop::computeDataWindow( const Gaffer::Context *context, const ImagePlug *parent ) const
+{
+	const Box2i dataWindow = inPlug()->dataWindowPlug()->getValue();
+	const vector<string> channels = scannedChannels();
+	if( dataWindow.isEmpty() || channels.empty() )
+	{
+		return Box2i();
+	}
+
+	BoundReducer reducer( inPlug(), channels, dataWindow, context );
+	tbb::parallel_reduce( tileRange( dataWindow ), reducer );
+
+	Box2i result = reducer.bound();
+	if( !result.isEmpty() && snapToTilesPlug()->getValue() )
+	{
+		result.min = ImagePlug::tileOrigin( result.min );
+		result.max = ImagePlug::tileOrigin( result.max ) + V2i( ImagePlug::tileSize() - 1 );
+		result = boxIntersection( result, dataWindow );
+	}
+
+	return result;
+}
+
+IECore::ConstStringVectorDataPtr AutoCrop::computeChannelNames( const Gaffer::Context *context, const ImagePlug *parent ) const
+{
+	return inPlug()->channelNamesPlug()->getValue();
+}
+
+IECore::ConstFloatVectorDataPtr AutoCrop::computeChannelData( const std::string &channelName, const Imath::V2i &tileOrigin, const Gaffer::Context *context, const ImagePlug *parent ) const
+{
+	ConstFloatVectorDataPtr inData = inPlug()->channelDataPlug()->getValue();
+	if( channelScanned( channelName ) )
+	{
+		// Every pixel outside the data window is zero already.
+		return inData;
+	}
+
+	const Box2i region = boxIntersection( tileBound( tileOrigin ), inPlug()->dataWindowPlug()->getValue() );
+	const Box2i dataWindow = parent->dataWindowPlug()->getValue();
+	const Box2i validRegion = boxIntersection( region, dataWindow );
+	if( validRegion == region )
+	{
+		return inData;
+	}
+
+	// The tile straddles the edge of the cropped data window,
+	// so we keep only the pixels inside it.
+	const int tileSize = ImagePlug::tileSize();
+	FloatVectorDataPtr resultData = ImagePlug::allocateTile();
+	float *result = &(resultData->writable()[0]);
+	const float *in = &(inData->readable()[0]);
+	std::fill( result, result + tileSize * tileSize, 0.0f );
+	for( int y = validRegion.min.y; y <= validRegion.max.y; ++y )
+	{
+		const int offset = ( y - tileOrigin.y ) * tileSize + ( validRegion.min.x - tileOrigin.x );
+		std::copy( in + offset, in + offset + validRegion.size().x + 1, result + offset );
+	}
+
+	return resultData;
+}
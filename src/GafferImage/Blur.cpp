@@ -0,0 +1,863 @@
+//////////////////////////////////////////////////////////////////////////
+//  
+//  Copyright (c) 2014, Image Engine Design Inc. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//  
+//      * Redistributions of source code must retain the above
+//        copyright notice, this list of conditions and the following
+//        disclaimer.
+//  
+//      * Redistributions in binary form must reproduce the above
+//        copyright notice, this list of conditions and the following
+//        disclaimer in the documentation and/or other materials provided with
+//        the distribution.
+//  
+//      * Neither the name of John Haddon nor the names of
+//        any other contributors to this software may be used to endorse or
+//        promote products derived from this software without specific prior
+//        written permission.
+//  
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//////////////////////////////////////////////////////////////////////////
+
+#include "IECore/BoxOps.h"
+
+#include "Gaffer/Context.h"
+
+#include "GafferImage/Blur.h"
+#include "GafferImage/SIMDFloat.h"
+
+using namespace std;
+using namespace Imath;
+using namespace IECore;
+using namespace Gaffer;
+using namespace GafferImage;
+
+//////////////////////////////////////////////////////////////////////////
+// Kernels. The blur is applied as a sequence of one dimensional passes,
+// horizontal passes first. Each pass reads the result of the previous one
+// as per-tile prefix sums, laid out as "spans" holding the sums for all
+// the rows or columns of the tile at one position along the axis of the
+// pass, so that the inner loops run over contiguous memory a SIMDFloat at
+// a time.
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+const IECore::InternedString g_passContextName( "__blur:pass" );
+
+struct Kernel
+{
+
+	Kernel()
+		:	tap( 0 ), support( 0 )
+	{
+	}
+
+	/// The radii of successive box passes. Fractional
+	/// radii are applied by weighting the pixels at either end by
+	/// the fractional part.
+	vector<float> boxRadii;
+	/// When not empty, the kernel is instead applied by direct
+	/// convolution with these weights, starting at tap.
+	vector<float> weights;
+	int tap;
+	/// The number of pixels to either side of the center which
+	/// contribute to the result.
+	int support;
+
+};
+
+inline int boxSupport( float radius )
+{
+	return int( ceilf( radius ) );
+}
+
+// Returns the radius of the box with the specified variance.
+float boxRadius( float variance )
+{
+	// A box of integer radius n has variance n( n + 1 ) / 3, so we find the
+	// largest such box not exceeding the variance, and then solve for the
+	// weight of the end pixels which makes up the difference.
+	const int n = int( ( sqrtf( 1.0f + 12.0f * variance ) - 1.0f ) * 0.5f );
+	const float a = n * ( n + 1 ) * ( 2 * n + 1 ) / 3.0f;
+	const float b = 2 * n + 1;
+	const float f = ( variance * b - a ) / ( 2.0f * ( ( n + 1 ) * ( n + 1 ) - variance ) );
+	return n + std::max( 0.0f, std::min( f, 1.0f ) );
+}
+
+Kernel kernel( int mode, float radius, const std::string &filterName )
+{
+	Kernel result;
+	if( radius <= 0.0f )
+	{
+		return result;
+	}
+
+	switch( mode )
+	{
+		case Blur::FilterKernel :
+		{
+			FilterPtr filter = Filter::create( filterName );
+			if( static_cast<GafferImage::TypeId>( filter->typeId() ) != BoxFilterTypeId )
+			{
+				filter->setScale( radius / filter->getRadius() );
+				Filter::Weights weights;
+				filter->computeWeights( vector<float>( 1, 0.5f ), weights );
+				result.weights = weights.weights;
+				result.tap = weights.taps[0];
+				result.support = std::max( -result.tap, result.tap + weights.width - 1 );
+				return result;
+			}
+			// Filter::computeWeights() treats the box filter as a point
+			// sample, so we use a running sum instead.
+			result.boxRadii.push_back( radius );
+			break;
+		}
+		case Blur::Gaussian :
+		{
+			// Three box passes give a close approximation to a gaussian,
+			// with the variances of the boxes summing to its variance.
+			const float sigma = radius / 3.0f;
+			result.boxRadii.resize( 3, boxRadius( sigma * sigma / 3.0f ) );
+			break;
+		}
+		default :
+			result.boxRadii.push_back( radius );
+	}
+
+	for( vector<float>::const_iterator it = result.boxRadii.begin(), eIt = result.boxRadii.end(); it != eIt; ++it )
+	{
+		result.support += boxSupport( *it );
+	}
+
+	return result;
+}
+
+struct Pass
+{
+
+	/// 0 for a horizontal pass and 1 for a vertical one.
+	int axis;
+	/// The radius of a box pass, used when weights is empty.
+	float radius;
+	/// When not empty, the pass convolves with these weights, starting at tap.
+	vector<float> weights;
+	int tap;
+	int support;
+
+};
+
+typedef vector<Pass> Passes;
+
+void appendPasses( const Kernel &kernel, int axis, Passes &passes )
+{
+	Pass pass;
+	pass.axis = axis;
+	pass.radius = 0.0f;
+	if( kernel.weights.size() )
+	{
+		pass.weights = kernel.weights;
+		pass.tap = kernel.tap;
+		pass.support = kernel.support;
+		passes.push_back( pass );
+		return;
+	}
+
+	pass.tap = 0;
+	for( vector<float>::const_iterator it = kernel.boxRadii.begin(), eIt = kernel.boxRadii.end(); it != eIt; ++it )
+	{
+		pass.radius = *it;
+		pass.support = boxSupport( *it );
+		passes.push_back( pass );
+	}
+}
+
+Passes blurPasses( int mode, const V2f &radius, const std::string &filterName )
+{
+	Passes result;
+	appendPasses( kernel( mode, radius.x, filterName ), 0, result );
+	appendPasses( kernel( mode, radius.y, filterName ), 1, result );
+	return result;
+}
+
+size_t numHorizontalPasses( const Passes &passes )
+{
+	size_t result = 0;
+	while( result < passes.size() && passes[result].axis == 0 )
+	{
+		result++;
+	}
+	return result;
+}
+
+// Returns the data window of the image produced by the first numPasses passes.
+Box2i passWindow( const Passes &passes, size_t numPasses, const Box2i &dataWindow )
+{
+	Box2i result = dataWindow;
+	if( result.isEmpty() )
+	{
+		return result;
+	}
+
+	for( size_t i = 0; i < numPasses; ++i )
+	{
+		result.min[passes[i].axis] -= passes[i].support;
+		result.max[passes[i].axis] += passes[i].support;
+	}
+	return result;
+}
+
+// Returns the distance, along the axis of the passes in [begin, end), beyond
+// which no pixels can affect the result of those passes for a tile. This is
+// greater than the sum of the supports, because each pass reads whole tiles
+// of sums from the pass before, and the tiles covering the support may extend
+// up to tileSize - 1 pixels beyond it.
+int passReach( const Passes &passes, size_t begin, size_t end )
+{
+	int result = 0;
+	for( size_t i = begin; i < end; ++i )
+	{
+		result += passes[i].support + ImagePlug::tileSize() - 1;
+	}
+	return result;
+}
+
+Box2i tileBound( const V2i &tileOrigin )
+{
+	return Box2i( tileOrigin, tileOrigin + V2i( ImagePlug::tileSize() - 1 ) );
+}
+
+// sum += weight * in
+void accumulate( float *sum, const float *in, float weight, int n )
+{
+	using namespace GafferImage::Detail;
+
+	typedef SIMDFloat V;
+	const V weightV( weight );
+
+	int i = 0;
+	for( ; i + V::width <= n; i += V::width )
+	{
+		store( load<V>( sum + i ) + weightV * load<V>( in + i ), sum + i );
+	}
+
+	for( ; i < n; ++i )
+	{
+		sum[i] += weight * in[i];
+	}
+}
+
+// out = a + b
+void add( float *out, const float *a, const float *b, int n )
+{
+	using namespace GafferImage::Detail;
+
+	typedef SIMDFloat V;
+
+	int i = 0;
+	for( ; i + V::width <= n; i += V::width )
+	{
+		store( load<V>( a + i ) + load<V>( b + i ), out + i );
+	}
+
+	for( ; i < n; ++i )
+	{
+		out[i] = a[i] + b[i];
+	}
+}
+
+// out = a - b
+void subtract( float *out, const float *a, const float *b, int n )
+{
+	using namespace GafferImage::Detail;
+
+	typedef SIMDFloat V;
+
+	int i = 0;
+	for( ; i + V::width <= n; i += V::width )
+	{
+		store( load<V>( a + i ) - load<V>( b + i ), out + i );
+	}
+
+	for( ; i < n; ++i )
+	{
+		out[i] = a[i] - b[i];
+	}
+}
+
+// out = ( ( 1 - endWeight ) * ( innerLast - innerFirst ) + endWeight * ( outerLast - outerFirst ) ) * normalisation,
+// where the inner and outer arguments are prefix sums bounding the box without and with its end pixels
+// respectively. The outer arguments may be NULL when endWeight is zero.
+void boxOutput( float *out, const float *innerFirst, const float *innerLast, const float *outerFirst, const float *outerLast, float endWeight, float normalisation, int n )
+{
+	using namespace GafferImage::Detail;
+
+	typedef SIMDFloat V;
+	const V normalisationV( normalisation );
+
+	int i = 0;
+	if( endWeight == 0.0f )
+	{
+		for( ; i + V::width <= n; i += V::width )
+		{
+			store( ( load<V>( innerLast + i ) - load<V>( innerFirst + i ) ) * normalisationV, out + i );
+		}
+		for( ; i < n; ++i )
+		{
+			out[i] = ( innerLast[i] - innerFirst[i] ) * normalisation;
+		}
+		return;
+	}
+
+	const float innerWeight = ( 1.0f - endWeight ) * normalisation;
+	const float outerWeight = endWeight * normalisation;
+	const V innerWeightV( innerWeight );
+	const V outerWeightV( outerWeight );
+	for( ; i + V::width <= n; i += V::width )
+	{
+		store(
+			innerWeightV * ( load<V>( innerLast + i ) - load<V>( innerFirst + i ) ) +
+			outerWeightV * ( load<V>( outerLast + i ) - load<V>( outerFirst + i ) ),
+			out + i
+		);
+	}
+	for( ; i < n; ++i )
+	{
+		out[i] = innerWeight * ( innerLast[i] - innerFirst[i] ) + outerWeight * ( outerLast[i] - outerFirst[i] );
+	}
+}
+
+// Computes the prefix sums of a tile along the specified axis, as tileSize + 1
+// spans of tileSize values. Span i holds the sums of the pixels before position i
+// in each row ( axis 0 ) or column ( axis 1 ), so the last span holds the totals.
+void prefixSums( const float *tile, int axis, float *sums )
+{
+	const int tileSize = ImagePlug::tileSize();
+	std::fill( sums, sums + tileSize, 0.0f );
+	for( int p = 0; p < tileSize; ++p )
+	{
+		const float *previous = sums + p * tileSize;
+		float *next = sums + ( p + 1 ) * tileSize;
+		if( axis == 1 )
+		{
+			add( next, previous, tile + p * tileSize, tileSize );
+		}
+		else
+		{
+			for( int y = 0; y < tileSize; ++y )
+			{
+				next[y] = previous[y] + tile[y * tileSize + p];
+			}
+		}
+	}
+}
+
+// Chains the per-tile prefix sums for a run of tiles along an axis, so that
+// the sum of all the pixels between the start of the run and any position
+// within it can be looked up without revisiting the pixels themselves.
+class PrefixSums
+{
+
+	public :
+
+		PrefixSums( int firstPosition )
+			:	m_firstPosition( firstPosition )
+		{
+		}
+
+		/// Appends the sums for the next tile, which may be
+		/// NULL if the tile is known to be black.
+		void addTile( ConstFloatVectorDataPtr sums )
+		{
+			const int tileSize = ImagePlug::tileSize();
+			const size_t i = m_tiles.size();
+			m_offsets.resize( ( i + 1 ) * tileSize, 0.0f );
+			if( i && m_tiles[i-1] )
+			{
+				add( &m_offsets[i * tileSize], &m_offsets[( i - 1 ) * tileSize], &(m_tiles[i-1]->readable()[tileSize * tileSize]), tileSize );
+			}
+			else if( i )
+			{
+				std::copy( &m_offsets[( i - 1 ) * tileSize], &m_offsets[i * tileSize], &m_offsets[i * tileSize] );
+			}
+			m_tiles.push_back( sums );
+		}
+
+		/// Fills count spans of out with the sums of the pixels from the start
+		/// of the run up to but not including the positions first, first + 1 ...
+		void gather( int first, int count, float *out ) const
+		{
+			const int tileSize = ImagePlug::tileSize();
+			for( int i = 0; i < count; ++i )
+			{
+				const int p = first + i - m_firstPosition;
+				const int tile = p / tileSize;
+				const float *offset = &m_offsets[tile * tileSize];
+				float *o = out + i * tileSize;
+				if( m_tiles[tile] )
+				{
+					add( o, offset, &(m_tiles[tile]->readable()[( p - tile * tileSize ) * tileSize]), tileSize );
+				}
+				else
+				{
+					std::copy( offset, offset + tileSize, o );
+				}
+			}
+		}
+
+	private :
+
+		int m_firstPosition;
+		vector<ConstFloatVectorDataPtr> m_tiles;
+		vector<float> m_offsets;
+
+};
+
+// Applies a box of the specified radius to the tile starting at position o, writing
+// tileSize spans to out. Each output is the difference between two lookups into the
+// sums, so the cost is independent of the radius.
+void boxPass( const PrefixSums &sums, int o, float radius, float *out )
+{
+	const int tileSize = ImagePlug::tileSize();
+	const int r = int( radius );
+	const float endWeight = radius - r;
+	const int s = boxSupport( radius );
+	const float normalisation = 1.0f / ( 2 * r + 1 + 2 * endWeight );
+
+	// When there is an end weight, s == r + 1, and span i of first holds the
+	// sums up to the outer start of the box for output i, and span i + 1 holds
+	// the sums up to its inner start. Likewise span i of last holds the sums up
+	// to its inner end and span i + 1 those up to its outer end.
+	const int numSpans = endWeight > 0.0f ? tileSize + 1 : tileSize;
+	vector<float> first( numSpans * tileSize );
+	vector<float> last( numSpans * tileSize );
+	sums.gather( o - s, numSpans, &first[0] );
+	sums.gather( o + r + 1, numSpans, &last[0] );
+
+	for( int i = 0; i < tileSize; ++i )
+	{
+		if( endWeight > 0.0f )
+		{
+			boxOutput(
+				out + i * tileSize,
+				&first[( i + 1 ) * tileSize], &last[i * tileSize],
+				&first[i * tileSize], &last[( i + 1 ) * tileSize],
+				endWeight, normalisation, tileSize
+			);
+		}
+		else
+		{
+			boxOutput( out + i * tileSize, &first[i * tileSize], &last[i * tileSize], NULL, NULL, 0.0f, normalisation, tileSize );
+		}
+	}
+}
+
+void convolvePass( const PrefixSums &sums, int o, const Pass &pass, float *out )
+{
+	const int tileSize = ImagePlug::tileSize();
+	const int numIn = tileSize + 2 * pass.support;
+
+	// Recover the pixels covered by the kernel from the sums.
+	vector<float> in( ( numIn + 1 ) * tileSize );
+	sums.gather( o - pass.support, numIn + 1, &in[0] );
+	for( int i = 0; i < numIn; ++i )
+	{
+		subtract( &in[i * tileSize], &in[( i + 1 ) * tileSize], &in[i * tileSize], tileSize );
+	}
+
+	const int offset = pass.support + pass.tap;
+	const int width = pass.weights.size();
+	for( int i = 0; i < tileSize; ++i )
+	{
+		float *o = out + i * tileSize;
+		std::fill( o, o + tileSize, 0.0f );
+		for( int j = 0; j < width; ++j )
+		{
+			const float w = pass.weights[j];
+			if( w != 0.0f )
+			{
+				accumulate( o, &in[( i + offset + j ) * tileSize], w, tileSize );
+			}
+		}
+	}
+}
+
+// Transposes a block of rows x columns values from in to out.
+void transpose( const float *in, int rows, int columns, float *out )
+{
+	for( int r = 0; r < rows; ++r )
+	{
+		const float *row = in + r * columns;
+		for( int c = 0; c < columns; ++c )
+		{
+			out[c * rows + r] = row[c];
+		}
+	}
+}
+
+const IECore::MurmurHash &blackTileHash()
+{
+	static const IECore::MurmurHash g_hash = ImagePlug::blackTile()->Object::hash();
+	return g_hash;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+// Blur
+//////////////////////////////////////////////////////////////////////////
+
+IE_CORE_DEFINERUNTIMETYPED( Blur );
+
+size_t Blur::g_firstPlugIndex = 0;
+
+Blur::Blur( const std::string &name )
+	:	ImageProcessor( name )
+{
+	storeIndexOfNextChild( g_firstPlugIndex );
+
+	addChild( new IntPlug( "mode", Plug::In, Gaussian, Box, FilterKernel ) );
+	addChild( new V2fPlug( "radius", Plug::In, V2f( 0 ), V2f( 0 ) ) );
+	addChild( new FilterPlug( "filter" ) );
+	addChild( new FloatVectorDataPlug( "__sums", Plug::Out, new FloatVectorData ) );
+}
+
+Blur::~Blur()
+{
+}
+
+Gaffer::IntPlug *Blur::modePlug()
+{
+	return getChild<IntPlug>( g_firstPlugIndex );
+}
+
+const Gaffer::IntPlug *Blur::modePlug() const
+{
+	return getChild<IntPlug>( g_firstPlugIndex );
+}
+
+Gaffer::V2fPlug *Blur::radiusPlug()
+{
+	return getChild<V2fPlug>( g_firstPlugIndex + 1 );
+}
+
+const Gaffer::V2fPlug *Blur::radiusPlug() const
+{
+	return getChild<V2fPlug>( g_firstPlugIndex + 1 );
+}
+
+GafferImage::FilterPlug *Blur::filterPlug()
+{
+	return getChild<FilterPlug>( g_firstPlugIndex + 2 );
+}
+
+const GafferImage::FilterPlug *Blur::filterPlug() const
+{
+	return getChild<FilterPlug>( g_firstPlugIndex + 2 );
+}
+
+Gaffer::FloatVectorDataPlug *Blur::sumsPlug()
+{
+	return getChild<FloatVectorDataPlug>( g_firstPlugIndex + 3 );
+}
+
+const Gaffer::FloatVectorDataPlug *Blur::sumsPlug() const
+{
+	return getChild<FloatVectorDataPlug>( g_firstPlugIndex + 3 );
+}
+
+void Blur::affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const
+{
+	ImageProcessor::affects( input, outputs );
+
+	if( input == inPlug()->formatPlug() || input == inPlug()->channelNamesPlug() )
+	{
+		outputs.push_back( outPlug()->getChild<ValuePlug>( input->getName() ) );
+	}
+	else if( input == inPlug()->channelDataPlug() )
+	{
+		outputs.push_back( sumsPlug() );
+	}
+	else if( input == sumsPlug() )
+	{
+		outputs.push_back( outPlug()->channelDataPlug() );
+	}
+	else if(
+		input == inPlug()->dataWindowPlug() ||
+		input == modePlug() ||
+		input == filterPlug() ||
+		input->parent<Plug>() == radiusPlug()
+	)
+	{
+		outputs.push_back( outPlug()->dataWindowPlug() );
+		outputs.push_back( sumsPlug() );
+		outputs.push_back( outPlug()->channelDataPlug() );
+	}
+}
+
+bool Blur::enabled() const
+{
+	if( !ImageProcessor::enabled() )
+	{
+		return false;
+	}
+
+	return radiusPlug()->getValue() != V2f( 0 );
+}
+
+void Blur::hash( const Gaffer::ValuePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
+{
+	ImageProcessor::hash( output, context, h );
+
+	if( output == sumsPlug() )
+	{
+		const int pass = context->get<int>( g_passContextName );
+		const V2i tileOrigin = context->get<V2i>( ImagePlug::tileOriginContextName );
+		hashPassInput( pass, tileOrigin, context, h );
+	}
+}
+
+void Blur::compute( Gaffer::ValuePlug *output, const Gaffer::Context *context ) const
+{
+	if( output == sumsPlug() )
+	{
+		const int pass = context->get<int>( g_passContextName );
+		const V2i tileOrigin = context->get<V2i>( ImagePlug::tileOriginContextName );
+		const Passes passes = blurPasses( modePlug()->getValue(), radiusPlug()->getValue(), filterPlug()->getValue() );
+
+		ConstFloatVectorDataPtr tileData = computePassInput( pass, tileOrigin, context );
+
+		const int tileSize = ImagePlug::tileSize();
+		FloatVectorDataPtr sumsData = new FloatVectorData;
+		sumsData->writable().resize( ( tileSize + 1 ) * tileSize );
+		prefixSums( &(tileData->readable()[0]), passes[pass].axis, &(sumsData->writable()[0]) );
+
+		static_cast<FloatVectorDataPlug *>( output )->setValue( sumsData );
+		return;
+	}
+
+	ImageProcessor::compute( output, context );
+}
+
+void Blur::hashFormat( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
+{
+	h = inPlug()->formatPlug()->hash();
+}
+
+void Blur::hashDataWindow( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
+{
+	ImageProcessor::hashDataWindow( output, context, h );
+
+	inPlug()->dataWindowPlug()->hash( h );
+	modePlug()->hash( h );
+	radiusPlug()->hash( h );
+	filterPlug()->hash( h );
+}
+
+void Blur::hashChannelNames( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
+{
+	h = inPlug()->channelNamesPlug()->hash();
+}
+
+void Blur::hashChannelData( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
+{
+	const V2i tileOrigin = context->get<V2i>( ImagePlug::tileOriginContextName );
+	const Passes passes = blurPasses( modePlug()->getValue(), radiusPlug()->getValue(), filterPlug()->getValue() );
+	if( !passWindow( passes, passes.size(), inPlug()->dataWindowPlug()->getValue() ).intersects( tileBound( tileOrigin ) ) )
+	{
+		h = blackTileHash();
+		return;
+	}
+
+	ImageProcessor::hashChannelData( output, context, h );
+	hashPassInput( passes.size(), tileOrigin, context, h );
+}
+
+GafferImage::Format Blur::computeFormat( const Gaffer::Context *context, const ImagePlug *parent ) const
+{
+	return inPlug()->formatPlug()->getValue();
+}
+
+Imath::Box2i Blur::computeDataWindow( const Gaffer::Context *context, const ImagePlug *parent ) const
+{
+	const Passes passes = blurPasses( modePlug()->getValue(), radiusPlug()->getValue(), filterPlug()->getValue() );
+	return passWindow( passes, passes.size(), inPlug()->dataWindowPlug()->getValue() );
+}
+
+IECore::ConstStringVectorDataPtr Blur::computeChannelNames( const Gaffer::Context *context, const ImagePlug *parent ) const
+{
+	return inPlug()->channelNamesPlug()->getValue();
+}
+
+IECore::ConstFloatVectorDataPtr Blur::computeChannelData( const std::string &channelName, const Imath::V2i &tileOrigin, const Gaffer::Context *context, const ImagePlug *parent ) const
+{
+	const Passes passes = blurPasses( modePlug()->getValue(), radiusPlug()->getValue(), filterPlug()->getValue() );
+	if( !passWindow( passes, passes.size(), inPlug()->dataWindowPlug()->getValue() ).intersects( tileBound( tileOrigin ) ) )
+	{
+		return ImagePlug::blackTile();
+	}
+
+	return computePassInput( passes.size(), tileOrigin, context );
+}
+
+void Blur::hashPassInput( size_t pass, const Imath::V2i &tileOrigin, const Gaffer::Context *context, IECore::MurmurHash &h ) const
+{
+	const Passes passes = blurPasses( modePlug()->getValue(), radiusPlug()->getValue(), filterPlug()->getValue() );
+	const Box2i dataWindow = inPlug()->dataWindowPlug()->getValue();
+
+	h.append( (uint64_t)pass );
+	h.append( tileOrigin );
+	h.append( dataWindow );
+	modePlug()->hash( h );
+	radiusPlug()->hash( h );
+	filterPlug()->hash( h );
+
+	// Rather than hash the sums from the previous pass, which would in turn hash
+	// the sums from the pass before that, we hash the tiles which the whole chain
+	// of passes depends on. For the horizontal passes those are input tiles, and
+	// for the vertical passes they are the tiles the first vertical pass reads.
+	ContextPtr tmpContext = new Context( *context, Context::Borrowed );
+	Context::Scope scopedContext( tmpContext.get() );
+
+	const int tileSize = ImagePlug::tileSize();
+	const size_t numHorizontal = numHorizontalPasses( passes );
+	if( pass <= numHorizontal )
+	{
+		if( tileOrigin.y > dataWindow.max.y || tileOrigin.y + tileSize - 1 < dataWindow.min.y )
+		{
+			return;
+		}
+
+		const int reach = passReach( passes, 0, pass );
+		const int minX = std::max( tileOrigin.x - reach, dataWindow.min.x );
+		const int maxX = std::min( tileOrigin.x + tileSize - 1 + reach, dataWindow.max.x );
+		for( int x = ImagePlug::tileOrigin( V2i( minX, tileOrigin.y ) ).x; x <= maxX; x += tileSize )
+		{
+			tmpContext->set( ImagePlug::tileOriginContextName, V2i( x, tileOrigin.y ) );
+			inPlug()->channelDataPlug()->hash( h );
+		}
+	}
+	else
+	{
+		const Box2i window = passWindow( passes, numHorizontal, dataWindow );
+		if( tileOrigin.x > window.max.x || tileOrigin.x + tileSize - 1 < window.min.x )
+		{
+			return;
+		}
+
+		const int reach = passReach( passes, numHorizontal, pass );
+		const int minY = std::max( tileOrigin.y - reach, window.min.y );
+		const int maxY = std::min( tileOrigin.y + tileSize - 1 + reach, window.max.y );
+		tmpContext->set( g_passContextName, (int)numHorizontal );
+		for( int y = ImagePlug::tileOrigin( V2i( tileOrigin.x, minY ) ).y; y <= maxY; y += tileSize )
+		{
+			tmpContext->set( ImagePlug::tileOriginContextName, V2i( tileOrigin.x, y ) );
+			sumsPlug()->hash( h );
+		}
+	}
+}
+
+IECore::ConstFloatVectorDataPtr Blur::computePassInput( size_t pass, const Imath::V2i &tileOrigin, const Gaffer::Context *context ) const
+{
+	const Passes passes = blurPasses( modePlug()->getValue(), radiusPlug()->getValue(), filterPlug()->getValue() );
+	const Box2i dataWindow = inPlug()->dataWindowPlug()->getValue();
+	const int tileSize = ImagePlug::tileSize();
+
+	ContextPtr tmpContext = new Context( *context, Context::Borrowed );
+	Context::Scope scopedContext( tmpContext.get() );
+	tmpContext->set( ImagePlug::tileOriginContextName, tileOrigin );
+
+	if( pass == 0 )
+	{
+		// The input to the first pass is the input image, with the
+		// pixels outside the data window set to black.
+		ConstFloatVectorDataPtr inData = inPlug()->channelDataPlug()->getValue();
+		const Box2i bound = tileBound( tileOrigin );
+		if( dataWindow.intersects( bound.min ) && dataWindow.intersects( bound.max ) )
+		{
+			return inData;
+		}
+
+		FloatVectorDataPtr resultData = ImagePlug::allocateTile();
+		const float *in = &(inData->readable()[0]);
+		float *result = &(resultData->writable()[0]);
+		for( int y = 0; y < tileSize; ++y )
+		{
+			for( int x = 0; x < tileSize; ++x )
+			{
+				const int i = y * tileSize + x;
+				result[i] = dataWindow.intersects( tileOrigin + V2i( x, y ) ) ? in[i] : 0.0f;
+			}
+		}
+		return resultData;
+	}
+
+	// Otherwise we apply the previous pass, chaining together the sums
+	// of the tiles covering its support. Tiles outside the data window
+	// of the previous pass are known to be black, so we don't compute them.
+	const Pass &p = passes[pass - 1];
+	const Box2i window = passWindow( passes, pass - 1, dataWindow );
+	const int o = tileOrigin[p.axis];
+	const int firstTile = ImagePlug::tileOrigin( V2i( o - p.support ) )[p.axis];
+	const int last = o + tileSize + p.support;
+
+	tmpContext->set( g_passContextName, (int)( pass - 1 ) );
+	PrefixSums sums( firstTile );
+	V2i t = tileOrigin;
+	for( t[p.axis] = firstTile; t[p.axis] <= last; t[p.axis] += tileSize )
+	{
+		if( window.intersects( tileBound( t ) ) )
+		{
+			tmpContext->set( ImagePlug::tileOriginContextName, t );
+			sums.addTile( sumsPlug()->getValue() );
+		}
+		else
+		{
+			sums.addTile( NULL );
+		}
+	}
+
+	// The passes produce one span per position along their axis,
+	// which for a horizontal pass is a column of the tile.
+	FloatVectorDataPtr resultData = ImagePlug::allocateTile();
+	float *result = &(resultData->writable()[0]);
+	vector<float> columns;
+	float *out = result;
+	if( p.axis == 0 )
+	{
+		columns.resize( tileSize * tileSize );
+		out = &columns[0];
+	}
+
+	if( p.weights.size() )
+	{
+		convolvePass( sums, o, p, out );
+	}
+	else
+	{
+		boxPass( sums, o, p.radius, out );
+	}
+
+	if( p.axis == 0 )
+	{
+		transpose( out, tileSize, tileSize, result );
+	}
+
+	return resultData;
+}
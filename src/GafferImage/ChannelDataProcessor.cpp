@@ -105,13 +105,73 @@ bool ChannelDataProcessor::channelEnabled( const std::string &channel ) const
 	return std::find( channelMask.begin(), channelMask.end(), channel ) != channelMask.end();
 }
 
+bool ChannelDataProcessor::passesThroughDataWindow() const
+{
+	return true;
+}
+
 IECore::ConstFloatVectorDataPtr ChannelDataProcessor::computeChannelData( const std::string &channelName, const Imath::V2i &tileOrigin, const Gaffer::Context *context, const ImagePlug *parent ) const
 {
-	IECore::FloatVectorDataPtr outData = inPlug()->channelData( channelName, tileOrigin )->copy();
+	IECore::FloatVectorDataPtr outData = fusedChannelData( inPlug(), channelName, tileOrigin );
 	processChannelData( context, parent, channelName, outData );
+	
+	if( outData->readable().size() == 1 )
+	{
+		// A constant input gives a constant output, so we only
+		// processed a single value.
+		return ImagePlug::constantTile( outData->readable()[0] );
+	}
+	
 	return outData;
 }
 
+IECore::FloatVectorDataPtr ChannelDataProcessor::fusedChannelData( const ImagePlug *image, const std::string &channelName, const Imath::V2i &tileOrigin )
+{
+	// Walk upstream through any directly connected ChannelDataProcessors,
+	// collecting the ones which will actually modify this channel. Disabled
+	// nodes are simply pass-throughs, so we can walk straight through them.
+	std::vector<const ChannelDataProcessor *> chain;
+	while( true )
+	{
+		const ValuePlug *source = image->channelDataPlug()->source<ValuePlug>();
+		const ChannelDataProcessor *upstream = IECore::runTimeCast<const ChannelDataProcessor>( source->node() );
+		if( !upstream || source != upstream->outPlug()->channelDataPlug() )
+		{
+			break;
+		}
+		
+		if( upstream->enabled() && upstream->channelEnabled( channelName ) )
+		{
+			chain.push_back( upstream );
+		}
+		image = upstream->inPlug();
+	}
+	
+	IECore::ConstFloatVectorDataPtr inData = image->channelData( channelName, tileOrigin );
+	
+	IECore::FloatVectorDataPtr result;
+	float constantValue;
+	if( ImagePlug::isConstantTile( inData.get(), constantValue ) )
+	{
+		result = new IECore::FloatVectorData( std::vector<float>( 1, constantValue ) );
+	}
+	else
+	{
+		result = ImagePlug::allocateTile();
+		const std::vector<float> &in = inData->readable();
+		std::copy( in.begin(), in.end(), result->writable().begin() );
+	}
+	
+	// Apply the chain in order, starting with the node furthest upstream.
+	const Context *context = Context::current();
+	for( std::vector<const ChannelDataProcessor *>::const_reverse_iterator it = chain.rbegin(), eIt = chain.rend(); it != eIt; ++it )
+	{
+		(*it)->processChannelData( context, (*it)->outPlug(), channelName, result );
+	}
+	
+	return result;
+}
+
 void ChannelDataProcessor::hashFormat( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {
 	h = inPlug()->formatPlug()->hash();
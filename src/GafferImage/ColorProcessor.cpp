@@ -39,6 +39,7 @@
 #include "Gaffer/Context.h"
 
 #include "GafferImage/ColorProcessor.h"
+#include "GafferImage/ChannelDataProcessor.h"
 
 using namespace std;
 using namespace IECore;
@@ -65,7 +66,7 @@ ColorProcessor::ColorProcessor( const std::string &name )
 	// Because our implementation of computeChannelData() is so simple,
 	// just copying data out of our intermediate colorDataPlug(), it is
 	// actually quicker not to cache the result.
-	outPlug()->channelDataPlug()->setFlags( Plug::Cacheable, false );
+	channelDataStoragePlug()->setFlags( Plug::Cacheable, false );
 }
 
 ColorProcessor::~ColorProcessor()
@@ -113,6 +114,11 @@ bool ColorProcessor::channelEnabled( const std::string &channel ) const
 	return channel == "R" || channel == "G" || channel == "B";
 }
 
+bool ColorProcessor::passesThroughDataWindow() const
+{
+	return true;
+}
+
 void ColorProcessor::hash( const Gaffer::ValuePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {
 	ImageProcessor::hash( output, context, h );
@@ -127,18 +133,39 @@ void ColorProcessor::compute( Gaffer::ValuePlug *output, const Gaffer::Context *
 {
 	if( output == colorDataPlug() )
 	{
+		// Our input channels are fetched via ChannelDataProcessor::fusedChannelData(),
+		// so that any ChannelDataProcessors directly upstream are applied in the same
+		// pass, without computing and caching their output tiles.
+		const Imath::V2i tileOrigin = context->get<Imath::V2i>( ImagePlug::tileOriginContextName );
 		FloatVectorDataPtr r, g, b;
 		{
 			ContextPtr tmpContext = new Context( *context, Context::Borrowed );
 			Context::Scope scopedContext( tmpContext.get() );
 			tmpContext->set( ImagePlug::channelNameContextName, string( "R" ) );
-			r = inPlug()->channelDataPlug()->getValue()->copy();
+			r = ChannelDataProcessor::fusedChannelData( inPlug(), "R", tileOrigin );
 			tmpContext->set( ImagePlug::channelNameContextName, string( "G" ) );
-			g = inPlug()->channelDataPlug()->getValue()->copy();
+			g = ChannelDataProcessor::fusedChannelData( inPlug(), "G", tileOrigin );
 			tmpContext->set( ImagePlug::channelNameContextName, string( "B" ) );
-			b = inPlug()->channelDataPlug()->getValue()->copy();
+			b = ChannelDataProcessor::fusedChannelData( inPlug(), "B", tileOrigin );
 		}	
 		
+		// Constant input tiles are returned as single values, and give constant output
+		// tiles, in which case we need only process a single pixel and computeChannelData()
+		// expands the results back into full tiles. If only some of the channels are
+		// constant, we must expand them before processing.
+		if( r->readable().size() != 1 || g->readable().size() != 1 || b->readable().size() != 1 )
+		{
+			FloatVectorData *channels[3] = { r.get(), g.get(), b.get() };
+			for( int i = 0; i < 3; ++i )
+			{
+				if( channels[i]->readable().size() == 1 )
+				{
+					const float value = channels[i]->readable()[0];
+					channels[i]->writable().resize( ImagePlug::tileSize() * ImagePlug::tileSize(), value );
+				}
+			}
+		}
+		
 		processColorData( context, r.get(), g.get(), b.get() );
 		
 		ObjectVectorPtr result = new ObjectVector();
@@ -193,21 +220,34 @@ void ColorProcessor::hashChannelData( const GafferImage::ImagePlug *output, cons
 IECore::ConstFloatVectorDataPtr ColorProcessor::computeChannelData( const std::string &channelName, const Imath::V2i &tileOrigin, const Gaffer::Context *context, const ImagePlug *parent ) const
 {
 	ConstObjectVectorPtr colorData = boost::static_pointer_cast<const ObjectVector>( colorDataPlug()->getValue() );
+	
+	ConstFloatVectorDataPtr result;
 	if( channelName == "R" )
 	{
-		return boost::static_pointer_cast<const FloatVectorData>( colorData->members()[0] );
+		result = boost::static_pointer_cast<const FloatVectorData>( colorData->members()[0] );
 	}
 	else if( channelName == "G" )
 	{
-		return boost::static_pointer_cast<const FloatVectorData>( colorData->members()[1] );
+		result = boost::static_pointer_cast<const FloatVectorData>( colorData->members()[1] );
 	}
 	else if( channelName == "B" )
 	{
-		return boost::static_pointer_cast<const FloatVectorData>( colorData->members()[2] );
+		result = boost::static_pointer_cast<const FloatVectorData>( colorData->members()[2] );
 	}
-	// We're not allowed to return NULL, but we should never get here because channelEnabled()
-	// should be preventing it.
-	return NULL;
+	else
+	{
+		// We're not allowed to return NULL, but we should never get here because channelEnabled()
+		// should be preventing it.
+		return NULL;
+	}
+	
+	if( result->readable().size() == 1 )
+	{
+		// Result of processing a constant tile.
+		return ImagePlug::constantTile( result->readable()[0] );
+	}
+	
+	return result;
 }
 
 bool ColorProcessor::affectsColorData( const Gaffer::Plug *input ) const
@@ -34,14 +34,35 @@
 //  
 //////////////////////////////////////////////////////////////////////////
 
+#include <cstring>
+
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
 #include "boost/bind.hpp"
 #include "boost/bind/placeholders.hpp"
 #include "boost/lexical_cast.hpp"
-#include "boost/multi_array.hpp"
+#include "boost/scoped_array.hpp"
+#include "boost/scoped_ptr.hpp"
+#include "boost/format.hpp"
+#include "boost/thread.hpp"
+#include "boost/date_time/posix_time/posix_time.hpp"
+#include "boost/interprocess/shared_memory_object.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+#include "boost/interprocess/permissions.hpp"
+
+#include "tbb/atomic.h"
+#include "tbb/spin_mutex.h"
 
 #include "IECore/LRUCache.h"
 #include "IECore/DisplayDriverServer.h"
 #include "IECore/DisplayDriver.h"
+#include "IECore/ClientDisplayDriver.h"
 #include "IECore/MessageHandler.h"
 #include "IECore/BoxOps.h"
 
@@ -75,6 +96,325 @@ static DisplayDriverServerCache g_serverCache( cacheGetter, 10 );
 // Implementation of a DisplayDriver to support the node itself
 //////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+
+// De-interleaves width pixels of numChannels channels each from src,
+// writing each channel into the corresponding row in dst. Channels are
+// transposed four at a time using SSE where available, which covers the
+// common RGBA case fully and most of any AOVs that accompany it.
+void deinterleave( const float *src, int numChannels, int width, float **dst )
+{
+	if( numChannels == 1 )
+	{
+		memcpy( dst[0], src, width * sizeof( float ) );
+		return;
+	}
+
+	int c = 0;
+#if defined( __SSE2__ )
+	for( ; c + 4 <= numChannels; c += 4 )
+	{
+		const float *s = src + c;
+		const int stride = numChannels;
+		int x = 0;
+		for( ; x + 4 <= width; x += 4 )
+		{
+			__m128 p0 = _mm_loadu_ps( s );
+			__m128 p1 = _mm_loadu_ps( s + stride );
+			__m128 p2 = _mm_loadu_ps( s + 2 * stride );
+			__m128 p3 = _mm_loadu_ps( s + 3 * stride );
+			_MM_TRANSPOSE4_PS( p0, p1, p2, p3 );
+			_mm_storeu_ps( dst[c] + x, p0 );
+			_mm_storeu_ps( dst[c+1] + x, p1 );
+			_mm_storeu_ps( dst[c+2] + x, p2 );
+			_mm_storeu_ps( dst[c+3] + x, p3 );
+			s += 4 * stride;
+		}
+		for( ; x < width; ++x )
+		{
+			dst[c][x] = s[0];
+			dst[c+1][x] = s[1];
+			dst[c+2][x] = s[2];
+			dst[c+3][x] = s[3];
+			s += stride;
+		}
+	}
+#endif
+
+	for( ; c < numChannels; ++c )
+	{
+		const float *s = src + c;
+		float *d = dst[c];
+		for( int x = 0; x < width; ++x )
+		{
+			d[x] = *s;
+			s += numChannels;
+		}
+	}
+}
+
+// Waits a little, yielding at first and then sleeping, so that threads
+// polling a BucketRingBuffer are responsive without burning cpu when idle.
+void backoff( unsigned &iteration )
+{
+	if( iteration++ < 16 )
+	{
+		boost::this_thread::yield();
+	}
+	else
+	{
+		boost::this_thread::sleep( boost::posix_time::milliseconds( 1 ) );
+	}
+}
+
+// A single-producer, single-consumer queue of buckets, stored in a shared
+// memory segment so that a renderer on the same machine can pass pixels to
+// the GafferDisplayDriver without going through a socket. The segment is
+// created (and eventually removed) by the consumer, and opened by the producer.
+// Buckets are stored contiguously so that the consumer can pass them on to
+// imageData() without copying them out of the segment first.
+class BucketRingBuffer
+{
+
+	public :
+	
+		// Creates a new segment, for reading.
+		BucketRingBuffer( const std::string &name, size_t capacity )
+			:	m_name( name ), m_owner( true )
+		{
+			// the segment carries the pixels being rendered, so only
+			// the current user may access it.
+			boost::interprocess::shared_memory_object segment( boost::interprocess::create_only, name.c_str(), boost::interprocess::read_write, boost::interprocess::permissions( 0600 ) );
+			segment.truncate( sizeof( Header ) + capacity );
+			boost::interprocess::mapped_region region( segment, boost::interprocess::read_write );
+			m_region.swap( region );
+			
+			m_header = new( m_region.get_address() ) Header;
+			m_header->magic = g_magic;
+			m_header->capacity = capacity;
+			m_header->readerPid = getpid();
+			m_header->writeOffset = 0;
+			m_header->readOffset = 0;
+			m_header->closed = 0;
+		}
+		
+		// Opens an existing segment, for writing.
+		BucketRingBuffer( const std::string &name )
+			:	m_name( name ), m_owner( false )
+		{
+			boost::interprocess::shared_memory_object segment( boost::interprocess::open_only, name.c_str(), boost::interprocess::read_write );
+			boost::interprocess::mapped_region region( segment, boost::interprocess::read_write );
+			m_region.swap( region );
+			
+			m_header = static_cast<Header *>( m_region.get_address() );
+			if( m_region.get_size() < sizeof( Header ) || m_header->magic != g_magic )
+			{
+				throw IECore::Exception( boost::str( boost::format( "Shared memory segment \"%s\" is not a bucket buffer" ) % name ) );
+			}
+		}
+		
+		~BucketRingBuffer()
+		{
+			if( m_owner )
+			{
+				close();
+				boost::interprocess::shared_memory_object::remove( m_name.c_str() );
+			}
+		}
+		
+		// Prevents any further writes, causing write() to return false.
+		void close()
+		{
+			m_header->closed = 1;
+		}
+		
+		// Writes a bucket, waiting for space if necessary. Returns false
+		// if the bucket will never fit, or the reader has gone away or
+		// stalled - see waitForReader().
+		bool write( const Imath::Box2i &box, const float *data, size_t dataSize )
+		{
+			const uint64_t capacity = m_header->capacity;
+			const uint64_t size = recordSize( dataSize );
+			if( size > capacity )
+			{
+				return false;
+			}
+			
+			// records are never split, so if this one won't fit before the
+			// end of the buffer we must skip to the start.
+			uint64_t writeOffset = m_header->writeOffset;
+			const uint64_t position = writeOffset % capacity;
+			const uint64_t skip = capacity - position < size ? capacity - position : 0;
+			
+			ReaderProgress progress( m_header->readOffset );
+			while( writeOffset + skip + size - m_header->readOffset > capacity )
+			{
+				if( !waitForReader( progress ) )
+				{
+					return false;
+				}
+			}
+			
+			if( skip )
+			{
+				if( skip >= sizeof( RecordHeader ) )
+				{
+					record( position )->dataSize = g_skipMarker;
+				}
+				writeOffset += skip;
+			}
+			
+			RecordHeader *r = record( writeOffset % capacity );
+			r->box = box;
+			r->dataSize = dataSize;
+			memcpy( r + 1, data, dataSize * sizeof( float ) );
+			
+			// publish the record to the reader.
+			m_header->writeOffset = writeOffset + size;
+			return true;
+		}
+		
+		// Waits until the reader has consumed everything written so far.
+		// Returns false if the reader went away or stalled first.
+		bool waitForEmpty()
+		{
+			ReaderProgress progress( m_header->readOffset );
+			while( m_header->readOffset != m_header->writeOffset )
+			{
+				if( !waitForReader( progress ) )
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+		
+		// If a bucket is available, calls f( box, data, dataSize ) with it
+		// and returns true. Returns false if there was nothing to read.
+		template<typename F>
+		bool read( F f )
+		{
+			const uint64_t capacity = m_header->capacity;
+			const uint64_t writeOffset = m_header->writeOffset;
+			uint64_t readOffset = m_header->readOffset;
+			while( readOffset != writeOffset )
+			{
+				const uint64_t position = readOffset % capacity;
+				const RecordHeader *r = record( position );
+				if( capacity - position < sizeof( RecordHeader ) || r->dataSize == g_skipMarker )
+				{
+					readOffset += capacity - position;
+					continue;
+				}
+				
+				f( r->box, reinterpret_cast<const float *>( r + 1 ), r->dataSize );
+				m_header->readOffset = readOffset + recordSize( r->dataSize );
+				return true;
+			}
+			
+			m_header->readOffset = readOffset;
+			return false;
+		}
+		
+	private :
+	
+		// The offsets only ever increase - positions in the buffer are
+		// found by taking them modulo the capacity. They are kept on
+		// separate cache lines so the reader and writer don't contend.
+		struct Header
+		{
+			uint64_t magic;
+			uint64_t capacity;
+			int32_t readerPid;
+			char padding0[44];
+			tbb::atomic<uint64_t> writeOffset;
+			char padding1[56];
+			tbb::atomic<uint64_t> readOffset;
+			char padding2[56];
+			tbb::atomic<int> closed;
+			char padding3[60];
+		};
+		
+		struct RecordHeader
+		{
+			Imath::Box2i box;
+			uint64_t dataSize;
+			uint64_t padding;
+		};
+		
+		static const uint64_t g_magic = 0x4761666665724275ull;
+		static const uint64_t g_skipMarker = ~0ull;
+		
+		// Used by the writer to track the progress of the reader.
+		struct ReaderProgress
+		{
+			ReaderProgress( uint64_t readOffset )
+				:	iteration( 0 ), readOffset( readOffset ), time( boost::posix_time::microsec_clock::universal_time() )
+			{
+			}
+			
+			unsigned iteration;
+			uint64_t readOffset;
+			boost::posix_time::ptime time;
+		};
+		
+		// Waits a little for the reader to consume some data. Returns false if
+		// the reader has closed the buffer, if its process no longer exists, or
+		// if it hasn't consumed anything within the timeout. In the latter cases
+		// we close the buffer ourselves, so that the writer falls back to the
+		// socket straight away from then on, rather than hanging the renderer.
+		bool waitForReader( ReaderProgress &progress )
+		{
+			if( m_header->closed )
+			{
+				return false;
+			}
+			
+			const boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+			const uint64_t readOffset = m_header->readOffset;
+			if( readOffset != progress.readOffset )
+			{
+				progress.readOffset = readOffset;
+				progress.time = now;
+			}
+			else if(
+				now - progress.time > boost::posix_time::seconds( 10 ) ||
+				( kill( m_header->readerPid, 0 ) != 0 && errno == ESRCH )
+			)
+			{
+				m_header->closed = 1;
+				return false;
+			}
+			
+			backoff( progress.iteration );
+			return true;
+		}
+		
+		static uint64_t recordSize( uint64_t dataSize )
+		{
+			const uint64_t size = sizeof( RecordHeader ) + dataSize * sizeof( float );
+			return ( size + 15 ) & ~uint64_t( 15 );
+		}
+		
+		RecordHeader *record( uint64_t position )
+		{
+			return reinterpret_cast<RecordHeader *>( static_cast<char *>( m_region.get_address() ) + sizeof( Header ) + position );
+		}
+		
+		std::string m_name;
+		bool m_owner;
+		boost::interprocess::mapped_region m_region;
+		Header *m_header;
+
+};
+
+// Size of the segments used by SharedMemoryClientDisplayDriver. Buckets which
+// don't fit fall back to the socket.
+const size_t g_bucketRingBufferCapacity = 32 * 1024 * 1024;
+
+} // namespace
+
 namespace GafferImage
 {
 
@@ -91,22 +431,44 @@ class GafferDisplayDriver : public IECore::DisplayDriver
 				m_gafferFormat( displayWindow, 1 ),
 				m_gafferDataWindow( m_gafferFormat.yDownToFormatSpace( dataWindow ) )
 		{
-			const V2i dataWindowMinTileIndex = ImagePlug::tileOrigin( m_gafferDataWindow.min ) / ImagePlug::tileSize();
-			const V2i dataWindowMaxTileIndex = ImagePlug::tileOrigin( m_gafferDataWindow.max ) / ImagePlug::tileSize();
-			
-			m_tiles.resize(
-				TileArray::extent_gen()
-					[TileArray::extent_range( dataWindowMinTileIndex.x, dataWindowMaxTileIndex.x + 1 )]
-					[TileArray::extent_range( dataWindowMinTileIndex.y, dataWindowMaxTileIndex.y + 1 )]
-					[channelNames.size()]
-			);
+			m_minTileIndex = ImagePlug::tileOrigin( m_gafferDataWindow.min ) / ImagePlug::tileSize();
+			m_numTiles = ImagePlug::tileOrigin( m_gafferDataWindow.max ) / ImagePlug::tileSize() - m_minTileIndex + V2i( 1 );
+
+			m_tiles.reset( new Tile[m_numTiles.x * m_numTiles.y] );
+			for( int i = 0, e = m_numTiles.x * m_numTiles.y; i < e; ++i )
+			{
+				m_tiles[i].channels.resize( channelNames.size() );
+				m_tiles[i].shared.resize( channelNames.size(), false );
+			}
+
+			m_sharedMemoryEnabled = false;
 			
 			m_parameters = parameters ? parameters->copy() : CompoundDataPtr( new CompoundData );
 			instanceCreatedSignal()( this );
+			
+			// the Display claiming us in instanceCreatedSignal() will have told us whether
+			// or not to use shared memory. if we do, the segment must exist before we return,
+			// as the client will open it as soon as the constructor has completed.
+			ConstStringDataPtr sharedMemoryName = m_parameters->member<StringData>( "sharedMemoryName" );
+			if( sharedMemoryName && m_sharedMemoryEnabled )
+			{
+				try
+				{
+					m_bucketRingBuffer.reset( new BucketRingBuffer( sharedMemoryName->readable(), g_bucketRingBufferCapacity ) );
+					m_stopReading = 0;
+					m_readThread = boost::thread( boost::bind( &GafferDisplayDriver::readBuckets, this ) );
+				}
+				catch( const std::exception &e )
+				{
+					m_bucketRingBuffer.reset();
+					msg( Msg::Warning, "GafferDisplayDriver", boost::format( "Unable to create shared memory segment (%s) - falling back to socket" ) % e.what() );
+				}
+			}
 		}
 
 		virtual ~GafferDisplayDriver()
 		{
+			stopReading();
 		}
 		
 		const Format &gafferFormat() const
@@ -126,46 +488,50 @@ class GafferDisplayDriver : public IECore::DisplayDriver
 		
 		virtual void imageData( const Imath::Box2i &box, const float *data, size_t dataSize )
 		{
-			Box2i yUpBox = m_gafferFormat.yDownToFormatSpace( box );
+			const Box2i yUpBox = m_gafferFormat.yDownToFormatSpace( box );
+			const int numChannels = channelNames().size();
+			const size_t srcRowLength = ( box.size().x + 1 ) * numChannels;
+			
+			vector<float *> dst( numChannels );
+			
 			const V2i boxMinTileOrigin = ImagePlug::tileOrigin( yUpBox.min );
 			const V2i boxMaxTileOrigin = ImagePlug::tileOrigin( yUpBox.max );
 			for( int tileOriginY = boxMinTileOrigin.y; tileOriginY <= boxMaxTileOrigin.y; tileOriginY += ImagePlug::tileSize() )
 			{
 				for( int tileOriginX = boxMinTileOrigin.x; tileOriginX <= boxMaxTileOrigin.x; tileOriginX += ImagePlug::tileSize() )
 				{
-					for( int channelIndex = 0, numChannels = channelNames().size(); channelIndex < numChannels; ++channelIndex )
+					const V2i tileOrigin( tileOriginX, tileOriginY );
+					Tile *tile = getTile( tileOrigin );
+					if( !tile )
 					{
-						const V2i tileOrigin( tileOriginX, tileOriginY );
-						ConstFloatVectorDataPtr tileData = getTile( tileOrigin, channelIndex );
-						if( !tileData )
-						{
-							// we've been sent data outside of the data window
-							continue;
-						}
-						
-						// we must create a new object to hold the updated tile data,
-						// because the old one might well have been returned from
-						// computeChannelData and be being held in the cache.
-						FloatVectorDataPtr updatedTileData = tileData->copy();
-						vector<float> &updatedTile = updatedTileData->writable();
-						
-						const Box2i tileBound( tileOrigin, tileOrigin + Imath::V2i( GafferImage::ImagePlug::tileSize() - 1 ) );
-						const Box2i transferBound = IECore::boxIntersection( tileBound, yUpBox );
-						for( int y = transferBound.min.y; y<=transferBound.max.y; ++y )
+						// we've been sent data outside of the data window
+						continue;
+					}
+					
+					const Box2i tileBound( tileOrigin, tileOrigin + Imath::V2i( GafferImage::ImagePlug::tileSize() - 1 ) );
+					const Box2i transferBound = IECore::boxIntersection( tileBound, yUpBox );
+					const int transferWidth = transferBound.size().x + 1;
+					
+					// we take the lock once for all channels of the tile, and write
+					// directly into the tile data unless it has been shared with a
+					// reader since the last write.
+					tbb::spin_mutex::scoped_lock tileLock( tile->mutex );
+					for( int channelIndex = 0; channelIndex < numChannels; ++channelIndex )
+					{
+						dst[channelIndex] = &(writableChannel( *tile, channelIndex )[0]);
+					}
+					
+					vector<float *> dstRow( dst );
+					for( int y = transferBound.min.y; y<=transferBound.max.y; ++y )
+					{
+						const int srcY = m_gafferFormat.formatToYDownSpace( y );
+						const float *src = data + ( srcY - box.min.y ) * srcRowLength + ( transferBound.min.x - box.min.x ) * numChannels;
+						const size_t dstIndex = ( y - tileBound.min.y ) * ImagePlug::tileSize() + transferBound.min.x - tileBound.min.x;
+						for( int channelIndex = 0; channelIndex < numChannels; ++channelIndex )
 						{
-							int srcY = m_gafferFormat.formatToYDownSpace( y );
-							size_t srcIndex = ( ( srcY - box.min.y ) * ( box.size().x + 1 ) * numChannels ) + ( transferBound.min.x - box.min.x ) + channelIndex;
-							size_t dstIndex = ( y - tileBound.min.y ) * ImagePlug::tileSize() + transferBound.min.x - tileBound.min.x;
-							const size_t srcEndIndex = srcIndex + transferBound.size().x * numChannels;
-							while( srcIndex <= srcEndIndex )
-							{
-								updatedTile[dstIndex] = data[srcIndex];
-								srcIndex += numChannels;
-								dstIndex++;
-							}
+							dstRow[channelIndex] = dst[channelIndex] + dstIndex;
 						}
-						
-						setTile( tileOrigin, channelIndex, updatedTileData );
+						deinterleave( src, numChannels, transferWidth, &dstRow[0] );
 					}
 				}
 			}
@@ -173,8 +539,16 @@ class GafferDisplayDriver : public IECore::DisplayDriver
 			dataReceivedSignal()( this, box );
 		}
 		
+		/// Called by the Display in response to instanceCreatedSignal(), to specify
+		/// whether or not buckets may be received via shared memory.
+		void setSharedMemoryEnabled( bool enabled )
+		{
+			m_sharedMemoryEnabled = enabled;
+		}
+		
 		virtual void imageClose()
 		{
+			stopReading();
 			imageReceivedSignal()( this );
 		}
 
@@ -190,21 +564,44 @@ class GafferDisplayDriver : public IECore::DisplayDriver
 		
 		ConstFloatVectorDataPtr channelData( const Imath::V2i &tileOrigin, const std::string &channelName )
 		{
-			vector<string>::const_iterator cIt = find( channelNames().begin(), channelNames().end(), channelName );
-			if( cIt == channelNames().end() )
+			size_t channelIndex;
+			Tile *tile = getTile( tileOrigin, channelName, channelIndex );
+			if( !tile )
 			{
 				return ImagePlug::blackTile();
 			}
 			
-			ConstFloatVectorDataPtr tile = getTile( tileOrigin, cIt - channelNames().begin() );
-			if( tile )
+			tbb::spin_mutex::scoped_lock tileLock( tile->mutex );
+			if( !tile->channels[channelIndex] )
 			{
-				return tile;
+				return ImagePlug::blackTile();
 			}
-			else
+			
+			// the result may be held in the cache from now on, so the next
+			// write must go to a copy.
+			tile->shared[channelIndex] = true;
+			return tile->channels[channelIndex];
+		}
+		
+		/// Returns the hash of the data that channelData() would return. Unlike
+		/// channelData(), this doesn't hand out the data, so it doesn't cause the
+		/// next write to the tile to be made to a copy.
+		IECore::MurmurHash channelDataHash( const Imath::V2i &tileOrigin, const std::string &channelName )
+		{
+			size_t channelIndex;
+			Tile *tile = getTile( tileOrigin, channelName, channelIndex );
+			if( !tile )
 			{
-				return ImagePlug::blackTile();
+				return ImagePlug::blackTile()->Object::hash();
 			}
+			
+			tbb::spin_mutex::scoped_lock tileLock( tile->mutex );
+			if( !tile->channels[channelIndex] )
+			{
+				return ImagePlug::blackTile()->Object::hash();
+			}
+			
+			return tile->channels[channelIndex]->Object::hash();
 		}
 		
 		typedef boost::signal<void ( GafferDisplayDriver *, const Imath::Box2i & )> DataReceivedSignal;
@@ -230,43 +627,110 @@ class GafferDisplayDriver : public IECore::DisplayDriver
 	
 		static const DisplayDriverDescription<GafferDisplayDriver> g_description;
 
-		ConstFloatVectorDataPtr getTile( const V2i &tileOrigin, size_t channelIndex )
+		struct Tile
 		{
-			V2i tileIndex = tileOrigin / ImagePlug::tileSize();
-			
+			tbb::spin_mutex mutex;
+			// indexed by channelIndex. null until data is first received.
+			vector<FloatVectorDataPtr> channels;
+			// true for channels which have been returned by channelData()
+			// since they were last written.
+			vector<bool> shared;
+		};
+		
+		Tile *getTile( const V2i &tileOrigin )
+		{
+			const V2i tileIndex = tileOrigin / ImagePlug::tileSize() - m_minTileIndex;
 			if(
-				tileIndex.x < m_tiles.index_bases()[0] ||
-				tileIndex.x >= (int)(m_tiles.index_bases()[0] + m_tiles.shape()[0] ) ||
-				tileIndex.y < m_tiles.index_bases()[1] ||
-				tileIndex.y >= (int)(m_tiles.index_bases()[1] + m_tiles.shape()[1] )
+				tileIndex.x < 0 || tileIndex.x >= m_numTiles.x ||
+				tileIndex.y < 0 || tileIndex.y >= m_numTiles.y
 			)
 			{
 				// outside data window
 				return NULL;
 			}
 			
-			tbb::spin_rw_mutex::scoped_lock tileLock( m_tileMutex, false /* read */ );
+			return &(m_tiles[tileIndex.y * m_numTiles.x + tileIndex.x]);
+		}
+		
+		// As above, but also returning the index of the channel within the
+		// tile. Returns NULL if the channel isn't being rendered.
+		Tile *getTile( const V2i &tileOrigin, const std::string &channelName, size_t &channelIndex )
+		{
+			vector<string>::const_iterator cIt = find( channelNames().begin(), channelNames().end(), channelName );
+			if( cIt == channelNames().end() )
+			{
+				return NULL;
+			}
 			
-			ConstFloatVectorDataPtr result = m_tiles[tileIndex.x][tileIndex.y][channelIndex];
-			if( !result )
+			channelIndex = cIt - channelNames().begin();
+			return getTile( tileOrigin );
+		}
+		
+		// Must be called with the tile mutex held.
+		vector<float> &writableChannel( Tile &tile, size_t channelIndex )
+		{
+			FloatVectorDataPtr &channel = tile.channels[channelIndex];
+			if( !channel )
+			{
+				channel = ImagePlug::allocateTile();
+				std::fill( channel->writable().begin(), channel->writable().end(), 0.0f );
+			}
+			else if( tile.shared[channelIndex] )
 			{
-				result = ImagePlug::blackTile();
+				// we must create a new object to hold the updated tile data,
+				// because the old one might well have been returned from
+				// computeChannelData and be being held in the cache.
+				FloatVectorDataPtr copy = ImagePlug::allocateTile();
+				copy->writable() = channel->readable();
+				channel = copy;
+				tile.shared[channelIndex] = false;
+			}
+			return channel->writable();
+		}
+
+		void readBuckets()
+		{
+			unsigned iteration = 0;
+			while( !m_stopReading )
+			{
+				if( m_bucketRingBuffer->read( boost::bind( &GafferDisplayDriver::imageData, this, ::_1, ::_2, ::_3 ) ) )
+				{
+					iteration = 0;
+				}
+				else
+				{
+					backoff( iteration );
+				}
 			}
 			
-			return result;
+			// the client doesn't wait for us to empty the buffer before
+			// closing the image, so we must drain anything remaining.
+			while( m_bucketRingBuffer->read( boost::bind( &GafferDisplayDriver::imageData, this, ::_1, ::_2, ::_3 ) ) )
+			{
+			}
 		}
 		
-		void setTile( const V2i &tileOrigin, size_t channelIndex, ConstFloatVectorDataPtr tile )
+		void stopReading()
 		{
-			V2i tileIndex = tileOrigin / ImagePlug::tileSize();
-			tbb::spin_rw_mutex::scoped_lock tileLock( m_tileMutex, true /* write */ );
-			m_tiles[tileIndex.x][tileIndex.y][channelIndex] = tile;
+			if( !m_bucketRingBuffer )
+			{
+				return;
+			}
+			
+			m_stopReading = 1;
+			m_readThread.join();
+			m_bucketRingBuffer.reset();
 		}
 
-		// indexed by tileIndexX, tileIndexY, channelIndex.
-		typedef boost::multi_array<ConstFloatVectorDataPtr, 3> TileArray;
-		TileArray m_tiles;
-		tbb::spin_rw_mutex m_tileMutex;
+		// indexed by ( tileIndexY - m_minTileIndex.y ) * m_numTiles.x + tileIndexX - m_minTileIndex.x
+		boost::scoped_array<Tile> m_tiles;
+		V2i m_minTileIndex;
+		V2i m_numTiles;
+		
+		bool m_sharedMemoryEnabled;
+		boost::scoped_ptr<BucketRingBuffer> m_bucketRingBuffer;
+		boost::thread m_readThread;
+		tbb::atomic<int> m_stopReading;
 
 		Format m_gafferFormat;
 		Imath::Box2i m_gafferDataWindow;
@@ -280,6 +744,111 @@ const DisplayDriver::DisplayDriverDescription<GafferDisplayDriver> GafferDisplay
 
 } // namespace GafferImage
 
+//////////////////////////////////////////////////////////////////////////
+// Implementation of a client driver using shared memory for pixel data
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+// Base class holding the segment name, so that it is available
+// before the ClientDisplayDriver base class is constructed.
+struct SharedMemoryName
+{
+
+	SharedMemoryName()
+	{
+		static tbb::atomic<int> g_count;
+		m_sharedMemoryName = boost::str( boost::format( "gafferDisplay.%d.%d" ) % getpid() % g_count.fetch_and_increment() );
+	}
+	
+	std::string m_sharedMemoryName;
+
+};
+
+ConstCompoundDataPtr sharedMemoryParameters( ConstCompoundDataPtr parameters, const std::string &sharedMemoryName )
+{
+	CompoundDataPtr result = parameters ? parameters->copy() : CompoundDataPtr( new CompoundData );
+	result->writable()["sharedMemoryName"] = new StringData( sharedMemoryName );
+	return result;
+}
+
+} // namespace
+
+namespace GafferImage
+{
+
+/// A ClientDisplayDriver which sends pixel data to a GafferDisplayDriver through
+/// a shared memory segment rather than the socket, which is then used only for
+/// opening and closing the image. This avoids serialising and copying every bucket
+/// when the renderer is on the same machine as the Display. Falls back to the socket
+/// if the Display doesn't have its sharedMemory plug on, or is on another machine.
+class SharedMemoryClientDisplayDriver : private SharedMemoryName, public IECore::ClientDisplayDriver
+{
+
+	public :
+	
+		IE_CORE_DECLARERUNTIMETYPEDEXTENSION( GafferImage::SharedMemoryClientDisplayDriver, SharedMemoryClientDisplayDriverTypeId, ClientDisplayDriver );
+
+		SharedMemoryClientDisplayDriver( const Imath::Box2i &displayWindow, const Imath::Box2i &dataWindow,
+			const vector<string> &channelNames, ConstCompoundDataPtr parameters )
+			:	ClientDisplayDriver( displayWindow, dataWindow, channelNames, sharedMemoryParameters( parameters, m_sharedMemoryName ) )
+		{
+			try
+			{
+				m_bucketRingBuffer.reset( new BucketRingBuffer( m_sharedMemoryName ) );
+			}
+			catch( ... )
+			{
+				// the server has declined to use shared memory
+				// or is on another machine - we'll use the socket.
+			}
+		}
+		
+		virtual ~SharedMemoryClientDisplayDriver()
+		{
+		}
+		
+		virtual void imageData( const Imath::Box2i &box, const float *data, size_t dataSize )
+		{
+			if( m_bucketRingBuffer )
+			{
+				if( m_bucketRingBuffer->write( box, data, dataSize ) )
+				{
+					return;
+				}
+				// the bucket is too big for the buffer, or the reader has gone
+				// away. we must send it via the socket, but only once the buffer
+				// is empty, so that it arrives after the buckets before it. if the
+				// reader never empties it, we stop using the buffer altogether.
+				if( !m_bucketRingBuffer->waitForEmpty() )
+				{
+					m_bucketRingBuffer.reset();
+				}
+			}
+			ClientDisplayDriver::imageData( box, data, dataSize );
+		}
+		
+		virtual void imageClose()
+		{
+			// we don't need to wait for the server to read the remaining
+			// buckets - it drains the buffer before closing the image.
+			m_bucketRingBuffer.reset();
+			ClientDisplayDriver::imageClose();
+		}
+		
+	private :
+	
+		static const DisplayDriverDescription<SharedMemoryClientDisplayDriver> g_description;
+		
+		boost::scoped_ptr<BucketRingBuffer> m_bucketRingBuffer;
+		
+};
+
+const DisplayDriver::DisplayDriverDescription<SharedMemoryClientDisplayDriver> SharedMemoryClientDisplayDriver::g_description;
+
+} // namespace GafferImage
+
 //////////////////////////////////////////////////////////////////////////
 // Implementation of the Display class itself
 //////////////////////////////////////////////////////////////////////////
@@ -322,6 +891,8 @@ Display::Display( const std::string &name )
 			Plug::Default & ~Plug::Serialisable
 		)
 	);
+	
+	addChild( new BoolPlug( "sharedMemory", Plug::In, false, Plug::Default & ~Plug::AcceptsInputs ) );
 		
 	plugSetSignal().connect( boost::bind( &Display::plugSet, this, ::_1 ) );
 	GafferDisplayDriver::instanceCreatedSignal().connect( boost::bind( &Display::driverCreated, this, ::_1 ) );
@@ -351,6 +922,16 @@ const Gaffer::IntPlug *Display::updateCountPlug() const
 {
 	return getChild<IntPlug>( g_firstPlugIndex + 1 );
 }
+
+Gaffer::BoolPlug *Display::sharedMemoryPlug()
+{
+	return getChild<BoolPlug>( g_firstPlugIndex + 2 );
+}
+
+const Gaffer::BoolPlug *Display::sharedMemoryPlug() const
+{
+	return getChild<BoolPlug>( g_firstPlugIndex + 2 );
+}
 				
 void Display::affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const
 {
@@ -457,15 +1038,20 @@ Imath::Box2i Display::computeDataWindow( const Gaffer::Context *context, const I
 
 void Display::hashChannelData( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {
-	ConstFloatVectorDataPtr channelData = ImagePlug::blackTile();
 	if( m_driver )
 	{
-		channelData = m_driver->channelData(
+		// we mustn't use channelData() here, because that would mark the tile
+		// as shared, forcing the next bucket to be written to a copy even if
+		// the data is never actually computed.
+		h = m_driver->channelDataHash(
 			context->get<Imath::V2i>( ImagePlug::tileOriginContextName ),
 			context->get<std::string>( ImagePlug::channelNameContextName )
 		);
 	}
-	h = channelData->Object::hash();
+	else
+	{
+		h = ImagePlug::blackTile()->Object::hash();
+	}
 }
 
 IECore::ConstFloatVectorDataPtr Display::computeChannelData( const std::string &channelName, const Imath::V2i &tileOrigin, const Gaffer::Context *context, const ImagePlug *parent ) const
@@ -507,6 +1093,7 @@ void Display::driverCreated( GafferDisplayDriver *driver )
 	ConstStringDataPtr portNumber = driver->parameters()->member<StringData>( "displayPort" );
 	if( portNumber && boost::lexical_cast<int>( portNumber->readable() ) == portPlug()->getValue() )
 	{
+		driver->setSharedMemoryEnabled( sharedMemoryPlug()->getValue() );
 		setupDriver( driver );
 	}
 }
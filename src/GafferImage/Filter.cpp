@@ -41,6 +41,7 @@
 
 #include "boost/format.hpp"
 #include "IECore/Exception.h"
+#include "IECore/FastFloat.h"
 #include "GafferImage/Filter.h"
 
 namespace GafferImage
@@ -64,6 +65,48 @@ void Filter::setScale( float scale )
 	m_scaledRadius = m_radius * m_scale;
 }
 
+void Filter::computeWeights( const std::vector<float> &centers, Weights &weights ) const
+{
+	const size_t numCenters = centers.size();
+
+	if( static_cast<GafferImage::TypeId>( typeId() ) == GafferImage::BoxFilterTypeId )
+	{
+		weights.width = 1;
+		weights.taps.resize( numCenters );
+		weights.weights.assign( numCenters, 1.0f );
+		for( size_t i = 0; i < numCenters; ++i )
+		{
+			weights.taps[i] = IECore::fastFloatFloor( centers[i] );
+		}
+		return;
+	}
+
+	const int w = width();
+	weights.width = w;
+	weights.taps.resize( numCenters );
+	weights.weights.resize( numCenters * w );
+
+	float *wi = weights.weights.empty() ? NULL : &weights.weights[0];
+	for( size_t i = 0; i < numCenters; ++i, wi += w )
+	{
+		const float center = centers[i];
+		const int tap = IECore::fastFloatFloor( center - m_scaledRadius );
+		weights.taps[i] = tap;
+
+		float sum = 0.0f;
+		for( int j = 0; j < w; ++j )
+		{
+			sum += wi[j] = weight( center, tap + j );
+		}
+
+		const float normalisation = sum != 0.0f ? 1.0f / sum : 0.0f;
+		for( int j = 0; j < w; ++j )
+		{
+			wi[j] *= normalisation;
+		}
+	}
+}
+
 FilterPtr Filter::create( const std::string &name, float scale )
 {
 	// Check to see whether the requested Filter is registered and if not, throw an exception.
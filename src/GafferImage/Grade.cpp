@@ -34,13 +34,67 @@
 //  
 //////////////////////////////////////////////////////////////////////////
 
+#include <limits>
+
 #include "Gaffer/Context.h"
 
 #include "GafferImage/Grade.h"
+#include "GafferImage/SIMDFloat.h"
 
 using namespace IECore;
 using namespace Gaffer;
 
+//////////////////////////////////////////////////////////////////////////
+// Grading kernel. This is templated on the value type so that it can be
+// applied to SIMDFloat::width values at a time, and then to any remainder
+// one at a time, and on whether or not gamma is applied, so that the
+// common multiply and offset case doesn't pay for it.
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+template<bool applyGamma, typename T>
+inline T grade( const T &x, const T &a, const T &b, const T &invGamma, const T &lowerLimit, const T &upperLimit )
+{
+	using namespace GafferImage::Detail;
+	
+	T c = a * x + b;
+	if( applyGamma )
+	{
+		// Zero and negative values are passed through unchanged, as are denormals,
+		// which fastPow() doesn't support, and for which the result would be
+		// vanishingly small anyway.
+		c = select( c > T( std::numeric_limits<float>::min() ), fastPow( c, invGamma ), c );
+	}
+	
+	// The value is passed as the second argument so that NaNs pass through
+	// unclamped.
+	return min( upperLimit, max( lowerLimit, c ) );
+}
+
+template<bool applyGamma>
+void gradePixels( float *data, size_t size, float a, float b, float invGamma, float lowerLimit, float upperLimit )
+{
+	using namespace GafferImage::Detail;
+	
+	typedef SIMDFloat V;
+	const V aV( a ), bV( b ), invGammaV( invGamma ), lowerLimitV( lowerLimit ), upperLimitV( upperLimit );
+	
+	size_t i = 0;
+	for( ; i + V::width <= size; i += V::width )
+	{
+		store( grade<applyGamma>( load<V>( data + i ), aV, bV, invGammaV, lowerLimitV, upperLimitV ), data + i );
+	}
+	
+	for( ; i < size; ++i )
+	{
+		data[i] = grade<applyGamma>( data[i], a, b, invGamma, lowerLimit, upperLimit );
+	}
+}
+
+} // namespace
+
 namespace GafferImage
 {
 
@@ -157,6 +211,13 @@ const Gaffer::BoolPlug *Grade::whiteClampPlug() const
 	return getChild<BoolPlug>( g_firstPlugIndex+8 );
 }
 
+bool Grade::halfStorageEnabled( const std::string &channel ) const
+{
+	// Grades are frequently chained, and quantising each of the
+	// results to half would compound the error.
+	return false;
+}
+
 bool Grade::channelEnabled( const std::string &channel ) const 
 {
 	if ( !ChannelDataProcessor::channelEnabled( channel ) )
@@ -243,33 +304,27 @@ void Grade::hashChannelData( const GafferImage::ImagePlug *output, const Gaffer:
 
 void Grade::processChannelData( const Gaffer::Context *context, const ImagePlug *parent, const std::string &channel, FloatVectorDataPtr outData ) const
 {
-	// Calculate the valid data window that we are to merge.
-	const int dataWidth = ImagePlug::tileSize()*ImagePlug::tileSize();
-
 	// Do some pre-processing.
 	float A, B, gamma;
 	parameters( ChannelMaskPlug::channelIndex( channel ), A, B, gamma );
 	const float invGamma = 1. / gamma;
 	const bool whiteClamp = whiteClampPlug()->getValue();	
 	const bool blackClamp = blackClampPlug()->getValue();	
+	
+	// Express the clamping as a range, so we can clamp without branching
+	// in the kernel.
+	const float lowerLimit = blackClamp ? 0.0f : -std::numeric_limits<float>::infinity();
+	const float upperLimit = whiteClamp ? 1.0f : std::numeric_limits<float>::infinity();
 
-	// Get some useful pointers.	
-	float *outPtr = &(outData->writable()[0]);
-	const float *END = outPtr + dataWidth;
-
-	while (outPtr != END)
+	std::vector<float> &data = outData->writable();
+	if( invGamma == 1.f )
 	{
-		// Calculate the colour of the graded pixel.
-		float colour = *outPtr;	// As the input has been copied to outData, grab the input colour from there.
-		const float c = A * colour + B;
-		colour = ( c >= 0.f && invGamma != 1.f ? (float)pow( c, invGamma ) : c );
-
-		// Clamp the white and blacks if necessary.
-		if ( blackClamp && colour < 0.f ) colour = 0.f;
-		if ( whiteClamp && colour > 1.f ) colour = 1.f;
-
-		// Write back the result.
-		*outPtr++ = colour;	
+		// Fast path for the common case where we just have a multiplier and offset.
+		gradePixels<false>( &(data[0]), data.size(), A, B, invGamma, lowerLimit, upperLimit );
+	}
+	else
+	{
+		gradePixels<true>( &(data[0]), data.size(), A, B, invGamma, lowerLimit, upperLimit );
 	}
 }
 
@@ -35,6 +35,10 @@
 //  
 //////////////////////////////////////////////////////////////////////////
 
+#include "OpenEXR/half.h"
+
+#include "IECore/VectorTypedData.h"
+
 #include "Gaffer/Context.h"
 #include "Gaffer/ScriptNode.h"
 
@@ -46,6 +50,85 @@ using namespace IECore;
 using namespace GafferImage;
 using namespace Gaffer;
 
+//////////////////////////////////////////////////////////////////////////
+// Utilities for converting between the float tiles passed between nodes
+// and the half tiles which may be stored in the cache, and for retrieving
+// the tile origin from the context.
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+IECore::ConstObjectPtr floatToHalfTile( const IECore::FloatVectorData *floatData )
+{
+	// Constant tiles are shared, so cost us nothing to store, and
+	// converting them would lose the ability to recognise them as
+	// constant downstream.
+	float constantValue;
+	if( ImagePlug::isConstantTile( floatData, constantValue ) )
+	{
+		return floatData;
+	}
+
+	const vector<float> &in = floatData->readable();
+	HalfVectorDataPtr halfData = new HalfVectorData;
+	vector<half> &out = halfData->writable();
+	out.resize( in.size() );
+	
+	const float *inPtr = in.empty() ? NULL : &in[0];
+	half *outPtr = out.empty() ? NULL : &out[0];
+	for( size_t i = 0, e = in.size(); i < e; ++i )
+	{
+		*outPtr++ = *inPtr++;
+	}
+	
+	return halfData;
+}
+
+IECore::ConstFloatVectorDataPtr halfToFloatTile( const IECore::Object *storedData )
+{
+	if( const FloatVectorData *floatData = runTimeCast<const FloatVectorData>( storedData ) )
+	{
+		return floatData;
+	}
+
+	const HalfVectorData *halfData = runTimeCast<const HalfVectorData>( storedData );
+	if( !halfData )
+	{
+		throw IECore::Exception( "Unexpected type for stored channel data" );
+	}
+	
+	const vector<half> &in = halfData->readable();
+	FloatVectorDataPtr floatData = ImagePlug::allocateTile();
+	vector<float> &out = floatData->writable();
+	out.resize( in.size() );
+	
+	const half *inPtr = in.empty() ? NULL : &in[0];
+	float *outPtr = out.empty() ? NULL : &out[0];
+	for( size_t i = 0, e = in.size(); i < e; ++i )
+	{
+		*outPtr++ = *inPtr++;
+	}
+
+	return floatData;
+}
+
+V2i tileOrigin( const Gaffer::Context *context )
+{
+	V2i tileOrigin = context->get<V2i>( ImagePlug::tileOriginContextName );
+	if( tileOrigin.x % ImagePlug::tileSize() || tileOrigin.y % ImagePlug::tileSize() )
+	{
+		throw Exception( "The image:tileOrigin must be a multiple of ImagePlug::tileSize()" );
+	}
+	return tileOrigin;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+// ImageNode implementation
+//////////////////////////////////////////////////////////////////////////
+
 IE_CORE_DEFINERUNTIMETYPED( ImageNode );
 
 size_t ImageNode::g_firstPlugIndex = 0;
@@ -56,6 +139,11 @@ ImageNode::ImageNode( const std::string &name )
 	storeIndexOfNextChild( g_firstPlugIndex );
 	addChild( new ImagePlug( "out", Gaffer::Plug::Out ) );
 	addChild( new BoolPlug( "enabled", Gaffer::Plug::In, true ) );
+	addChild( new ObjectPlug( "__channelDataStorage", Gaffer::Plug::Out, ImagePlug::blackTile() ) );
+
+	// The channel data is cached by channelDataStoragePlug(), possibly at
+	// half precision. We don't want to store it a second time here.
+	outPlug()->channelDataPlug()->setFlags( Plug::Cacheable, false );
 }
 
 ImageNode::~ImageNode()
@@ -82,13 +170,46 @@ const BoolPlug *ImageNode::enabledPlug() const
 	return getChild<BoolPlug>( g_firstPlugIndex + 1 );
 }
 
+Gaffer::ObjectPlug *ImageNode::channelDataStoragePlug()
+{
+	return getChild<ObjectPlug>( g_firstPlugIndex + 2 );
+}
+
+const Gaffer::ObjectPlug *ImageNode::channelDataStoragePlug() const
+{
+	return getChild<ObjectPlug>( g_firstPlugIndex + 2 );
+}
+
 bool ImageNode::enabled() const
 {
 	return enabledPlug()->getValue();
 };
 
+bool ImageNode::halfStorageEnabled( const std::string &channel ) const
+{
+	return true;
+}
+
+bool ImageNode::useHalfStorage( const std::string &channel ) const
+{
+	return ImagePlug::getTileStorage() == ImagePlug::HalfTileStorage && halfStorageEnabled( channel );
+}
+
 void ImageNode::hash( const Gaffer::ValuePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {	
+	if( output == channelDataStoragePlug() )
+	{
+		// Half and float tiles for the same channel data must not share an entry
+		// in the cache, but pass-through nodes should still share the entry of the
+		// node they pass through, so we derive our hash from the channel data hash.
+		h = outPlug()->channelDataPlug()->hash();
+		if( useHalfStorage( context->get<std::string>( ImagePlug::channelNameContextName ) ) )
+		{
+			h.append( "half" );
+		}
+		return;
+	}
+
 	const ImagePlug *imagePlug = output->ancestor<ImagePlug>();
 	if( imagePlug && enabled() )
 	{
@@ -165,6 +286,21 @@ void ImageNode::parentChanging( Gaffer::GraphComponent *newParent )
 
 void ImageNode::compute( ValuePlug *output, const Context *context ) const
 {
+	if( output == channelDataStoragePlug() )
+	{
+		const std::string &channelName = context->get<string>( ImagePlug::channelNameContextName );
+		ConstFloatVectorDataPtr channelData = computeChannelData( channelName, tileOrigin( context ), context, outPlug() );
+		if( useHalfStorage( channelName ) )
+		{
+			static_cast<ObjectPlug *>( output )->setValue( floatToHalfTile( channelData.get() ) );
+		}
+		else
+		{
+			static_cast<ObjectPlug *>( output )->setValue( channelData );
+		}
+		return;
+	}
+
 	ImagePlug *imagePlug = output->parent<ImagePlug>();
 	if( !imagePlug )
 	{
@@ -206,14 +342,17 @@ void ImageNode::compute( ValuePlug *output, const Context *context ) const
 		std::string channelName = context->get<string>( ImagePlug::channelNameContextName );
 		if( channelEnabled( channelName ) )
 		{
-			V2i tileOrigin = context->get<V2i>( ImagePlug::tileOriginContextName );
-			if( tileOrigin.x % ImagePlug::tileSize() || tileOrigin.y % ImagePlug::tileSize() )
+			if( imagePlug == outPlug() && channelDataStoragePlug()->getFlags( Plug::Cacheable ) )
+			{
+				ConstObjectPtr storedData = channelDataStoragePlug()->getValue();
+				static_cast<FloatVectorDataPlug *>( output )->setValue( halfToFloatTile( storedData.get() ) );
+			}
+			else
 			{
-				throw Exception( "The image:tileOrigin must be a multiple of ImagePlug::tileSize()" );
+				static_cast<FloatVectorDataPlug *>( output )->setValue(
+					computeChannelData( channelName, tileOrigin( context ), context, imagePlug )
+				);
 			}
-			static_cast<FloatVectorDataPlug *>( output )->setValue(
-				computeChannelData( channelName, tileOrigin, context, imagePlug )
-			);
 		}
 		else
 		{
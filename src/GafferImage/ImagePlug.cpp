@@ -35,9 +35,14 @@
 //  
 //////////////////////////////////////////////////////////////////////////
 
+#include <map>
+
 #include "tbb/tbb.h"
 
+#include "boost/format.hpp"
+
 #include "IECore/Exception.h"
+#include "IECore/MessageHandler.h"
 #include "IECore/BoxOps.h"
 #include "IECore/BoxAlgo.h"
 
@@ -55,6 +60,42 @@ using namespace tbb;
 
 IE_CORE_DEFINERUNTIMETYPED( ImagePlug );
 
+//////////////////////////////////////////////////////////////////////////
+// Tile size
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+const int g_defaultTileSize = 64;
+const int g_minTileSize = 8;
+const int g_maxTileSize = 1024;
+
+int initialTileSize()
+{
+	const char *s = getenv( "GAFFERIMAGE_TILE_SIZE" );
+	if( !s )
+	{
+		return g_defaultTileSize;
+	}
+	
+	const int tileSize = atoi( s );
+	if( tileSize < g_minTileSize || tileSize > g_maxTileSize )
+	{
+		msg(
+			Msg::Warning, "ImagePlug",
+			boost::format( "Invalid GAFFERIMAGE_TILE_SIZE \"%s\" (must be between %d and %d) - using %d" ) % s % g_minTileSize % g_maxTileSize % g_defaultTileSize
+		);
+		return g_defaultTileSize;
+	}
+	
+	return tileSize;
+}
+
+} // namespace
+
+const int ImagePlug::g_tileSize = initialTileSize();
+
 //////////////////////////////////////////////////////////////////////////
 // Implementation of CopyTiles:
 // A simple class for multithreading the copying of
@@ -201,6 +242,205 @@ ImagePlug::~ImagePlug()
 {
 }
 
+static tbb::atomic<int> g_tileStorage;
+
+void ImagePlug::setTileStorage( TileStorage tileStorage )
+{
+	g_tileStorage = tileStorage;
+}
+
+ImagePlug::TileStorage ImagePlug::getTileStorage()
+{
+	return (TileStorage)(int)g_tileStorage;
+}
+
+namespace
+{
+
+// Registry of the shared tiles returned by constantTile(). We limit the
+// number we keep around so that an animated colour doesn't cause the
+// registry to grow without bound - when full we simply start afresh,
+// which is safe because tiles are only recognised as constant while
+// they are held by the registry.
+struct ConstantTiles
+{
+	typedef std::map<float, ConstFloatVectorDataPtr> Map;
+	typedef tbb::spin_rw_mutex Mutex;
+	
+	Map tiles;
+	Mutex mutex;
+};
+
+const size_t g_maxConstantTiles = 256;
+
+ConstantTiles &constantTiles()
+{
+	static ConstantTiles c;
+	return c;
+}
+
+} // namespace
+
+IECore::ConstFloatVectorDataPtr ImagePlug::constantTile( float value )
+{
+	if( value == 0.0f )
+	{
+		return blackTile();
+	}
+	else if( value == 1.0f )
+	{
+		return whiteTile();
+	}
+	else if( value != value )
+	{
+		// NaN can't be used as a key, so we just make a new tile.
+		return new FloatVectorData( std::vector<float>( tileSize() * tileSize(), value ) );
+	}
+	
+	ConstantTiles &c = constantTiles();
+	{
+		ConstantTiles::Mutex::scoped_lock lock( c.mutex, /* write = */ false );
+		ConstantTiles::Map::const_iterator it = c.tiles.find( value );
+		if( it != c.tiles.end() )
+		{
+			return it->second;
+		}
+	}
+	
+	ConstFloatVectorDataPtr tile = new FloatVectorData( std::vector<float>( tileSize() * tileSize(), value ) );
+	
+	ConstantTiles::Mutex::scoped_lock lock( c.mutex, /* write = */ true );
+	if( c.tiles.size() >= g_maxConstantTiles )
+	{
+		c.tiles.clear();
+	}
+	// If another thread beat us to it then insert() returns
+	// the tile it made, and ours is discarded.
+	return c.tiles.insert( ConstantTiles::Map::value_type( value, tile ) ).first->second;
+}
+
+bool ImagePlug::isConstantTile( const IECore::FloatVectorData *tile, float &value )
+{
+	if( tile == blackTile() )
+	{
+		value = 0.0f;
+		return true;
+	}
+	else if( tile == whiteTile() )
+	{
+		value = 1.0f;
+		return true;
+	}
+	
+	const std::vector<float> &data = tile->readable();
+	if( data.size() != (size_t)( tileSize() * tileSize() ) )
+	{
+		return false;
+	}
+	
+	ConstantTiles &c = constantTiles();
+	ConstantTiles::Mutex::scoped_lock lock( c.mutex, /* write = */ false );
+	ConstantTiles::Map::const_iterator it = c.tiles.find( data[0] );
+	if( it != c.tiles.end() && it->second.get() == tile )
+	{
+		value = data[0];
+		return true;
+	}
+	
+	return false;
+}
+
+namespace
+{
+
+// Pool of tile storage for allocateTile(). Each thread has its own list of free
+// tiles, so that allocation and release need no locking. Tiles are returned to
+// the list of the thread which destroys them, which is not necessarily the one
+// which allocated them, so we limit the size of each list to stop a thread which
+// only releases tiles from hoarding them.
+typedef std::vector<std::vector<float> > TileFreeList;
+typedef tbb::enumerable_thread_specific<TileFreeList> TilePool;
+
+// Limit on the memory held by each free list. This is specified in bytes
+// rather than tiles so that it is independent of the tile size.
+const size_t g_maxFreeBytesPerThread = 1024 * 1024;
+
+size_t maxFreeTilesPerThread()
+{
+	static const size_t n = std::max<size_t>( 4, g_maxFreeBytesPerThread / ( ImagePlug::tileSize() * ImagePlug::tileSize() * sizeof( float ) ) );
+	return n;
+}
+
+TilePool &tilePool()
+{
+	// Deliberately leaked, as pooled tiles may outlive static destruction.
+	static TilePool *p = new TilePool;
+	return *p;
+}
+
+TileFreeList &freeList()
+{
+	TileFreeList &l = tilePool().local();
+	if( l.capacity() < maxFreeTilesPerThread() )
+	{
+		// Reserving up front means that returning a tile to the
+		// list never itself needs to allocate.
+		l.reserve( maxFreeTilesPerThread() );
+	}
+	return l;
+}
+
+// A FloatVectorData which takes its storage from the pool on construction,
+// and gives it back on destruction. It adds no data members and doesn't
+// declare a new type, so is indistinguishable from a FloatVectorData in
+// every other respect.
+class PooledTileData : public FloatVectorData
+{
+
+	public :
+
+		PooledTileData()
+		{
+			std::vector<float> &data = writable();
+			TileFreeList &l = freeList();
+			if( l.size() )
+			{
+				data.swap( l.back() );
+				l.pop_back();
+			}
+			else
+			{
+				data.resize( ImagePlug::tileSize() * ImagePlug::tileSize() );
+			}
+		}
+
+		virtual ~PooledTileData()
+		{
+			TileFreeList &l = freeList();
+			if( l.size() >= maxFreeTilesPerThread() )
+			{
+				return;
+			}
+
+			// If the tile has been shared by copy(), then writable() will
+			// unshare it first, which is wasteful but harmless.
+			std::vector<float> &data = writable();
+			if( data.size() == (size_t)( ImagePlug::tileSize() * ImagePlug::tileSize() ) )
+			{
+				l.push_back( std::vector<float>() );
+				l.back().swap( data );
+			}
+		}
+
+};
+
+} // namespace
+
+IECore::FloatVectorDataPtr ImagePlug::allocateTile()
+{
+	return new PooledTileData;
+}
+
 const IECore::FloatVectorData *ImagePlug::whiteTile()
 {
 	static IECore::ConstFloatVectorDataPtr g_whiteTile( new IECore::FloatVectorData( std::vector<float>( ImagePlug::tileSize()*ImagePlug::tileSize(), 1. ) ) );
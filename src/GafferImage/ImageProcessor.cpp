@@ -39,9 +39,30 @@
 
 #include "GafferImage/ImageProcessor.h"
 
+using namespace Imath;
 using namespace Gaffer;
 using namespace GafferImage;
 
+namespace
+{
+
+// Returns true if the tile specified by the context lies entirely outside the
+// data window of image. Such tiles are black by definition.
+bool tileOutsideDataWindow( const ImagePlug *image, const Context *context )
+{
+	const V2i tileOrigin = context->get<V2i>( ImagePlug::tileOriginContextName );
+	const Box2i tileBound( tileOrigin, tileOrigin + V2i( ImagePlug::tileSize() - 1 ) );
+	return !tileBound.intersects( image->dataWindowPlug()->getValue() );
+}
+
+const IECore::MurmurHash &blackTileHash()
+{
+	static const IECore::MurmurHash g_hash = ImagePlug::blackTile()->Object::hash();
+	return g_hash;
+}
+
+} // namespace
+
 IE_CORE_DEFINERUNTIMETYPED( ImageProcessor );
 
 size_t ImageProcessor::g_firstPlugIndex = 0;
@@ -87,6 +108,18 @@ const Plug *ImageProcessor::correspondingInput( const Plug *output ) const
 	return ImageNode::correspondingInput( output );
 }
 
+void ImageProcessor::affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const
+{
+	ImageNode::affects( input, outputs );
+	
+	// Tiles outside the data window are output as black, so the
+	// data window affects the channel data.
+	if( input == inPlug()->dataWindowPlug() && passesThroughDataWindow() )
+	{
+		outputs.push_back( outPlug()->channelDataPlug() );
+	}
+}
+
 void ImageProcessor::hash( const Gaffer::ValuePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {
 	const ImagePlug *imagePlug = output->parent<ImagePlug>();
@@ -114,6 +147,12 @@ void ImageProcessor::hash( const Gaffer::ValuePlug *output, const Gaffer::Contex
 	{
 		h = inPlug()->getChild<ValuePlug>( output->getName() )->hash();	
 	}
+	else if( output == imagePlug->channelDataPlug() && imagePlug == outPlug() && passesThroughDataWindow() && tileOutsideDataWindow( inPlug(), context ) )
+	{
+		// The tile will be black, so we needn't hash the inputs at all, and
+		// all such tiles can share a single entry in the cache.
+		h = blackTileHash();
+	}
 	else
 	{
 		// normal operation - just let the base class take care of it.
@@ -146,9 +185,18 @@ void ImageProcessor::compute( ValuePlug *output, const Context *context ) const
 	{
 		output->setFrom( inPlug()->getChild<ValuePlug>( output->getName() ) );
 	}
+	else if( output == imagePlug->channelDataPlug() && imagePlug == outPlug() && passesThroughDataWindow() && tileOutsideDataWindow( inPlug(), context ) )
+	{
+		static_cast<FloatVectorDataPlug *>( output )->setValue( ImagePlug::blackTile() );
+	}
 	else
 	{
 		// normal operation - just let the base class take care of it.
 		ImageNode::compute( output, context );
 	}
 }
+
+bool ImageProcessor::passesThroughDataWindow() const
+{
+	return false;
+}
@@ -37,9 +37,16 @@
 
 #include "boost/tokenizer.hpp"
 
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+
 #include "OpenImageIO/imagecache.h"
 OIIO_NAMESPACE_USING
 
+#include "IECore/CompoundData.h"
+#include "IECore/SimpleTypedData.h"
+#include "IECore/BoxOps.h"
+
 #include "Gaffer/Context.h"
 
 #include "GafferImage/ImageReader.h"
@@ -83,6 +90,49 @@ static ImageCache *imageCache()
 	return cache;
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Prefetching. We load tiles with get_tile() and release them immediately,
+// which brings them into the cache without copying the pixels anywhere.
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+struct PrefetchRequest
+{
+	ustring fileName;
+	int x;
+	int y;
+};
+
+struct PrefetchTiles
+{
+	PrefetchTiles( const vector<PrefetchRequest> &requests )
+		:	m_requests( requests )
+	{
+	}
+	
+	void operator()( const blocked_range<size_t> &r ) const
+	{
+		ImageCache *cache = imageCache();
+		for( size_t i = r.begin(); i != r.end(); ++i )
+		{
+			const PrefetchRequest &request = m_requests[i];
+			ImageCache::Tile *tile = cache->get_tile( request.fileName, 0, 0, request.x, request.y, 0 );
+			if( tile )
+			{
+				cache->release_tile( tile );
+			}
+		}
+	}
+	
+	private :
+	
+		const vector<PrefetchRequest> &m_requests;
+};
+
+} // namespace
+
 //////////////////////////////////////////////////////////////////////////
 // ImageReader implementation
 //////////////////////////////////////////////////////////////////////////
@@ -102,6 +152,7 @@ ImageReader::ImageReader( const std::string &name )
 	{
 		(*it)->setFlags( Plug::Cacheable, false );
 	}
+	channelDataStoragePlug()->setFlags( Plug::Cacheable, false );
 }
 
 ImageReader::~ImageReader()
@@ -149,6 +200,133 @@ size_t ImageReader::supportedExtensions( std::vector<std::string> &extensions )
 	return extensions.size();
 }
 
+void ImageReader::prefetch( int startFrame, int endFrame, const Imath::Box2i &region ) const
+{
+	// Find the files for each frame.
+	vector<ustring> fileNames;
+	ContextPtr context = new Context( *Context::current() );
+	for( int frame = startFrame; frame <= endFrame; ++frame )
+	{
+		context->setFrame( frame );
+		Context::Scope scope( context.get() );
+		const ustring fileName( fileNamePlug()->getValue().c_str() );
+		if( find( fileNames.begin(), fileNames.end(), fileName ) == fileNames.end() )
+		{
+			fileNames.push_back( fileName );
+		}
+	}
+	
+	// Find the tiles within the region for each file.
+	vector<PrefetchRequest> requests;
+	for( vector<ustring>::const_iterator it = fileNames.begin(), eIt = fileNames.end(); it != eIt; ++it )
+	{
+		const ImageSpec *spec = imageCache()->imagespec( *it );
+		if( !spec )
+		{
+			continue;
+		}
+		
+		// OIIO's space is Y-down, so we must convert the region first.
+		Format format( Imath::Box2i( Imath::V2i( spec->full_x, spec->full_y ), Imath::V2i( spec->full_width + spec->full_x - 1, spec->full_height + spec->full_y - 1 ) ) );
+		Imath::Box2i bound( Imath::V2i( spec->x, spec->y ), Imath::V2i( spec->width + spec->x - 1, spec->height + spec->y - 1 ) );
+		if( !region.isEmpty() )
+		{
+			bound = boxIntersection( bound, format.formatToYDownSpace( region ) );
+		}
+		
+		const int tileWidth = spec->tile_width ? spec->tile_width : spec->width;
+		const int tileHeight = spec->tile_height ? spec->tile_height : spec->height;
+		
+		PrefetchRequest request;
+		request.fileName = *it;
+		for( int y = bound.min.y; y <= bound.max.y; y = ( ( y - spec->y ) / tileHeight + 1 ) * tileHeight + spec->y )
+		{
+			for( int x = bound.min.x; x <= bound.max.x; x = ( ( x - spec->x ) / tileWidth + 1 ) * tileWidth + spec->x )
+			{
+				request.x = x;
+				request.y = y;
+				requests.push_back( request );
+			}
+		}
+	}
+	
+	parallel_for( blocked_range<size_t>( 0, requests.size() ), PrefetchTiles( requests ) );
+}
+
+size_t ImageReader::getCacheMemoryLimit()
+{
+	float memoryMB = 0;
+	imageCache()->getattribute( "max_memory_MB", memoryMB );
+	return (size_t)( memoryMB * 1024 * 1024 );
+}
+
+void ImageReader::setCacheMemoryLimit( size_t bytes )
+{
+	imageCache()->attribute( "max_memory_MB", (float)bytes / ( 1024 * 1024 ) );
+}
+
+int ImageReader::getCacheFileHandleLimit()
+{
+	int result = 0;
+	imageCache()->getattribute( "max_open_files", result );
+	return result;
+}
+
+void ImageReader::setCacheFileHandleLimit( int fileHandles )
+{
+	imageCache()->attribute( "max_open_files", fileHandles );
+}
+
+int ImageReader::getCacheAutoTile()
+{
+	int result = 0;
+	imageCache()->getattribute( "autotile", result );
+	return result;
+}
+
+void ImageReader::setCacheAutoTile( int tileSize )
+{
+	imageCache()->attribute( "autotile", tileSize );
+}
+
+bool ImageReader::getCacheAutoMip()
+{
+	int result = 0;
+	imageCache()->getattribute( "automip", result );
+	return result;
+}
+
+void ImageReader::setCacheAutoMip( bool autoMip )
+{
+	imageCache()->attribute( "automip", (int)autoMip );
+}
+
+IECore::CompoundDataPtr ImageReader::cacheStatistics()
+{
+	ImageCache *cache = imageCache();
+	
+	long long findTileCalls = 0, cacheMisses = 0, bytesRead = 0, memoryUsage = 0;
+	int openFiles = 0, uniqueFiles = 0;
+	cache->getattribute( "stat:find_tile_calls", TypeDesc::INT64, &findTileCalls );
+	cache->getattribute( "stat:find_tile_cache_misses", TypeDesc::INT64, &cacheMisses );
+	cache->getattribute( "stat:bytes_read", TypeDesc::INT64, &bytesRead );
+	cache->getattribute( "stat:cache_memory_used", TypeDesc::INT64, &memoryUsage );
+	cache->getattribute( "stat:open_files_current", openFiles );
+	cache->getattribute( "stat:unique_files", uniqueFiles );
+	
+	CompoundDataPtr result = new CompoundData;
+	CompoundDataMap &m = result->writable();
+	m["tileRequests"] = new Int64Data( findTileCalls );
+	m["tileMisses"] = new Int64Data( cacheMisses );
+	m["hitRate"] = new FloatData( findTileCalls ? 1.0f - (float)cacheMisses / (float)findTileCalls : 0.0f );
+	m["bytesRead"] = new Int64Data( bytesRead );
+	m["memoryUsage"] = new Int64Data( memoryUsage );
+	m["openFiles"] = new IntData( openFiles );
+	m["uniqueFiles"] = new IntData( uniqueFiles );
+	
+	return result;
+}
+
 void ImageReader::affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const
 {
 	ImageNode::affects( input, outputs );
@@ -242,7 +420,13 @@ IECore::ConstFloatVectorDataPtr ImageReader::computeChannelData( const std::stri
 	Format format( Imath::Box2i( Imath::V2i( spec->full_x, spec->full_y ), Imath::V2i( spec->full_width + spec->full_x - 1, spec->full_height + spec->full_y - 1 ) ) );
 	const int newY = format.formatToYDownSpace( tileOrigin.y + ImagePlug::tileSize() - 1 );
 
-	std::vector<float> channelData( ImagePlug::tileSize() * ImagePlug::tileSize() );
+	// Read straight into the output tile, using a negative y stride to flip
+	// it in the Y axis as we go, converting it to our internal image data
+	// representation.
+	FloatVectorDataPtr resultData = ImagePlug::allocateTile();
+	vector<float> &result = resultData->writable();
+	const stride_t rowStride = ImagePlug::tileSize() * sizeof( float );
+	
 	size_t channelIndex = channelIt - spec->channelnames.begin();
 	imageCache()->get_pixels(
 		uFileName,
@@ -252,20 +436,10 @@ IECore::ConstFloatVectorDataPtr ImageReader::computeChannelData( const std::stri
 		0, 1,
 		channelIndex, channelIndex + 1,
 		TypeDesc::FLOAT,
-		&(channelData[0])
+		&(result[ ( ImagePlug::tileSize() - 1 ) * ImagePlug::tileSize() ]),
+		sizeof( float ), -rowStride, AutoStride
 	);
 
-	// Create the output data buffer.
-	FloatVectorDataPtr resultData = new FloatVectorData;
-	vector<float> &result = resultData->writable();	
-	result.resize( ImagePlug::tileSize() * ImagePlug::tileSize() );
-
-	// Flip the tile in the Y axis to convert it to our internal image data representation.
-	for( int y = 0; y < ImagePlug::tileSize(); ++y )
-	{
-		memcpy( &(result[ ( ImagePlug::tileSize() - y - 1 ) * ImagePlug::tileSize() ]), &(channelData[ y * ImagePlug::tileSize() ]), sizeof(float)*ImagePlug::tileSize()  );
-	}
-
 	return resultData;
 }
 
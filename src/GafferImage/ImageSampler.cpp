@@ -34,6 +34,12 @@
 //  
 //////////////////////////////////////////////////////////////////////////
 
+#include "tbb/parallel_for.h"
+
+#include "IECore/VectorTypedData.h"
+
+#include "Gaffer/Context.h"
+
 #include "GafferImage/ImageSampler.h"
 #include "GafferImage/ImagePlug.h"
 #include "GafferImage/FilterPlug.h"
@@ -45,6 +51,128 @@ using namespace IECore;
 using namespace Gaffer;
 using namespace GafferImage;
 
+//////////////////////////////////////////////////////////////////////////
+// Utilities for batched sampling
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+// A group of locations which lie within the same tile, and can
+// therefore share a Sampler.
+struct SampleGroup
+{
+	size_t begin;
+	size_t end;
+	Box2i sampleWindow;
+};
+
+struct TileLess
+{
+
+	TileLess( const vector<V2f> &pixels )
+		:	m_pixels( pixels )
+	{
+	}
+	
+	bool operator()( size_t a, size_t b ) const
+	{
+		const V2i ta = ImagePlug::tileOrigin( V2i( m_pixels[a] ) );
+		const V2i tb = ImagePlug::tileOrigin( V2i( m_pixels[b] ) );
+		return ta.y < tb.y || ( ta.y == tb.y && ta.x < tb.x );
+	}
+	
+	const vector<V2f> &m_pixels;
+
+};
+
+// Sorts the indices of the locations so that those within the same tile are
+// adjacent, and then returns a group for each tile. The sample window of each
+// group matches the union of the windows that would be used to sample the
+// locations individually.
+void groupByTile( const vector<V2f> &pixels, vector<size_t> &order, vector<SampleGroup> &groups )
+{
+	order.resize( pixels.size() );
+	for( size_t i = 0; i < order.size(); ++i )
+	{
+		order[i] = i;
+	}
+	
+	std::stable_sort( order.begin(), order.end(), TileLess( pixels ) );
+	
+	for( size_t i = 0; i < order.size(); ++i )
+	{
+		const V2i pixel( pixels[order[i]] );
+		if( !groups.size() || ImagePlug::tileOrigin( pixel ) != ImagePlug::tileOrigin( V2i( pixels[order[groups.back().begin]] ) ) )
+		{
+			SampleGroup group;
+			group.begin = i;
+			groups.push_back( group );
+		}
+		groups.back().end = i + 1;
+		groups.back().sampleWindow.extendBy( pixel - V2i( 1 ) );
+		groups.back().sampleWindow.extendBy( pixel + V2i( 1 ) );
+	}
+}
+
+// Body for tbb::parallel_for(), sampling a range of groups.
+class GroupSampler
+{
+
+	public :
+	
+		GroupSampler(
+			const ImagePlug *image, const vector<string> &channels, ConstFilterPtr filter,
+			const vector<V2f> &pixels, const vector<size_t> &order, const vector<SampleGroup> &groups,
+			const Context *context, vector<Color4f> &colors
+		)
+			:	m_image( image ), m_channels( channels ), m_filter( filter ),
+				m_pixels( pixels ), m_order( order ), m_groups( groups ),
+				m_context( context ), m_colors( colors )
+		{
+		}
+		
+		void operator()( const tbb::blocked_range<size_t> &range ) const
+		{
+			Context::Scope scopedContext( m_context );
+			for( size_t g = range.begin(); g != range.end(); ++g )
+			{
+				const SampleGroup &group = m_groups[g];
+				for( size_t c = 0; c < 4; ++c )
+				{
+					if( m_channels[c].empty() )
+					{
+						continue;
+					}
+					Sampler sampler( m_image, m_channels[c], group.sampleWindow, m_filter );
+					for( size_t i = group.begin; i < group.end; ++i )
+					{
+						const size_t index = m_order[i];
+						m_colors[index][c] = sampler.sample( m_pixels[index].x, m_pixels[index].y );
+					}
+				}
+			}
+		}
+		
+	private :
+	
+		const ImagePlug *m_image;
+		const vector<string> &m_channels;
+		ConstFilterPtr m_filter;
+		const vector<V2f> &m_pixels;
+		const vector<size_t> &m_order;
+		const vector<SampleGroup> &m_groups;
+		const Context *m_context;
+		vector<Color4f> &m_colors;
+
+};
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+// ImageSampler
+//////////////////////////////////////////////////////////////////////////
+
 IE_CORE_DEFINERUNTIMETYPED( ImageSampler );
 
 size_t ImageSampler::g_firstPlugIndex = 0;
@@ -59,6 +187,8 @@ ImageSampler::ImageSampler( const std::string &name )
 	addChild( new V2fPlug( "pixel" ) );
 	addChild( new FilterPlug( "filter" ) );
 	addChild( new Color4fPlug( "color", Plug::Out ) );
+	addChild( new V2fVectorDataPlug( "pixels", Plug::In, new V2fVectorData ) );
+	addChild( new Color4fVectorDataPlug( "colors", Plug::Out, new Color4fVectorData ) );
 	
 }
 
@@ -106,6 +236,26 @@ const Gaffer::Color4fPlug *ImageSampler::colorPlug() const
 	return getChild<Color4fPlug>( g_firstPlugIndex + 3 );
 }
 
+Gaffer::V2fVectorDataPlug *ImageSampler::pixelsPlug()
+{
+	return getChild<V2fVectorDataPlug>( g_firstPlugIndex + 4 );
+}
+
+const Gaffer::V2fVectorDataPlug *ImageSampler::pixelsPlug() const
+{
+	return getChild<V2fVectorDataPlug>( g_firstPlugIndex + 4 );
+}
+
+Gaffer::Color4fVectorDataPlug *ImageSampler::colorsPlug()
+{
+	return getChild<Color4fVectorDataPlug>( g_firstPlugIndex + 5 );
+}
+
+const Gaffer::Color4fVectorDataPlug *ImageSampler::colorsPlug() const
+{
+	return getChild<Color4fVectorDataPlug>( g_firstPlugIndex + 5 );
+}
+
 void ImageSampler::affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const
 {
 	ComputeNode::affects( input, outputs );
@@ -118,6 +268,11 @@ void ImageSampler::affects( const Gaffer::Plug *input, AffectedPlugsContainer &o
 			outputs.push_back( componentIt->get() );
 		}
 	}
+	
+	if( inputParent == imagePlug() || input == pixelsPlug() || input == filterPlug() )
+	{
+		outputs.push_back( colorsPlug() );
+	}
 }
 
 void ImageSampler::hash( const Gaffer::ValuePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
@@ -141,6 +296,10 @@ void ImageSampler::hash( const Gaffer::ValuePlug *output, const Gaffer::Context
 			h.append( filter );
 		}
 	}
+	else if( output == colorsPlug() )
+	{
+		hashColors( context, h );
+	}
 }
 
 void ImageSampler::compute( Gaffer::ValuePlug *output, const Gaffer::Context *context ) const
@@ -163,6 +322,11 @@ void ImageSampler::compute( Gaffer::ValuePlug *output, const Gaffer::Context *co
 		static_cast<FloatPlug *>( output )->setValue( sample );
 		return;
 	}
+	else if( output == colorsPlug() )
+	{
+		static_cast<Color4fVectorDataPlug *>( output )->setValue( computeColors( context ) );
+		return;
+	}
 	
 	ComputeNode::compute( output, context );	
 }
@@ -197,3 +361,59 @@ std::string ImageSampler::channelName( const Gaffer::ValuePlug *output ) const
 
 	return "";	
 }
+
+void ImageSampler::hashColors( const Gaffer::Context *context, IECore::MurmurHash &h ) const
+{
+	ConstV2fVectorDataPtr pixelsData = pixelsPlug()->getValue();
+	pixelsData->hash( h );
+	
+	const string filter = filterPlug()->getValue();
+	h.append( filter );
+	
+	vector<size_t> order;
+	vector<SampleGroup> groups;
+	groupByTile( pixelsData->readable(), order, groups );
+	
+	ConstFilterPtr f = Filter::create( filter );
+	for( int c = 0; c < 4; ++c )
+	{
+		const string channel = channelName( colorPlug()->getChild( c ) );
+		if( channel.empty() )
+		{
+			continue;
+		}
+		h.append( channel );
+		for( vector<SampleGroup>::const_iterator it = groups.begin(), eIt = groups.end(); it != eIt; ++it )
+		{
+			Sampler sampler( imagePlug(), channel, it->sampleWindow, f );
+			sampler.hash( h );
+		}
+	}
+}
+
+IECore::ConstColor4fVectorDataPtr ImageSampler::computeColors( const Gaffer::Context *context ) const
+{
+	ConstV2fVectorDataPtr pixelsData = pixelsPlug()->getValue();
+	const vector<V2f> &pixels = pixelsData->readable();
+	
+	Color4fVectorDataPtr result = new Color4fVectorData;
+	result->writable().resize( pixels.size(), Color4f( 0 ) );
+	
+	vector<string> channels;
+	for( int c = 0; c < 4; ++c )
+	{
+		channels.push_back( channelName( colorPlug()->getChild( c ) ) );
+	}
+	
+	vector<size_t> order;
+	vector<SampleGroup> groups;
+	groupByTile( pixels, order, groups );
+	
+	ConstFilterPtr filter = Filter::create( filterPlug()->getValue() );
+	tbb::parallel_for(
+		tbb::blocked_range<size_t>( 0, groups.size() ),
+		GroupSampler( imagePlug(), channels, filter, pixels, order, groups, context, result->writable() )
+	);
+	
+	return result;
+}
@@ -36,6 +36,14 @@
 
 #include "boost/bind.hpp"
 
+#include "tbb/parallel_for.h"
+#include "tbb/parallel_reduce.h"
+#include "tbb/blocked_range2d.h"
+
+#include "IECore/BoxOps.h"
+#include "IECore/CompoundObject.h"
+#include "IECore/VectorTypedData.h"
+
 #include "Gaffer/TypedPlug.h"
 #include "Gaffer/BoxPlug.h"
 #include "Gaffer/Context.h"
@@ -46,9 +54,295 @@
 #include "GafferImage/ChannelMaskPlug.h"
 #include "GafferImage/Format.h"
 
+using namespace std;
+using namespace Imath;
+using namespace IECore;
 using namespace GafferImage;
 using namespace Gaffer;
 
+//////////////////////////////////////////////////////////////////////////
+// Utilities for reducing over the tiles within the region of interest.
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+// Calls functor.span( values, x, y, n ) for each row of pixels where the
+// tile at tileOrigin intersects the region of interest, or functor.constant( value, region )
+// if the intersection has a single value. Pixels outside the data window are visited
+// as zero, as they would be by a Sampler in Black mode. Expects the channel name
+// and tile origin to have been set in the current context.
+template<typename Functor>
+void visitTile( const ImagePlug *image, const V2i &tileOrigin, const Box2i &regionOfInterest, const Box2i &dataWindow, Functor &functor )
+{
+	const int tileSize = ImagePlug::tileSize();
+	const Box2i region = boxIntersection( Box2i( tileOrigin, tileOrigin + V2i( tileSize - 1 ) ), regionOfInterest );
+	const Box2i validRegion = boxIntersection( region, dataWindow );
+	if( validRegion.isEmpty() )
+	{
+		functor.constant( 0.0f, region );
+		return;
+	}
+	
+	ConstFloatVectorDataPtr tileData = image->channelDataPlug()->getValue();
+	
+	float constantValue;
+	if( validRegion == region && ImagePlug::isConstantTile( tileData.get(), constantValue ) )
+	{
+		functor.constant( constantValue, region );
+		return;
+	}
+	
+	const float *tile = &(tileData->readable()[0]);
+	const int width = region.size().x + 1;
+	if( validRegion == region )
+	{
+		for( int y = region.min.y; y <= region.max.y; ++y )
+		{
+			functor.span( tile + ( y - tileOrigin.y ) * tileSize + ( region.min.x - tileOrigin.x ), region.min.x, y, width );
+		}
+		return;
+	}
+	
+	// The tile straddles the edge of the data window, so we pad
+	// each row with zeroes before visiting it.
+	vector<float> row( width );
+	for( int y = region.min.y; y <= region.max.y; ++y )
+	{
+		std::fill( row.begin(), row.end(), 0.0f );
+		if( y >= validRegion.min.y && y <= validRegion.max.y )
+		{
+			const float *tileRow = tile + ( y - tileOrigin.y ) * tileSize;
+			std::copy(
+				tileRow + ( validRegion.min.x - tileOrigin.x ),
+				tileRow + ( validRegion.max.x - tileOrigin.x ) + 1,
+				row.begin() + ( validRegion.min.x - region.min.x )
+			);
+		}
+		functor.span( &row[0], region.min.x, y, width );
+	}
+}
+
+// Visits all the tiles in a range of tile indices, using a
+// context derived from parentContext.
+template<typename Functor>
+void visitTiles( const tbb::blocked_range2d<int> &range, const ImagePlug *image, const Box2i &regionOfInterest, const Box2i &dataWindow, const Context *parentContext, Functor &functor )
+{
+	ContextPtr context = new Context( *parentContext, Context::Borrowed );
+	Context::Scope scopedContext( context.get() );
+	
+	const int tileSize = ImagePlug::tileSize();
+	for( int tileY = range.rows().begin(); tileY != range.rows().end(); ++tileY )
+	{
+		for( int tileX = range.cols().begin(); tileX != range.cols().end(); ++tileX )
+		{
+			const V2i tileOrigin( tileX * tileSize, tileY * tileSize );
+			context->set( ImagePlug::tileOriginContextName, tileOrigin );
+			visitTile( image, tileOrigin, regionOfInterest, dataWindow, functor );
+		}
+	}
+}
+
+tbb::blocked_range2d<int> tileRange( const Box2i &regionOfInterest )
+{
+	const V2i minTile = ImagePlug::tileOrigin( regionOfInterest.min ) / ImagePlug::tileSize();
+	const V2i maxTile = ImagePlug::tileOrigin( regionOfInterest.max ) / ImagePlug::tileSize();
+	return tbb::blocked_range2d<int>( minTile.y, maxTile.y + 1, 1, minTile.x, maxTile.x + 1, 1 );
+}
+
+// Returns true if position a comes before b, ordering
+// first by y and then by x.
+inline bool precedes( const V2i &a, const V2i &b )
+{
+	return a.y < b.y || ( a.y == b.y && a.x < b.x );
+}
+
+// Body for tbb::parallel_reduce(), accumulating the statistics
+// for a single channel.
+class StatisticsReducer
+{
+
+	public :
+	
+		StatisticsReducer( const ImagePlug *image, const Box2i &regionOfInterest, const Box2i &dataWindow, const Context *context, int histogramBins, const V2f &histogramRange )
+			:	m_image( image ), m_regionOfInterest( regionOfInterest ), m_dataWindow( dataWindow ), m_context( context ),
+				m_histogramOffset( histogramRange[0] ),
+				m_histogramScale( histogramRange[1] > histogramRange[0] ? histogramBins / ( histogramRange[1] - histogramRange[0] ) : 0.0f )
+		{
+			initialise( histogramBins );
+		}
+		
+		StatisticsReducer( StatisticsReducer &other, tbb::split )
+			:	m_image( other.m_image ), m_regionOfInterest( other.m_regionOfInterest ), m_dataWindow( other.m_dataWindow ), m_context( other.m_context ),
+				m_histogramOffset( other.m_histogramOffset ), m_histogramScale( other.m_histogramScale )
+		{
+			initialise( other.m_histogram.size() );
+		}
+		
+		void operator()( const tbb::blocked_range2d<int> &range )
+		{
+			visitTiles( range, m_image, m_regionOfInterest, m_dataWindow, m_context, *this );
+		}
+		
+		void join( const StatisticsReducer &other )
+		{
+			update( other.m_min, other.m_minPosition, other.m_max, other.m_maxPosition );
+			m_sum += other.m_sum;
+			for( size_t i = 0, e = m_histogram.size(); i < e; ++i )
+			{
+				m_histogram[i] += other.m_histogram[i];
+			}
+		}
+		
+		void span( const float *values, int x, int y, int n )
+		{
+			int minIndex = 0;
+			int maxIndex = 0;
+			double sum = 0.0;
+			for( int i = 0; i < n; ++i )
+			{
+				const float v = values[i];
+				if( v < values[minIndex] )
+				{
+					minIndex = i;
+				}
+				if( v > values[maxIndex] )
+				{
+					maxIndex = i;
+				}
+				sum += v;
+				++m_histogram[bin( v )];
+			}
+			
+			update( values[minIndex], V2i( x + minIndex, y ), values[maxIndex], V2i( x + maxIndex, y ) );
+			m_sum += sum;
+		}
+		
+		void constant( float value, const Box2i &region )
+		{
+			const V2i size = region.size() + V2i( 1 );
+			update( value, region.min, value, region.min );
+			m_sum += double( value ) * size.x * size.y;
+			m_histogram[bin( value )] += size.x * size.y;
+		}
+		
+		CompoundObjectPtr result() const
+		{
+			const V2i size = m_regionOfInterest.size() + V2i( 1 );
+			CompoundObjectPtr result = new CompoundObject;
+			result->members()["min"] = new FloatData( m_min );
+			result->members()["max"] = new FloatData( m_max );
+			result->members()["average"] = new FloatData( m_sum / ( double( size.x ) * double( size.y ) ) );
+			result->members()["minPosition"] = new V2iData( m_minPosition );
+			result->members()["maxPosition"] = new V2iData( m_maxPosition );
+			result->members()["histogram"] = new IntVectorData( m_histogram );
+			return result;
+		}
+		
+	private :
+	
+		void initialise( size_t histogramBins )
+		{
+			m_min = numeric_limits<float>::max();
+			m_max = -numeric_limits<float>::max();
+			m_minPosition = m_maxPosition = V2i( numeric_limits<int>::max() );
+			m_sum = 0.0;
+			m_histogram.resize( histogramBins, 0 );
+		}
+	
+		// Values outside the histogram range are counted in the end bins.
+		inline size_t bin( float value ) const
+		{
+			const float b = ( value - m_histogramOffset ) * m_histogramScale;
+			if( b >= m_histogram.size() )
+			{
+				return m_histogram.size() - 1;
+			}
+			return b > 0.0f ? size_t( b ) : 0;
+		}
+		
+		inline void update( float minValue, const V2i &minPosition, float maxValue, const V2i &maxPosition )
+		{
+			if( minValue < m_min || ( minValue == m_min && precedes( minPosition, m_minPosition ) ) )
+			{
+				m_min = minValue;
+				m_minPosition = minPosition;
+			}
+			if( maxValue > m_max || ( maxValue == m_max && precedes( maxPosition, m_maxPosition ) ) )
+			{
+				m_max = maxValue;
+				m_maxPosition = maxPosition;
+			}
+		}
+		
+		const ImagePlug *m_image;
+		const Box2i m_regionOfInterest;
+		const Box2i m_dataWindow;
+		const Context *m_context;
+		const float m_histogramOffset;
+		const float m_histogramScale;
+		
+		float m_min;
+		float m_max;
+		V2i m_minPosition;
+		V2i m_maxPosition;
+		double m_sum;
+		vector<int> m_histogram;
+
+};
+
+// Body for tbb::parallel_for(), gathering all the pixel values of
+// a single channel into a buffer, in the order of the region of interest.
+class ValueGatherer
+{
+
+	public :
+	
+		ValueGatherer( const ImagePlug *image, const Box2i &regionOfInterest, const Box2i &dataWindow, const Context *context, float *values )
+			:	m_image( image ), m_regionOfInterest( regionOfInterest ), m_dataWindow( dataWindow ), m_context( context ), m_values( values )
+		{
+		}
+		
+		void operator()( const tbb::blocked_range2d<int> &range ) const
+		{
+			visitTiles( range, m_image, m_regionOfInterest, m_dataWindow, m_context, *this );
+		}
+		
+		void span( const float *values, int x, int y, int n ) const
+		{
+			std::copy( values, values + n, destination( x, y ) );
+		}
+		
+		void constant( float value, const Box2i &region ) const
+		{
+			for( int y = region.min.y; y <= region.max.y; ++y )
+			{
+				float *d = destination( region.min.x, y );
+				std::fill( d, d + region.size().x + 1, value );
+			}
+		}
+	
+	private :
+	
+		float *destination( int x, int y ) const
+		{
+			return m_values + ( y - m_regionOfInterest.min.y ) * ( m_regionOfInterest.size().x + 1 ) + ( x - m_regionOfInterest.min.x );
+		}
+	
+		const ImagePlug *m_image;
+		const Box2i m_regionOfInterest;
+		const Box2i m_dataWindow;
+		const Context *m_context;
+		float *m_values;
+
+};
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+// ImageStats
+//////////////////////////////////////////////////////////////////////////
+
 IE_CORE_DEFINERUNTIMETYPED( ImageStats );
 
 size_t ImageStats::g_firstPlugIndex = 0;
@@ -70,6 +364,27 @@ ImageStats::ImageStats( const std::string &name )
 	addChild( new Color4fPlug( "average", Gaffer::Plug::Out ) );
 	addChild( new Color4fPlug( "min", Gaffer::Plug::Out ) );
 	addChild( new Color4fPlug( "max", Gaffer::Plug::Out ) );
+	addChild( new IntPlug( "histogramBins", Gaffer::Plug::In, 256, 1 ) );
+	addChild( new V2fPlug( "histogramRange", Gaffer::Plug::In, V2f( 0, 1 ) ) );
+	addChild( new FloatPlug( "percentile", Gaffer::Plug::In, 0.5f, 0.0f, 1.0f ) );
+	
+	const char *channelPlugNames[] = { "r", "g", "b", "a" };
+	CompoundPlugPtr minPosition = new CompoundPlug( "minPosition", Gaffer::Plug::Out );
+	CompoundPlugPtr maxPosition = new CompoundPlug( "maxPosition", Gaffer::Plug::Out );
+	CompoundPlugPtr histogram = new CompoundPlug( "histogram", Gaffer::Plug::Out );
+	for( int i = 0; i < 4; ++i )
+	{
+		minPosition->addChild( new V2iPlug( channelPlugNames[i], Gaffer::Plug::Out ) );
+		maxPosition->addChild( new V2iPlug( channelPlugNames[i], Gaffer::Plug::Out ) );
+		histogram->addChild( new IntVectorDataPlug( channelPlugNames[i], Gaffer::Plug::Out, new IntVectorData ) );
+	}
+	addChild( minPosition );
+	addChild( maxPosition );
+	addChild( histogram );
+	addChild( new Color4fPlug( "percentileValue", Gaffer::Plug::Out ) );
+	
+	addChild( new ObjectPlug( "__channelStatistics", Gaffer::Plug::Out, new CompoundObject ) );
+	
 	plugInputChangedSignal().connect( boost::bind( &ImageStats::inputChanged, this, ::_1 ) );
 }
 
@@ -137,6 +452,86 @@ const Color4fPlug *ImageStats::maxPlug() const
 	return getChild<Color4fPlug>( g_firstPlugIndex + 5 );
 }
 
+IntPlug *ImageStats::histogramBinsPlug()
+{
+	return getChild<IntPlug>( g_firstPlugIndex + 6 );
+}
+
+const IntPlug *ImageStats::histogramBinsPlug() const
+{
+	return getChild<IntPlug>( g_firstPlugIndex + 6 );
+}
+
+V2fPlug *ImageStats::histogramRangePlug()
+{
+	return getChild<V2fPlug>( g_firstPlugIndex + 7 );
+}
+
+const V2fPlug *ImageStats::histogramRangePlug() const
+{
+	return getChild<V2fPlug>( g_firstPlugIndex + 7 );
+}
+
+FloatPlug *ImageStats::percentilePlug()
+{
+	return getChild<FloatPlug>( g_firstPlugIndex + 8 );
+}
+
+const FloatPlug *ImageStats::percentilePlug() const
+{
+	return getChild<FloatPlug>( g_firstPlugIndex + 8 );
+}
+
+CompoundPlug *ImageStats::minPositionPlug()
+{
+	return getChild<CompoundPlug>( g_firstPlugIndex + 9 );
+}
+
+const CompoundPlug *ImageStats::minPositionPlug() const
+{
+	return getChild<CompoundPlug>( g_firstPlugIndex + 9 );
+}
+
+CompoundPlug *ImageStats::maxPositionPlug()
+{
+	return getChild<CompoundPlug>( g_firstPlugIndex + 10 );
+}
+
+const CompoundPlug *ImageStats::maxPositionPlug() const
+{
+	return getChild<CompoundPlug>( g_firstPlugIndex + 10 );
+}
+
+CompoundPlug *ImageStats::histogramPlug()
+{
+	return getChild<CompoundPlug>( g_firstPlugIndex + 11 );
+}
+
+const CompoundPlug *ImageStats::histogramPlug() const
+{
+	return getChild<CompoundPlug>( g_firstPlugIndex + 11 );
+}
+
+Color4fPlug *ImageStats::percentileValuePlug()
+{
+	return getChild<Color4fPlug>( g_firstPlugIndex + 12 );
+}
+
+const Color4fPlug *ImageStats::percentileValuePlug() const
+{
+	return getChild<Color4fPlug>( g_firstPlugIndex + 12 );
+}
+
+ObjectPlug *ImageStats::channelStatisticsPlug()
+{
+	return getChild<ObjectPlug>( g_firstPlugIndex + 13 );
+}
+
+const ObjectPlug *ImageStats::channelStatisticsPlug() const
+{
+	return getChild<ObjectPlug>( g_firstPlugIndex + 13 );
+}
+
 void ImageStats::inputChanged( Gaffer::Plug *plug )
 {
 	const Imath::Box2i regionOfInterest( regionOfInterestPlug()->getValue() );
@@ -173,19 +568,45 @@ void ImageStats::parentChanging( Gaffer::GraphComponent *newParent )
 void ImageStats::affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const
 {
 	ComputeNode::affects( input, outputs );
-	if (
-			input == channelsPlug() ||
-			input->parent<ImagePlug>() == inPlug() ||
-			regionOfInterestPlug()->isAncestorOf( input )
-	   ) 
+	
+	const bool affectsStatistics =
+		input->parent<ImagePlug>() == inPlug() ||
+		regionOfInterestPlug()->isAncestorOf( input ) ||
+		input == histogramBinsPlug() ||
+		histogramRangePlug()->isAncestorOf( input )
+	;
+	
+	if( affectsStatistics )
+	{
+		outputs.push_back( channelStatisticsPlug() );
+	}
+	
+	if( input == channelsPlug() || input == channelStatisticsPlug() )
 	{
 		for( unsigned int i = 0; i < 4; ++i )
 		{
 			outputs.push_back( minPlug()->getChild(i) );	
 			outputs.push_back( averagePlug()->getChild(i) );	
 			outputs.push_back( maxPlug()->getChild(i) );	
+			outputs.push_back( minPositionPlug()->getChild<V2iPlug>( i )->getChild( 0 ) );
+			outputs.push_back( minPositionPlug()->getChild<V2iPlug>( i )->getChild( 1 ) );
+			outputs.push_back( maxPositionPlug()->getChild<V2iPlug>( i )->getChild( 0 ) );
+			outputs.push_back( maxPositionPlug()->getChild<V2iPlug>( i )->getChild( 1 ) );
+			outputs.push_back( histogramPlug()->getChild<ValuePlug>( i ) );
+		}
+	}
+	
+	if(
+		input == channelsPlug() ||
+		input == percentilePlug() ||
+		input->parent<ImagePlug>() == inPlug() ||
+		regionOfInterestPlug()->isAncestorOf( input )
+	)
+	{
+		for( unsigned int i = 0; i < 4; ++i )
+		{
+			outputs.push_back( percentileValuePlug()->getChild(i) );
 		}
-		return;
 	}
 }
 
@@ -193,20 +614,14 @@ void ImageStats::hash( const ValuePlug *output, const Context *context, IECore::
 {
 	ComputeNode::hash( output, context, h);
 	
-	bool earlyOut = true;
-	for( int i = 0; i < 4; ++i )
+	if( output == channelStatisticsPlug() )
 	{
-		if (
-				output == minPlug()->getChild(i) ||
-				output == maxPlug()->getChild(i) ||
-				output == averagePlug()->getChild(i)
-		   )
-		{
-			earlyOut = false;
-			break;
-		}
+		hashChannelStatistics( context, h );
+		return;
 	}
-	if( earlyOut )
+	
+	const int channelIndex = outputChannelIndex( output );
+	if( channelIndex < 0 )
 	{
 		return;
 	}
@@ -216,33 +631,32 @@ void ImageStats::hash( const ValuePlug *output, const Context *context, IECore::
 	inPlug()->channelNamesPlug()->hash( h );
 	inPlug()->dataWindowPlug()->hash( h );
 
-	IECore::ConstStringVectorDataPtr channelNamesData = inPlug()->channelNamesPlug()->getValue();
-	std::vector<std::string> maskChannels = channelNamesData->readable();
-	channelsPlug()->maskChannels( maskChannels );
-	const int nChannels( maskChannels.size() );
-	
-	if ( nChannels > 0 )
-	{
-		std::vector<std::string> uniqueChannels = maskChannels;
-		GafferImage::ChannelMaskPlug::removeDuplicateIndices( uniqueChannels );
-		std::string channel;
-		channelNameFromOutput( output, channel );
+	std::string channel;
+	channelNameFromOutput( output, channel );
 
-		if ( !channel.empty() )
+	if ( !channel.empty() )
+	{
+		h.append( channel );	
+		
+		ContextPtr tmpContext = new Context( *context, Context::Borrowed );
+		tmpContext->set( ImagePlug::channelNameContextName, channel );
+		Context::Scope scopedContext( tmpContext.get() );
+		
+		if( output == percentileValuePlug()->getChild( channelIndex ) )
 		{
-			h.append( channel );	
+			percentilePlug()->hash( h );
 			Sampler s( inPlug(), channel, regionOfInterest );
 			s.hash( h );
-			return;
 		}
+		else
+		{
+			channelStatisticsPlug()->hash( h );
+		}
+		return;
 	}
 
 	// If our node is not enabled then we just append the default value that we will give the plug.
-	if(
-			output == maxPlug()->getChild(3) ||
-			output == minPlug()->getChild(3) ||
-			output == averagePlug()->getChild(3)
-	  )
+	if( channelIndex == 3 )
 	{
 		h.append( 0 );
 	}
@@ -252,8 +666,40 @@ void ImageStats::hash( const ValuePlug *output, const Context *context, IECore::
 	}
 }
 
+int ImageStats::outputChannelIndex( const ValuePlug *output ) const
+{
+	const ValuePlug *parent = output->parent<ValuePlug>();
+	if( !parent )
+	{
+		return -1;
+	}
+	
+	for( int channelIndex = 0; channelIndex < 4; ++channelIndex )
+	{
+		if ( output == minPlug()->getChild( channelIndex ) ||
+			 output == maxPlug()->getChild( channelIndex ) ||
+			 output == averagePlug()->getChild( channelIndex ) ||
+			 output == percentileValuePlug()->getChild( channelIndex ) ||
+			 output == histogramPlug()->getChild<ValuePlug>( channelIndex ) ||
+			 parent == minPositionPlug()->getChild<ValuePlug>( channelIndex ) ||
+			 parent == maxPositionPlug()->getChild<ValuePlug>( channelIndex )
+		   )
+		{
+			return channelIndex;
+		}
+	}
+	
+	return -1;
+}
+
 void ImageStats::channelNameFromOutput( const ValuePlug *output, std::string &channelName ) const
 {
+	const int channelIndex = outputChannelIndex( output );
+	if( channelIndex < 0 )
+	{
+		return;
+	}
+	
 	IECore::ConstStringVectorDataPtr channelNamesData = inPlug()->channelNamesPlug()->getValue();
 	std::vector<std::string> maskChannels = channelNamesData->readable();
 	channelsPlug()->maskChannels( maskChannels );
@@ -264,48 +710,57 @@ void ImageStats::channelNameFromOutput( const ValuePlug *output, std::string &ch
 	std::vector<std::string> uniqueChannels = maskChannels;
 	GafferImage::ChannelMaskPlug::removeDuplicateIndices( uniqueChannels );
 		
-	for( int channelIndex = 0; channelIndex < 4; ++channelIndex )
+	for( std::vector<std::string>::iterator it( uniqueChannels.begin() ); it != uniqueChannels.end(); ++it )
 	{
-		if ( output == minPlug()->getChild( channelIndex ) ||
-			 output == maxPlug()->getChild( channelIndex ) ||
-			 output == averagePlug()->getChild( channelIndex )
-		   )
+		if ( GafferImage::ChannelMaskPlug::channelIndex( *it ) == channelIndex )
 		{
-			for( std::vector<std::string>::iterator it( uniqueChannels.begin() ); it != uniqueChannels.end(); ++it )
-			{
-				if ( GafferImage::ChannelMaskPlug::channelIndex( *it ) == channelIndex )
-				{
-					channelName = *it;
-					return;
-				}
-			}
+			channelName = *it;
+			return;
 		}
 	}
-	return;
 }
 
-void ImageStats::setOutputToDefault( FloatPlug *output ) const
+void ImageStats::setOutputToDefault( ValuePlug *output ) const
 {
+	const ValuePlug *parent = output->parent<ValuePlug>();
 	if (
 			output == minPlug()->getChild(3) ||
 			output == maxPlug()->getChild(3) ||
-			output == averagePlug()->getChild(3)
+			output == averagePlug()->getChild(3) ||
+			output == percentileValuePlug()->getChild(3)
 	   )
 	{
-		output->setValue( 1. );
+		static_cast<FloatPlug *>( output )->setValue( 1. );
+	}
+	else if( parent == minPlug() || parent == maxPlug() || parent == averagePlug() || parent == percentileValuePlug() )
+	{
+		static_cast<FloatPlug *>( output )->setValue( 0. );
 	}
 	else
 	{
-		output->setValue( 0. );
+		output->setToDefault();
 	}
 }
 
 void ImageStats::compute( ValuePlug *output, const Context *context ) const
 {
-	const Imath::Box2i &regionOfInterest( regionOfInterestPlug()->getValue() );
+	if( output == channelStatisticsPlug() )
+	{
+		static_cast<ObjectPlug *>( output )->setValue( computeChannelStatistics( regionOfInterestPlug()->getValue() ) );
+		return;
+	}
+	
+	const int channelIndex = outputChannelIndex( output );
+	if( channelIndex < 0 )
+	{
+		ComputeNode::compute( output, context );
+		return;
+	}
+
+	const Imath::Box2i regionOfInterest( regionOfInterestPlug()->getValue() );
 	if( regionOfInterest.isEmpty() )
 	{
-		setOutputToDefault( static_cast<FloatPlug*>( output ) );
+		setOutputToDefault( output );
 		return;
 	}
 	
@@ -313,52 +768,95 @@ void ImageStats::compute( ValuePlug *output, const Context *context ) const
 	channelNameFromOutput( output, channelName );
 	if ( channelName.empty() )
 	{
-		setOutputToDefault( static_cast<FloatPlug*>( output ) );
+		setOutputToDefault( output );
 		return;
 	}
 
-	int channelIndex = GafferImage::ChannelMaskPlug::channelIndex( channelName );
-
 	// Set up the execution context.
 	ContextPtr tmpContext = new Context( *context, Context::Borrowed );
 	tmpContext->set( ImagePlug::channelNameContextName, channelName );
 	Context::Scope scopedContext( tmpContext.get() );
 
-	// Loop over the ROI and compute the min, max and average channel values and then set our outputs.
-	Sampler s( inPlug(), channelName, regionOfInterest );	
-
-	float min = std::numeric_limits<float>::max();
-	float max = std::numeric_limits<float>::min();
-	float average = 0.f;
-
-	double sum = 0.;
-	for( int y = regionOfInterest.min.y; y <= regionOfInterest.max.y; ++y )
+	if( output == percentileValuePlug()->getChild( channelIndex ) )
 	{
-		for( int x = regionOfInterest.min.x; x <= regionOfInterest.max.x; ++x )
-		{
-			float v = s.sample( x, y );
-			min = std::min( v, min );
-			max = std::max( v, max );
-			sum += v;
-		}
+		static_cast<FloatPlug *>( output )->setValue( computePercentile( regionOfInterest ) );
+		return;
 	}
-	average = sum / double( (regionOfInterest.size().x+1) * (regionOfInterest.size().y+1) );
-
+	
+	ConstCompoundObjectPtr statistics = boost::static_pointer_cast<const CompoundObject>( channelStatisticsPlug()->getValue() );
+	
 	if ( minPlug()->getChild( channelIndex ) == output )
 	{
-		static_cast<FloatPlug *>( output )->setValue( min );
+		static_cast<FloatPlug *>( output )->setValue( statistics->member<FloatData>( "min" )->readable() );
 	}
 	else if ( maxPlug()->getChild( channelIndex ) == output )
 	{
-		static_cast<FloatPlug *>( output )->setValue( max );
+		static_cast<FloatPlug *>( output )->setValue( statistics->member<FloatData>( "max" )->readable() );
 	}
 	else if ( averagePlug()->getChild( channelIndex ) == output )
 	{
-		static_cast<FloatPlug *>( output )->setValue( average );
+		static_cast<FloatPlug *>( output )->setValue( statistics->member<FloatData>( "average" )->readable() );
+	}
+	else if( histogramPlug()->getChild<ValuePlug>( channelIndex ) == output )
+	{
+		static_cast<IntVectorDataPlug *>( output )->setValue( statistics->member<IntVectorData>( "histogram" ) );
 	}
 	else
 	{
-		static_cast<FloatPlug *>( output )->setValue( 0 );
+		const V2iPlug *positionPlug = output->parent<V2iPlug>();
+		const V2i position = positionPlug->parent<CompoundPlug>() == minPositionPlug() ?
+			statistics->member<V2iData>( "minPosition" )->readable() :
+			statistics->member<V2iData>( "maxPosition" )->readable();
+		static_cast<IntPlug *>( output )->setValue( output == positionPlug->getChild( 0 ) ? position.x : position.y );
 	}
 }
 
+void ImageStats::hashChannelStatistics( const Gaffer::Context *context, IECore::MurmurHash &h ) const
+{
+	const std::string &channelName = context->get<std::string>( ImagePlug::channelNameContextName );
+	const Imath::Box2i regionOfInterest( regionOfInterestPlug()->getValue() );
+	
+	h.append( channelName );
+	regionOfInterestPlug()->hash( h );
+	inPlug()->dataWindowPlug()->hash( h );
+	histogramBinsPlug()->hash( h );
+	histogramRangePlug()->hash( h );
+	
+	Sampler s( inPlug(), channelName, regionOfInterest );
+	s.hash( h );
+}
+
+IECore::ConstObjectPtr ImageStats::computeChannelStatistics( const Imath::Box2i &regionOfInterest ) const
+{
+	if( regionOfInterest.isEmpty() )
+	{
+		return channelStatisticsPlug()->defaultValue();
+	}
+	
+	// Reduce over the tiles in parallel, working directly
+	// on the tile data.
+	StatisticsReducer reducer(
+		inPlug(), regionOfInterest, inPlug()->dataWindowPlug()->getValue(), Context::current(),
+		histogramBinsPlug()->getValue(), histogramRangePlug()->getValue()
+	);
+	tbb::parallel_reduce( tileRange( regionOfInterest ), reducer );
+	
+	return reducer.result();
+}
+
+float ImageStats::computePercentile( const Imath::Box2i &regionOfInterest ) const
+{
+	const V2i size = regionOfInterest.size() + V2i( 1 );
+	vector<float> values( size_t( size.x ) * size_t( size.y ) );
+	
+	tbb::parallel_for(
+		tileRange( regionOfInterest ),
+		ValueGatherer( inPlug(), regionOfInterest, inPlug()->dataWindowPlug()->getValue(), Context::current(), &values[0] )
+	);
+	
+	const float percentile = std::max( 0.0f, std::min( 1.0f, percentilePlug()->getValue() ) );
+	vector<float>::iterator nth = values.begin() + size_t( double( percentile ) * ( values.size() - 1 ) + 0.5 );
+	std::nth_element( values.begin(), nth, values.end() );
+	
+	return *nth;
+}
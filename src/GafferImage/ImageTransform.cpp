@@ -35,13 +35,13 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include "IECore/AngleConversion.h"
+#include "IECore/FastFloat.h"
 
 #include "Gaffer/Context.h"
 
 #include "GafferImage/ImageTransform.h"
-#include "GafferImage/Reformat.h"
 #include "GafferImage/Filter.h"
-#include "GafferImage/FormatPlug.h"
+#include "GafferImage/FilterPlug.h"
 #include "GafferImage/ImagePlug.h"
 #include "GafferImage/Sampler.h"
 
@@ -49,141 +49,178 @@ using namespace Gaffer;
 using namespace IECore;
 using namespace GafferImage;
 
-IE_CORE_DEFINERUNTIMETYPED( ImageTransform );
-
 //////////////////////////////////////////////////////////////////////////
-// Implementation of ImageTransform::Implementation
+// Utilities
 //////////////////////////////////////////////////////////////////////////
 
-namespace GafferImage
+namespace
 {
 
-namespace Detail
+// Returns an axis-aligned box that contains box*m.
+Imath::Box2i transformBox( const Imath::M33d &m, const Imath::Box2i &box )
 {
+	Imath::V2d pt[4];
+	pt[0] = Imath::V2d( box.min.x, box.min.y );
+	pt[1] = Imath::V2d( box.max.x+1, box.max.y+1 );
+	pt[2] = Imath::V2d( box.max.x+1, box.min.y );
+	pt[3] = Imath::V2d( box.min.x, box.max.y+1 );
+
+	int maxX = std::numeric_limits<int>::min();
+	int maxY = std::numeric_limits<int>::min();
+	int minX = std::numeric_limits<int>::max();
+	int minY = std::numeric_limits<int>::max();
 
-class Implementation : public ImageProcessor
+	for( unsigned int i = 0; i < 4; ++i )
+	{
+		pt[i] = pt[i] * m;
+		maxX = std::max( int( ceil( pt[i].x ) ), maxX );
+		maxY = std::max( int( ceil( pt[i].y ) ), maxY );
+		minX = std::min( int( floor( pt[i].x ) ), minX );
+		minY = std::min( int( floor( pt[i].y ) ), minY );
+	}
+
+	return Imath::Box2i( Imath::V2i( minX, minY ), Imath::V2i( maxX-1, maxY-1 ) );
+}
+
+// Returns true if m has no rotation, so that the output pixels
+// sample the input on a regular grid.
+bool axisAligned( const Imath::M33d &m )
+{
+	return m[0][1] == 0. && m[1][0] == 0.;
+}
+
+// Returns true if m is a translation by a whole number of pixels, setting
+// offset to the translation.
+bool integerTranslation( const Imath::M33d &m, Imath::V2i &offset )
 {
-	public :
-
-		Implementation( const std::string &name=staticTypeName() );
-
-		virtual ~Implementation(){};
-		
-		IE_CORE_DECLARERUNTIMETYPEDEXTENSION( Implementation, ImageTransformImplementationTypeId, ImageProcessor );
-	
-		virtual void hashFormat( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
-		virtual void hashDataWindow( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
-		virtual void hashChannelNames( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
-		virtual void hashChannelData( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const;
-		
-		virtual GafferImage::Format computeFormat( const Gaffer::Context *context, const ImagePlug *parent ) const;
-		virtual Imath::Box2i computeDataWindow( const Gaffer::Context *context, const ImagePlug *parent ) const;
-		virtual IECore::ConstStringVectorDataPtr computeChannelNames( const Gaffer::Context *context, const ImagePlug *parent ) const;
-		virtual IECore::ConstFloatVectorDataPtr computeChannelData( const std::string &channelName, const Imath::V2i &tileOrigin, const Gaffer::Context *context, const ImagePlug *parent ) const;
-
-		/// Plug accessors.	
-		Gaffer::Transform2DPlug *transformPlug();
-		const Gaffer::Transform2DPlug *transformPlug() const;
-		GafferImage::FilterPlug *filterPlug();
-		const GafferImage::FilterPlug *filterPlug() const;
-		GafferImage::FormatPlug *outputFormatPlug();
-		const GafferImage::FormatPlug *outputFormatPlug() const;	
-		
-		virtual void affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const;
-		virtual bool enabled() const;
-
-	private :
-				
-		static size_t g_firstPlugIndex;
-
-		// A useful method that returns an axis-aligned box that contains box*m.		
-		Imath::Box2i transformBox( const Imath::M33f &m, const Imath::Box2i &box ) const;
-
-		// A method that uses the input and output format along with the transform plug to create
-		// the transform matrix that will compensate for the reformat node having resized the input.
-		Imath::M33f computeAdjustedMatrix() const;
-};
-
-size_t Implementation::g_firstPlugIndex = 0;
-
-Implementation::Implementation( const std::string &name )
+	if( m[0][0] != 1. || m[0][1] != 0. || m[1][0] != 0. || m[1][1] != 1. )
+	{
+		return false;
+	}
+
+	offset = Imath::V2i( IECore::fastFloatRound( m[2][0] ), IECore::fastFloatRound( m[2][1] ) );
+	return fabs( m[2][0] - offset.x ) < 1e-6 && fabs( m[2][1] - offset.y ) < 1e-6;
+}
+
+// Returns true if offset is a whole number of tiles, so that output tiles
+// map exactly onto input tiles.
+bool tileAligned( const Imath::V2i &offset )
+{
+	return offset.x % ImagePlug::tileSize() == 0 && offset.y % ImagePlug::tileSize() == 0;
+}
+
+// Returns the factor by which m scales each axis.
+Imath::V2d axisScale( const Imath::M33d &m )
+{
+	return Imath::V2d(
+		Imath::V2d( m[0][0], m[0][1] ).length(),
+		Imath::V2d( m[1][0], m[1][1] ).length()
+	);
+}
+
+// Creates the filter used to sample the input, scaled to cover the footprint of
+// an output pixel when m shrinks the image, so that we don't alias.
+FilterPtr createFilter( const std::string &name, const Imath::M33d &m )
+{
+	const Imath::V2d scale = axisScale( m );
+	const double minScale = std::min( scale.x, scale.y );
+	return Filter::create( name, minScale > 0. ? 1. / minScale : 1. );
+}
+
+// Returns the area of the input sampled to compute the output tile at tileOrigin.
+Imath::Box2i sampleWindow( const Imath::M33d &inverse, const Imath::V2i &tileOrigin )
+{
+	return transformBox( inverse, Imath::Box2i( tileOrigin, tileOrigin + Imath::V2i( ImagePlug::tileSize() - 1 ) ) );
+}
+
+// Returns the area of the input copied to compute the output tile at
+// tileOrigin, when translating by offset.
+Imath::Box2i copyWindow( const Imath::V2i &offset, const Imath::V2i &tileOrigin )
+{
+	return Imath::Box2i( tileOrigin - offset, tileOrigin - offset + Imath::V2i( ImagePlug::tileSize() - 1 ) );
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+// ImageTransform
+//////////////////////////////////////////////////////////////////////////
+
+IE_CORE_DEFINERUNTIMETYPED( ImageTransform );
+
+size_t ImageTransform::g_firstPlugIndex = 0;
+
+ImageTransform::ImageTransform( const std::string &name )
 	:	ImageProcessor( name )
 {
 	storeIndexOfNextChild( g_firstPlugIndex );
-	
 	addChild( new Gaffer::Transform2DPlug( "transform" ) );
-	addChild( new GafferImage::FilterPlug( "filter" ) );
-	addChild( new GafferImage::FormatPlug( "outputFormat" ) );
+	addChild( new FilterPlug( "filter" ) );
 }
 
-Gaffer::Transform2DPlug *Implementation::transformPlug()
+ImageTransform::~ImageTransform()
 {
-	return getChild<Gaffer::Transform2DPlug>( g_firstPlugIndex );
 }
 
-const Gaffer::Transform2DPlug *Implementation::transformPlug() const
+Gaffer::Transform2DPlug *ImageTransform::transformPlug()
 {
 	return getChild<Gaffer::Transform2DPlug>( g_firstPlugIndex );
 }
 
-GafferImage::FilterPlug *Implementation::filterPlug()
-{
-	return getChild<GafferImage::FilterPlug>( g_firstPlugIndex+1 );
-}
-
-const GafferImage::FilterPlug *Implementation::filterPlug() const
+const Gaffer::Transform2DPlug *ImageTransform::transformPlug() const
 {
-	return getChild<GafferImage::FilterPlug>( g_firstPlugIndex+1 );
+	return getChild<Gaffer::Transform2DPlug>( g_firstPlugIndex );
 }
 
-GafferImage::FormatPlug *Implementation::outputFormatPlug()
+GafferImage::FilterPlug *ImageTransform::filterPlug()
 {
-	return getChild<GafferImage::FormatPlug>( g_firstPlugIndex + 2 );
+	return getChild<GafferImage::FilterPlug>( g_firstPlugIndex + 1 );
 }
 
-const GafferImage::FormatPlug *Implementation::outputFormatPlug() const
+const GafferImage::FilterPlug *ImageTransform::filterPlug() const
 {
-	return getChild<GafferImage::FormatPlug>( g_firstPlugIndex + 2 );
+	return getChild<GafferImage::FilterPlug>( g_firstPlugIndex + 1 );
 }
 
-void Implementation::affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const
+void ImageTransform::affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const
 {
 	ImageProcessor::affects( input, outputs );
 
-	if( input == inPlug()->formatPlug()	)
+	if( input == inPlug()->formatPlug() )
 	{
-		outputs.push_back( outPlug()->channelDataPlug() );
+		outputs.push_back( outPlug()->formatPlug() );
 	}
 	else if( input == inPlug()->dataWindowPlug() )
 	{
-		outputs.push_back( outPlug()->dataWindowPlug() );	
+		outputs.push_back( outPlug()->dataWindowPlug() );
+		outputs.push_back( outPlug()->channelDataPlug() );
 	}
 	else if( input == inPlug()->channelNamesPlug() )
 	{
 		outputs.push_back( outPlug()->channelNamesPlug() );
 	}
-	else if ( input == outputFormatPlug() )
+	else if( input == inPlug()->channelDataPlug() )
 	{
-		outputs.push_back( outPlug()->formatPlug() );
+		outputs.push_back( outPlug()->channelDataPlug() );
 	}
-	else if ( transformPlug()->isAncestorOf( input ) )
+	else if( transformPlug()->isAncestorOf( input ) )
 	{
 		outputs.push_back( outPlug()->dataWindowPlug() );
 		outputs.push_back( outPlug()->channelDataPlug() );
 	}
-	else if ( input == filterPlug() )
+	else if( input == filterPlug() )
 	{
 		outputs.push_back( outPlug()->channelDataPlug() );
 	}
 }
 
-bool Implementation::enabled() const
+bool ImageTransform::enabled() const
 {
 	if ( !ImageProcessor::enabled() )
 	{
 		return false;
 	}
-	
+
 	// Disable the node if it isn't doing anything...
 	Imath::V2f scale = transformPlug()->scalePlug()->getValue();
 	Imath::V2f translate = transformPlug()->translatePlug()->getValue();
@@ -200,320 +237,177 @@ bool Implementation::enabled() const
 	return true;
 }
 
-void Implementation::hashFormat( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
+Imath::M33d ImageTransform::matrix() const
 {
-	h = outputFormatPlug()->hash();
-}
+	const Imath::V2d pivot( transformPlug()->pivotPlug()->getValue() );
 
-void Implementation::hashDataWindow( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
-{
-	ImageProcessor::hashDataWindow( output, context, h );
-	inPlug()->dataWindowPlug()->hash( h );
-	transformPlug()->hash( h );
-}
+	// Move the image so that the pivot is at the origin.
+	Imath::M33d pi;
+	pi.translate( -pivot );
 
-void Implementation::hashChannelNames( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
-{
-	h = inPlug()->channelNamesPlug()->hash();
-}
+	// Scale and rotate about the pivot.
+	Imath::M33d s;
+	s.scale( Imath::V2d( transformPlug()->scalePlug()->getValue() ) );
 
-void Implementation::hashChannelData( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
-{
-	ImageProcessor::hashChannelData( output, context, h );
+	Imath::M33d r;
+	r.rotate( -IECore::degreesToRadians( double( transformPlug()->rotatePlug()->getValue() ) ) );
 
-	// Hash all of the tiles that the sample requires for this tile.	
-	Imath::V2i tileOrigin( Context::current()->get<Imath::V2i>( ImagePlug::tileOriginContextName ) );
-	std::string channelName( Context::current()->get<std::string>( ImagePlug::channelNameContextName ) );
-	Imath::M33f sampleTransform( computeAdjustedMatrix().inverse() );
-	Imath::Box2i tile( transformBox( sampleTransform, Imath::Box2i( tileOrigin, tileOrigin + Imath::V2i( ImagePlug::tileSize() ) ) ) );
-	
-	GafferImage::FilterPtr filter = GafferImage::Filter::create( filterPlug()->getValue() );
-	Sampler sampler( inPlug(), channelName, tile, filter );
-	sampler.hash( h );
-	
-	// Hash in the origin of the output tile. Multiple output tiles may share the exact same set of input
-	// tiles, but will reference different parts of them depending on the tile origin.
-	h.append( tileOrigin );
+	// Translate, and move the pivot back.
+	Imath::M33d t;
+	t.translate( Imath::V2d( transformPlug()->translatePlug()->getValue() ) );
 
-	// Hash the filter type that we are using.	
-	filterPlug()->hash( h );
-	
-	// Finally we hash the transformation.
-	transformPlug()->hash( h );
-}
+	Imath::M33d p;
+	p.translate( pivot );
 
-Imath::Box2i Implementation::computeDataWindow( const Gaffer::Context *context, const ImagePlug *parent ) const
-{
-	Format inFormat( inPlug()->formatPlug()->getValue() );
-	Imath::Box2i inWindow( inPlug()->dataWindowPlug()->getValue() );
-	Imath::M33f t = computeAdjustedMatrix();
-	Imath::Box2i outWindow( transformBox( t, inWindow ) );
-	return outWindow;
+	return pi * s * r * t * p;
 }
 
-Imath::M33f Implementation::computeAdjustedMatrix() const
+void ImageTransform::hashFormat( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {
-	Format inFormat = inPlug()->formatPlug()->getValue();
-	Format outFormat = outputFormatPlug()->getValue();
-
-	// The desired scale factor.
-	Imath::V2f scale = transformPlug()->scalePlug()->getValue();
-
-	// The actual scale factor that the reformat node has resized the input to.
-	Imath::V2f trueScale = Imath::V2f(
-		float( inFormat.getDisplayWindow().size().x+1 ) / ( outFormat.getDisplayWindow().size().x+1 ),
-		float( inFormat.getDisplayWindow().size().y+1 ) / ( outFormat.getDisplayWindow().size().y+1 )
-	);
-
-	// To transform the image correctly we need to first move the image to the pivot point.
-	Imath::M33f pi;
-	Imath::V2f invPivotVec = -transformPlug()->pivotPlug()->getValue();
-	invPivotVec *= trueScale;
-	pi.translate( invPivotVec );
-
-	// As the input was only scaled to the nearest integer bounding box by the reformat node we need to 
-	// do a slight scale adjustment to achieve any sub-pixel scale factor.
-	Imath::V2f scaleOffset = scale / trueScale;
-	Imath::M33f s;
-	s.scale( scaleOffset );
-
-	// The rotation component.	
-	Imath::M33f r;
-	r.rotate( -IECore::degreesToRadians( transformPlug()->rotatePlug()->getValue() ) );
-	
-	// The translation component.
-	Imath::M33f t;
-	t.translate( transformPlug()->translatePlug()->getValue() );
-
-	// Here we invert the pivot vector and translate the image back.
-	Imath::M33f p;
-	p.translate( transformPlug()->pivotPlug()->getValue() );
-
-	// Concatenate the transforms.
-	Imath::M33f result = pi * s * r * t * p;
-
-	return result;
+	h = inPlug()->formatPlug()->hash();
 }
 
-Imath::Box2i Implementation::transformBox( const Imath::M33f &m, const Imath::Box2i &box ) const
+void ImageTransform::hashDataWindow( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {
-	Imath::V3f pt[4];
-	pt[0] = Imath::V3f( box.min.x, box.min.y, 1. );
-	pt[1] = Imath::V3f( box.max.x+1, box.max.y+1, 1. );
-	pt[2] = Imath::V3f( box.max.x+1, box.min.y, 1. );
-	pt[3] = Imath::V3f( box.min.x, box.max.y+1, 1. );
-
-	int maxX = std::numeric_limits<int>::min();
-	int maxY = std::numeric_limits<int>::min();
-	int minX = std::numeric_limits<int>::max();
-	int minY = std::numeric_limits<int>::max();
-	
-	for( unsigned int i = 0; i < 4; ++i )
-	{
-		pt[i] = pt[i] * m;
-		maxX = std::max( int( ceil( pt[i].x ) ), maxX );
-		maxY = std::max( int( ceil( pt[i].y ) ), maxY );
-		minX = std::min( int( floor( pt[i].x ) ), minX );
-		minY = std::min( int( floor( pt[i].y ) ), minY );
-	}
-	
-	return Imath::Box2i( Imath::V2i( minX, minY ), Imath::V2i( maxX-1, maxY-1 ) );	
-}
-
-GafferImage::Format Implementation::computeFormat( const Gaffer::Context *context, const ImagePlug *parent ) const
-{
-	return outputFormatPlug()->getValue();
+	ImageProcessor::hashDataWindow( output, context, h );
+	inPlug()->dataWindowPlug()->hash( h );
+	transformPlug()->hash( h );
 }
 
-IECore::ConstStringVectorDataPtr Implementation::computeChannelNames( const Gaffer::Context *context, const ImagePlug *parent ) const
+void ImageTransform::hashChannelNames( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {
-	return inPlug()->channelNamesPlug()->getValue();
+	h = inPlug()->channelNamesPlug()->hash();
 }
 
-IECore::ConstFloatVectorDataPtr Implementation::computeChannelData( const std::string &channelName, const Imath::V2i &tileOrigin, const Gaffer::Context *context, const ImagePlug *parent ) const
+void ImageTransform::hashChannelData( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {
-	// Allocate the new tile
-	FloatVectorDataPtr outDataPtr = new FloatVectorData;
-	std::vector<float> &out = outDataPtr->writable();
-	out.resize( ImagePlug::tileSize() * ImagePlug::tileSize() );
+	const Imath::V2i tileOrigin = context->get<Imath::V2i>( ImagePlug::tileOriginContextName );
+	const std::string &channelName = context->get<std::string>( ImagePlug::channelNameContextName );
+	const Imath::M33d m = matrix();
 
-	// Work out the bounds of the tile that we are outputting to.
-	Imath::Box2i tile( tileOrigin, Imath::V2i( tileOrigin.x + ImagePlug::tileSize() - 1, tileOrigin.y + ImagePlug::tileSize() - 1 ) );
-
-	// Work out the sample area that we require to compute this tile.
-
-	Imath::M33f t = computeAdjustedMatrix().inverse();
-	Imath::Box2i inWindow( inPlug()->dataWindowPlug()->getValue() );
-	Imath::Box2i sampleBox( transformBox( t, tile ) );
-	
-	GafferImage::FilterPtr filter = GafferImage::Filter::create( filterPlug()->getValue() );
-	Sampler sampler( inPlug(), channelName, sampleBox, filter );
-	for ( int j = 0; j < ImagePlug::tileSize(); ++j )
+	Imath::V2i offset;
+	const bool translation = integerTranslation( m, offset );
+	if( translation && tileAligned( offset ) )
 	{
-		for ( int i = 0; i < ImagePlug::tileSize(); ++i )
-		{
-			Imath::V3f p( i+tile.min.x+.5, j+tile.min.y+.5, 1. );
-			p *= t;
-			out[ i + j*ImagePlug::tileSize() ] = sampler.sample( p.x, p.y );
-		}
+		// We'll be passing through an input tile unchanged.
+		h = inPlug()->channelDataHash( channelName, tileOrigin - offset );
+		return;
 	}
 
-	return outDataPtr;
-}
-
-}; // namespace Detail
-
-}; // namespace GafferImage
-
-//////////////////////////////////////////////////////////////////////////
-// Implementation of ImageTransform
-//////////////////////////////////////////////////////////////////////////
-
-size_t ImageTransform::g_firstPlugIndex = 0;
-
-ImageTransform::ImageTransform( const std::string &name )
-	:	ImageProcessor( name )
-{
-	storeIndexOfNextChild( g_firstPlugIndex );
-	
-	addChild( new Gaffer::Transform2DPlug( "transform" ) );
-	
-	FilterPlug *filterPlug = new FilterPlug( "filter" );
-	addChild( filterPlug );
-	
-	addChild( new GafferImage::FormatPlug( "__scaledFormat", Gaffer::Plug::Out ) );
-
-	// Create the internal implementation of our transform and connect it up the our plugs.
-	GafferImage::Reformat *r = new GafferImage::Reformat( std::string( boost::str( boost::format( "__%sReformat" )  % name  ) ) );
-	r->inPlug()->setInput( inPlug() );
-	r->filterPlug()->setInput( filterPlug );
-	r->formatPlug()->setInput( formatPlug() );
-	r->enabledPlug()->setInput( enabledPlug() );
-	addChild( r );
-
-	GafferImage::Detail::Implementation *t = new GafferImage::Detail::Implementation( std::string( boost::str( boost::format( "__%sImplementation" )  % name  ) ) );
-	t->inPlug()->setInput( r->outPlug() );
-	t->transformPlug()->pivotPlug()->setInput( transformPlug()->pivotPlug() );
-	t->transformPlug()->scalePlug()->setInput( transformPlug()->scalePlug() );
-	t->transformPlug()->rotatePlug()->setInput( transformPlug()->rotatePlug() );
-	t->transformPlug()->translatePlug()->setInput( transformPlug()->translatePlug() );
-	t->outputFormatPlug()->setInput( inPlug()->formatPlug() );
-	t->filterPlug()->setInput( filterPlug );
-	t->enabledPlug()->setInput( enabledPlug() );
-	addChild( t );
-	
-	outPlug()->setInput( t->outPlug() );
-}
+	ImageProcessor::hashChannelData( output, context, h );
 
-bool ImageTransform::enabled() const
-{
-	if ( !ImageProcessor::enabled() )
+	// Hash all of the tiles that the sample requires for this tile.
+	if( translation )
 	{
-		return false;
+		Sampler sampler( inPlug(), channelName, copyWindow( offset, tileOrigin ) );
+		sampler.hash( h );
 	}
-
-	// Disable the node if it isn't doing anything...
-	Imath::V2f scale = transformPlug()->scalePlug()->getValue();
-	Imath::V2f translate = transformPlug()->translatePlug()->getValue();
-	float rotate = transformPlug()->rotatePlug()->getValue();
-	if (
-		rotate == 0 &&
-		scale.x == 1 && scale.y == 1 &&
-		translate.x == 0 && translate.y == 0
-		)
+	else
 	{
-		return false;
+		Sampler sampler( inPlug(), channelName, sampleWindow( m.inverse(), tileOrigin ), createFilter( filterPlug()->getValue(), m ) );
+		sampler.hash( h );
+		filterPlug()->hash( h );
 	}
 
-	return true;
-}
+	// Hash in the origin of the output tile. Multiple output tiles may share the exact same set of input
+	// tiles, but will reference different parts of them depending on the tile origin.
+	h.append( tileOrigin );
 
-Gaffer::Transform2DPlug *ImageTransform::transformPlug()
-{
-	return getChild<Gaffer::Transform2DPlug>( g_firstPlugIndex );
+	inPlug()->dataWindowPlug()->hash( h );
+	transformPlug()->hash( h );
 }
 
-const Gaffer::Transform2DPlug *ImageTransform::transformPlug() const
+GafferImage::Format ImageTransform::computeFormat( const Gaffer::Context *context, const ImagePlug *parent ) const
 {
-	return getChild<Gaffer::Transform2DPlug>( g_firstPlugIndex );
+	return inPlug()->formatPlug()->getValue();
 }
 
-GafferImage::FormatPlug *ImageTransform::formatPlug()
+Imath::Box2i ImageTransform::computeDataWindow( const Gaffer::Context *context, const ImagePlug *parent ) const
 {
-	return getChild<GafferImage::FormatPlug>( g_firstPlugIndex + 2 );
+	return transformBox( matrix(), inPlug()->dataWindowPlug()->getValue() );
 }
 
-const GafferImage::FormatPlug *ImageTransform::formatPlug() const
+IECore::ConstStringVectorDataPtr ImageTransform::computeChannelNames( const Gaffer::Context *context, const ImagePlug *parent ) const
 {
-	return getChild<GafferImage::FormatPlug>( g_firstPlugIndex + 2 );
+	return inPlug()->channelNamesPlug()->getValue();
 }
 
-void ImageTransform::compute( ValuePlug *output, const Context *context ) const
+IECore::ConstFloatVectorDataPtr ImageTransform::computeChannelData( const std::string &channelName, const Imath::V2i &tileOrigin, const Gaffer::Context *context, const ImagePlug *parent ) const
 {
-	if( output == formatPlug() )
+	const Imath::M33d m = matrix();
+
+	// Translations by a whole number of pixels don't need any filtering. If the
+	// offset is also a whole number of tiles then we can just return an input tile,
+	// and otherwise we copy spans of pixels from the input.
+	Imath::V2i offset;
+	if( integerTranslation( m, offset ) )
 	{
-		Imath::V2f scale = transformPlug()->scalePlug()->getValue();
-		GafferImage::Format f = inPlug()->formatPlug()->getValue();
+		if( tileAligned( offset ) )
+		{
+			return inPlug()->channelData( channelName, tileOrigin - offset );
+		}
 
-		Imath::Box2i newDisplayWindow(
-			Imath::V2i( IECore::fastFloatFloor( f.getDisplayWindow().min.x * scale.x ), IECore::fastFloatFloor( f.getDisplayWindow().min.y * scale.y ) ),
-			Imath::V2i( IECore::fastFloatCeil( f.getDisplayWindow().max.x * scale.x ), IECore::fastFloatCeil( f.getDisplayWindow().max.y * scale.y ) )
-		);
+		FloatVectorDataPtr outDataPtr = ImagePlug::allocateTile();
+		std::vector<float> &out = outDataPtr->writable();
 
-		static_cast<FormatPlug *>( output )->setValue( GafferImage::Format( newDisplayWindow, 1.f ) );
-		return;
+		const Imath::Box2i window = copyWindow( offset, tileOrigin );
+		Sampler sampler( inPlug(), channelName, window );
+		sampler.sampleRegion( window, &out[0] );
+		return outDataPtr;
 	}
 
-	ImageProcessor::compute( output, context );
-}
+	// Otherwise we resample the input once, using a filter scaled to the footprint
+	// of the output pixels.
+	FloatVectorDataPtr outDataPtr = ImagePlug::allocateTile();
+	std::vector<float> &out = outDataPtr->writable();
 
-void ImageTransform::affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const
-{
-	ImageProcessor::affects( input, outputs );
-	
-	if( transformPlug()->scalePlug()->isAncestorOf( input ) ||
-		input == inPlug()->formatPlug()
-	)
-	{
-		outputs.push_back( formatPlug() );
-	}
-}
+	const Imath::M33d inverse = m.inverse();
+	FilterPtr filter = createFilter( filterPlug()->getValue(), m );
+	Sampler sampler( inPlug(), channelName, sampleWindow( inverse, tileOrigin ), filter );
 
-void ImageTransform::hash( const ValuePlug *output, const Context *context, IECore::MurmurHash &h ) const
-{
-	ImageProcessor::hash( output, context, h );
-	
-	const FormatPlug *fPlug = IECore::runTimeCast<const FormatPlug>(output);
-	if( fPlug == formatPlug() )
+	if( axisAligned( m ) )
 	{
-		h = inPlug()->formatPlug()->hash();
-		transformPlug()->scalePlug()->hash( h );
-		return;
-	}
-}
+		// The sample positions lie on a regular grid, so we can precompute the filter
+		// weights for each column and row, scaling the filter separately for each
+		// axis, and let the sampler convolve the tile separably.
+		const Imath::V2d scale = axisScale( m );
+		std::vector<float> centers( ImagePlug::tileSize() );
+		Filter::Weights xWeights, yWeights;
+
+		for( int i = 0; i < ImagePlug::tileSize(); ++i )
+		{
+			centers[i] = ( tileOrigin.x + i + .5 ) * inverse[0][0] + inverse[2][0];
+		}
+		filter->setScale( 1. / scale.x );
+		filter->computeWeights( centers, xWeights );
 
-ImageTransform::~ImageTransform()
-{
-}
+		for( int i = 0; i < ImagePlug::tileSize(); ++i )
+		{
+			centers[i] = ( tileOrigin.y + i + .5 ) * inverse[1][1] + inverse[2][1];
+		}
+		filter->setScale( 1. / scale.y );
+		filter->computeWeights( centers, yWeights );
 
-GafferImage::Format ImageTransform::computeFormat( const Gaffer::Context *context, const ImagePlug *parent ) const
-{
-	return inPlug()->formatPlug()->getValue();
-}
+		sampler.sampleGrid( xWeights, yWeights, &out[0] );
+		return outDataPtr;
+	}
 
-Imath::Box2i ImageTransform::computeDataWindow( const Gaffer::Context *context, const ImagePlug *parent ) const
-{
-	return inPlug()->dataWindowPlug()->getValue();
-}
+	// In the general case we filter each output pixel individually, stepping
+	// through the sample positions incrementally rather than transforming
+	// every pixel by the matrix.
+	const Imath::V2d dx( inverse[0][0], inverse[0][1] );
+	const Imath::V2d dy( inverse[1][0], inverse[1][1] );
+	Imath::V2d rowStart = Imath::V2d( tileOrigin.x + .5, tileOrigin.y + .5 ) * inverse;
 
-IECore::ConstStringVectorDataPtr ImageTransform::computeChannelNames( const Gaffer::Context *context, const ImagePlug *parent ) const
-{
-	return inPlug()->channelNamesPlug()->getValue();
-}
+	std::vector<float>::iterator outIt = out.begin();
+	for( int y = 0; y < ImagePlug::tileSize(); ++y, rowStart += dy )
+	{
+		Imath::V2d p = rowStart;
+		for( int x = 0; x < ImagePlug::tileSize(); ++x, p += dx )
+		{
+			*outIt++ = sampler.sample( float( p.x ), float( p.y ) );
+		}
+	}
 
-IECore::ConstFloatVectorDataPtr ImageTransform::computeChannelData( const std::string &channelName, const Imath::V2i &tileOrigin, const Gaffer::Context *context, const ImagePlug *parent ) const
-{
-	IECore::FloatVectorDataPtr outData = inPlug()->channelData( channelName, tileOrigin )->copy();
-	return outData;
+	return outDataPtr;
 }
-
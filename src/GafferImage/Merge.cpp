@@ -40,19 +40,33 @@
 using namespace IECore;
 using namespace Gaffer;
 
-// Create a set of functions to perform the different operations.
-typedef float (*Op)( float A, float B, float a, float b );
-float opAdd( float A, float B, float a, float b){ return A + B; }
-float opAtop( float A, float B, float a, float b){ return A*b + B*(1.-a); }
-float opDivide( float A, float B, float a, float b){ return A / B; }
-float opIn( float A, float B, float a, float b){ return A*b; }
-float opOut( float A, float B, float a, float b){ return A*(1.-b); }
-float opMask( float A, float B, float a, float b){ return B*a; }
-float opMatte( float A, float B, float a, float b){ return A*a + B*(1.-a); }
-float opMultiply( float A, float B, float a, float b){ return A * B; }
-float opOver( float A, float B, float a, float b){ return A + B*(1.-a); }
-float opSubtract( float A, float B, float a, float b){ return A - B; }
-float opUnder( float A, float B, float a, float b){ return A*(1.-b) + B; }
+// Create a set of functors to perform the different operations. These are
+// templated so that they can operate on both float and SIMDFloat values.
+namespace
+{
+
+#define GAFFERIMAGE_MERGE_OP( NAME, EXPRESSION ) \
+	struct NAME \
+	{ \
+		template<typename T> \
+		T operator()( const T &A, const T &B, const T &a, const T &b ) const { return EXPRESSION; } \
+	};
+
+GAFFERIMAGE_MERGE_OP( OpAdd, A + B )
+GAFFERIMAGE_MERGE_OP( OpAtop, A*b + B*( T( 1 ) - a ) )
+GAFFERIMAGE_MERGE_OP( OpDivide, A / B )
+GAFFERIMAGE_MERGE_OP( OpIn, A*b )
+GAFFERIMAGE_MERGE_OP( OpOut, A*( T( 1 ) - b ) )
+GAFFERIMAGE_MERGE_OP( OpMask, B*a )
+GAFFERIMAGE_MERGE_OP( OpMatte, A*a + B*( T( 1 ) - a ) )
+GAFFERIMAGE_MERGE_OP( OpMultiply, A * B )
+GAFFERIMAGE_MERGE_OP( OpOver, A + B*( T( 1 ) - a ) )
+GAFFERIMAGE_MERGE_OP( OpSubtract, A - B )
+GAFFERIMAGE_MERGE_OP( OpUnder, A*( T( 1 ) - b ) + B )
+
+#undef GAFFERIMAGE_MERGE_OP
+
+} // namespace
 
 namespace GafferImage
 {
@@ -102,9 +116,48 @@ bool Merge::enabled() const
 	return ( m_inputs.nConnectedInputs() >= 2 );
 }
 
+bool Merge::halfStorageEnabled( const std::string &channel ) const
+{
+	// Merges typically sit at the bottom of a comp, accumulating many
+	// layers, so we don't want to quantise the result of all that work.
+	return false;
+}
+
 void Merge::hashChannelData( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {
-	FilterProcessor::hashChannelData( output, context, h );
+	// We bypass FilterProcessor::hashChannelData() because we want to skip
+	// the inputs which don't contribute to the tile, and because we depend on
+	// the alpha channel of each input as well as the channel being merged.
+	ImageProcessor::hashChannelData( output, context, h );
+	
+	const std::string &channelName = context->get<std::string>( ImagePlug::channelNameContextName );
+	const Imath::V2i tileOrigin = context->get<Imath::V2i>( ImagePlug::tileOriginContextName );
+	const Imath::Box2i tileBound( tileOrigin, tileOrigin + Imath::V2i( ImagePlug::tileSize() - 1 ) );
+	
+	const ImagePlugList::const_iterator end( m_inputs.endIterator() );
+	for( ImagePlugList::const_iterator it( m_inputs.inputs().begin() ); it != end; it++ )
+	{
+		if( !(*it)->getInput<ValuePlug>() )
+		{
+			continue;
+		}
+		
+		if( tileBound.intersects( (*it)->dataWindowPlug()->getValue() ) )
+		{
+			h.append( (*it)->channelDataHash( channelName, tileOrigin ) );
+			if( channelName != "A" )
+			{
+				h.append( (*it)->channelDataHash( "A", tileOrigin ) );
+			}
+		}
+		else
+		{
+			// The input contributes only black, which we represent
+			// by a single token rather than hashing its channel data.
+			h.append( 0 );
+		}
+	}
+	
 	operationPlug()->hash( h );
 }
 
@@ -113,36 +166,49 @@ IECore::ConstFloatVectorDataPtr Merge::computeChannelData( const std::string &ch
 	std::vector< ConstFloatVectorDataPtr > inData;
 	std::vector< ConstFloatVectorDataPtr > inAlpha;
 	
+	const bool mergingAlpha = channelName == "A";
+	const Imath::Box2i tileBound( tileOrigin, tileOrigin + Imath::V2i( ImagePlug::tileSize() - 1 ) );
 	const ImagePlugList::const_iterator end( m_inputs.endIterator() );
 	for( ImagePlugList::const_iterator it( m_inputs.inputs().begin() ); it != end; it++ )
 	{
 		if ( (*it)->getInput<ValuePlug>() )
 		{
+			if( !tileBound.intersects( (*it)->dataWindowPlug()->getValue() ) )
+			{
+				// The tile lies outside the data window of this input, so it
+				// is black with zero alpha and there's no need to compute it.
+				inData.push_back( ImagePlug::blackTile() );
+				inAlpha.push_back( ImagePlug::blackTile() );
+				continue;
+			}
+			
 			inData.push_back( (*it)->channelData( channelName, tileOrigin ) );
-			inAlpha.push_back( (*it)->channelData( "A", tileOrigin ) );
+			// When merging the alpha channel itself, the data and alpha
+			// are one and the same - we don't want to fetch them twice.
+			inAlpha.push_back( mergingAlpha ? inData.back() : (*it)->channelData( "A", tileOrigin ) );
 		}
 	}
 
-	// Get a pointer to the operation that we wish to perform.
+	// Perform the operation that we wish to perform.
 	int operation = operationPlug()->getValue();
 	switch( operation )
 	{
 		default:
-		case( kAdd ): return doMergeOperation( opAdd, inData, inAlpha, tileOrigin ); break;
-		case( kAtop ): return doMergeOperation( opAtop, inData, inAlpha, tileOrigin ); break;
-		case( kDivide ): return doMergeOperation( opDivide, inData, inAlpha, tileOrigin ); break;
-		case( kIn ): return doMergeOperation( opIn, inData, inAlpha, tileOrigin ); break;
-		case( kOut ): return doMergeOperation( opOut, inData, inAlpha, tileOrigin ); break;
-		case( kMask ): return doMergeOperation( opMask, inData, inAlpha, tileOrigin ); break;
-		case( kMatte ): return doMergeOperation( opMatte, inData, inAlpha, tileOrigin ); break;
-		case( kMultiply ): return doMergeOperation( opMultiply, inData, inAlpha, tileOrigin ); break;
-		case( kOver ): return doMergeOperation( opOver, inData, inAlpha, tileOrigin ); break;
-		case( kSubtract ): return doMergeOperation( opSubtract, inData, inAlpha, tileOrigin ); break;
-		case( kUnder ): return doMergeOperation( opUnder, inData, inAlpha, tileOrigin ); break;
+		case( kAdd ): return doMergeOperation( OpAdd(), inData, inAlpha ); break;
+		case( kAtop ): return doMergeOperation( OpAtop(), inData, inAlpha ); break;
+		case( kDivide ): return doMergeOperation( OpDivide(), inData, inAlpha ); break;
+		case( kIn ): return doMergeOperation( OpIn(), inData, inAlpha ); break;
+		case( kOut ): return doMergeOperation( OpOut(), inData, inAlpha ); break;
+		case( kMask ): return doMergeOperation( OpMask(), inData, inAlpha ); break;
+		case( kMatte ): return doMergeOperation( OpMatte(), inData, inAlpha ); break;
+		case( kMultiply ): return doMergeOperation( OpMultiply(), inData, inAlpha ); break;
+		case( kOver ): return doMergeOperation( OpOver(), inData, inAlpha ); break;
+		case( kSubtract ): return doMergeOperation( OpSubtract(), inData, inAlpha ); break;
+		case( kUnder ): return doMergeOperation( OpUnder(), inData, inAlpha ); break;
 	}
 
 	// We should never get here...
-	return doMergeOperation( opAdd, inData, inAlpha, tileOrigin );
+	return doMergeOperation( OpAdd(), inData, inAlpha );
 }
 
 bool Merge::hasAlpha( ConstStringVectorDataPtr channelNamesData ) const
@@ -40,9 +40,12 @@
 
 #include "OpenColorIO/OpenColorIO.h"
 
+#include "IECore/LRUCache.h"
+
 #include "Gaffer/Context.h"
 
 #include "GafferImage/OpenColorIO.h"
+#include "GafferImage/SIMDFloat.h"
 
 using namespace std;
 using namespace IECore;
@@ -71,6 +74,244 @@ typedef tbb::null_mutex OCIOMutex;
 
 static OCIOMutex g_ocioMutex;
 
+namespace
+{
+
+// Maps x into the range [ 0, lutSize - 1 ] using the allocation of the input
+// colour space, either uniformly or logarithmically.
+template<bool logAllocation, typename T>
+inline T shape( const T &x, const T &offset, const T &minimum, const T &scale, const T &lutMax )
+{
+	T v = x;
+	if( logAllocation )
+	{
+		// 1.4426950408889634 is 1 / ln( 2 ), giving us log2( x + offset ).
+		v = fastLog( max( x + offset, T( 1e-10f ) ) ) * T( 1.4426950408889634f );
+	}
+	return min( lutMax, max( T( 0.0f ), ( v - minimum ) * scale ) );
+}
+
+template<bool logAllocation>
+void shapeChannel( const float *in, float *out, size_t size, float offset, float minimum, float scale, float lutMax )
+{
+	size_t i = 0;
+	const SIMDFloat offsetV( offset ), minimumV( minimum ), scaleV( scale ), lutMaxV( lutMax );
+	for( ; i + SIMDFloat::width <= size; i += SIMDFloat::width )
+	{
+		store( shape<logAllocation>( load<SIMDFloat>( in + i ), offsetV, minimumV, scaleV, lutMaxV ), out + i );
+	}
+	for( ; i < size; ++i )
+	{
+		out[i] = shape<logAllocation>( in[i], offset, minimum, scale, lutMax );
+	}
+}
+
+inline float lerp( float a, float b, float t )
+{
+	return a + ( b - a ) * t;
+}
+
+} // namespace
+
+// A transform between two colour spaces. This wraps an OpenColorIO processor,
+// which may optionally be baked into a 3D LUT indexed through a 1D shaper
+// derived from the allocation of the input space. The LUT is an approximation,
+// but is much quicker to evaluate than a complex chain of OpenColorIO operations.
+class ColorTransform : public IECore::RefCounted
+{
+
+	public :
+
+		ColorTransform( const std::string &inputSpace, const std::string &outputSpace, bool bakeLUT )
+			:	m_logAllocation( false ), m_offset( 0.0f ), m_minimum( 0.0f ), m_maximum( 1.0f )
+		{
+			::OpenColorIO::ConstConfigRcPtr config = ::OpenColorIO::GetCurrentConfig();
+			{
+				OCIOMutex::scoped_lock lock( g_ocioMutex );
+				m_processor = config->getProcessor( inputSpace.c_str(), outputSpace.c_str() );
+			}
+
+			::OpenColorIO::ConstColorSpaceRcPtr colorSpace = config->getColorSpace( inputSpace.c_str() );
+			if( bakeLUT && colorSpace && !m_processor->isNoOp() )
+			{
+				bake( colorSpace );
+			}
+		}
+
+		bool isNoOp() const
+		{
+			return m_processor->isNoOp();
+		}
+
+		void apply( float *r, float *g, float *b, size_t size ) const
+		{
+			if( m_lut.empty() )
+			{
+				::OpenColorIO::PlanarImageDesc image( r, g, b, 0, size, 1 );
+				m_processor->apply( image );
+				return;
+			}
+
+			// Find the LUT coordinates for each pixel, and then interpolate.
+			std::vector<float> coordinates( size * 3 );
+			float *cr = &coordinates[0];
+			float *cg = cr + size;
+			float *cb = cg + size;
+			shape( r, cr, size );
+			shape( g, cg, size );
+			shape( b, cb, size );
+
+			const int dx = 3;
+			const int dy = 3 * g_lutSize;
+			const int dz = 3 * g_lutSize * g_lutSize;
+			for( size_t i = 0; i < size; ++i )
+			{
+				const int x0 = std::min( int( cr[i] ), g_lutSize - 2 );
+				const int y0 = std::min( int( cg[i] ), g_lutSize - 2 );
+				const int z0 = std::min( int( cb[i] ), g_lutSize - 2 );
+				const float fx = cr[i] - x0;
+				const float fy = cg[i] - y0;
+				const float fz = cb[i] - z0;
+
+				const float *c = &m_lut[x0 * dx + y0 * dy + z0 * dz];
+				float result[3];
+				for( int k = 0; k < 3; ++k )
+				{
+					const float c00 = lerp( c[k], c[dx+k], fx );
+					const float c10 = lerp( c[dy+k], c[dy+dx+k], fx );
+					const float c01 = lerp( c[dz+k], c[dz+dx+k], fx );
+					const float c11 = lerp( c[dz+dy+k], c[dz+dy+dx+k], fx );
+					result[k] = lerp( lerp( c00, c10, fy ), lerp( c01, c11, fy ), fz );
+				}
+
+				r[i] = result[0];
+				g[i] = result[1];
+				b[i] = result[2];
+			}
+		}
+
+	private :
+
+		void bake( ::OpenColorIO::ConstColorSpaceRcPtr colorSpace )
+		{
+			m_logAllocation = colorSpace->getAllocation() == ::OpenColorIO::ALLOCATION_LG2;
+
+			float vars[3] = { 0.0f, 1.0f, 0.0f };
+			if( m_logAllocation )
+			{
+				// A generous default range for scene linear data, in stops.
+				vars[0] = -15.0f;
+				vars[1] = 6.0f;
+			}
+
+			const int numVars = colorSpace->getAllocationNumVars();
+			if( numVars >= 2 && numVars <= 3 )
+			{
+				colorSpace->getAllocationVars( vars );
+			}
+
+			m_minimum = vars[0];
+			m_maximum = vars[1];
+			m_offset = vars[2];
+			if( m_maximum <= m_minimum )
+			{
+				return;
+			}
+
+			// Find the input value for each node of the LUT, by inverting the shaper,
+			// and then run them all through the processor in one go.
+			std::vector<float> nodes( g_lutSize );
+			for( int i = 0; i < g_lutSize; ++i )
+			{
+				const float v = m_minimum + ( m_maximum - m_minimum ) * i / ( g_lutSize - 1 );
+				nodes[i] = m_logAllocation ? powf( 2.0f, v ) - m_offset : v;
+			}
+
+			m_lut.resize( g_lutSize * g_lutSize * g_lutSize * 3 );
+			std::vector<float>::iterator it = m_lut.begin();
+			for( int z = 0; z < g_lutSize; ++z )
+			{
+				for( int y = 0; y < g_lutSize; ++y )
+				{
+					for( int x = 0; x < g_lutSize; ++x )
+					{
+						*it++ = nodes[x];
+						*it++ = nodes[y];
+						*it++ = nodes[z];
+					}
+				}
+			}
+
+			::OpenColorIO::PackedImageDesc image( &m_lut[0], g_lutSize * g_lutSize * g_lutSize, 1, 3 );
+			m_processor->apply( image );
+		}
+
+		void shape( const float *in, float *out, size_t size ) const
+		{
+			const float scale = ( g_lutSize - 1 ) / ( m_maximum - m_minimum );
+			if( m_logAllocation )
+			{
+				shapeChannel<true>( in, out, size, m_offset, m_minimum, scale, g_lutSize - 1 );
+			}
+			else
+			{
+				shapeChannel<false>( in, out, size, m_offset, m_minimum, scale, g_lutSize - 1 );
+			}
+		}
+
+		static const int g_lutSize = 64;
+
+		::OpenColorIO::ConstProcessorRcPtr m_processor;
+
+		bool m_logAllocation;
+		float m_offset;
+		float m_minimum;
+		float m_maximum;
+		std::vector<float> m_lut;
+
+};
+
+IE_CORE_DECLAREPTR( ColorTransform )
+
+// Getting a processor from OpenColorIO is expensive, and may be serialised by
+// g_ocioMutex, so we cache them rather than getting one for every tile. The key
+// is formed from the cache id of the config, the input and output spaces and
+// whether or not to bake a LUT, separated by newlines.
+ConstColorTransformPtr colorTransformGetter( const std::string &key, size_t &cost )
+{
+	const size_t inputStart = key.find( '\n' ) + 1;
+	const size_t outputStart = key.find( '\n', inputStart ) + 1;
+	const size_t bakeStart = key.find( '\n', outputStart ) + 1;
+	const bool bakeLUT = key[bakeStart] == '1';
+
+	// Baked LUTs take a few megabytes each, so we allow fewer of them.
+	cost = bakeLUT ? 10 : 1;
+
+	return new ColorTransform(
+		key.substr( inputStart, outputStart - inputStart - 1 ),
+		key.substr( outputStart, bakeStart - outputStart - 1 ),
+		bakeLUT
+	);
+}
+
+typedef LRUCache<std::string, ConstColorTransformPtr> ColorTransformCache;
+
+ColorTransformCache *colorTransformCache()
+{
+	static ColorTransformCache *c = new ColorTransformCache( colorTransformGetter, 100 );
+	return c;
+}
+
+ConstColorTransformPtr colorTransform( const std::string &inputSpace, const std::string &outputSpace, bool bakeLUT )
+{
+	::OpenColorIO::ConstConfigRcPtr config = ::OpenColorIO::GetCurrentConfig();
+
+	std::string key = config->getCacheID();
+	key += "\n" + inputSpace + "\n" + outputSpace + "\n" + ( bakeLUT ? "1" : "0" );
+
+	return colorTransformCache()->get( key );
+}
+
 } // namespace Detail
 
 IE_CORE_DEFINERUNTIMETYPED( OpenColorIO );
@@ -83,6 +324,7 @@ OpenColorIO::OpenColorIO( const std::string &name )
 	storeIndexOfNextChild( g_firstPlugIndex );
 	addChild( new StringPlug( "inputSpace" ) );
 	addChild( new StringPlug( "outputSpace" ) );
+	addChild( new BoolPlug( "bakeLUT" ) );
 }
 
 OpenColorIO::~OpenColorIO()
@@ -109,6 +351,16 @@ const Gaffer::StringPlug *OpenColorIO::outputSpacePlug() const
 	return getChild<StringPlug>( g_firstPlugIndex + 1 );
 }
 
+Gaffer::BoolPlug *OpenColorIO::bakeLUTPlug()
+{
+	return getChild<BoolPlug>( g_firstPlugIndex + 2 );
+}
+
+const Gaffer::BoolPlug *OpenColorIO::bakeLUTPlug() const
+{
+	return getChild<BoolPlug>( g_firstPlugIndex + 2 );
+}
+
 bool OpenColorIO::enabled() const
 {
 	if( !ColorProcessor::enabled() )
@@ -130,7 +382,7 @@ bool OpenColorIO::affectsColorData( const Gaffer::Plug *input ) const
 	{
 		return true;
 	}
-	return input == inputSpacePlug() || input == outputSpacePlug();
+	return input == inputSpacePlug() || input == outputSpacePlug() || input == bakeLUTPlug();
 }
 
 void OpenColorIO::hashColorData( const Gaffer::Context *context, IECore::MurmurHash &h ) const
@@ -139,30 +391,28 @@ void OpenColorIO::hashColorData( const Gaffer::Context *context, IECore::MurmurH
 	
 	inputSpacePlug()->hash( h );
 	outputSpacePlug()->hash( h );
+	bakeLUTPlug()->hash( h );
 }
 
 void OpenColorIO::processColorData( const Gaffer::Context *context, IECore::FloatVectorData *r, IECore::FloatVectorData *g, IECore::FloatVectorData *b ) const
 {
-	string inputSpace( inputSpacePlug()->getValue() );
-	string outputSpace( outputSpacePlug()->getValue() );
-	
-	::OpenColorIO::ConstProcessorRcPtr processor;
+	Detail::ConstColorTransformPtr transform = Detail::colorTransform(
+		inputSpacePlug()->getValue(),
+		outputSpacePlug()->getValue(),
+		bakeLUTPlug()->getValue()
+	);
+
+	if( transform->isNoOp() )
 	{
-		Detail::OCIOMutex::scoped_lock lock( Detail::g_ocioMutex );
-		::OpenColorIO::ConstConfigRcPtr config = ::OpenColorIO::GetCurrentConfig();
-		processor = config->getProcessor( inputSpace.c_str(), outputSpace.c_str() );
+		return;
 	}
-			
-	::OpenColorIO::PlanarImageDesc image(
+
+	transform->apply(
 		r->baseWritable(),
 		g->baseWritable(),
 		b->baseWritable(),
-		0, // alpha
-		ImagePlug::tileSize(), // width
-		ImagePlug::tileSize() // height
+		r->readable().size()
 	);
-	
-	processor->apply( image );
 }
 
 } // namespace GafferImage
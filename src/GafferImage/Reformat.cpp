@@ -35,6 +35,10 @@
 //  
 //////////////////////////////////////////////////////////////////////////
 
+#include "IECore/CompoundData.h"
+
+#include "Gaffer/Context.h"
+
 #include "GafferImage/Reformat.h"
 #include "GafferImage/Sampler.h"
 
@@ -52,6 +56,8 @@ Reformat::Reformat( const std::string &name )
 	storeIndexOfNextChild( g_firstPlugIndex );
 	addChild( new FormatPlug( "format" ) );
 	addChild( new FilterPlug( "filter" ) );
+	addChild( new ObjectPlug( "__xWeights", Gaffer::Plug::Out, new CompoundData() ) );
+	addChild( new ObjectPlug( "__yWeights", Gaffer::Plug::Out, new CompoundData() ) );
 }
 
 Reformat::~Reformat()
@@ -78,6 +84,26 @@ const GafferImage::FilterPlug *Reformat::filterPlug() const
 	return getChild<GafferImage::FilterPlug>( g_firstPlugIndex+1 );
 }
 
+Gaffer::ObjectPlug *Reformat::xWeightsPlug()
+{
+	return getChild<ObjectPlug>( g_firstPlugIndex+2 );
+}
+
+const Gaffer::ObjectPlug *Reformat::xWeightsPlug() const
+{
+	return getChild<ObjectPlug>( g_firstPlugIndex+2 );
+}
+
+Gaffer::ObjectPlug *Reformat::yWeightsPlug()
+{
+	return getChild<ObjectPlug>( g_firstPlugIndex+3 );
+}
+
+const Gaffer::ObjectPlug *Reformat::yWeightsPlug() const
+{
+	return getChild<ObjectPlug>( g_firstPlugIndex+3 );
+}
+
 void Reformat::affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const
 {
 	ImageProcessor::affects( input, outputs );
@@ -87,8 +113,16 @@ void Reformat::affects( const Gaffer::Plug *input, AffectedPlugsContainer &outpu
 		outputs.push_back( outPlug()->formatPlug() );
 		outputs.push_back( outPlug()->dataWindowPlug() );
 		outputs.push_back( outPlug()->channelDataPlug() );
+		outputs.push_back( xWeightsPlug() );
+		outputs.push_back( yWeightsPlug() );
+	}
+	else if ( input == filterPlug() || input == inPlug()->formatPlug() )
+	{
+		outputs.push_back( outPlug()->channelDataPlug() );
+		outputs.push_back( xWeightsPlug() );
+		outputs.push_back( yWeightsPlug() );
 	}
-	else if ( input == filterPlug() )
+	else if ( input == xWeightsPlug() || input == yWeightsPlug() )
 	{
 		outputs.push_back( outPlug()->channelDataPlug() );
 	}
@@ -111,6 +145,20 @@ bool Reformat::enabled() const
 	return inFormat != outFormat;
 }
 
+void Reformat::hash( const Gaffer::ValuePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
+{
+	ImageProcessor::hash( output, context, h );
+
+	if ( output == xWeightsPlug() || output == yWeightsPlug() )
+	{
+		const Imath::V2i tileOrigin = context->get<Imath::V2i>( ImagePlug::tileOriginContextName );
+		h.append( output == xWeightsPlug() ? tileOrigin.x : tileOrigin.y );
+		filterPlug()->hash( h );
+		inPlug()->formatPlug()->hash( h );
+		formatPlug()->hash( h );
+	}
+}
+
 void Reformat::hashFormat( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {
 	ImageProcessor::hashFormat( output, context, h );
@@ -198,21 +246,157 @@ Imath::V2d Reformat::scale() const
 	return scale;
 }
 
-struct Contribution
+namespace
+{
+
+// Returns true if ratio is a whole number, setting n to it.
+bool integerRatio( double ratio, int &n )
+{
+	n = int( ratio + 0.5 );
+	return n >= 1 && fabs( ratio - n ) < 1e-6;
+}
+
+// Fills weights with the filter weights for a tile's worth of output pixels along
+// one axis, starting at origin. When scaling by an integer factor the weights repeat
+// with a short period (every pixel when downsampling, every `factor` pixels when
+// upsampling), so we compute a single period and replicate it with shifted taps.
+void computeWeights( const Filter *filter, int origin, double scale, double inOffset, double outOffset, Filter::Weights &weights )
 {
-	int pixel;
-	float weight;
-};
+	const int tileSize = ImagePlug::tileSize();
+
+	int period = tileSize;
+	int shift = 0;
+	int ratio;
+	if ( integerRatio( 1. / scale, ratio ) )
+	{
+		period = 1;
+		shift = ratio;
+	}
+	else if ( integerRatio( scale, ratio ) && ratio < tileSize )
+	{
+		period = ratio;
+		shift = 1;
+	}
+
+	std::vector<float> centers( period );
+	for ( int i = 0; i < period; ++i )
+	{
+		centers[i] = ( origin + i + 0.5 - outOffset ) / scale + inOffset;
+	}
+	filter->computeWeights( centers, weights );
+
+	if ( period == tileSize )
+	{
+		return;
+	}
+
+	const int width = weights.width;
+	weights.taps.resize( tileSize );
+	weights.weights.resize( tileSize * width );
+	for ( int i = period; i < tileSize; ++i )
+	{
+		weights.taps[i] = weights.taps[i-period] + shift;
+		std::copy(
+			weights.weights.begin() + ( i - period ) * width,
+			weights.weights.begin() + ( i - period + 1 ) * width,
+			weights.weights.begin() + i * width
+		);
+	}
+}
+
+CompoundDataPtr weightsToData( const Filter::Weights &weights )
+{
+	CompoundDataPtr result = new CompoundData;
+	result->writable()["width"] = new IntData( weights.width );
+	result->writable()["taps"] = new IntVectorData( weights.taps );
+	result->writable()["weights"] = new FloatVectorData( weights.weights );
+	return result;
+}
+
+// Fills weights from the table cached in plug for the specified tile.
+void cachedWeights( const ObjectPlug *plug, const Imath::V2i &tileOrigin, const Context *context, Filter::Weights &weights )
+{
+	ContextPtr c = new Context( *context, Context::Borrowed );
+	c->set( ImagePlug::tileOriginContextName, tileOrigin );
+	Context::Scope scope( c.get() );
+
+	ConstCompoundDataPtr data = boost::static_pointer_cast<const CompoundData>( plug->getValue() );
+	weights.width = data->member<IntData>( "width" )->readable();
+	weights.taps = data->member<IntVectorData>( "taps" )->readable();
+	weights.weights = data->member<FloatVectorData>( "weights" )->readable();
+}
+
+// Fills out with a tile in which each pixel is the average of a block of ratio.x
+// by ratio.y input pixels, starting at inOrigin. This needs only additions and
+// reads the input a row at a time, so runs at close to memory bandwidth.
+void boxDownsample( Sampler &sampler, const Imath::V2i &inOrigin, const Imath::V2i &ratio, float *out )
+{
+	const int tileSize = ImagePlug::tileSize();
+	const int inWidth = tileSize * ratio.x;
+	const float normalisation = 1.f / ( ratio.x * ratio.y );
+
+	std::vector<float> rows( inWidth * ratio.y );
+	for ( int y = 0; y < tileSize; ++y, out += tileSize )
+	{
+		const Imath::V2i rowsOrigin( inOrigin.x, inOrigin.y + y * ratio.y );
+		sampler.sampleRegion( Imath::Box2i( rowsOrigin, rowsOrigin + Imath::V2i( inWidth - 1, ratio.y - 1 ) ), &rows[0] );
+
+		// Sum the rows of each block into the first row.
+		float *sums = &rows[0];
+		for ( int j = 1; j < ratio.y; ++j )
+		{
+			const float *row = &rows[j * inWidth];
+			for ( int i = 0; i < inWidth; ++i )
+			{
+				sums[i] += row[i];
+			}
+		}
+
+		// Then sum across each block.
+		const float *s = sums;
+		for ( int x = 0; x < tileSize; ++x )
+		{
+			float v = 0.f;
+			for ( int i = 0; i < ratio.x; ++i )
+			{
+				v += *s++;
+			}
+			out[x] = v * normalisation;
+		}
+	}
+}
+
+} // namespace
+
+void Reformat::compute( Gaffer::ValuePlug *output, const Gaffer::Context *context ) const
+{
+	if ( output == xWeightsPlug() || output == yWeightsPlug() )
+	{
+		const int axis = output == xWeightsPlug() ? 0 : 1;
+		const int origin = context->get<Imath::V2i>( ImagePlug::tileOriginContextName )[axis];
+		const double exactScaleFactor = scale()[axis];
+		const double inFormatOffset = inPlug()->formatPlug()->getValue().getDisplayWindow().min[axis];
+		const double outFormatOffset = formatPlug()->getValue().getDisplayWindow().min[axis];
+
+		FilterPtr f = Filter::create( filterPlug()->getValue(), 1.f / float( exactScaleFactor ) );
+		Filter::Weights weights;
+		computeWeights( f.get(), origin, exactScaleFactor, inFormatOffset, outFormatOffset, weights );
+		static_cast<ObjectPlug *>( output )->setValue( weightsToData( weights ) );
+		return;
+	}
+
+	ImageProcessor::compute( output, context );
+}
 
 IECore::ConstFloatVectorDataPtr Reformat::computeChannelData( const std::string &channelName, const Imath::V2i &tileOrigin, const Gaffer::Context *context, const ImagePlug *parent ) const
 {
 	// Allocate the new tile
-	FloatVectorDataPtr outDataPtr = new FloatVectorData;
+	FloatVectorDataPtr outDataPtr = ImagePlug::allocateTile();
 	std::vector<float> &out = outDataPtr->writable();
-	out.resize( ImagePlug::tileSize() * ImagePlug::tileSize() );
 
 	// Create some useful variables...
-	Imath::V2f scaleFactor( scale() );
+	const Imath::V2d exactScaleFactor( scale() );
+	Imath::V2f scaleFactor( exactScaleFactor );
 	Imath::V2d inFormatOffset( inPlug()->formatPlug()->getValue().getDisplayWindow().min );
 	Imath::V2d outFormatOffset( formatPlug()->getValue().getDisplayWindow().min );
 
@@ -229,171 +413,48 @@ IECore::ConstFloatVectorDataPtr Reformat::computeChannelData( const std::string
 		)
 	);
 
-	// Create our filter.
+	// Create our filter, and get the dimensions of the area of the input that we need.
 	FilterPtr f = Filter::create( filterPlug()->getValue(), 1.f / scaleFactor.y );
-	
-	// If we are filtering with a box filter then just don't bother filtering
-	// at all and just integer sample instead...
-	if ( static_cast<GafferImage::TypeId>( f->typeId() ) == GafferImage::BoxFilterTypeId )
-	{
-		Imath::V2d scaleFactorD( scale() );
-		Imath::Box2i sampleBox(
-			Imath::V2i( IECore::fastFloatFloor( inTile.min.x ), IECore::fastFloatCeil( inTile.min.y ) ),
-			Imath::V2i( IECore::fastFloatFloor( inTile.max.x ), IECore::fastFloatCeil( inTile.max.y ) )
-		);
-
-		Sampler sampler( inPlug(), channelName, sampleBox, f, Sampler::Clamp );
-		for ( int y = outTile.min.y, ty = 0; y <= outTile.max.y; ++y, ++ty )
-		{
-			for ( int x = outTile.min.x, tx = 0; x <= outTile.max.x; ++x, ++tx )
-			{
-				float value = sampler.sample( float( ( x + .5f - outFormatOffset.x ) / scaleFactor.x + inFormatOffset.x ), float( ( y + .5f - outFormatOffset.y ) / scaleFactor.y + inFormatOffset.y ) ); 
-				out[ tx + ImagePlug::tileSize() * ty ] = value;
-			}
-		}
-		return outDataPtr;
-	}
+	const bool boxFilter = static_cast<GafferImage::TypeId>( f->typeId() ) == GafferImage::BoxFilterTypeId;
 
-	// Get the dimensions of our filter and create a box that we can use to define the bounds of our input.
 	int fHeight = f->width();
-	
 	int sampleMinY = f->tap( inTile.min.y );
 	int sampleMaxY = f->tap( inTile.max.y );
-		
+
 	f->setScale( 1.f / scaleFactor.x );
+	int fWidth = f->width();
 	int sampleMinX = f->tap( inTile.min.x );
 	int sampleMaxX = f->tap( inTile.max.x );
-	
-	int fWidth = f->width();
 
 	Imath::Box2i sampleBox(
 		Imath::V2i( sampleMinX, sampleMinY ),
 		Imath::V2i( sampleMaxX + fWidth, sampleMaxY + fHeight )
 	);
 
-	int sampleBoxWidth = sampleBox.size().x + 1;
-	int sampleBoxHeight = sampleBox.size().y + 1;
-
-	// Create a temporary buffer that we can write the result of the first pass to.
-	// We extend the buffer vertically as we will need additional information in the
-	// vertical squash (the second pass) to properly convolve the filter.
-	float buffer[ ImagePlug::tileSize() * sampleBoxHeight ];
-	
-	// Create several buffers for each pixel in the output row (or column depending on the pass)
-	// into which we can place the indices for the pixels that are contribute to it's result and
-	// their weight.
-	
-	// A buffer that holds a list of pixel contributions and their weights for every pixel in the output buffer.
-	// As it gets reused for both passes we make it large enough to hold both so that we don't have to resize it later.
-	std::vector<Contribution> contribution( ImagePlug::tileSize() * ( sampleBoxHeight > sampleBoxWidth ? sampleBoxHeight : sampleBoxWidth ) ); 
-	
-	// The total number of pixels that contribute towards each pixel in th resulting image.
-	std::vector<int> coverageTotal( ImagePlug::tileSize() );
-
-	// The total weighted sum of contribution that each pixel in the output gets.
-	// This value is used to normalize the result.
-	std::vector<float> weightedSum( ImagePlug::tileSize() );
-
-	// Horizontal Pass
-	// Here we build a row buffer of contributing pixels and their weights for every pixel in the row.
-	int contributionIdx = 0;
-	for ( int i = 0; i < ImagePlug::tileSize(); ++i, contributionIdx += fWidth )
-	{
-		float center = ( outTile.min.x + i + 0.5 - outFormatOffset.x ) / scaleFactor.x + inFormatOffset.x;
-		int tap = f->tap( center );
-		
-		int n = 0;	
-		weightedSum[i] = 0.;
-		for ( int j = tap; j < tap+fWidth; ++j )
-		{
-			float weight = f->weight( center, j );
-			if ( weight == 0 )
-			{
-				continue;
-			}
-			
-			contribution[contributionIdx+n].pixel = j; 
-			weightedSum[i] += contribution[contributionIdx+n].weight = weight; 
-			n++;
-		}
-		coverageTotal[i] = n;
-	}
-	
-	// Now that we know the contribution of each pixel from the others on the row, compute the
-	// horizontally scaled buffer which we will use as input in the vertical scale pass.
 	Sampler sampler( inPlug(), channelName, sampleBox, f, Sampler::Clamp );
-	for ( int k = 0; k < sampleBoxHeight; ++k )
-	{
-		for ( int i = 0, contributionIdx = 0; i < ImagePlug::tileSize(); ++i, contributionIdx += fWidth )
-		{
-			float intensity = 0;
 
-			for ( int j = 0; j < coverageTotal[i]; ++j )
-			{
-				Contribution &contributor( contribution[ contributionIdx+j ] );
-
-				if ( contributor.weight == 0. )
-				{
-					continue;
-				}
-
-				float value = sampler.sample( contributor.pixel, k + sampleBox.min.y );
-				intensity += value * contributor.weight;
-			}
-
-			buffer[i + ImagePlug::tileSize() * k] = intensity / weightedSum[i];
-		}
-	}
-	
-	// Vertical Pass
-	// Build the column buffer of contributing pixels and their weights for each pixel in the column.
-	f->setScale( 1.f / scaleFactor.y );
-	for ( int i = 0, contributionIdx = 0; i < ImagePlug::tileSize(); ++i, contributionIdx += fHeight )
+	// When downsampling by integer factors with a box filter, each output pixel
+	// is just the average of a block of input pixels.
+	Imath::V2i ratio;
+	if ( boxFilter && integerRatio( 1. / exactScaleFactor.x, ratio.x ) && integerRatio( 1. / exactScaleFactor.y, ratio.y ) )
 	{
-		float center = ( outTile.min.y - outFormatOffset.y + i + 0.5 ) / scaleFactor.y - sampleBox.min.y + inFormatOffset.y;
-		int tap = f->tap( center );
-		
-		int n = 0;	
-		weightedSum[i] = 0.;
-		for ( int j = tap; j < tap+fHeight; ++j )
-		{
-			float weight = f->weight( center, j );
-			if ( weight == 0 )
-			{
-				continue;
-			}
-			
-			contribution[contributionIdx+n].pixel = j; 
-			weightedSum[i] += contribution[contributionIdx+n].weight = weight;
-			n++;
-		}
-		coverageTotal[i] = n;
+		const Imath::V2i inOrigin(
+			int( ( outTile.min.x - outFormatOffset.x ) * ratio.x + inFormatOffset.x ),
+			int( ( outTile.min.y - outFormatOffset.y ) * ratio.y + inFormatOffset.y )
+		);
+		boxDownsample( sampler, inOrigin, ratio, &out[0] );
+		return outDataPtr;
 	}
-	
-	// Use the column buffer of pixel contributions to scale the temporary buffer vertically.
-	// Write the result into the output buffer.
-	for ( int k = 0; k < ImagePlug::tileSize(); ++k )
-	{
-		for ( int i = 0, contributionIdx = 0; i < ImagePlug::tileSize(); ++i, contributionIdx += fHeight )
-		{
-			float intensity = 0;
-
-			for ( int j = 0; j < coverageTotal[i]; ++j )
-			{
-				Contribution &contributor( contribution[ contributionIdx+j ] );
 
-				if ( contributor.weight == 0. )
-				{
-					continue;
-				}
+	// Otherwise get the tables of filter weights for the columns and rows of the
+	// output tile, and let the sampler do a separable 2-pass convolution. Note that
+	// a box filter yields a single tap per pixel, so that we just integer sample
+	// the input.
+	Filter::Weights xWeights, yWeights;
+	cachedWeights( xWeightsPlug(), Imath::V2i( tileOrigin.x, 0 ), context, xWeights );
+	cachedWeights( yWeightsPlug(), Imath::V2i( 0, tileOrigin.y ), context, yWeights );
 
-				intensity += buffer[ k + ImagePlug::tileSize() * contributor.pixel ] * contributor.weight;
-			}
+	sampler.sampleGrid( xWeights, yWeights, &out[0] );
 
-			out[k + ImagePlug::tileSize() * i] = intensity / weightedSum[i];
-		}
-	}
-   
 	return outDataPtr;
 }
-
@@ -34,6 +34,8 @@
 //  
 //////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+
 #include "Gaffer/Context.h"
 #include "GafferImage/Sampler.h"
 
@@ -45,7 +47,8 @@ Sampler::Sampler( const GafferImage::ImagePlug *plug, const std::string &channel
 	: m_plug( plug ),
 	m_channelName( channelName ),
 	m_boundingMode( boundingMode ),
-	m_filter( Filter::create( Filter::defaultFilter() ) )
+	m_filter( Filter::create( Filter::defaultFilter() ) ),
+	m_boxFilter( false )
 {
 	setSampleWindow( window );
 }
@@ -54,7 +57,8 @@ Sampler::Sampler( const GafferImage::ImagePlug *plug, const std::string &channel
 	: m_plug( plug ),
 	m_channelName( channelName ),
 	m_boundingMode( boundingMode ),
-	m_filter( filter )
+	m_filter( filter ),
+	m_boxFilter( static_cast<GafferImage::TypeId>( filter->typeId() ) == GafferImage::BoxFilterTypeId )
 {
 	setSampleWindow( window );
 }
@@ -97,3 +101,153 @@ void Sampler::hash( IECore::MurmurHash &h ) const
 	}
 }
 
+void Sampler::sampleRegion( const Imath::Box2i &region, float *buffer )
+{
+	if ( region.isEmpty() )
+	{
+		return;
+	}
+
+	const int width = region.size().x + 1;
+	const int height = region.size().y + 1;
+
+	if ( m_sampleWindow.isEmpty() )
+	{
+		std::fill( buffer, buffer + width * height, 0.f );
+		return;
+	}
+
+	// Split each row into the span of pixels that lies within the sample window
+	// and the pixels to either side of it, which are filled according to the
+	// bounding mode.
+	const int before = std::max( 0, std::min( width, m_sampleWindow.min.x - region.min.x ) );
+	const int after = std::max( 0, std::min( width - before, region.max.x - m_sampleWindow.max.x ) );
+	const int inside = width - before - after;
+
+	int previousY = m_sampleWindow.min.y - 1;
+	const float *previousRow = NULL;
+	for ( int y = region.min.y; y <= region.max.y; ++y, buffer += width )
+	{
+		int sampleY = y;
+		if ( y < m_sampleWindow.min.y || y > m_sampleWindow.max.y )
+		{
+			if ( m_boundingMode == Black )
+			{
+				std::fill( buffer, buffer + width, 0.f );
+				continue;
+			}
+			sampleY = std::max( std::min( y, m_sampleWindow.max.y ), m_sampleWindow.min.y );
+		}
+
+		// Clamped rows outside the sample window are repeats of the edge row.
+		if ( sampleY == previousY )
+		{
+			std::copy( previousRow, previousRow + width, buffer );
+			continue;
+		}
+
+		if ( inside > 0 )
+		{
+			copySpan( region.min.x + before, sampleY, inside, buffer + before );
+			const float beforeValue = m_boundingMode == Black ? 0.f : buffer[before];
+			const float afterValue = m_boundingMode == Black ? 0.f : buffer[before+inside-1];
+			std::fill( buffer, buffer + before, beforeValue );
+			std::fill( buffer + before + inside, buffer + width, afterValue );
+		}
+		else
+		{
+			const float value = m_boundingMode == Black ? 0.f : sample( region.min.x, sampleY );
+			std::fill( buffer, buffer + width, value );
+		}
+
+		previousY = sampleY;
+		previousRow = buffer;
+	}
+}
+
+void Sampler::sampleGrid( const Filter::Weights &xWeights, const Filter::Weights &yWeights, float *buffer )
+{
+	const int numX = xWeights.taps.size();
+	const int numY = yWeights.taps.size();
+	if ( !numX || !numY )
+	{
+		return;
+	}
+
+	// Fetch all the pixels covered by the kernels in one go.
+	const Imath::Box2i region(
+		Imath::V2i(
+			*std::min_element( xWeights.taps.begin(), xWeights.taps.end() ),
+			*std::min_element( yWeights.taps.begin(), yWeights.taps.end() )
+		),
+		Imath::V2i(
+			*std::max_element( xWeights.taps.begin(), xWeights.taps.end() ) + xWeights.width - 1,
+			*std::max_element( yWeights.taps.begin(), yWeights.taps.end() ) + yWeights.width - 1
+		)
+	);
+
+	const int regionWidth = region.size().x + 1;
+	const int regionHeight = region.size().y + 1;
+	m_regionBuffer.resize( regionWidth * regionHeight );
+	sampleRegion( region, &m_regionBuffer[0] );
+
+	// Horizontal pass. Filter every row of the region, storing numX
+	// results per row.
+	m_rowBuffer.resize( numX * regionHeight );
+	for ( int y = 0; y < regionHeight; ++y )
+	{
+		const float *in = &m_regionBuffer[y * regionWidth] - region.min.x;
+		float *out = &m_rowBuffer[y * numX];
+		const float *weights = &xWeights.weights[0];
+		for ( int i = 0; i < numX; ++i, weights += xWeights.width )
+		{
+			const float *p = in + xWeights.taps[i];
+			float v = 0.f;
+			for ( int j = 0; j < xWeights.width; ++j )
+			{
+				v += p[j] * weights[j];
+			}
+			out[i] = v;
+		}
+	}
+
+	// Vertical pass. Accumulate whole rows of the horizontal result at
+	// a time, so that the inner loop runs over contiguous memory.
+	const float *weights = &yWeights.weights[0];
+	for ( int i = 0; i < numY; ++i, weights += yWeights.width, buffer += numX )
+	{
+		std::fill( buffer, buffer + numX, 0.f );
+		const float *in = &m_rowBuffer[( yWeights.taps[i] - region.min.y ) * numX];
+		for ( int j = 0; j < yWeights.width; ++j, in += numX )
+		{
+			const float w = weights[j];
+			if ( w == 0.f )
+			{
+				continue;
+			}
+			for ( int k = 0; k < numX; ++k )
+			{
+				buffer[k] += in[k] * w;
+			}
+		}
+	}
+}
+
+void Sampler::copySpan( int x, int y, int count, float *buffer )
+{
+	while ( count > 0 )
+	{
+		const float *tileData;
+		Imath::V2i tileOrigin;
+		Imath::V2i tileIndex;
+		cachedData( Imath::V2i( x, y ), tileData, tileOrigin, tileIndex );
+
+		const int n = std::min( count, ImagePlug::tileSize() - tileIndex.x );
+		const float *in = tileData + tileIndex.y * ImagePlug::tileSize() + tileIndex.x;
+		std::copy( in, in + n, buffer );
+
+		x += n;
+		buffer += n;
+		count -= n;
+	}
+}
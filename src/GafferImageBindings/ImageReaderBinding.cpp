@@ -36,6 +36,8 @@
 
 #include "boost/python.hpp"
 
+#include "IECorePython/ScopedGILRelease.h"
+
 #include "GafferBindings/DependencyNodeBinding.h"
 
 #include "GafferImage/ImageReader.h"
@@ -58,12 +60,37 @@ static boost::python::list supportedExtensions()
 	return result;
 }
 
+static void prefetch( const ImageReader &reader, int startFrame, int endFrame, const Imath::Box2i &region )
+{
+	IECorePython::ScopedGILRelease gilRelease;
+	reader.prefetch( startFrame, endFrame, region );
+}
+
 void GafferImageBindings::bindImageReader()
 {
 	
 	GafferBindings::DependencyNodeClass<ImageReader>()
 		.def( "supportedExtensions", &supportedExtensions )
 		.staticmethod( "supportedExtensions" )
+		.def( "prefetch", &prefetch, ( boost::python::arg( "startFrame" ), boost::python::arg( "endFrame" ), boost::python::arg( "region" ) = Imath::Box2i() ) )
+		.def( "getCacheMemoryLimit", &ImageReader::getCacheMemoryLimit )
+		.staticmethod( "getCacheMemoryLimit" )
+		.def( "setCacheMemoryLimit", &ImageReader::setCacheMemoryLimit )
+		.staticmethod( "setCacheMemoryLimit" )
+		.def( "getCacheFileHandleLimit", &ImageReader::getCacheFileHandleLimit )
+		.staticmethod( "getCacheFileHandleLimit" )
+		.def( "setCacheFileHandleLimit", &ImageReader::setCacheFileHandleLimit )
+		.staticmethod( "setCacheFileHandleLimit" )
+		.def( "getCacheAutoTile", &ImageReader::getCacheAutoTile )
+		.staticmethod( "getCacheAutoTile" )
+		.def( "setCacheAutoTile", &ImageReader::setCacheAutoTile )
+		.staticmethod( "setCacheAutoTile" )
+		.def( "getCacheAutoMip", &ImageReader::getCacheAutoMip )
+		.staticmethod( "getCacheAutoMip" )
+		.def( "setCacheAutoMip", &ImageReader::setCacheAutoMip )
+		.staticmethod( "setCacheAutoMip" )
+		.def( "cacheStatistics", &ImageReader::cacheStatistics )
+		.staticmethod( "cacheStatistics" )
 	;
 		
 }
@@ -49,6 +49,17 @@ using namespace GafferImage;
 namespace GafferImageBindings
 {
 
+static IECore::FloatVectorDataPtr sampleRegion( Sampler &sampler, const Imath::Box2i &region )
+{
+	IECore::FloatVectorDataPtr result = new IECore::FloatVectorData;
+	if( !region.isEmpty() )
+	{
+		result->writable().resize( ( region.size().x + 1 ) * ( region.size().y + 1 ) );
+		sampler.sampleRegion( region, &result->writable()[0] );
+	}
+	return result;
+}
+
 void bindSampler()
 {
 	enum_<Sampler::BoundingMode>( "BoundingMode" )
@@ -77,6 +88,7 @@ void bindSampler()
 		.def( "hash", &Sampler::hash )
 		.def( "sample", (float (Sampler::*)( int, int ) )&Sampler::sample )
 		.def( "sample", (float (Sampler::*)( float, float ) )&Sampler::sample )
+		.def( "sampleRegion", &sampleRegion )
 	;
 }
 
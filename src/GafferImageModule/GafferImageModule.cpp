@@ -59,6 +59,8 @@
 #include "GafferImage/ImageTransform.h"
 #include "GafferImage/ImageStats.h"
 #include "GafferImage/ImageSampler.h"
+#include "GafferImage/AutoCrop.h"
+#include "GafferImage/Blur.h"
 
 #include "GafferImageBindings/FormatBinding.h"
 #include "GafferImageBindings/FormatPlugBinding.h"
@@ -89,25 +91,34 @@ static IECore::ImagePrimitivePtr image( const ImagePlug &plug )
 BOOST_PYTHON_MODULE( _GafferImage )
 {
 	
-	IECorePython::RunTimeTypedClass<ImagePlug>()
-		.def(
-			init< const std::string &, Gaffer::Plug::Direction, unsigned >
-			(
+	{
+		scope s = IECorePython::RunTimeTypedClass<ImagePlug>()
+			.def(
+				init< const std::string &, Gaffer::Plug::Direction, unsigned >
 				(
-					arg( "name" ) = Gaffer::GraphComponent::defaultName<ImagePlug>(),
-					arg( "direction" ) = Gaffer::Plug::In,
-					arg( "flags" ) = Gaffer::Plug::Default
-				)
-			)	
-		)
-		.def( "channelData", &channelData )
-		.def( "channelDataHash", &ImagePlug::channelDataHash )
-		.def( "image", &image )
-		.def( "imageHash", &ImagePlug::imageHash )
-		.def( "tileSize", &ImagePlug::tileSize ).staticmethod( "tileSize" )
-		.def( "tileBound", &ImagePlug::tileBound ).staticmethod( "tileBound" )
-		.def( "tileOrigin", &ImagePlug::tileOrigin ).staticmethod( "tileOrigin" )
-	;
+					(
+						arg( "name" ) = Gaffer::GraphComponent::defaultName<ImagePlug>(),
+						arg( "direction" ) = Gaffer::Plug::In,
+						arg( "flags" ) = Gaffer::Plug::Default
+					)
+				)	
+			)
+			.def( "channelData", &channelData )
+			.def( "channelDataHash", &ImagePlug::channelDataHash )
+			.def( "image", &image )
+			.def( "imageHash", &ImagePlug::imageHash )
+			.def( "tileSize", &ImagePlug::tileSize ).staticmethod( "tileSize" )
+			.def( "tileBound", &ImagePlug::tileBound ).staticmethod( "tileBound" )
+			.def( "tileOrigin", &ImagePlug::tileOrigin ).staticmethod( "tileOrigin" )
+			.def( "setTileStorage", &ImagePlug::setTileStorage ).staticmethod( "setTileStorage" )
+			.def( "getTileStorage", &ImagePlug::getTileStorage ).staticmethod( "getTileStorage" )
+		;
+
+		enum_<ImagePlug::TileStorage>( "TileStorage" )
+			.value( "Float", ImagePlug::FloatTileStorage )
+			.value( "Half", ImagePlug::HalfTileStorage )
+		;
+	}
 
 	GafferBindings::DependencyNodeClass<ImageNode>();
 	GafferBindings::DependencyNodeClass<ImagePrimitiveNode>();
@@ -130,6 +141,17 @@ BOOST_PYTHON_MODULE( _GafferImage )
 	GafferBindings::DependencyNodeClass<ImageTransform>();
 	GafferBindings::DependencyNodeClass<ImageStats>();
 	GafferBindings::DependencyNodeClass<ImageSampler>();
+	GafferBindings::DependencyNodeClass<AutoCrop>();
+
+	{
+		scope s = GafferBindings::DependencyNodeClass<Blur>();
+
+		enum_<Blur::Mode>( "Mode" )
+			.value( "Box", Blur::Box )
+			.value( "Gaussian", Blur::Gaussian )
+			.value( "FilterKernel", Blur::FilterKernel )
+		;
+	}
 
 	GafferImageBindings::bindRemoveChannels();
 	GafferImageBindings::bindFormat();
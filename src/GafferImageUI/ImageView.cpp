@@ -43,7 +43,12 @@
 
 #include "OpenEXR/ImathColorAlgo.h"
 
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_scheduler_init.h"
+
 #include "IECore/FastFloat.h"
+#include "IECore/ImagePrimitive.h"
 #include "IECore/BoxOps.h"
 #include "IECore/BoxAlgo.h"
 
@@ -55,6 +60,7 @@
 #include "IECoreGL/IECoreGL.h"
 
 #include "Gaffer/Context.h"
+#include "Gaffer/ValuePlug.h"
 
 #include "GafferUI/Gadget.h"
 #include "GafferUI/Style.h"
@@ -100,7 +106,6 @@ class ImageViewGadget : public GafferUI::Gadget
 	public :
 
 		ImageViewGadget(
-			IECore::ConstImagePrimitivePtr image,
 			GafferImage::ImageStatsPtr imageStats,
 			GafferImage::ImageSamplerPtr imageSampler,
 			int &channelToView,
@@ -111,11 +116,7 @@ class ImageViewGadget : public GafferUI::Gadget
 			Color4f &averageColor
 		)
 			:	Gadget( defaultName<ImageViewGadget>() ),
-				m_displayBound( image->bound() ),
-				m_displayWindow( image->getDisplayWindow() ),
-				m_dataWindow( image->getDataWindow() ),
-				m_image( image->copy() ),
-				m_texture( 0 ),
+				m_generation( 0 ),
 				m_mousePos( mousePos ),
 				m_sampleColor( 0.f ),
 				m_dragSelecting( false ),
@@ -125,23 +126,6 @@ class ImageViewGadget : public GafferUI::Gadget
 				m_imageStats( imageStats ),
 				m_imageSampler( imageSampler )
 		{
-			V2f displayWindowCenter( ( m_displayWindow.min + m_displayWindow.max + V2f( 1 ) ) / Imath::V2f( 2. ) );
-			V2f dataWindowCenter( ( m_dataWindow.min + m_dataWindow.max + V2f( 1 ) ) / Imath::V2f( 2. ) );
-			V2f offset( dataWindowCenter.x - displayWindowCenter.x, displayWindowCenter.y - dataWindowCenter.y );
-			
-			m_dataBound = Box3f(
-				V3f(
-					offset.x - ( m_dataWindow.size().x + 1 ) / 2.,
-					offset.y - ( m_dataWindow.size().y + 1 ) / 2.,
-					0.f
-				),
-				V3f(
-					offset.x + ( m_dataWindow.size().x + 1 ) / 2.,
-					offset.y + ( m_dataWindow.size().y + 1 ) / 2.,
-					0.f
-				)
-			);
-
 			keyPressSignal().connect( boost::bind( &ImageViewGadget::keyPress, this, ::_1,  ::_2 ) );
 			buttonPressSignal().connect( boost::bind( &ImageViewGadget::buttonPress, this, ::_1,  ::_2 ) );
 			buttonReleaseSignal().connect( boost::bind( &ImageViewGadget::buttonRelease, this, ::_1,  ::_2 ) );
@@ -151,8 +135,6 @@ class ImageViewGadget : public GafferUI::Gadget
 			dragEndSignal().connect( boost::bind( &ImageViewGadget::dragEnd, this, ::_1, ::_2 ) );
 			mouseMoveSignal().connect( boost::bind( &ImageViewGadget::mouseMove, this, ::_1, ::_2 ) );
 
-			sampleColor = ImageViewGadget::sampleColor( mousePos );
-
 			// Create some useful structs that we will use to hold information needed
 			// to draw the UI elements that display the color readouts to the screen.	
 			m_colorUiElements.reserve(4);
@@ -170,10 +152,6 @@ class ImageViewGadget : public GafferUI::Gadget
 			m_colorUiElements[2].position = V2i( 385, 19 );
 			m_colorUiElements[3].name = "Mean"; // The mean color within a selection.
 			m_colorUiElements[3].position = V2i( 635, 19 );
-			
-			std::vector< std::string > channelNames;	
-			m_image->channelNames( channelNames );
-			m_hasAlpha = std::find( channelNames.begin(), channelNames.end(), "A" ) != channelNames.end();
 		}
 
 		virtual ~ImageViewGadget()
@@ -188,7 +166,242 @@ class ImageViewGadget : public GafferUI::Gadget
 			return m_displayBound;
 		}
 		
+		/// Must be called with the appropriate Context current whenever
+		/// the image has changed. The format, data window and channel names
+		/// are updated immediately, but the tiles of the display buffer are
+		/// only revalidated as they are visited by updateTiles().
+		void imageChanged( const ImagePlug *image )
+		{
+			m_format = image->formatPlug()->getValue();
+			m_imageDataWindow = image->dataWindowPlug()->getValue();
+			
+			viewableChannelNames( image, m_channelNames );
+			m_hasAlpha = std::find( m_channelNames.begin(), m_channelNames.end(), "A" ) != m_channelNames.end();
+
+			// Windows in the Y-down space used by ImagePlug::image(), as
+			// expected by the drawing and sampling code.
+			m_displayWindow = m_format.getDisplayWindow();
+			m_dataWindow = m_imageDataWindow.isEmpty() ? Box2i( V2i( 0 ) ) : m_format.yDownToFormatSpace( m_imageDataWindow );
+			
+			const V2f displaySize( m_displayWindow.size() + V2i( 1 ) );
+			m_displayBound = Box3f(
+				V3f( -displaySize.x / 2., -displaySize.y / 2., 0.f ),
+				V3f( displaySize.x / 2., displaySize.y / 2., 0.f )
+			);
+			
+			V2f displayWindowCenter( ( m_displayWindow.min + m_displayWindow.max + V2f( 1 ) ) / Imath::V2f( 2. ) );
+			V2f dataWindowCenter( ( m_dataWindow.min + m_dataWindow.max + V2f( 1 ) ) / Imath::V2f( 2. ) );
+			V2f offset( dataWindowCenter.x - displayWindowCenter.x, displayWindowCenter.y - dataWindowCenter.y );
+			
+			m_dataBound = Box3f(
+				V3f(
+					offset.x - ( m_dataWindow.size().x + 1 ) / 2.,
+					offset.y - ( m_dataWindow.size().y + 1 ) / 2.,
+					0.f
+				),
+				V3f(
+					offset.x + ( m_dataWindow.size().x + 1 ) / 2.,
+					offset.y + ( m_dataWindow.size().y + 1 ) / 2.,
+					0.f
+				)
+			);
+			
+			// Forget tiles which are no longer in the data window, and
+			// mark the rest as needing revalidation. We keep displaying
+			// the stale tiles until they are replaced, so that edits
+			// upstream don't cause the image to flicker. Tiles which
+			// are merely offscreen are removed by evictTiles().
+			for( TileMap::iterator it = m_tiles.begin(); it != m_tiles.end(); )
+			{
+				if( !tileBound( it->first ).intersects( m_imageDataWindow ) )
+				{
+					m_tiles.erase( it++ );
+				}
+				else
+				{
+					++it;
+				}
+			}
+			m_generation++;
+			
+			*m_colorUiElements[0].color = sampleColor( m_mousePos );
+			renderRequestSignal()( this );
+		}
+		
+		/// Must be called with the appropriate Context current. Returns the tiles and
+		/// channels of the image which would be visible in the viewport, which needn't
+		/// be those currently displayed, allowing them to be computed in advance.
+		void visibleTiles( const ImagePlug *image, std::vector<V2i> &tileOrigins, std::vector<std::string> &channelNames ) const
+		{
+			tileOrigins.clear();
+			channelNames.clear();
+			
+			const Box2f visible = visibleRegion();
+			if( visible.isEmpty() )
+			{
+				return;
+			}
+			
+			const Box2i visiblePixels = boxIntersection( pixelBound( visible ), image->dataWindowPlug()->getValue() );
+			if( visiblePixels.isEmpty() )
+			{
+				return;
+			}
+			
+			const V2i minTileOrigin = ImagePlug::tileOrigin( visiblePixels.min );
+			const V2i maxTileOrigin = ImagePlug::tileOrigin( visiblePixels.max );
+			for( int y = minTileOrigin.y; y <= maxTileOrigin.y; y += ImagePlug::tileSize() )
+			{
+				for( int x = minTileOrigin.x; x <= maxTileOrigin.x; x += ImagePlug::tileSize() )
+				{
+					tileOrigins.push_back( V2i( x, y ) );
+				}
+			}
+			
+			viewableChannelNames( image, channelNames );
+		}
+		
+		static size_t maxTilesPerUpdate()
+		{
+			static const size_t n = 4 * tbb::task_scheduler_init::default_num_threads();
+			return n;
+		}
+		
+		/// Must be called with the appropriate Context current. Validates the tiles
+		/// of the display buffer which are visible in the viewport, computing any
+		/// whose hashes have changed since they were last computed. To keep the UI
+		/// responsive, only a limited number of tiles are computed per call, closest
+		/// to the centre of the viewport first. Returns true if all the visible tiles
+		/// are now up to date, and false if further calls are needed.
+		bool updateTiles( const ImagePlug *image )
+		{
+			const Box2f visible = visibleRegion();
+			if( visible.isEmpty() || m_imageDataWindow.isEmpty() )
+			{
+				return true;
+			}
+			
+			const Box2i visiblePixels = boxIntersection( pixelBound( visible ), m_imageDataWindow );
+			if( visiblePixels.isEmpty() )
+			{
+				return true;
+			}
+			
+			evictTiles( visiblePixels );
+			
+			// Find the visible tiles which need revalidating, and compute their hashes.
+			std::vector<V2i> tileOrigins;
+			const V2i minTileOrigin = ImagePlug::tileOrigin( visiblePixels.min );
+			const V2i maxTileOrigin = ImagePlug::tileOrigin( visiblePixels.max );
+			for( int y = minTileOrigin.y; y <= maxTileOrigin.y; y += ImagePlug::tileSize() )
+			{
+				for( int x = minTileOrigin.x; x <= maxTileOrigin.x; x += ImagePlug::tileSize() )
+				{
+					Tile &tile = m_tiles[V2i( x, y )];
+					if( tile.generation != m_generation )
+					{
+						tileOrigins.push_back( V2i( x, y ) );
+					}
+				}
+			}
+			
+			if( tileOrigins.empty() )
+			{
+				return true;
+			}
+			
+			std::vector<MurmurHash> hashes( tileOrigins.size() );
+			tbb::parallel_for(
+				tbb::blocked_range<size_t>( 0, tileOrigins.size() ),
+				HashTiles( image, m_channelNames, Context::current(), tileOrigins, hashes )
+			);
+			
+			// Tiles whose hashes are unchanged need not be recomputed. The
+			// rest are computed in order of distance from the centre of the view.
+			std::vector<std::pair<float, size_t> > toCompute;
+			const V2f visibleCenter = visible.center();
+			for( size_t i = 0; i < tileOrigins.size(); ++i )
+			{
+				Tile &tile = m_tiles[tileOrigins[i]];
+				if( tile.hash == hashes[i] )
+				{
+					tile.generation = m_generation;
+				}
+				else
+				{
+					const V2f tileCenter = V2f( tileOrigins[i] ) + V2f( ImagePlug::tileSize() / 2.0f );
+					toCompute.push_back( std::pair<float, size_t>( ( tileCenter - visibleCenter ).length2(), i ) );
+				}
+			}
+			
+			std::sort( toCompute.begin(), toCompute.end() );
+			const size_t numToCompute = std::min( toCompute.size(), maxTilesPerUpdate() );
+			
+			std::vector<V2i> computeOrigins;
+			std::vector<Tile *> computeTiles;
+			for( size_t i = 0; i < numToCompute; ++i )
+			{
+				const size_t index = toCompute[i].second;
+				computeOrigins.push_back( tileOrigins[index] );
+				computeTiles.push_back( &m_tiles[tileOrigins[index]] );
+			}
+			
+			tbb::parallel_for(
+				tbb::blocked_range<size_t>( 0, computeOrigins.size() ),
+				ComputeTiles( image, m_channelNames, Context::current(), computeOrigins, computeTiles )
+			);
+			
+			// Only now that the computation has succeeded do we
+			// record the tiles as being up to date.
+			for( size_t i = 0; i < numToCompute; ++i )
+			{
+				computeTiles[i]->hash = hashes[toCompute[i].second];
+				computeTiles[i]->generation = m_generation;
+			}
+			
+			renderRequestSignal()( this );
+			
+			return numToCompute == toCompute.size();
+		}
+		
 	protected :
+	
+		/// The number of offscreen tiles we keep in the display buffer, so
+		/// that panning and zooming back needn't recompute them. Corresponds
+		/// to roughly 256MB of RGBA tiles.
+		static size_t maxOffscreenTiles()
+		{
+			static const size_t n = ( 256 * 1024 * 1024 ) / ( ImagePlug::tileSize() * ImagePlug::tileSize() * 4 * sizeof( float ) );
+			return n;
+		}
+		
+		/// Removes tiles outside the visible pixels from the display buffer,
+		/// furthest first, until no more than maxOffscreenTiles() remain.
+		void evictTiles( const Box2i &visiblePixels )
+		{
+			std::vector<std::pair<float, V2i> > offscreen;
+			const V2f visibleCenter = V2f( visiblePixels.min + visiblePixels.max ) / 2.0f;
+			for( TileMap::const_iterator it = m_tiles.begin(), eIt = m_tiles.end(); it != eIt; ++it )
+			{
+				if( !tileBound( it->first ).intersects( visiblePixels ) )
+				{
+					const V2f tileCenter = V2f( it->first ) + V2f( ImagePlug::tileSize() / 2.0f );
+					offscreen.push_back( std::pair<float, V2i>( ( tileCenter - visibleCenter ).length2(), it->first ) );
+				}
+			}
+			
+			if( offscreen.size() <= maxOffscreenTiles() )
+			{
+				return;
+			}
+			
+			const size_t numToEvict = offscreen.size() - maxOffscreenTiles();
+			std::nth_element( offscreen.begin(), offscreen.begin() + numToEvict, offscreen.end(), EvictionOrder() );
+			for( size_t i = 0; i < numToEvict; ++i )
+			{
+				m_tiles.erase( offscreen[i].second );
+			}
+		}
 
 		static const char *vertexSource()
 		{
@@ -275,7 +488,7 @@ class ImageViewGadget : public GafferUI::Gadget
 			return g_shader.get();
 		}
 
-		void renderImageWindow( const Imath::Box2f &box, const IECoreGL::Texture *texture, int channelToView ) const
+		void renderImageWindow( const Imath::Box2f &box, const Imath::Box2f &textureBox, const IECoreGL::Texture *texture, int channelToView ) const
 		{
 			glPushAttrib( GL_COLOR_BUFFER_BIT );
 
@@ -297,13 +510,13 @@ class ImageViewGadget : public GafferUI::Gadget
 
 			glBegin( GL_QUADS );
 
-			glTexCoord2f( 1, 0 );
+			glTexCoord2f( textureBox.max.x, textureBox.min.y );
 			glVertex2f( box.max.x, box.min.y );
-			glTexCoord2f( 1, 1 );
+			glTexCoord2f( textureBox.max.x, textureBox.max.y );
 			glVertex2f( box.max.x, box.max.y );
-			glTexCoord2f( 0, 1 );
+			glTexCoord2f( textureBox.min.x, textureBox.max.y );
 			glVertex2f( box.min.x, box.max.y );	
-			glTexCoord2f( 0, 0 );
+			glTexCoord2f( textureBox.min.x, textureBox.min.y );
 			glVertex2f( box.min.x, box.min.y );
 
 			glEnd();
@@ -611,19 +824,6 @@ class ImageViewGadget : public GafferUI::Gadget
 		virtual void doRender( const Style *style ) const
 		{
 
-			if( !m_texture )
-			{
-				// convert image to texture
-				ToGLTextureConverterPtr converter = new ToGLTextureConverter( boost::static_pointer_cast<const ImagePrimitive>( m_image ), true );
-				m_texture = IECore::runTimeCast<IECoreGL::Texture>( converter->convert() );
-
-				{
-					Texture::ScopedBinding scope( *m_texture );
-					glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-					glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
-				}
-			}
-
 			// Transform them to Raster Space
 			///\todo: The RasterScope class transforms Gadgets into a space where coordinate (0, 0) is in the top left corner.
 			/// If we are rasterizing gadgets in 2D then we want (0, 0) to be in the bottom left corner. Perhaps we should write
@@ -642,11 +842,49 @@ class ImageViewGadget : public GafferUI::Gadget
 				style->renderSolidRectangle( dispRasterBox );
 			}
 
-			// Draw the image data.
+			// Draw the image data, tile by tile, converting any newly
+			// computed tiles to textures as we go.
+			const V2f displayCenter = this->displayCenter();
+			for( TileMap::const_iterator it = m_tiles.begin(), eIt = m_tiles.end(); it != eIt; ++it )
 			{
-				// Get the bounds of the data window in Gadget space.
-				Box2f b( V2f( m_dataBound.min.x, m_dataBound.min.y ), V2f( m_dataBound.max.x, m_dataBound.max.y ) );
-				renderImageWindow( b, (const Texture *)m_texture.get(), m_channelToView );
+				const Tile &tile = it->second;
+				if( tile.image )
+				{
+					ToGLTextureConverterPtr converter = new ToGLTextureConverter( tile.image, true );
+					tile.texture = IECore::runTimeCast<IECoreGL::Texture>( converter->convert() );
+					tile.image = 0;
+
+					Texture::ScopedBinding scope( *tile.texture );
+					glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+					glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+					glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+					glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+				}
+				
+				if( !tile.texture )
+				{
+					continue;
+				}
+				
+				// Draw only the part of the tile inside the data window,
+				// so that pixels outside it don't obscure the background.
+				const Box2i tileBound = ImageViewGadget::tileBound( it->first );
+				const Box2i pixels = boxIntersection( tileBound, m_imageDataWindow );
+				if( pixels.isEmpty() )
+				{
+					continue;
+				}
+				
+				const V2f min( pixels.min );
+				const V2f max( pixels.max + V2i( 1 ) );
+				const V2f tileOrigin( tileBound.min );
+				const float tileSize = ImagePlug::tileSize();
+				renderImageWindow(
+					Box2f( min - displayCenter, max - displayCenter ),
+					Box2f( ( min - tileOrigin ) / tileSize, ( max - tileOrigin ) / tileSize ),
+					tile.texture.get(),
+					m_channelToView
+				);
 			}
 
 			ViewportGadget::RasterScope rasterScope( viewportGadget );
@@ -873,12 +1111,178 @@ class ImageViewGadget : public GafferUI::Gadget
 			bool hsv;
 		};
 
+		/// Returns the centre of the display window, which is the origin
+		/// of gadget space.
+		V2f displayCenter() const
+		{
+			return V2f( m_displayWindow.min + m_displayWindow.max + V2i( 1 ) ) / 2.0f;
+		}
+		
+		static Box2i tileBound( const V2i &tileOrigin )
+		{
+			return Box2i( tileOrigin, tileOrigin + V2i( ImagePlug::tileSize() - 1 ) );
+		}
+		
+		/// Returns the region of the image that is visible in the
+		/// viewport, in the Y-up pixel space of the ImagePlug.
+		Box2f visibleRegion() const
+		{
+			Box2f result;
+			const ViewportGadget *viewportGadget = ancestor<ViewportGadget>();
+			const V2i viewport = viewportGadget->getViewport();
+			if( !viewport.x || !viewport.y )
+			{
+				return result;
+			}
+			
+			const V2f displayCenter = this->displayCenter();
+			for( int i = 0; i < 4; ++i )
+			{
+				const V2f rasterCorner( i & 1 ? viewport.x : 0, i & 2 ? viewport.y : 0 );
+				const V3f c = viewportGadget->rasterToGadgetSpace( rasterCorner, this ).p0;
+				result.extendBy( V2f( c.x, c.y ) + displayCenter );
+			}
+			return result;
+		}
+		
+		static Box2i pixelBound( const Box2f &b )
+		{
+			return Box2i( V2i( (int)floorf( b.min.x ), (int)floorf( b.min.y ) ), V2i( (int)ceilf( b.max.x ), (int)ceilf( b.max.y ) ) );
+		}
+		
+		/// The channels we're able to display, in RGBA order.
+		static void viewableChannelNames( const ImagePlug *image, std::vector<std::string> &result )
+		{
+			ConstStringVectorDataPtr channelNamesData = image->channelNamesPlug()->getValue();
+			const std::vector<std::string> &channelNames = channelNamesData->readable();
+			result.clear();
+			const char *viewableChannels[] = { "R", "G", "B", "A" };
+			for( int i = 0; i < 4; ++i )
+			{
+				if( std::find( channelNames.begin(), channelNames.end(), viewableChannels[i] ) != channelNames.end() )
+				{
+					result.push_back( viewableChannels[i] );
+				}
+			}
+		}
+		
+		/// An entry in the display buffer. The image is filled in by updateTiles()
+		/// and converted to a texture by doRender().
+		struct Tile
+		{
+			Tile() : generation( 0 ) {}
+			IECore::MurmurHash hash;
+			unsigned generation;
+			mutable ConstImagePrimitivePtr image;
+			mutable ConstTexturePtr texture;
+		};
+		
+		struct TileLess
+		{
+			bool operator()( const V2i &a, const V2i &b ) const
+			{
+				return a.y < b.y || ( a.y == b.y && a.x < b.x );
+			}
+		};
+		
+		typedef std::map<V2i, Tile, TileLess> TileMap;
+		
+		/// Orders offscreen tiles furthest first.
+		struct EvictionOrder
+		{
+			bool operator()( const std::pair<float, V2i> &a, const std::pair<float, V2i> &b ) const
+			{
+				return a.first > b.first;
+			}
+		};
+		
+		/// Computes the hashes of a number of tiles in parallel.
+		struct HashTiles
+		{
+			HashTiles( const ImagePlug *image, const std::vector<std::string> &channelNames, const Context *context, const std::vector<V2i> &tileOrigins, std::vector<MurmurHash> &hashes )
+				:	m_image( image ), m_channelNames( channelNames ), m_context( context ), m_tileOrigins( tileOrigins ), m_hashes( hashes )
+			{
+			}
+			
+			void operator()( const tbb::blocked_range<size_t> &r ) const
+			{
+				Context::Scope scope( m_context );
+				for( size_t i = r.begin(); i != r.end(); ++i )
+				{
+					MurmurHash &h = m_hashes[i];
+					for( std::vector<std::string>::const_iterator it = m_channelNames.begin(), eIt = m_channelNames.end(); it != eIt; ++it )
+					{
+						h.append( m_image->channelDataHash( *it, m_tileOrigins[i] ) );
+					}
+				}
+			}
+			
+			private :
+			
+				const ImagePlug *m_image;
+				const std::vector<std::string> &m_channelNames;
+				const Context *m_context;
+				const std::vector<V2i> &m_tileOrigins;
+				std::vector<MurmurHash> &m_hashes;
+		};
+		
+		/// Computes a number of tiles in parallel, storing them as ImagePrimitives
+		/// ready for conversion to textures.
+		struct ComputeTiles
+		{
+			ComputeTiles( const ImagePlug *image, const std::vector<std::string> &channelNames, const Context *context, const std::vector<V2i> &tileOrigins, std::vector<Tile *> &tiles )
+				:	m_image( image ), m_channelNames( channelNames ), m_context( context ), m_tileOrigins( tileOrigins ), m_tiles( tiles )
+			{
+			}
+			
+			void operator()( const tbb::blocked_range<size_t> &r ) const
+			{
+				Context::Scope scope( m_context );
+				const int tileSize = ImagePlug::tileSize();
+				const Box2i window( V2i( 0 ), V2i( tileSize - 1 ) );
+				for( size_t i = r.begin(); i != r.end(); ++i )
+				{
+					ImagePrimitivePtr tileImage = new ImagePrimitive( window, window );
+					for( std::vector<std::string>::const_iterator it = m_channelNames.begin(), eIt = m_channelNames.end(); it != eIt; ++it )
+					{
+						// ImagePrimitives are Y-down, so we flip the rows as we copy.
+						ConstFloatVectorDataPtr channelData = m_image->channelData( *it, m_tileOrigins[i] );
+						const std::vector<float> &in = channelData->readable();
+						FloatVectorDataPtr outData = new FloatVectorData;
+						std::vector<float> &out = outData->writable();
+						out.resize( tileSize * tileSize );
+						for( int y = 0; y < tileSize; ++y )
+						{
+							std::copy( in.begin() + y * tileSize, in.begin() + ( y + 1 ) * tileSize, out.begin() + ( tileSize - y - 1 ) * tileSize );
+						}
+						tileImage->variables[*it] = PrimitiveVariable( PrimitiveVariable::Vertex, outData );
+					}
+					m_tiles[i]->image = tileImage;
+				}
+			}
+			
+			private :
+			
+				const ImagePlug *m_image;
+				const std::vector<std::string> &m_channelNames;
+				const Context *m_context;
+				const std::vector<V2i> &m_tileOrigins;
+				std::vector<Tile *> &m_tiles;
+		};
+
 		Imath::Box3f m_displayBound;
 		Imath::Box3f m_dataBound;
+		/// Display and data windows in the Y-down space
+		/// of ImagePlug::image().
 		Imath::Box2i m_displayWindow;
 		Imath::Box2i m_dataWindow;
-		ConstImagePrimitivePtr m_image;
-		mutable ConstTexturePtr m_texture;
+		
+		GafferImage::Format m_format;
+		/// The data window in the Y-up space of the ImagePlug.
+		Imath::Box2i m_imageDataWindow;
+		std::vector<std::string> m_channelNames;
+		TileMap m_tiles;
+		unsigned m_generation;
 
 		Imath::V2f &m_mousePos;
 		Imath::V3f m_dragStartPosition;
@@ -897,6 +1301,35 @@ class ImageViewGadget : public GafferUI::Gadget
 
 IE_CORE_DECLAREPTR( ImageViewGadget );
 
+/// Computes the channel data for a number of tiles in parallel, discarding
+/// the results - we're only interested in getting them into the cache.
+struct PrefetchTiles
+{
+	PrefetchTiles( const ImagePlug *image, const std::vector<std::string> &channelNames, const Context *context, const std::vector<V2i> &tileOrigins )
+		:	m_image( image ), m_channelNames( channelNames ), m_context( context ), m_tileOrigins( tileOrigins )
+	{
+	}
+	
+	void operator()( const tbb::blocked_range<size_t> &r ) const
+	{
+		Context::Scope scope( m_context );
+		for( size_t i = r.begin(); i != r.end(); ++i )
+		{
+			for( std::vector<std::string>::const_iterator it = m_channelNames.begin(), eIt = m_channelNames.end(); it != eIt; ++it )
+			{
+				m_image->channelData( *it, m_tileOrigins[i] );
+			}
+		}
+	}
+	
+	private :
+	
+		const ImagePlug *m_image;
+		const std::vector<std::string> &m_channelNames;
+		const Context *m_context;
+		const std::vector<V2i> &m_tileOrigins;
+};
+
 }; // namespace Detail
 
 }; // namespace GafferImageUI
@@ -911,6 +1344,11 @@ ImageView::ViewDescription<ImageView> ImageView::g_viewDescription( GafferImage:
 
 ImageView::ImageView( const std::string &name )
 	:	View( name, new GafferImage::ImagePlug() ),
+		m_imageDirty( true ),
+		m_frame( 0 ),
+		m_prefetchDirection( 0 ),
+		m_prefetchOffset( 1 ),
+		m_prefetchTileIndex( 0 ),
 		m_channelToView( 0 ),
 		m_mousePos( Imath::V2f( 0.0f ) ),
 		m_sampleColor( Imath::Color4f( 0.0f ) ),
@@ -964,6 +1402,9 @@ ImageView::ImageView( const std::string &name )
 	addChild( gammaPlug );
 
 	addChild( new StringPlug( "displayTransform", Plug::In, "Default", Plug::Default & ~Plug::AcceptsInputs ) );
+	
+	addChild( new IntPlug( "prefetchFrames", Plug::In, 12, 0, Imath::limits<int>::max(), Plug::Default & ~Plug::AcceptsInputs ) );
+	addChild( new IntPlug( "prefetchMemory", Plug::In, 1024, 0, Imath::limits<int>::max(), Plug::Default & ~Plug::AcceptsInputs ) );
 
 	ImagePlugPtr preprocessorOutput = new ImagePlug( "out", Plug::Out );
 	preprocessor->addChild( preprocessorOutput );
@@ -976,6 +1417,8 @@ ImageView::ImageView( const std::string &name )
 	// connect up to some signals
 	
 	plugSetSignal().connect( boost::bind( &ImageView::plugSet, this, ::_1 ) );
+	viewportGadget()->viewportChangedSignal().connect( boost::bind( &ImageView::viewportChanged, this ) );
+	viewportGadget()->cameraChangedSignal().connect( boost::bind( &ImageView::viewportChanged, this ) );
 
 	// get our display transform right
 	
@@ -1057,6 +1500,26 @@ const Gaffer::StringPlug *ImageView::displayTransformPlug() const
 {
 	return getChild<StringPlug>( "displayTransform" );
 }
+
+Gaffer::IntPlug *ImageView::prefetchFramesPlug()
+{
+	return getChild<IntPlug>( "prefetchFrames" );
+}
+
+const Gaffer::IntPlug *ImageView::prefetchFramesPlug() const
+{
+	return getChild<IntPlug>( "prefetchFrames" );
+}
+
+Gaffer::IntPlug *ImageView::prefetchMemoryPlug()
+{
+	return getChild<IntPlug>( "prefetchMemory" );
+}
+
+const Gaffer::IntPlug *ImageView::prefetchMemoryPlug() const
+{
+	return getChild<IntPlug>( "prefetchMemory" );
+}
 				
 GafferImage::ImageStats *ImageView::imageStatsNode()
 {
@@ -1101,14 +1564,148 @@ const GafferImage::Grade *ImageView::gradeNode() const
 void ImageView::update()
 {
 	Context::Scope context( getContext() );
-	ConstImagePrimitivePtr image = preprocessedInPlug<ImagePlug>()->image();
+	const ImagePlug *image = preprocessedInPlug<ImagePlug>();
+	m_frame = getContext()->getFrame();
 
-	Detail::ImageViewGadgetPtr imageViewGadget = new Detail::ImageViewGadget( image, imageStatsNode(), imageSamplerNode(), m_channelToView, m_mousePos, m_sampleColor, m_minColor, m_maxColor, m_averageColor );
-	bool hadChild = viewportGadget()->getPrimaryChild();
-	viewportGadget()->setPrimaryChild( imageViewGadget );
-	if( !hadChild )
+	bool framingRequired = false;
+	if( !m_imageViewGadget )
+	{
+		m_imageViewGadget = new Detail::ImageViewGadget( imageStatsNode(), imageSamplerNode(), m_channelToView, m_mousePos, m_sampleColor, m_minColor, m_maxColor, m_averageColor );
+		framingRequired = !viewportGadget()->getPrimaryChild();
+		viewportGadget()->setPrimaryChild( m_imageViewGadget );
+	}
+	
+	if( m_imageDirty )
+	{
+		// Clear the flag first, so that if the image is dirtied again
+		// while we're computing, we'll come back for another go.
+		m_imageDirty = false;
+		m_imageViewGadget->imageChanged( image );
+		if( framingRequired )
+		{
+			viewportGadget()->frame( m_imageViewGadget->bound() );
+		}
+	}
+	
+	// Rather than compute all the visible tiles in one go, we compute
+	// a batch at a time, requesting another update until we're done.
+	// This allows the image to be drawn progressively, and keeps the
+	// UI responsive in the meantime. Once the current frame is complete
+	// we use the same mechanism to prefetch the frames ahead of it.
+	if( !m_imageViewGadget->updateTiles( image ) || prefetch() )
+	{
+		updateRequestSignal()( this );
+	}
+}
+
+void ImageView::contextChanged( const IECore::InternedString &name )
+{
+	m_imageDirty = true;
+	
+	const float frame = getContext()->getFrame();
+	if( name == "frame" && frame != m_frame )
+	{
+		const int direction = frame > m_frame ? 1 : -1;
+		if( direction == m_prefetchDirection )
+		{
+			// Frames we've already prefetched are now closer to
+			// the current frame, so we needn't start again.
+			m_prefetchOffset = std::max( 1, m_prefetchOffset - (int)fabs( frame - m_frame ) );
+			m_prefetchTileIndex = 0;
+		}
+		else
+		{
+			// Cancel the prefetch in the old direction.
+			m_prefetchDirection = direction;
+			resetPrefetch();
+		}
+		m_frame = frame;
+	}
+	else
+	{
+		resetPrefetch();
+	}
+	
+	View::contextChanged( name );
+}
+
+void ImageView::plugDirtied( const Gaffer::Plug *plug )
+{
+	if( plug == preprocessedInPlug<ImagePlug>() )
+	{
+		m_imageDirty = true;
+		resetPrefetch();
+	}
+	View::plugDirtied( plug );
+}
+
+bool ImageView::prefetch()
+{
+	// We only prefetch once the frame has been changed, which gives
+	// us the direction of playback.
+	if( !m_prefetchDirection || m_prefetchOffset > prefetchFramesPlug()->getValue() )
+	{
+		return false;
+	}
+	
+	ContextPtr context = new Context( *getContext() );
+	context->setFrame( m_frame + m_prefetchDirection * m_prefetchOffset );
+	Context::Scope scope( context.get() );
+	
+	const ImagePlug *image = preprocessedInPlug<ImagePlug>();
+	std::vector<V2i> tileOrigins;
+	std::vector<std::string> channelNames;
+	m_imageViewGadget->visibleTiles( image, tileOrigins, channelNames );
+	if( tileOrigins.empty() || channelNames.empty() )
+	{
+		return false;
+	}
+	
+	// Stay within the memory budget, and well within the cache limit so
+	// that prefetched frames aren't evicted before we get to view them.
+	const size_t bytesPerFrame = tileOrigins.size() * channelNames.size() * ImagePlug::tileSize() * ImagePlug::tileSize() * sizeof( float );
+	const size_t budget = std::min( (size_t)prefetchMemoryPlug()->getValue() * 1024 * 1024, ValuePlug::getCacheMemoryLimit() / 2 );
+	if( bytesPerFrame * m_prefetchOffset > budget )
+	{
+		return false;
+	}
+	
+	// We compute only a single tile per core in each call, as unlike the
+	// visible tiles, nobody is waiting for these, and we don't want to
+	// delay the processing of UI events any more than necessary.
+	static const size_t batchSize = tbb::task_scheduler_init::default_num_threads();
+	const size_t begin = std::min( m_prefetchTileIndex, tileOrigins.size() );
+	const size_t end = std::min( begin + batchSize, tileOrigins.size() );
+	const std::vector<V2i> batch( tileOrigins.begin() + begin, tileOrigins.begin() + end );
+	tbb::parallel_for(
+		tbb::blocked_range<size_t>( 0, batch.size() ),
+		Detail::PrefetchTiles( image, channelNames, context.get(), batch )
+	);
+	
+	m_prefetchTileIndex = end;
+	if( end == tileOrigins.size() )
+	{
+		m_prefetchOffset++;
+		m_prefetchTileIndex = 0;
+	}
+	
+	return true;
+}
+
+void ImageView::resetPrefetch()
+{
+	m_prefetchOffset = 1;
+	m_prefetchTileIndex = 0;
+}
+
+void ImageView::viewportChanged()
+{
+	// Panning or zooming may reveal tiles we haven't computed yet,
+	// for this frame or those we've prefetched.
+	resetPrefetch();
+	if( m_imageViewGadget )
 	{
-		viewportGadget()->frame( imageViewGadget->bound() );
+		updateRequestSignal()( this );
 	}
 }
 
@@ -34,6 +34,11 @@
 //  
 //////////////////////////////////////////////////////////////////////////
 
+#include <set>
+#include <algorithm>
+
+#include "tbb/spin_mutex.h"
+
 #include "IECore/CompoundData.h"
 
 #include "Gaffer/Context.h"
@@ -54,6 +59,47 @@ using namespace GafferOSL;
 
 IE_CORE_DEFINERUNTIMETYPED( OSLImage );
 
+// The channel being computed when the shading plugs are evaluated, so that
+// only the part of the shading network needed for it is executed. The empty
+// string means that all outputs are required. We use our own variable rather
+// than the standard channel name variable, because that may be inherited
+// from a downstream computation when computing the channel names.
+static InternedString g_shadingChannelNameContextName( "__oslImage:channelName" );
+
+static OSLRenderer::ConstShadingEnginePtr shadingEngine( const Plug *shaderPlug )
+{
+	if( const OSLShader *shader = runTimeCast<const OSLShader>( shaderPlug->source<Plug>()->node() ) )
+	{
+		return shader->shadingEngine();
+	}
+	return NULL;
+}
+
+// As above, but also returning the state hash for the shader, so that
+// callers needing both don't have to compute it twice.
+static OSLRenderer::ConstShadingEnginePtr shadingEngine( const Plug *shaderPlug, MurmurHash &stateHash )
+{
+	if( const OSLShader *shader = runTimeCast<const OSLShader>( shaderPlug->source<Plug>()->node() ) )
+	{
+		stateHash = shader->stateHash();
+		return shader->shadingEngine( stateHash );
+	}
+	return NULL;
+}
+
+static OSLRenderer::ShadingEngine::Outputs requestedOutputs( const OSLRenderer::ShadingEngine *shadingEngine, const Gaffer::Context *context )
+{
+	const std::string channelName = context->get<std::string>( g_shadingChannelNameContextName, "" );
+	if( channelName.empty() )
+	{
+		return shadingEngine->outputs();
+	}
+	
+	OSLRenderer::ShadingEngine::Outputs result;
+	result.insert( channelName );
+	return result;
+}
+
 size_t OSLImage::g_firstPlugIndex = 0;
 
 OSLImage::OSLImage( const std::string &name )
@@ -64,11 +110,12 @@ OSLImage::OSLImage( const std::string &name )
 	addChild( new Plug( "shader" ) );
 	
 	addChild( new Gaffer::ObjectPlug( "__shading", Gaffer::Plug::Out, new CompoundData() ) );
+	addChild( new Gaffer::ObjectPlug( "__batchShading", Gaffer::Plug::Out, new CompoundData() ) );
 
 	// we disable caching for the channel data plug, because our compute
 	// simply references data direct from the shading plug, which will itself
 	// be cached. we don't want to count the memory usage for that twice.
-	outPlug()->channelDataPlug()->setFlags( Plug::Cacheable, false );
+	channelDataStoragePlug()->setFlags( Plug::Cacheable, false );
 }
 
 OSLImage::~OSLImage()
@@ -94,12 +141,26 @@ const Gaffer::ObjectPlug *OSLImage::shadingPlug() const
 {
 	return getChild<ObjectPlug>( g_firstPlugIndex + 1 );
 }
+
+Gaffer::ObjectPlug *OSLImage::batchShadingPlug()
+{
+	return getChild<ObjectPlug>( g_firstPlugIndex + 2 );
+}
+
+const Gaffer::ObjectPlug *OSLImage::batchShadingPlug() const
+{
+	return getChild<ObjectPlug>( g_firstPlugIndex + 2 );
+}
 		
 void OSLImage::affects( const Gaffer::Plug *input, AffectedPlugsContainer &outputs ) const
 {
 	ImageProcessor::affects( input, outputs );
 	
 	if( input == shaderPlug() )
+	{
+		outputs.push_back( batchShadingPlug() );
+	}
+	else if( input == batchShadingPlug() )
 	{
 		outputs.push_back( shadingPlug() );
 	}
@@ -167,6 +228,10 @@ void OSLImage::hash( const Gaffer::ValuePlug *output, const Gaffer::Context *con
 	{
 		hashShading( context, h );
 	}
+	else if( output == batchShadingPlug() )
+	{
+		hashBatchShading( context, h );
+	}
 }
 
 void OSLImage::compute( Gaffer::ValuePlug *output, const Gaffer::Context *context ) const
@@ -176,6 +241,11 @@ void OSLImage::compute( Gaffer::ValuePlug *output, const Gaffer::Context *contex
 		static_cast<ObjectPlug *>( output )->setValue( computeShading( context ) );
 		return;
 	}
+	else if( output == batchShadingPlug() )
+	{
+		static_cast<ObjectPlug *>( output )->setValue( computeBatchShading( context ) );
+		return;
+	}
 	
 	ImageProcessor::compute( output, context );
 }
@@ -210,6 +280,7 @@ void OSLImage::hashChannelNames( const GafferImage::ImagePlug *output, const Gaf
 	{
 		ContextPtr c = new Context( *context, Context::Borrowed );
 		c->set( ImagePlug::tileOriginContextName, ImagePlug::tileOrigin( dataWindow.min ) );
+		c->set( g_shadingChannelNameContextName, std::string( "" ) );
 		Context::Scope s( c.get() );
 		shadingPlug()->hash( h );	
 	}
@@ -221,18 +292,10 @@ IECore::ConstStringVectorDataPtr OSLImage::computeChannelNames( const Gaffer::Co
 
 	set<string> result( channelNamesData->readable().begin(), channelNamesData->readable().end() );
 	
-	const Box2i dataWindow = inPlug()->dataWindowPlug()->getValue();
-	if( !dataWindow.isEmpty() )
+	ConstCompoundDataPtr shading = firstTileShading( context );
+	for( CompoundDataMap::const_iterator it = shading->readable().begin(), eIt = shading->readable().end(); it != eIt; ++it )
 	{
-		ContextPtr c = new Context( *context, Context::Borrowed );
-		c->set( ImagePlug::tileOriginContextName, ImagePlug::tileOrigin( dataWindow.min ) );
-		Context::Scope s( c.get() );
-	
-		ConstCompoundDataPtr shading = runTimeCast<const CompoundData>( shadingPlug()->getValue() );
-		for( CompoundDataMap::const_iterator it = shading->readable().begin(), eIt = shading->readable().end(); it != eIt; ++it )
-		{
-			result.insert( it->first );
-		}
+		result.insert( it->first );
 	}
 	
 	return new StringVectorData( vector<string>( result.begin(), result.end() ) );
@@ -240,14 +303,44 @@ IECore::ConstStringVectorDataPtr OSLImage::computeChannelNames( const Gaffer::Co
 
 void OSLImage::hashChannelData( const GafferImage::ImagePlug *output, const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {
+	const std::string &channelName = context->get<std::string>( ImagePlug::channelNameContextName );
+	
+	MurmurHash stateHash;
+	OSLRenderer::ConstShadingEnginePtr engine = shadingEngine( shaderPlug(), stateHash );
+	if( !shadesChannel( channelName, engine.get(), context ) )
+	{
+		// the shader doesn't write to this channel, so we can pass it
+		// through without doing any shading at all.
+		h = inPlug()->channelDataPlug()->hash();
+		return;
+	}
+	
 	ImageProcessor::hashChannelData( output, context, h );
-	h.append( context->get<std::string>( ImagePlug::channelNameContextName ) );
-	shadingPlug()->hash( h );
+	h.append( channelName );
+	
+	// we hash the shading directly rather than calling shadingPlug()->hash(),
+	// so that we can reuse the state hash computed above.
+	ContextPtr c = new Context( *context, Context::Borrowed );
+	c->set( g_shadingChannelNameContextName, channelName );
+	hashShading( c.get(), stateHash, engine.get(), h );
 }
 
 IECore::ConstFloatVectorDataPtr OSLImage::computeChannelData( const std::string &channelName, const Imath::V2i &tileOrigin, const Gaffer::Context *context, const GafferImage::ImagePlug *parent ) const
 {	
-	ConstCompoundDataPtr shadedPoints = runTimeCast<const CompoundData>( shadingPlug()->getValue() );
+	OSLRenderer::ConstShadingEnginePtr engine = shadingEngine( shaderPlug() );
+	if( !shadesChannel( channelName, engine.get(), context ) )
+	{
+		return inPlug()->channelDataPlug()->getValue();
+	}
+	
+	ConstCompoundDataPtr shadedPoints;
+	{
+		ContextPtr c = new Context( *context, Context::Borrowed );
+		c->set( g_shadingChannelNameContextName, channelName );
+		Context::Scope s( c.get() );
+		shadedPoints = runTimeCast<const CompoundData>( shadingPlug()->getValue() );
+	}
+	
 	ConstFloatVectorDataPtr result = shadedPoints->member<FloatVectorData>( channelName );
 	
 	if( !result )
@@ -258,44 +351,274 @@ IECore::ConstFloatVectorDataPtr OSLImage::computeChannelData( const std::string
 	return result;
 }
 
+IECore::ConstCompoundDataPtr OSLImage::firstTileShading( const Gaffer::Context *context ) const
+{
+	const Box2i dataWindow = inPlug()->dataWindowPlug()->getValue();
+	if( dataWindow.isEmpty() )
+	{
+		return static_cast<const CompoundData *>( shadingPlug()->defaultValue() );
+	}
+	
+	ContextPtr c = new Context( *context, Context::Borrowed );
+	c->set( ImagePlug::tileOriginContextName, ImagePlug::tileOrigin( dataWindow.min ) );
+	c->set( g_shadingChannelNameContextName, std::string( "" ) );
+	Context::Scope s( c.get() );
+	return runTimeCast<const CompoundData>( shadingPlug()->getValue() );
+}
+
+bool OSLImage::shadesChannel( const std::string &channelName, const OSLRenderer::ShadingEngine *engine, const Gaffer::Context *context ) const
+{
+	if( !engine )
+	{
+		return false;
+	}
+	
+	if( engine->outputs().count( channelName ) )
+	{
+		return true;
+	}
+	
+	// the outputs() are determined by shading a single point, so may not include
+	// outputs the shader only writes for some points. computeChannelNames() lists
+	// the outputs from shading the first tile, so we must shade any channel it
+	// lists too, rather than passing the input through.
+	return firstTileShading( context )->readable().count( channelName );
+}
+
+// The number of tiles along each side of a batch.
+static const int g_tilesPerBatch = 4;
+
+static int batchOrigin( int tileOrigin )
+{
+	const int batchSize = ImagePlug::tileSize() * g_tilesPerBatch;
+	return tileOrigin < 0 && tileOrigin % batchSize != 0 ? ( tileOrigin / batchSize - 1 ) * batchSize : ( tileOrigin / batchSize ) * batchSize;
+}
+
+static V2i batchOrigin( const V2i &tileOrigin )
+{
+	return V2i( batchOrigin( tileOrigin.x ), batchOrigin( tileOrigin.y ) );
+}
+
+// Returns the range of tile origins (inclusive) to be shaded for the batch. We clip
+// to the data window because tiles outside it will never be requested.
+static Box2i batchTileOrigins( const V2i &batchOrigin, const Box2i &dataWindow )
+{
+	if( dataWindow.isEmpty() )
+	{
+		return Box2i();
+	}
+	
+	const V2i dataWindowMin = ImagePlug::tileOrigin( dataWindow.min );
+	const V2i dataWindowMax = ImagePlug::tileOrigin( dataWindow.max );
+	const V2i batchMax = batchOrigin + V2i( ( g_tilesPerBatch - 1 ) * ImagePlug::tileSize() );
+	
+	return Box2i(
+		V2i( std::max( batchOrigin.x, dataWindowMin.x ), std::max( batchOrigin.y, dataWindowMin.y ) ),
+		V2i( std::min( batchMax.x, dataWindowMax.x ), std::min( batchMax.y, dataWindowMax.y ) )
+	);
+}
+
+// The batches currently being computed. See computeShading().
+typedef std::set<IECore::MurmurHash> BatchSet;
+static BatchSet g_batchesInProgress;
+static tbb::spin_mutex g_batchesInProgressMutex;
+
+// Claims the right to compute a batch, if no other computation
+// of it is already in progress, releasing it on destruction.
+class BatchClaim
+{
+
+	public :
+	
+		BatchClaim( const MurmurHash &batchId )
+			:	m_batchId( batchId )
+		{
+			tbb::spin_mutex::scoped_lock lock( g_batchesInProgressMutex );
+			m_acquired = g_batchesInProgress.insert( m_batchId ).second;
+		}
+		
+		~BatchClaim()
+		{
+			if( m_acquired )
+			{
+				tbb::spin_mutex::scoped_lock lock( g_batchesInProgressMutex );
+				g_batchesInProgress.erase( m_batchId );
+			}
+		}
+		
+		bool acquired() const
+		{
+			return m_acquired;
+		}
+		
+	private :
+	
+		MurmurHash m_batchId;
+		bool m_acquired;
+
+};
+
 void OSLImage::hashShading( const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {
+	MurmurHash stateHash;
+	OSLRenderer::ConstShadingEnginePtr engine = shadingEngine( shaderPlug(), stateHash );
+	hashShading( context, stateHash, engine.get(), h );
+}
+
+void OSLImage::hashShading( const Gaffer::Context *context, const IECore::MurmurHash &stateHash, const OSLRenderer::ShadingEngine *engine, IECore::MurmurHash &h ) const
+{
+	// each point is shaded independently of all others, so the shading for
+	// a tile depends only on the inputs for that tile, regardless of whether
+	// it is extracted from a batch or shaded on its own. we therefore hash
+	// only the inputs for our tile, and leave it to hashBatchShading() to hash
+	// those of the whole batch.
 	const V2i tileOrigin = context->get<V2i>( ImagePlug::tileOriginContextName );
-	h.append( tileOrigin );
+	const V2i origin = batchOrigin( tileOrigin );
+	h.append( origin );
+	h.append( ( tileOrigin - origin ) / ImagePlug::tileSize() );
 	inPlug()->formatPlug()->hash( h );
+	inPlug()->dataWindowPlug()->hash( h );
 	
 	ConstStringVectorDataPtr channelNamesData = inPlug()->channelNamesPlug()->getValue();
 	const vector<string> &channelNames = channelNamesData->readable();
 	for( vector<string>::const_iterator it = channelNames.begin(), eIt = channelNames.end(); it != eIt; ++it )
 	{
+		h.append( *it );
 		h.append( inPlug()->channelDataHash( *it, tileOrigin ) );
 	}
+	
+	hashShadingState( context, stateHash, engine, h );
+}
 
-	const OSLShader *shader = runTimeCast<const OSLShader>( shaderPlug()->source<Plug>()->node() );
-	if( shader )
+IECore::ConstCompoundDataPtr OSLImage::computeShading( const Gaffer::Context *context ) const
+{
+	const V2i tileOrigin = context->get<V2i>( ImagePlug::tileOriginContextName );
+	const V2i origin = batchOrigin( tileOrigin );
+	
+	const Box2i tiles = batchTileOrigins( origin, inPlug()->dataWindowPlug()->getValue() );
+	if( !tiles.intersects( tileOrigin ) )
 	{
-		shader->stateHash( h );
+		return static_cast<const CompoundData *>( shadingPlug()->defaultValue() );
 	}
+	
+	ConstCompoundDataPtr batchShading;
+	{
+		ContextPtr c = new Context( *context, Context::Borrowed );
+		c->set( ImagePlug::tileOriginContextName, origin );
+		Context::Scope s( c.get() );
+		
+		// only one thread computes any given batch at a time. rather than wait
+		// for another thread's computation to complete, which would risk deadlock
+		// because that thread may be waiting in turn for TBB tasks which we would
+		// need to run, we just shade our own tile. this bounds the duplicated work
+		// to a single tile per thread, rather than a whole batch. we identify the
+		// batch by the node and the context it will be computed in, rather than by
+		// batchShadingPlug()->hash(), because that would hash the inputs for every
+		// tile in the batch each time a tile is computed, even when the batch is
+		// already cached.
+		MurmurHash batchId = c->hash();
+		batchId.append( (uint64_t)this );
+		BatchClaim claim( batchId );
+		if( !claim.acquired() )
+		{
+			return shade( Box2i( tileOrigin ), context );
+		}
+		batchShading = runTimeCast<const CompoundData>( batchShadingPlug()->getValue() );
+	}
+	
+	if( batchShading->readable().empty() )
+	{
+		return batchShading;
+	}
+	
+	// the batch stores the points for each tile contiguously, one tile after
+	// another, so we just need to copy out the range belonging to our tile.
+	
+	const int tileSize = ImagePlug::tileSize();
+	const size_t numTilesX = ( tiles.max.x - tiles.min.x ) / tileSize + 1;
+	const size_t tileIndex = ( ( tileOrigin.y - tiles.min.y ) / tileSize ) * numTilesX + ( tileOrigin.x - tiles.min.x ) / tileSize;
+	const size_t begin = tileIndex * tileSize * tileSize;
+	const size_t end = begin + tileSize * tileSize;
+	
+	CompoundDataPtr result = new CompoundData;
+	for( CompoundDataMap::const_iterator it = batchShading->readable().begin(), eIt = batchShading->readable().end(); it != eIt; ++it )
+	{
+		const vector<float> &batchValues = static_cast<const FloatVectorData *>( it->second.get() )->readable();
+		FloatVectorDataPtr tileData = ImagePlug::allocateTile();
+		std::copy( batchValues.begin() + begin, batchValues.begin() + end, tileData->writable().begin() );
+		result->writable()[it->first] = tileData;
+	}
+	
+	return result;
 }
 
-IECore::ConstCompoundDataPtr OSLImage::computeShading( const Gaffer::Context *context ) const
+void OSLImage::hashBatchShading( const Gaffer::Context *context, IECore::MurmurHash &h ) const
 {
-	OSLRenderer::ConstShadingEnginePtr shadingEngine;
-	if( const OSLShader *shader = runTimeCast<const OSLShader>( shaderPlug()->source<Plug>()->node() ) )
+	const V2i origin = context->get<V2i>( ImagePlug::tileOriginContextName );
+	h.append( origin );
+	inPlug()->formatPlug()->hash( h );
+	inPlug()->dataWindowPlug()->hash( h );
+	
+	const Box2i tiles = batchTileOrigins( origin, inPlug()->dataWindowPlug()->getValue() );
+	
+	ConstStringVectorDataPtr channelNamesData = inPlug()->channelNamesPlug()->getValue();
+	const vector<string> &channelNames = channelNamesData->readable();
+	const int tileSize = ImagePlug::tileSize();
+	for( int y = tiles.min.y; y <= tiles.max.y; y += tileSize )
 	{
-		shadingEngine = shader->shadingEngine();
+		for( int x = tiles.min.x; x <= tiles.max.x; x += tileSize )
+		{
+			for( vector<string>::const_iterator it = channelNames.begin(), eIt = channelNames.end(); it != eIt; ++it )
+			{
+				h.append( *it );
+				h.append( inPlug()->channelDataHash( *it, V2i( x, y ) ) );
+			}
+		}
 	}
+
+	MurmurHash stateHash;
+	OSLRenderer::ConstShadingEnginePtr engine = shadingEngine( shaderPlug(), stateHash );
+	hashShadingState( context, stateHash, engine.get(), h );
+}
+
+void OSLImage::hashShadingState( const Gaffer::Context *context, const IECore::MurmurHash &stateHash, const OSLRenderer::ShadingEngine *engine, IECore::MurmurHash &h ) const
+{
+	if( !engine )
+	{
+		return;
+	}
+	
+	h.append( stateHash );
 	
-	if( !shadingEngine )
+	// outputs computed together share the same shading, so we hash the
+	// outputs that will be computed rather than the requested channel.
+	const OSLRenderer::ShadingEngine::Outputs &outputs = engine->computedOutputs( requestedOutputs( engine, context ) );
+	for( OSLRenderer::ShadingEngine::Outputs::const_iterator it = outputs.begin(), eIt = outputs.end(); it != eIt; ++it )
 	{
-		return static_cast<const CompoundData *>( shadingPlug()->defaultValue() );	
+		h.append( *it );
 	}
-			
-	const V2i tileOrigin = context->get<V2i>( ImagePlug::tileOriginContextName );
+}
+
+IECore::ConstCompoundDataPtr OSLImage::computeBatchShading( const Gaffer::Context *context ) const
+{
+	const V2i origin = context->get<V2i>( ImagePlug::tileOriginContextName );
+	return shade( batchTileOrigins( origin, inPlug()->dataWindowPlug()->getValue() ), context );
+}
+
+IECore::ConstCompoundDataPtr OSLImage::shade( const Imath::Box2i &tiles, const Gaffer::Context *context ) const
+{
+	OSLRenderer::ConstShadingEnginePtr engine = shadingEngine( shaderPlug() );
+	if( !engine || tiles.isEmpty() )
+	{
+		return static_cast<const CompoundData *>( batchShadingPlug()->defaultValue() );	
+	}
+	
 	const Format format = inPlug()->formatPlug()->getValue();
 	
 	CompoundDataPtr shadingPoints = new CompoundData();
 
+	// these hold the points for the whole batch rather than a single tile,
+	// so we can't take them from ImagePlug::allocateTile().
 	V3fVectorDataPtr pData = new V3fVectorData;
 	FloatVectorDataPtr uData = new FloatVectorData;
 	FloatVectorDataPtr vData = new FloatVectorData;
@@ -304,10 +627,12 @@ IECore::ConstCompoundDataPtr OSLImage::computeShading( const Gaffer::Context *co
 	vector<float> &uWritable = uData->writable();
 	vector<float> &vWritable = vData->writable();
 	
-	const size_t tileSize = ImagePlug::tileSize();
-	pWritable.reserve( tileSize * tileSize );
-	uWritable.reserve( tileSize * tileSize );
-	vWritable.reserve( tileSize * tileSize );
+	const int tileSize = ImagePlug::tileSize();
+	const size_t numTiles = ( ( tiles.max.x - tiles.min.x ) / tileSize + 1 ) * ( ( tiles.max.y - tiles.min.y ) / tileSize + 1 );
+	const size_t numPoints = numTiles * tileSize * tileSize;
+	pWritable.reserve( numPoints );
+	uWritable.reserve( numPoints );
+	vWritable.reserve( numPoints );
 
 	/// \todo Non-zero display window origins - do we have those?
 	const float uStep = 1.0f / format.width();
@@ -316,16 +641,27 @@ IECore::ConstCompoundDataPtr OSLImage::computeShading( const Gaffer::Context *co
 	const float vStep = 1.0f / format.height();
 	const float vMin = 0.5f * vStep;
 	
-	const size_t xMax = tileOrigin.x + tileSize;
-	const size_t yMax = tileOrigin.y + tileSize;
-	for( size_t y = tileOrigin.y; y < yMax; ++y )
+	// the points for each tile are stored contiguously, so that
+	// computeShading() can extract the results for a tile from a
+	// batch as a single range, and so that input channel data can
+	// be appended a tile at a time.
+	
+	for( int tileY = tiles.min.y; tileY <= tiles.max.y; tileY += tileSize )
 	{
-		const float v = vMin + y * vStep;
-		for( size_t x = tileOrigin.x; x < xMax; ++x )
+		for( int tileX = tiles.min.x; tileX <= tiles.max.x; tileX += tileSize )
 		{
-			uWritable.push_back( uMin + x * uStep );
-			vWritable.push_back( v );
-			pWritable.push_back( V3f( x, y, 0.0f ) );
+			const int xMax = tileX + tileSize;
+			const int yMax = tileY + tileSize;
+			for( int y = tileY; y < yMax; ++y )
+			{
+				const float v = vMin + y * vStep;
+				for( int x = tileX; x < xMax; ++x )
+				{
+					uWritable.push_back( uMin + x * uStep );
+					vWritable.push_back( v );
+					pWritable.push_back( V3f( x, y, 0.0f ) );
+				}
+			}
 		}
 	}
 	
@@ -337,10 +673,21 @@ IECore::ConstCompoundDataPtr OSLImage::computeShading( const Gaffer::Context *co
 	const vector<string> &channelNames = channelNamesData->readable();
 	for( vector<string>::const_iterator it = channelNames.begin(), eIt = channelNames.end(); it != eIt; ++it )
 	{
-		shadingPoints->writable()[*it] = boost::const_pointer_cast<FloatVectorData>( inPlug()->channelData( *it, tileOrigin ) );
+		FloatVectorDataPtr channelData = new FloatVectorData;
+		vector<float> &channelDataWritable = channelData->writable();
+		channelDataWritable.reserve( numPoints );
+		for( int tileY = tiles.min.y; tileY <= tiles.max.y; tileY += tileSize )
+		{
+			for( int tileX = tiles.min.x; tileX <= tiles.max.x; tileX += tileSize )
+			{
+				ConstFloatVectorDataPtr tileData = inPlug()->channelData( *it, V2i( tileX, tileY ) );
+				channelDataWritable.insert( channelDataWritable.end(), tileData->readable().begin(), tileData->readable().end() );
+			}
+		}
+		shadingPoints->writable()[*it] = channelData;
 	}
 	
-	CompoundDataPtr result = shadingEngine->shade( shadingPoints.get() );
+	CompoundDataPtr result = engine->shade( shadingPoints.get(), requestedOutputs( engine.get(), context ) );
 	
 	// remove results that aren't suitable to become channels
 	for( CompoundDataMap::iterator it = result->writable().begin(); it != result->writable().end();  )
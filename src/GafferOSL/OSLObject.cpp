@@ -192,7 +192,12 @@ IECore::ConstObjectPtr OSLObject::computeProcessedObject( const ScenePath &path,
 
 	PrimitivePtr outputPrimitive = inputPrimitive->copy();
 
-	CompoundDataPtr shadedPoints = shadingEngine->shade( shadingPoints.get() );
+	// we don't use Ci, so we request only the other outputs, allowing the
+	// ShadingEngine to skip any parts of the network which only affect Ci.
+	OSLRenderer::ShadingEngine::Outputs outputs = shadingEngine->outputs();
+	outputs.erase( "Ci" );
+
+	CompoundDataPtr shadedPoints = shadingEngine->shade( shadingPoints.get(), outputs );
 	for( CompoundDataMap::const_iterator it = shadedPoints->readable().begin(), eIt = shadedPoints->readable().end(); it != eIt; ++it )
 	{
 		if( it->first != "Ci" )
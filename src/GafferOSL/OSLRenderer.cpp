@@ -34,10 +34,18 @@
 //  
 //////////////////////////////////////////////////////////////////////////
 
+#include <map>
+#include <algorithm>
+
 #include "boost/algorithm/string/split.hpp"
 #include "boost/algorithm/string/predicate.hpp"
 #include "boost/algorithm/string/classification.hpp"
 
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
+#include "tbb/enumerable_thread_specific.h"
+#include "tbb/mutex.h"
+
 #include "OSL/oslclosure.h"
 #include "OSL/genclosure.h"
 #include "OSL/oslversion.h"
@@ -251,9 +259,9 @@ class OSLRenderer::RenderState
 			return ShadingSystem::convert_value( value, type, src, it->typeDesc );
 		}
 		
-		void incrementPointIndex()
+		void setPointIndex( size_t pointIndex )
 		{
-			m_pointIndex++;
+			m_pointIndex = pointIndex;
 		}
 
 	private :
@@ -727,30 +735,137 @@ static void declareConnections( const std::string &shaderHandle, const CompoundD
 	}	
 }
 						
-OSLRenderer::ShadingEnginePtr OSLRenderer::shadingEngine() const
+static OSL::ShadingAttribStateRef declareShaderGroup( const vector<ConstShaderPtr> &shaders, const IECore::Shader *surfaceShader, const CompoundDataMap &surfaceParameters, ShadingSystem *shadingSystem )
 {
-	const State &state = m_stateStack.top();
+	shadingSystem->ShaderGroupBegin();
 
-	m_shadingSystem->ShaderGroupBegin();
-
-		for( vector<ConstShaderPtr>::const_iterator it = state.shaders.begin(), eIt = state.shaders.end(); it != eIt; ++it )
+		for( vector<ConstShaderPtr>::const_iterator it = shaders.begin(), eIt = shaders.end(); it != eIt; ++it )
 		{
-			declareParameters( (*it)->parameters(), m_shadingSystem.get() );
+			declareParameters( (*it)->parameters(), shadingSystem );
 			const StringData *handle = (*it)->parametersData()->member<StringData>( "__handle" );
-			m_shadingSystem->Shader( "surface", (*it)->getName().c_str(), handle ? handle->readable().c_str() : NULL  );
+			shadingSystem->Shader( "surface", (*it)->getName().c_str(), handle ? handle->readable().c_str() : NULL  );
 			if( handle )
 			{
-				declareConnections( handle->readable(), (*it)->parameters(), m_shadingSystem.get() );
+				declareConnections( handle->readable(), (*it)->parameters(), shadingSystem );
 			}
 		}
 
-		declareParameters( state.surfaceShader->parameters(), m_shadingSystem.get() );
-		m_shadingSystem->Shader( "surface", state.surfaceShader->getName().c_str(), "oslRenderer:surface" );
-		declareConnections( "oslRenderer:surface", state.surfaceShader->parameters(), m_shadingSystem.get() );
+		declareParameters( surfaceParameters, shadingSystem );
+		shadingSystem->Shader( "surface", surfaceShader->getName().c_str(), "oslRenderer:surface" );
+		declareConnections( "oslRenderer:surface", surfaceParameters, shadingSystem );
 
-	m_shadingSystem->ShaderGroupEnd();
+	shadingSystem->ShaderGroupEnd();
+	
+	return shadingSystem->state();
+}
 
-	return new ShadingEngine( this, m_shadingSystem->state() );
+// Returns the handle of the shader a parameter is linked to, or
+// the empty string if it isn't linked.
+static std::string linkedHandle( const Data *value )
+{
+	if( value->typeId() != StringDataTypeId )
+	{
+		return "";
+	}
+	const std::string &s = static_cast<const StringData *>( value )->readable();
+	if( !boost::starts_with( s, "link:" ) )
+	{
+		return "";
+	}
+	return s.substr( 5, s.find( '.' ) - 5 );
+}
+
+static size_t component( vector<size_t> &parents, size_t i )
+{
+	while( parents[i] != i )
+	{
+		parents[i] = parents[parents[i]];
+		i = parents[i];
+	}
+	return i;
+}
+
+OSLRenderer::ShadingEnginePtr OSLRenderer::shadingEngine() const
+{
+	const State &state = m_stateStack.top();
+
+	OSL::ShadingAttribStateRef shadingState = declareShaderGroup( state.shaders, state.surfaceShader.get(), state.surfaceShader->parameters(), m_shadingSystem.get() );
+	
+	// find the connected components of the shading network, so we can
+	// declare a separate group for each of the independent parts feeding
+	// into the surface shader. the ShadingEngine can then prune the network
+	// by executing only the parts needed for particular outputs.
+
+	map<string, size_t> handleIndices;
+	for( size_t i = 0; i < state.shaders.size(); ++i )
+	{
+		if( const StringData *handle = state.shaders[i]->parametersData()->member<StringData>( "__handle" ) )
+		{
+			handleIndices[handle->readable()] = i;
+		}
+	}
+	
+	vector<size_t> parents( state.shaders.size() );
+	for( size_t i = 0; i < parents.size(); ++i )
+	{
+		parents[i] = i;
+	}
+	
+	for( size_t i = 0; i < state.shaders.size(); ++i )
+	{
+		const CompoundDataMap &parameters = state.shaders[i]->parameters();
+		for( CompoundDataMap::const_iterator it = parameters.begin(), eIt = parameters.end(); it != eIt; ++it )
+		{
+			map<string, size_t>::const_iterator hIt = handleIndices.find( linkedHandle( it->second.get() ) );
+			if( hIt != handleIndices.end() )
+			{
+				parents[component( parents, i )] = component( parents, hIt->second );
+			}
+		}
+	}
+	
+	// map from component to the surface parameters linked to it
+	map<size_t, vector<InternedString> > surfaceLinks;
+	const CompoundDataMap &surfaceParameters = state.surfaceShader->parameters();
+	for( CompoundDataMap::const_iterator it = surfaceParameters.begin(), eIt = surfaceParameters.end(); it != eIt; ++it )
+	{
+		map<string, size_t>::const_iterator hIt = handleIndices.find( linkedHandle( it->second.get() ) );
+		if( hIt != handleIndices.end() )
+		{
+			surfaceLinks[component( parents, hIt->second )].push_back( it->first );
+		}
+	}
+	
+	vector<OSL::ShadingAttribStateRef> partitionShadingStates;
+	if( surfaceLinks.size() > 1 )
+	{
+		for( map<size_t, vector<InternedString> >::const_iterator it = surfaceLinks.begin(), eIt = surfaceLinks.end(); it != eIt; ++it )
+		{
+			vector<ConstShaderPtr> partitionShaders;
+			for( size_t i = 0; i < state.shaders.size(); ++i )
+			{
+				if( component( parents, i ) == it->first )
+				{
+					partitionShaders.push_back( state.shaders[i] );
+				}
+			}
+			
+			CompoundDataMap partitionSurfaceParameters;
+			for( CompoundDataMap::const_iterator pIt = surfaceParameters.begin(), peIt = surfaceParameters.end(); pIt != peIt; ++pIt )
+			{
+				if( linkedHandle( pIt->second.get() ).empty() || std::find( it->second.begin(), it->second.end(), pIt->first ) != it->second.end() )
+				{
+					partitionSurfaceParameters.insert( *pIt );
+				}
+			}
+			
+			partitionShadingStates.push_back(
+				declareShaderGroup( partitionShaders, state.surfaceShader.get(), partitionSurfaceParameters, m_shadingSystem.get() )
+			);
+		}
+	}
+
+	return new ShadingEngine( this, shadingState, partitionShadingStates );
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -773,6 +888,8 @@ class OSLRenderer::ShadingResults
 			m_results->writable()["Ci"] = ciData;
 		}
 		
+		/// May be called concurrently from multiple threads, provided
+		/// that each call is for a different pointIndex.
 		void addResult( size_t pointIndex, const ClosureColor *result )
 		{
 			addResult( pointIndex, result, Color3f( 1.0f ) );
@@ -785,6 +902,32 @@ class OSLRenderer::ShadingResults
 
 	private :
 
+		/// \todo This is a lot like the UserData struct above - maybe we should
+		/// just have one type we can use for both?
+		struct DebugResult
+		{
+			DebugResult()
+				:	basePointer( NULL )
+			{
+			}
+		
+			ustring name;
+			TypeDesc type;
+			void *basePointer;
+			
+			bool operator < ( const DebugResult &rhs ) const
+			{
+				return name.c_str() < rhs.name.c_str();
+			}
+			
+			bool operator < ( const ustring &rhs ) const
+			{
+				return name.c_str() < rhs.c_str();
+			}
+		};
+		
+		typedef vector<DebugResult> DebugResults; // sorted on name for quick lookups
+
 		const ClosureComponent::Attr *attr( const ClosureComponent *closure, ustring key )
 		{
 			const ClosureComponent::Attr *a = closure->attrs();
@@ -843,15 +986,54 @@ class OSLRenderer::ShadingResults
 		}
 		
 		void addDebug( size_t pointIndex, const ClosureComponent *closure, const Color3f &weight )
+		{
+			const DebugResult &result = debugResult( closure );
+			
+			Color3f value = weight;
+			if( const ClosureComponent::Attr *valueAttr = attr( closure, DebugParameters::valueAttrKey ) )
+			{
+				value *= valueAttr->color();
+			}
+			
+			char *dst = static_cast<char *>( result.basePointer );
+			dst += pointIndex * result.type.elementsize();
+			ShadingSystem::convert_value(
+				dst,
+				result.type,
+				&value,
+				result.type.aggregate == TypeDesc::SCALAR ? TypeDesc::TypeFloat : TypeDesc::TypeColor
+			);
+		}
+		
+		// Returns the DebugResult for the closure, allocating storage for it if
+		// no thread has encountered it before. Lookups go to a per-thread copy of
+		// the results first, so the mutex is only taken the first time each thread
+		// sees a particular name, and not once per point.
+		const DebugResult &debugResult( const ClosureComponent *closure )
 		{
 			const DebugParameters *parameters = static_cast<const DebugParameters *>( closure->data() );
-			vector<DebugResult>::iterator it = lower_bound(
+			
+			DebugResults &threadDebugResults = m_threadDebugResults.local();
+			DebugResults::iterator it = lower_bound(
+				threadDebugResults.begin(),
+				threadDebugResults.end(),
+				parameters->name
+			);
+			
+			if( it != threadDebugResults.end() && it->name == parameters->name )
+			{
+				return *it;
+			}
+			
+			tbb::mutex::scoped_lock lock( m_debugResultsMutex );
+			
+			DebugResults::iterator sharedIt = lower_bound(
 				m_debugResults.begin(),
 				m_debugResults.end(),
 				parameters->name
 			);
 			
-			if( it == m_debugResults.end() || it->name != parameters->name )
+			if( sharedIt == m_debugResults.end() || sharedIt->name != parameters->name )
 			{
 				DebugResult result;
 				result.name = parameters->name;
@@ -868,62 +1050,99 @@ class OSLRenderer::ShadingResults
 				}
 				result.type.unarray(); // so we can use convert_value
 				m_results->writable()[result.name.c_str()] = data;
-				it = m_debugResults.insert( it, result );
+				sharedIt = m_debugResults.insert( sharedIt, result );
 			}
 			
-			Color3f value = weight;
-			if( const ClosureComponent::Attr *valueAttr = attr( closure, DebugParameters::valueAttrKey ) )
-			{
-				value *= valueAttr->color();
-			}
-			
-			char *dst = static_cast<char *>( it->basePointer );
-			dst += pointIndex * it->type.elementsize();
-			ShadingSystem::convert_value(
-				dst,
-				it->type,
-				&value,
-				it->type.aggregate == TypeDesc::SCALAR ? TypeDesc::TypeFloat : TypeDesc::TypeColor
-			);
+			return *threadDebugResults.insert( it, *sharedIt );
 		}
+		
+		CompoundDataPtr m_results;
+		vector<Color3f> *m_ci;
+		
+		DebugResults m_debugResults;
+		tbb::mutex m_debugResultsMutex;
+		tbb::enumerable_thread_specific<DebugResults> m_threadDebugResults;
+		
+};
 
-		/// \todo This is a lot like the UserData struct above - maybe we should
-		/// just have one type we can use for both?
-		struct DebugResult
+//////////////////////////////////////////////////////////////////////////
+// OSLRenderer::ShadeTask
+//////////////////////////////////////////////////////////////////////////
+
+// Shades a range of points. Each invocation gets its own ShadingContext,
+// ShaderGlobals and RenderState, so invocations may run concurrently.
+class OSLRenderer::ShadeTask
+{
+
+	public :
+
+		ShadeTask( ShadingSystem *shadingSystem, ShadingAttribState *shadingState, const ShaderGlobals &shaderGlobals, const RenderState &renderState, const OSL::Vec3 *p, const float *u, const float *v, const V3f *n, ShadingResults &results )
+			:	m_shadingSystem( shadingSystem ), m_shadingState( shadingState ), m_shaderGlobals( shaderGlobals ), m_renderState( renderState ), m_p( p ), m_u( u ), m_v( v ), m_n( n ), m_results( results )
 		{
-			DebugResult()
-				:	basePointer( NULL )
-			{
-			}
-		
-			ustring name;
-			TypeDesc type;
-			void *basePointer;
-			
-			bool operator < ( const DebugResult &rhs ) const
-			{
-				return name.c_str() < rhs.name.c_str();
-			}
-			
-			bool operator < ( const ustring &rhs ) const
+		}
+	
+		void operator()( const tbb::blocked_range<size_t> &range ) const
+		{
+			ShaderGlobals shaderGlobals = m_shaderGlobals;
+			RenderState renderState = m_renderState;
+			shaderGlobals.renderstate = &renderState;
+	
+			ShadingContext *shadingContext = m_shadingSystem->get_context();
+			for( size_t i = range.begin(); i < range.end(); ++i )
 			{
-				return name.c_str() < rhs.c_str();
-			}
-		};
+				shaderGlobals.P = m_p[i];
+				if( m_u )
+				{
+					shaderGlobals.u = m_u[i];
+				}
+				if( m_v )
+				{
+					shaderGlobals.v = m_v[i];
+				}
+				if( m_n )
+				{
+					shaderGlobals.N = m_n[i];
+				}
 		
-		CompoundDataPtr m_results;
-		vector<Color3f> *m_ci;
-		vector<DebugResult> m_debugResults; // sorted on name for quick lookups
+				shaderGlobals.Ci = NULL;
+				renderState.setPointIndex( i );
 		
+				m_shadingSystem->execute( *shadingContext, *m_shadingState, shaderGlobals );
+				m_results.addResult( i, shaderGlobals.Ci );
+			}
+			m_shadingSystem->release_context( shadingContext );
+		}
+	
+	private :
+	
+		ShadingSystem *m_shadingSystem;
+		ShadingAttribState *m_shadingState;
+		const ShaderGlobals &m_shaderGlobals;
+		const RenderState &m_renderState;
+		const OSL::Vec3 *m_p;
+		const float *m_u;
+		const float *m_v;
+		const V3f *m_n;
+		ShadingResults &m_results;
+
 };
 
 //////////////////////////////////////////////////////////////////////////
 // OSLRenderer::ShadingEngine
 //////////////////////////////////////////////////////////////////////////
 
-OSLRenderer::ShadingEngine::ShadingEngine( ConstOSLRendererPtr renderer, OSL::ShadingAttribStateRef shadingState )
+OSLRenderer::ShadingEngine::ShadingEngine( ConstOSLRendererPtr renderer, OSL::ShadingAttribStateRef shadingState, const std::vector<OSL::ShadingAttribStateRef> &partitionShadingStates )
 	:	m_renderer( renderer ), m_shadingState( shadingState )
 {
+	m_outputs = shadedOutputs( *m_shadingState );
+	
+	for( vector<OSL::ShadingAttribStateRef>::const_iterator it = partitionShadingStates.begin(), eIt = partitionShadingStates.end(); it != eIt; ++it )
+	{
+		Partition p;
+		p.shadingState = *it;
+		p.outputs = shadedOutputs( **it );
+		m_partitions.push_back( p );
+	}
 }
 
 template <typename T>
@@ -957,6 +1176,76 @@ static const T *varyingValue( const IECore::CompoundData *points, const char *na
 }
 
 IECore::CompoundDataPtr OSLRenderer::ShadingEngine::shade( const IECore::CompoundData *points ) const
+{
+	return shade( points, *m_shadingState );
+}
+
+IECore::CompoundDataPtr OSLRenderer::ShadingEngine::shade( const IECore::CompoundData *points, const Outputs &outputs ) const
+{
+	const Partition *p = partition( outputs );
+	return shade( points, p ? *p->shadingState : *m_shadingState );
+}
+
+const OSLRenderer::ShadingEngine::Outputs &OSLRenderer::ShadingEngine::outputs() const
+{
+	return m_outputs;
+}
+
+const OSLRenderer::ShadingEngine::Outputs &OSLRenderer::ShadingEngine::computedOutputs( const Outputs &outputs ) const
+{
+	const Partition *p = partition( outputs );
+	return p ? p->outputs : m_outputs;
+}
+
+const OSLRenderer::ShadingEngine::Partition *OSLRenderer::ShadingEngine::partition( const Outputs &outputs ) const
+{
+	for( vector<Partition>::const_iterator it = m_partitions.begin(), eIt = m_partitions.end(); it != eIt; ++it )
+	{
+		if( !std::includes( it->outputs.begin(), it->outputs.end(), outputs.begin(), outputs.end() ) )
+		{
+			continue;
+		}
+		
+		// an output produced by more than one partition depends on all
+		// of them, so we can only use this partition if it is the sole
+		// producer of each of the requested outputs.
+		for( vector<Partition>::const_iterator oIt = m_partitions.begin(); oIt != eIt; ++oIt )
+		{
+			if( oIt == it )
+			{
+				continue;
+			}
+			for( Outputs::const_iterator nIt = outputs.begin(), neIt = outputs.end(); nIt != neIt; ++nIt )
+			{
+				if( oIt->outputs.count( *nIt ) )
+				{
+					return NULL;
+				}
+			}
+		}
+		
+		return &(*it);
+	}
+	
+	return NULL;
+}
+
+OSLRenderer::ShadingEngine::Outputs OSLRenderer::ShadingEngine::shadedOutputs( OSL::ShadingAttribState &shadingState ) const
+{
+	CompoundDataPtr points = new CompoundData;
+	points->writable()["P"] = new V3fVectorData( vector<V3f>( 1, V3f( 0 ) ) );
+	
+	CompoundDataPtr shaded = shade( points.get(), shadingState );
+	
+	Outputs result;
+	for( CompoundDataMap::const_iterator it = shaded->readable().begin(), eIt = shaded->readable().end(); it != eIt; ++it )
+	{
+		result.insert( it->first.string() );
+	}
+	return result;
+}
+
+IECore::CompoundDataPtr OSLRenderer::ShadingEngine::shade( const IECore::CompoundData *points, OSL::ShadingAttribState &shadingState ) const
 {
 	// get the data for "P" - this determines the number of points to be shaded.
 	
@@ -1001,11 +1290,10 @@ IECore::CompoundDataPtr OSLRenderer::ShadingEngine::shade( const IECore::Compoun
 	shaderGlobals.dPdu = uniformValue<V3f>( points, "dPdu" );
 	shaderGlobals.dPdv = uniformValue<V3f>( points, "dPdv" );
 	
-	// add a RenderState to the ShaderGlobals. this will
+	// create a RenderState for the points. this will
 	// get passed to our RendererServices queries.
 	
-	RenderState renderState( points );
-	shaderGlobals.renderstate = &renderState;
+	const RenderState renderState( points );
 	
 	// get pointers to varying data, we'll use these to
 	// update the shaderGlobals as we iterate over our points.
@@ -1020,33 +1308,12 @@ IECore::CompoundDataPtr OSLRenderer::ShadingEngine::shade( const IECore::Compoun
 	
 	ShadingResults results( numPoints );
 	
-	// iterate over the input points, doing the shading as we go
+	// iterate over the input points in parallel, doing the shading as we go.
+	// results for different points are written to different locations, so
+	// the tasks only need to synchronise when a debug closure is first seen.
 
-	ShadingContext *shadingContext = m_renderer->m_shadingSystem->get_context();
-	for( size_t i = 0; i < numPoints; ++i )
-	{
-		shaderGlobals.P = *p++;
-		if( u )
-		{
-			shaderGlobals.u = *u++;
-		}
-		if( v )
-		{
-			shaderGlobals.v = *v++;
-		}
-		if( n )
-		{
-			shaderGlobals.N = *n++;
-		}
-		
-		shaderGlobals.Ci = NULL;
-		
-		m_renderer->m_shadingSystem->execute( *shadingContext, *m_shadingState, shaderGlobals );
-		results.addResult( i, shaderGlobals.Ci );
-		renderState.incrementPointIndex();
-	}
-	
-	m_renderer->m_shadingSystem->release_context( shadingContext );
+	ShadeTask shadeTask( m_renderer->m_shadingSystem.get(), &shadingState, shaderGlobals, renderState, p, u, v, n, results );
+	tbb::parallel_for( tbb::blocked_range<size_t>( 0, numPoints, 1000 ), shadeTask );
 	
 	return results.results();
 }
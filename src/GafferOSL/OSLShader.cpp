@@ -74,6 +74,11 @@ struct ShadingEngineCacheKey
 		:	shader( s ), hash( s->stateHash() )
 	{
 	}
+	
+	ShadingEngineCacheKey( const OSLShader *s, const MurmurHash &h )
+		:	shader( s ), hash( h )
+	{
+	}
 
 	bool operator == ( const ShadingEngineCacheKey &other ) const
 	{
@@ -167,6 +172,11 @@ OSLRenderer::ConstShadingEnginePtr OSLShader::shadingEngine() const
 	return g_shadingEngineCache.get( ShadingEngineCacheKey( this ) );
 }
 
+OSLRenderer::ConstShadingEnginePtr OSLShader::shadingEngine( const IECore::MurmurHash &stateHash ) const
+{
+	return g_shadingEngineCache.get( ShadingEngineCacheKey( this, stateHash ) );
+}
+
 bool OSLShader::acceptsInput( const Plug *plug, const Plug *inputPlug ) const
 {
 	if( !Shader::acceptsInput( plug, inputPlug ) )
@@ -100,6 +100,45 @@ static IECore::DataPtr parameterMetadata( const OSLShader &s, const Gaffer::Plug
 	return NULL;
 }
 
+static OSLRenderer::ShadingEngine::Outputs outputsFromList( const list &l )
+{
+	OSLRenderer::ShadingEngine::Outputs result;
+	for( long i = 0, e = len( l ); i < e; ++i )
+	{
+		result.insert( extract<std::string>( l[i] ) );
+	}
+	return result;
+}
+
+static list outputsToList( const OSLRenderer::ShadingEngine::Outputs &outputs )
+{
+	list result;
+	for( OSLRenderer::ShadingEngine::Outputs::const_iterator it = outputs.begin(), eIt = outputs.end(); it != eIt; ++it )
+	{
+		result.append( *it );
+	}
+	return result;
+}
+
+static IECore::CompoundDataPtr shade( const OSLRenderer::ShadingEngine &shadingEngine, const IECore::CompoundData *points, object outputs )
+{
+	if( outputs.ptr() == Py_None )
+	{
+		return shadingEngine.shade( points );
+	}
+	return shadingEngine.shade( points, outputsFromList( extract<list>( outputs ) ) );
+}
+
+static list outputs( const OSLRenderer::ShadingEngine &shadingEngine )
+{
+	return outputsToList( shadingEngine.outputs() );
+}
+
+static list computedOutputs( const OSLRenderer::ShadingEngine &shadingEngine, const list &outputs )
+{
+	return outputsToList( shadingEngine.computedOutputs( outputsFromList( outputs ) ) );
+}
+
 BOOST_PYTHON_MODULE( _GafferOSL )
 {
 	
@@ -120,7 +159,9 @@ BOOST_PYTHON_MODULE( _GafferOSL )
 	;
 
 	IECorePython::RefCountedClass<OSLRenderer::ShadingEngine, IECore::RefCounted>( "ShadingEngine" )
-		.def( "shade", &OSLRenderer::ShadingEngine::shade )
+		.def( "shade", &shade, ( arg_( "points" ), arg_( "outputs" ) = object() ) )
+		.def( "outputs", &outputs )
+		.def( "computedOutputs", &computedOutputs )
 	;
 
 }
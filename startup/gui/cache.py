@@ -36,6 +36,7 @@
 ##########################################################################
 
 import Gaffer
+import GafferImage
 
 # add plugs to the preferences node
 
@@ -43,6 +44,11 @@ preferences = application.root()["preferences"]
 preferences["cache"] = Gaffer.CompoundPlug()
 preferences["cache"]["enabled"] = Gaffer.BoolPlug( defaultValue = True )
 preferences["cache"]["memoryLimit"] = Gaffer.IntPlug( defaultValue = Gaffer.ValuePlug.getCacheMemoryLimit() / ( 1024 * 1024 ) )
+preferences["cache"]["halfPrecisionImageTiles"] = Gaffer.BoolPlug( defaultValue = False )
+preferences["cache"]["imageReaderMemoryLimit"] = Gaffer.IntPlug( defaultValue = GafferImage.ImageReader.getCacheMemoryLimit() / ( 1024 * 1024 ) )
+preferences["cache"]["imageReaderFileHandleLimit"] = Gaffer.IntPlug( defaultValue = GafferImage.ImageReader.getCacheFileHandleLimit() )
+preferences["cache"]["imageReaderAutoTile"] = Gaffer.IntPlug( defaultValue = GafferImage.ImageReader.getCacheAutoTile() )
+preferences["cache"]["imageReaderAutoMip"] = Gaffer.BoolPlug( defaultValue = GafferImage.ImageReader.getCacheAutoMip() )
 
 # update cache settings when they change
 
@@ -57,4 +63,13 @@ def __plugSet( plug ) :
 	
 	Gaffer.ValuePlug.setCacheMemoryLimit( memoryLimit )
 	
+	GafferImage.ImagePlug.setTileStorage(
+		GafferImage.ImagePlug.TileStorage.Half if plug["halfPrecisionImageTiles"].getValue() else GafferImage.ImagePlug.TileStorage.Float
+	)
+	
+	GafferImage.ImageReader.setCacheMemoryLimit( plug["imageReaderMemoryLimit"].getValue() * 1024 * 1024 )
+	GafferImage.ImageReader.setCacheFileHandleLimit( plug["imageReaderFileHandleLimit"].getValue() )
+	GafferImage.ImageReader.setCacheAutoTile( plug["imageReaderAutoTile"].getValue() )
+	GafferImage.ImageReader.setCacheAutoMip( plug["imageReaderAutoMip"].getValue() )
+	
 application.__cachePlugSetConnection = preferences.plugSetSignal().connect( __plugSet )
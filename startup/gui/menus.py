@@ -222,6 +222,8 @@ nodeMenu.append( "/Image/Merge/Merge", GafferImage.Merge )
 nodeMenu.append( "/Image/Merge/Switch", GafferImage.ImageSwitch, searchText = "ImageSwitch" )
 nodeMenu.append( "/Image/Transform/Reformat", GafferImage.Reformat )
 nodeMenu.append( "/Image/Transform/Transform", GafferImage.ImageTransform, searchText = "ImageTransform" )
+nodeMenu.append( "/Image/Transform/Auto Crop", GafferImage.AutoCrop, searchText = "AutoCrop" )
+nodeMenu.append( "/Image/Filter/Blur", GafferImage.Blur )
 nodeMenu.append( "/Image/Channels/RemoveChannels", GafferImage.RemoveChannels )
 nodeMenu.append( "/Image/Context/Time Warp", GafferImage.ImageTimeWarp, searchText = "ImageTimeWarp" )
 nodeMenu.append( "/Image/Context/Variables", GafferImage.ImageContextVariables, searchText = "ImageContextVariables"  )
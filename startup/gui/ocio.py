@@ -54,6 +54,9 @@ defaultDisplay = config.getDefaultDisplay()
 preferences = application.root()["preferences"]
 preferences["displayColorSpace"] = Gaffer.CompoundPlug()
 preferences["displayColorSpace"]["view"] = Gaffer.StringPlug( defaultValue = config.getDefaultView( defaultDisplay ) )
+# baking the transform into a LUT is faster, but clamps values outside
+# the range of the LUT, so it is off by default.
+preferences["displayColorSpace"]["bakeLUT"] = Gaffer.BoolPlug( defaultValue = False )
 
 # configure ui for preferences plugs
 
@@ -90,16 +93,28 @@ def __plugSet( plug ) :
 	
 	__setDisplayTransform()
 	__updateDefaultDisplayTransforms()
+	__updateBakeLUT()
 	
 application.__ocioPlugSetConnection = preferences.plugSetSignal().connect( __plugSet )
 
 # register display transforms with the image viewer
 
+__displayTransforms = []
+
+def __updateBakeLUT() :
+
+	bakeLUT = preferences["displayColorSpace"]["bakeLUT"].getValue()
+	for node in __displayTransforms :
+		node["bakeLUT"].setValue( bakeLUT )
+
 def __displayTransformCreator( name ) :
 
 	result = GafferImage.OpenColorIO()
 	result["inputSpace"].setValue( "linear" )
 	result["outputSpace"].setValue( config.getDisplayColorSpaceName( defaultDisplay, name ) )
+	result["bakeLUT"].setValue( preferences["displayColorSpace"]["bakeLUT"].getValue() )
+	
+	__displayTransforms.append( result )
 	
 	return result
 
@@ -122,8 +137,10 @@ def __defaultDisplayTransformCreator() :
 
 	result = GafferImage.OpenColorIO()
 	result["inputSpace"].setValue( "linear" )
+	result["bakeLUT"].setValue( preferences["displayColorSpace"]["bakeLUT"].getValue() )
 	
 	__defaultDisplayTransforms.append( result )
+	__displayTransforms.append( result )
 	__updateDefaultDisplayTransforms()
 		
 	return result